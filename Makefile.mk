@@ -1074,6 +1074,15 @@ else
 FMAP_SPD_CACHE_ENTRY :=
 endif
 
+ifeq ($(CONFIG_ACPI_SSDT_CACHE),y)
+FMAP_SSDT_CACHE_BASE := $(call int-align, $(FMAP_CURRENT_BASE), 0x1000)
+FMAP_SSDT_CACHE_SIZE := $(CONFIG_ACPI_SSDT_CACHE_SIZE)
+FMAP_SSDT_CACHE_ENTRY := $(CONFIG_ACPI_SSDT_CACHE_FMAP_NAME)@$(FMAP_SSDT_CACHE_BASE) $(FMAP_SSDT_CACHE_SIZE)
+FMAP_CURRENT_BASE := $(call int-add, $(FMAP_SSDT_CACHE_BASE) $(FMAP_SSDT_CACHE_SIZE))
+else
+FMAP_SSDT_CACHE_ENTRY :=
+endif
+
 ifeq ($(CONFIG_VPD),y)
 FMAP_VPD_BASE := $(call int-align, $(FMAP_CURRENT_BASE), 0x4000)
 FMAP_VPD_SIZE := $(CONFIG_VPD_FMAP_SIZE)
@@ -1169,6 +1178,7 @@ $(obj)/fmap.fmd: $(top)/Makefile.mk $(DEFAULT_FLASHMAP) $(obj)/config.h
 	    -e "s,##MRC_CACHE_ENTRY##,$(FMAP_MRC_CACHE_ENTRY)," \
 	    -e "s,##SMMSTORE_ENTRY##,$(FMAP_SMMSTORE_ENTRY)," \
 	    -e "s,##SPD_CACHE_ENTRY##,$(FMAP_SPD_CACHE_ENTRY)," \
+	    -e "s,##SSDT_CACHE_ENTRY##,$(FMAP_SSDT_CACHE_ENTRY)," \
 	    -e "s,##VPD_ENTRY##,$(FMAP_VPD_ENTRY)," \
 	    -e "s,##HSPHY_FW_ENTRY##,$(FMAP_HSPHY_FW_ENTRY)," \
 	    -e "s,##CBFS_BASE##,$(FMAP_CBFS_BASE)," \
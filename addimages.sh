@@ -1,12 +1,17 @@
 #!/bin/bash
 cp -n build/coreboot.rom build/coreboot_copy.rom #backup unmodified rom image
 
+manifest=$(mktemp)
+trap 'rm -f "${manifest}"' EXIT
+
 for filename in example_images/*; #add all files in /example_images/ to the CBFS
-do 
-    ./build/cbfstool build/coreboot.rom add -f ${filename} -n ${filename#*/} -t bootsplash
+do
+    echo "add -f \"${filename}\" -n \"${filename#*/}\" -t bootsplash" >> "${manifest}"
 done
 
-./build/cbfstool build/coreboot.rom add-int -i 1500 -n etc/boot-menu-wait #define boot menu timeout
-./build/cbfstool build/coreboot.rom add-int -i $(ls example_images/ | wc -l) -n etc/n-of-img #set image number variable in CBFS
+echo "add-int -i 1500 -n etc/boot-menu-wait" >> "${manifest}" #define boot menu timeout
+echo "add-int -i $(ls example_images/ | wc -l) -n etc/n-of-img" >> "${manifest}" #set image number variable in CBFS
+
+./build/cbfstool build/coreboot.rom batch -J "$(nproc)" -f "${manifest}" #add everything in a single pass, one worker per CPU
 
-./build/cbfstool build/coreboot.rom print #print CBFS content
\ No newline at end of file
+./build/cbfstool build/coreboot.rom print #print CBFS content
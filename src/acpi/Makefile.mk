@@ -21,6 +21,7 @@ ramstage-$(CONFIG_ACPI_SOC_NVS) += gnvs.c
 ramstage-y += pld.c
 ramstage-y += sata.c
 ramstage-y += soundwire.c
+ramstage-$(CONFIG_ACPI_SSDT_CACHE) += ssdt_cache.c
 ramstage-y += fadt_filler.c
 ramstage-$(CONFIG_ACPI_COMMON_MADT_GICC_V3) += acpi_gic.c
 
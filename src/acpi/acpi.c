@@ -17,6 +17,7 @@
 #include <acpi/acpi_iort.h>
 #include <acpi/acpi_ivrs.h>
 #include <acpi/acpigen.h>
+#include <acpi/ssdt_cache.h>
 #include <cbfs.h>
 #include <cbmem.h>
 #include <commonlib/helpers.h>
@@ -324,13 +325,15 @@ static void acpi_create_ssdt_generator(acpi_header_t *ssdt, void *unused)
 	/* Write object to declare coreboot tables */
 	acpi_ssdt_write_cbtable();
 
-	{
+	if (CONFIG(ACPI_SSDT_CACHE)) {
+		acpi_ssdt_cache_fill();
+	} else {
 		struct device *dev;
 		for (dev = all_devices; dev; dev = dev->next)
 			if (dev->enabled && dev->ops && dev->ops->acpi_fill_ssdt)
 				dev->ops->acpi_fill_ssdt(dev);
-		current = (unsigned long)acpigen_get_current();
 	}
+	current = (unsigned long)acpigen_get_current();
 
 	/* (Re)calculate length and checksum. */
 	ssdt->length = current - (unsigned long)ssdt;
@@ -1624,12 +1627,6 @@ unsigned long write_acpi_tables(const unsigned long start)
 		acpi_add_table(rsdp, header);
 	}
 
-	/*
-	 * cbfs_unmap() uses mem_pool_free() which works correctly only
-	 * if freeing is done in reverse order than memory allocation.
-	 * This is why unmapping of dsdt_file must be done after
-	 * unmapping slic file.
-	 */
 	cbfs_unmap(slic_file);
 	cbfs_unmap(dsdt_file);
 
@@ -21,6 +21,24 @@ static char *gencurrent;
 char *len_stack[ACPIGEN_LENSTACK_SIZE];
 int ltop = 0;
 
+/* The template being recorded, whose fields move along when a PkgLength shrinks. */
+static struct acpigen_template *active_template;
+static int template_ltop;
+
+static void template_payload_moved(const char *payload, size_t shift)
+{
+	struct acpigen_template *t = active_template;
+	size_t i;
+
+	if (!t)
+		return;
+
+	for (i = 0; i < t->num_fields; i++) {
+		if (t->start + t->fields[i].offset >= payload)
+			t->fields[i].offset -= shift;
+	}
+}
+
 void acpigen_write_len_f(void)
 {
 	ASSERT(ltop < (ACPIGEN_LENSTACK_SIZE - 1))
@@ -45,6 +63,7 @@ void acpigen_pop_len(void)
 		   data needs to be moved by 2 bytes */
 		memmove(&p[ACPIGEN_RSVD_PKGLEN_BYTES - 2],
 			&p[ACPIGEN_RSVD_PKGLEN_BYTES], payload_len);
+		template_payload_moved(&p[ACPIGEN_RSVD_PKGLEN_BYTES], 2);
 		/* Adjust the PkgLength to take into account that we only use 1 of the 3
 		   reserved bytes */
 		len -= 2;
@@ -60,6 +79,7 @@ void acpigen_pop_len(void)
 		   data needs to be moved by 1 byte */
 		memmove(&p[ACPIGEN_RSVD_PKGLEN_BYTES - 1],
 			&p[ACPIGEN_RSVD_PKGLEN_BYTES], payload_len);
+		template_payload_moved(&p[ACPIGEN_RSVD_PKGLEN_BYTES], 1);
 		/* Adjust the PkgLength to take into account that we only use 2 of the 3
 		   reserved bytes */
 		len -= 1;
@@ -87,6 +107,30 @@ void acpigen_pop_len(void)
 	}
 }
 
+/*
+ * Emit the PkgLength of payload_len bytes that follow it, for objects whose size is known
+ * before they are written. Same encoding as acpigen_pop_len(), without moving anything.
+ */
+static void acpigen_write_len(size_t payload_len)
+{
+	size_t len;
+
+	if (payload_len + 1 <= 0x3f) {
+		acpigen_emit_byte(payload_len + 1);
+	} else if (payload_len + 2 <= 0xfff) {
+		len = payload_len + 2;
+		acpigen_emit_byte(0x1 << 6 | (len & 0xf));
+		acpigen_emit_byte(len >> 4 & 0xff);
+	} else if (payload_len + 3 <= 0xfffff) {
+		len = payload_len + 3;
+		acpigen_emit_byte(0x2 << 6 | (len & 0xf));
+		acpigen_emit_byte(len >> 4 & 0xff);
+		acpigen_emit_byte(len >> 12 & 0xff);
+	} else {
+		printk(BIOS_ERR, "%s: package length exceeds maximum of 0xfffff.\n", __func__);
+	}
+}
+
 void acpigen_set_current(char *curr)
 {
 	gencurrent = curr;
@@ -458,32 +502,200 @@ void acpigen_write_processor_device(unsigned int cpu_index)
 	acpigen_write_name_integer("_UID", cpu_index);
 }
 
+/* Size of what acpigen_emit_namestring() emits for the short namepath. */
+static size_t namestring_size(const char *namepath)
+{
+	char buffer[32];
+	char *current = gencurrent;
+	size_t size;
+
+	gencurrent = buffer;
+	acpigen_emit_namestring(namepath);
+	size = gencurrent - buffer;
+	gencurrent = current;
+
+	return size;
+}
+
+/* The namestrings of all CPUs have this size, they only differ in their NameSeg. */
+static size_t processor_namestring_size(void)
+{
+	char buffer[16];
+
+	snprintf(buffer, sizeof(buffer), "\\_SB." CONFIG_ACPI_CPU_STRING, 0);
+	return namestring_size(buffer);
+}
+
+/* Overwrite the NameSeg at p, padded with '_' like acpigen_emit_simple_namestring(). */
+static void patch_processor_nameseg(char *p, unsigned int cpu_index)
+{
+	char name[16];
+	size_t len;
+
+	len = snprintf(name, sizeof(name), CONFIG_ACPI_CPU_STRING, cpu_index);
+	memset(p, '_', 4);
+	memcpy(p, name, MIN(len, 4));
+}
+
+/* Emit the namestring of cpu_index as a copy of the CPU namestring at prev. */
+static void write_next_processor_namestring(const char *prev, size_t size,
+					    unsigned int cpu_index)
+{
+	memcpy(gencurrent, prev, size);
+	gencurrent += size;
+	patch_processor_nameseg(gencurrent - 4, cpu_index);
+}
+
+/*
+ * The per-CPU arrays below have a known size, so their PkgLength is written up front, and
+ * each namestring is copied from the previous one with only its NameSeg patched.
+ */
 void acpigen_write_processor_package(const char *const name, const unsigned int first_core,
 				     const unsigned int core_count)
 {
+	const size_t ns_size = processor_namestring_size();
 	unsigned int i;
+	char *prev;
 
 	acpigen_write_name(name);
-	acpigen_write_package(core_count);
+	acpigen_emit_byte(PACKAGE_OP);
+	acpigen_write_len(1 + core_count * ns_size);
+	acpigen_emit_byte(core_count);
 
-	for (i = first_core; i < first_core + core_count; ++i)
-		acpigen_write_processor_namestring(i);
+	if (!core_count)
+		return;
 
-	acpigen_pop_len();
+	prev = gencurrent;
+	acpigen_write_processor_namestring(first_core);
+	for (i = first_core + 1; i < first_core + core_count; ++i) {
+		write_next_processor_namestring(prev, ns_size, i);
+		prev += ns_size;
+	}
 }
 
 /* Method to notify all CPU cores */
 void acpigen_write_processor_cnot(const unsigned int number_of_cores)
 {
+	const char *const method = "\\_SB.CNOT";
+	const size_t ns_size = processor_namestring_size();
+	const char *prev = NULL;
 	int core_id;
 
-	acpigen_write_method("\\_SB.CNOT", 1);
+	acpigen_emit_byte(METHOD_OP);
+	acpigen_write_len(namestring_size(method) + 1 + number_of_cores * (ns_size + 2));
+	acpigen_emit_namestring(method);
+	acpigen_emit_byte(1);
+
 	for (core_id = 0; core_id < number_of_cores; core_id++) {
 		acpigen_emit_byte(NOTIFY_OP);
-		acpigen_write_processor_namestring(core_id);
+		if (prev)
+			write_next_processor_namestring(prev, ns_size, core_id);
+		else
+			acpigen_write_processor_namestring(core_id);
+		prev = gencurrent - ns_size;
 		acpigen_emit_byte(ARG0_OP);
 	}
-	acpigen_pop_len();
+}
+
+void acpigen_template_begin(struct acpigen_template *t)
+{
+	assert(!active_template);
+
+	t->start = gencurrent;
+	t->size = 0;
+	t->num_fields = 0;
+	active_template = t;
+	template_ltop = ltop;
+}
+
+void acpigen_template_end(struct acpigen_template *t)
+{
+	assert(active_template == t);
+	/* A copy must not leave anything open or close what was open before. */
+	assert(ltop == template_ltop);
+
+	t->size = gencurrent - t->start;
+	active_template = NULL;
+}
+
+static void template_add_field(struct acpigen_template *t, enum acpigen_field_type type)
+{
+	assert(active_template == t);
+	assert(t->num_fields < ACPIGEN_TEMPLATE_MAX_FIELDS);
+
+	/* Both field types are the last 4 bytes emitted. */
+	t->fields[t->num_fields].offset = gencurrent - 4 - t->start;
+	t->fields[t->num_fields].type = type;
+	t->num_fields++;
+}
+
+void acpigen_template_write_processor_namestring(struct acpigen_template *t,
+						 unsigned int cpu_index)
+{
+	acpigen_write_processor_namestring(cpu_index);
+	template_add_field(t, ACPIGEN_FIELD_CPU_NAMESEG);
+}
+
+void acpigen_template_write_dword(struct acpigen_template *t, uint32_t value)
+{
+	acpigen_write_dword(value);
+	template_add_field(t, ACPIGEN_FIELD_DWORD);
+}
+
+void acpigen_template_write_processor_device(struct acpigen_template *t,
+					     unsigned int cpu_index)
+{
+	acpigen_emit_ext_op(DEVICE_OP);
+	acpigen_write_len_f();
+	acpigen_template_write_processor_namestring(t, cpu_index);
+	acpigen_write_name_string("_HID", "ACPI0007");
+	acpigen_write_name("_UID");
+	acpigen_template_write_dword(t, cpu_index);
+}
+
+void acpigen_template_stamp(const struct acpigen_template *t, const uint32_t *values)
+{
+	char *copy = gencurrent;
+	char *field;
+	size_t i;
+
+	memcpy(copy, t->start, t->size);
+	gencurrent += t->size;
+
+	for (i = 0; i < t->num_fields; i++) {
+		field = copy + t->fields[i].offset;
+		if (t->fields[i].type == ACPIGEN_FIELD_CPU_NAMESEG) {
+			patch_processor_nameseg(field, values[i]);
+		} else {
+			field[0] = values[i] & 0xff;
+			field[1] = (values[i] >> 8) & 0xff;
+			field[2] = (values[i] >> 16) & 0xff;
+			field[3] = (values[i] >> 24) & 0xff;
+		}
+	}
+}
+
+void acpigen_write_processor_devices(unsigned int count, void (*body)(void *arg), void *arg)
+{
+	struct acpigen_template t;
+	uint32_t values[2];
+	unsigned int cpu;
+
+	if (!count)
+		return;
+
+	acpigen_template_begin(&t);
+	acpigen_template_write_processor_device(&t, 0);
+	if (body)
+		body(arg);
+	acpigen_write_processor_device_end();
+	acpigen_template_end(&t);
+
+	for (cpu = 1; cpu < count; cpu++) {
+		values[0] = cpu;
+		values[1] = cpu;
+		acpigen_template_stamp(&t, values);
+	}
 }
 
 /*
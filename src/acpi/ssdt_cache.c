@@ -0,0 +1,370 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <acpi/acpigen.h>
+#include <acpi/ssdt_cache.h>
+#include <commonlib/bsd/helpers.h>
+#include <commonlib/region.h>
+#include <console/console.h>
+#include <device/device.h>
+#include <fmap.h>
+#include <fw_config.h>
+#include <spi_flash.h>
+#include <string.h>
+#include <types.h>
+#include <version.h>
+#include <xxhash.h>
+
+/*
+ * SSDT_CACHE layout
+ *    +===============+ offset 0x00
+ *    |    header     |   Alone in the first sector, so it's erased first and written last.
+ *    +---------------+ offset HEADER_SECTOR
+ *    | segment sizes |   One uint32_t per cacheable device, in all_devices order.
+ *    +---------------+
+ *    |      AML      |   The output of the cacheable devices, back to back.
+ *    +===============+
+ *
+ * A header with the current key and no segments records an update that failed, so that it
+ * isn't tried again on every boot until the key changes.
+ *
+ * Only the output of cacheable devices is stored. Everything else, including the CTBL
+ * object pointing at this boot's coreboot table, is generated on every boot, so that the
+ * AML keeps its order.
+ */
+
+#define SSDT_CACHE_SIGNATURE	0x43445353	/* 'SSDC' */
+#define HEADER_SECTOR		(4 * KiB)
+#define MAX_SEGMENTS		64
+
+struct ssdt_cache_header {
+	uint32_t signature;
+	uint32_t segments;
+	uint64_t key;
+	/* Size and xxh32 of the segment sizes and the AML. */
+	uint32_t size;
+	uint32_t data_hash;
+};
+
+/* Where the output of each cacheable device went in this boot's SSDT. */
+static struct {
+	const char *start;
+	uint32_t size;
+} segments[MAX_SEGMENTS];
+
+__weak uint64_t acpi_ssdt_cache_platform_key(void)
+{
+	return 0;
+}
+
+static bool has_ssdt(const struct device *dev)
+{
+	return dev->enabled && dev->ops && dev->ops->acpi_fill_ssdt;
+}
+
+static void hash_string(struct xxh64_state *state, const char *s)
+{
+	xxh64_update(state, s, strlen(s) + 1);
+}
+
+static uint64_t cache_key(void)
+{
+	struct xxh64_state state;
+	const struct device *dev;
+	const struct resource *res;
+	uint64_t platform;
+
+	xxh64_reset(&state, 0);
+
+	/* A firmware update may change what any callback emits. */
+	hash_string(&state, coreboot_version);
+	hash_string(&state, coreboot_extra_version);
+	hash_string(&state, coreboot_build);
+	hash_string(&state, coreboot_compile_time);
+
+	/* dev_path() instead of the raw path, whose unused union bytes may be garbage. */
+	for (dev = all_devices; dev; dev = dev->next) {
+		const uint64_t state_of_dev[] = {
+			dev->enabled,
+			dev->hidden,
+			dev->vendor,
+			dev->device,
+			dev->class,
+			dev->subsystem_vendor << 16 | dev->subsystem_device,
+			(uintptr_t)dev->ops,
+			has_ssdt(dev) ? (uintptr_t)dev->ops->acpi_fill_ssdt : 0,
+		};
+
+		hash_string(&state, dev_path(dev));
+		xxh64_update(&state, state_of_dev, sizeof(state_of_dev));
+
+		for (res = dev->resource_list; res; res = res->next) {
+			const uint64_t state_of_res[] = {
+				res->index, res->flags, res->base, res->size,
+			};
+
+			xxh64_update(&state, state_of_res, sizeof(state_of_res));
+		}
+	}
+
+	if (CONFIG(FW_CONFIG)) {
+		const uint64_t fw_config = fw_config_get();
+
+		xxh64_update(&state, &fw_config, sizeof(fw_config));
+	}
+
+	platform = acpi_ssdt_cache_platform_key();
+	xxh64_update(&state, &platform, sizeof(platform));
+
+	return xxh64_digest(&state);
+}
+
+/* Map the segment sizes and AML if the cache holds what this boot would generate. */
+static const uint32_t *map_cache(const struct region_device *rdev, uint64_t key,
+				 size_t num_segments)
+{
+	struct ssdt_cache_header header;
+	const uint32_t *sizes;
+	size_t aml_size = 0;
+	size_t i;
+
+	if (rdev_readat(rdev, &header, 0, sizeof(header)) != sizeof(header))
+		return NULL;
+
+	if (header.signature != SSDT_CACHE_SIGNATURE || header.key != key ||
+	    header.segments != num_segments ||
+	    header.size < num_segments * sizeof(*sizes) ||
+	    header.size > region_device_sz(rdev) - HEADER_SECTOR)
+		return NULL;
+
+	sizes = rdev_mmap(rdev, HEADER_SECTOR, header.size);
+	if (!sizes)
+		return NULL;
+
+	for (i = 0; i < num_segments; i++)
+		aml_size += sizes[i];
+
+	if (xxh32(sizes, header.size, 0) != header.data_hash ||
+	    aml_size != header.size - num_segments * sizeof(*sizes)) {
+		printk(BIOS_WARNING, "SSDT_CACHE: Data corrupted\n");
+		rdev_munmap(rdev, (void *)sizes);
+		return NULL;
+	}
+
+	return sizes;
+}
+
+static bool update_failed_before(const struct region_device *rdev, uint64_t key)
+{
+	struct ssdt_cache_header header;
+
+	if (rdev_readat(rdev, &header, 0, sizeof(header)) != sizeof(header))
+		return false;
+
+	return header.signature == SSDT_CACHE_SIGNATURE && header.key == key &&
+	       header.segments == 0;
+}
+
+static bool write_protected(const struct region_device *rdev)
+{
+	const struct spi_flash *flash;
+
+	if (!CONFIG(BOOT_DEVICE_SPI_FLASH))
+		return false;
+
+	flash = boot_device_spi_flash();
+	if (!flash)
+		return false;
+
+	return spi_flash_is_write_protected(flash, region_device_region(rdev)) == 1;
+}
+
+/* Only sticks if the flash still takes writes, e.g. when programming failed halfway. */
+static void mark_update_failed(const struct region_device *rdev, uint64_t key)
+{
+	const struct ssdt_cache_header header = {
+		.signature = SSDT_CACHE_SIGNATURE,
+		.key = key,
+	};
+
+	if (rdev_eraseat(rdev, 0, HEADER_SECTOR) == HEADER_SECTOR)
+		rdev_writeat(rdev, &header, 0, sizeof(header));
+}
+
+static void update_cache(uint64_t key, size_t num_segments)
+{
+	struct ssdt_cache_header header = {
+		.signature = SSDT_CACHE_SIGNATURE,
+		.segments = num_segments,
+		.key = key,
+	};
+	uint32_t sizes[MAX_SEGMENTS];
+	struct region_device rdev;
+	struct xxh32_state state;
+	size_t offset, i;
+
+	header.size = num_segments * sizeof(*sizes);
+	for (i = 0; i < num_segments; i++) {
+		sizes[i] = segments[i].size;
+		header.size += sizes[i];
+	}
+
+	if (fmap_locate_area_as_rdev_rw(CONFIG_ACPI_SSDT_CACHE_FMAP_NAME, &rdev)) {
+		printk(BIOS_ERR, "SSDT_CACHE: Cannot access %s region\n",
+		       CONFIG_ACPI_SSDT_CACHE_FMAP_NAME);
+		return;
+	}
+
+	if (update_failed_before(&rdev, key)) {
+		printk(BIOS_DEBUG, "SSDT_CACHE: Updating %s failed before, not retrying\n",
+		       CONFIG_ACPI_SSDT_CACHE_FMAP_NAME);
+		return;
+	}
+
+	if (write_protected(&rdev)) {
+		printk(BIOS_INFO, "SSDT_CACHE: %s is write-protected, not updating\n",
+		       CONFIG_ACPI_SSDT_CACHE_FMAP_NAME);
+		return;
+	}
+
+	if (header.size > region_device_sz(&rdev) - HEADER_SECTOR) {
+		printk(BIOS_WARNING, "SSDT_CACHE: %u bytes don't fit into %s\n", header.size,
+		       CONFIG_ACPI_SSDT_CACHE_FMAP_NAME);
+		return;
+	}
+
+	xxh32_reset(&state, 0);
+	xxh32_update(&state, sizes, num_segments * sizeof(*sizes));
+	for (i = 0; i < num_segments; i++)
+		xxh32_update(&state, segments[i].start, segments[i].size);
+	header.data_hash = xxh32_digest(&state);
+
+	printk(BIOS_INFO, "SSDT_CACHE: Updating %s\n", CONFIG_ACPI_SSDT_CACHE_FMAP_NAME);
+
+	/* An interrupted update leaves an erased header behind, i.e. no cache. */
+	offset = HEADER_SECTOR + ALIGN_UP(header.size, HEADER_SECTOR);
+	if (rdev_eraseat(&rdev, 0, offset) != offset)
+		goto fail;
+
+	offset = HEADER_SECTOR;
+	if (rdev_writeat(&rdev, sizes, offset, num_segments * sizeof(*sizes)) < 0)
+		goto fail;
+	offset += num_segments * sizeof(*sizes);
+
+	for (i = 0; i < num_segments; i++) {
+		if (segments[i].size && rdev_writeat(&rdev, segments[i].start, offset,
+						     segments[i].size) < 0)
+			goto fail;
+		offset += segments[i].size;
+	}
+
+	if (rdev_writeat(&rdev, &header, 0, sizeof(header)) < 0)
+		goto fail;
+
+	return;
+
+fail:
+	printk(BIOS_ERR, "SSDT_CACHE: Cannot update %s region\n",
+	       CONFIG_ACPI_SSDT_CACHE_FMAP_NAME);
+	mark_update_failed(&rdev, key);
+}
+
+static size_t count_cacheable(void)
+{
+	const struct device *dev;
+	size_t count = 0;
+
+	for (dev = all_devices; dev; dev = dev->next) {
+		if (has_ssdt(dev) && dev->ops->acpi_ssdt_cacheable)
+			count++;
+	}
+
+	return count;
+}
+
+static void fill_all(void)
+{
+	const struct device *dev;
+
+	for (dev = all_devices; dev; dev = dev->next) {
+		if (has_ssdt(dev))
+			dev->ops->acpi_fill_ssdt(dev);
+	}
+}
+
+void acpi_ssdt_cache_fill(void)
+{
+	const size_t num_segments = count_cacheable();
+	const uint32_t *sizes = NULL;
+	struct region_device rdev;
+	const struct device *dev;
+	const char *aml = NULL;
+	bool stale = false;
+	uint64_t key;
+	size_t i = 0;
+	char *start;
+
+	if (!num_segments) {
+		fill_all();
+		return;
+	}
+
+	if (num_segments > MAX_SEGMENTS) {
+		printk(BIOS_WARNING, "SSDT_CACHE: Too many cacheable devices (%zu)\n",
+		       num_segments);
+		fill_all();
+		return;
+	}
+
+	if (fmap_locate_area_as_rdev(CONFIG_ACPI_SSDT_CACHE_FMAP_NAME, &rdev)) {
+		printk(BIOS_ERR, "SSDT_CACHE: Cannot find %s region\n",
+		       CONFIG_ACPI_SSDT_CACHE_FMAP_NAME);
+		fill_all();
+		return;
+	}
+
+	key = cache_key();
+	sizes = map_cache(&rdev, key, num_segments);
+	if (sizes)
+		aml = (const char *)&sizes[num_segments];
+
+	printk(BIOS_DEBUG, "SSDT_CACHE: %s for key 0x%016llx\n",
+	       sizes ? "Using cached AML" : "No cached AML", key);
+
+	for (dev = all_devices; dev; dev = dev->next) {
+		if (!has_ssdt(dev))
+			continue;
+
+		if (!dev->ops->acpi_ssdt_cacheable) {
+			dev->ops->acpi_fill_ssdt(dev);
+			continue;
+		}
+
+		start = acpigen_get_current();
+		if (sizes && !CONFIG(ACPI_SSDT_CACHE_VERIFY)) {
+			memcpy(start, aml, sizes[i]);
+			acpigen_set_current(start + sizes[i]);
+		} else {
+			dev->ops->acpi_fill_ssdt(dev);
+		}
+
+		segments[i].start = start;
+		segments[i].size = acpigen_get_current() - start;
+
+		if (CONFIG(ACPI_SSDT_CACHE_VERIFY) && sizes &&
+		    (segments[i].size != sizes[i] || memcmp(start, aml, sizes[i]) != 0)) {
+			printk(BIOS_ERR, "SSDT_CACHE: AML of %s differs from the cache\n",
+			       dev_path(dev));
+			stale = true;
+		}
+
+		if (sizes)
+			aml += sizes[i];
+		i++;
+	}
+
+	if (sizes)
+		rdev_munmap(&rdev, (void *)sizes);
+
+	if (!sizes || stale)
+		update_cache(key, num_segments);
+}
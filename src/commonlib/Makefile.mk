@@ -51,6 +51,7 @@ bootblock-y += bsd/lz4_wrapper.c
 verstage-y += bsd/lz4_wrapper.c
 romstage-y += bsd/lz4_wrapper.c
 ramstage-y += bsd/lz4_wrapper.c
+ramstage-y += bsd/lz4_compress.c
 postcar-y += bsd/lz4_wrapper.c
 
 all-y += list.c
@@ -135,6 +135,7 @@ enum cbfs_file_attr_tag {
 	CBFS_FILE_ATTR_TAG_IBB		= 0x32494242, /* BE: '2IBB' */
 	CBFS_FILE_ATTR_TAG_PADDING	= 0x47444150, /* BE: 'GNDP' */
 	CBFS_FILE_ATTR_TAG_STAGEHEADER	= 0x53746748, /* BE: 'StgH' */
+	CBFS_FILE_ATTR_TAG_LZ4_BLOCKS	= 0x4c5a3442, /* BE: 'LZ4B' */
 };
 
 struct cbfs_file_attr_compression {
@@ -173,6 +174,20 @@ struct cbfs_file_attr_stageheader {
 } __packed;
 
 
+/* Index of the independent blocks in an LZ4-compressed file. Every block decompresses to
+   exactly block_size bytes, except for the last one which may be shorter. Offsets point to
+   the LZ4 block header and are relative to the start of the file data. The number of
+   blocks is capped so that the index always fits into CBFS_METADATA_MAX_SIZE. */
+#define CBFS_LZ4_BLOCKS_MAX 16
+struct cbfs_file_attr_lz4_blocks {
+	uint32_t tag;
+	uint32_t len;
+	uint32_t block_size;
+	uint32_t num_blocks;
+	uint32_t offsets[];
+} __packed;
+
+
 /*** Component sub-headers ***/
 
 /* Following are component sub-headers for the "standard"
@@ -51,6 +51,7 @@
 #define CBMEM_ID_RAMSTAGE_CACHE	0x9a3ca54e
 #define CBMEM_ID_REFCODE	0x04efc0de
 #define CBMEM_ID_REFCODE_CACHE	0x4efc0de5
+#define CBMEM_ID_REGF_HINTS	0x48464752
 #define CBMEM_ID_RESUME		0x5245534d
 #define CBMEM_ID_RESUME_SCRATCH	0x52455343
 #define CBMEM_ID_ROMSTAGE_INFO	0x47545352
@@ -81,6 +82,9 @@
 #define CBMEM_ID_FMAP		0x464d4150
 #define CBMEM_ID_CBFS_RO_MCACHE	0x524d5346
 #define CBMEM_ID_CBFS_RW_MCACHE	0x574d5346
+#define CBMEM_ID_CBFS_TRACE	0x43465452
+#define CBMEM_ID_BOOT_PROFILE	0x42505246
+#define CBMEM_ID_CBFS_CACHE_STATS	0x43435354
 #define CBMEM_ID_FSP_LOGO	0x4c4f474f
 #define CBMEM_ID_SMM_COMBUFFER	0x53534d32
 #define CBMEM_ID_TYPE_C_INFO	0x54595045
@@ -136,6 +140,7 @@
 	{ CBMEM_ID_RAMSTAGE_CACHE,	"RAMSTAGE $ " }, \
 	{ CBMEM_ID_RAMSTAGE,		"RAMSTAGE   " }, \
 	{ CBMEM_ID_REFCODE_CACHE,	"REFCODE $  " }, \
+	{ CBMEM_ID_REGF_HINTS,		"REGF HINTS " }, \
 	{ CBMEM_ID_REFCODE,		"REFCODE    " }, \
 	{ CBMEM_ID_RESUME,		"ACPI RESUME" }, \
 	{ CBMEM_ID_RESUME_SCRATCH,	"ACPISCRATCH" }, \
@@ -164,6 +169,9 @@
 	{ CBMEM_ID_FMAP,		"FMAP       "}, \
 	{ CBMEM_ID_CBFS_RO_MCACHE,	"RO MCACHE  "}, \
 	{ CBMEM_ID_CBFS_RW_MCACHE,	"RW MCACHE  "}, \
+	{ CBMEM_ID_CBFS_TRACE,		"CBFS TRACE "}, \
+	{ CBMEM_ID_BOOT_PROFILE,	"BOOT PROFILE"}, \
+	{ CBMEM_ID_CBFS_CACHE_STATS,	"CBFS CACHE STATS"}, \
 	{ CBMEM_ID_FSP_LOGO,		"FSP LOGO   "}, \
 	{ CBMEM_ID_SMM_COMBUFFER,	"SMM COMBUFFER"}, \
 	{ CBMEM_ID_TYPE_C_INFO,		"TYPE_C INFO"},\
@@ -15,7 +15,20 @@
  */
 size_t ulz4fn(const void *src, size_t srcn, void *dst, size_t dstn);
 
+/* Decompresses a single independent LZ4 block (starting with its 4-byte block header,
+ * as found inside an LZ4F frame) from src to dst. Used to decompress the blocks of a
+ * frame out of order, e.g. on multiple CPUs. Does not support in-place decompression.
+ * Returns amount of decompressed bytes, or 0 on error.
+ */
+size_t ulz4_block(const void *src, size_t srcn, void *dst, size_t dstn);
+
 /* Same as ulz4fn() but does not perform any bounds checks. */
 size_t ulz4f(const void *src, void *dst);
 
+/* Compresses srcn bytes from src into an LZ4F image at dst that ulz4fn() can
+ * decompress, writing no more than dstn bytes. Favors a small stack footprint
+ * over compression ratio. Returns the size of the image, or 0 if it didn't fit.
+ */
+size_t lz4f_compress(const void *src, size_t srcn, void *dst, size_t dstn);
+
 #endif	/* _COMMONLIB_COMPRESSION_H_ */
@@ -0,0 +1,194 @@
+/* SPDX-License-Identifier: BSD-3-Clause OR GPL-2.0-only */
+
+#include <commonlib/bsd/compression.h>
+#include <commonlib/bsd/helpers.h>
+#include <commonlib/bsd/sysincludes.h>
+#include <stdint.h>
+#include <string.h>
+
+/*
+ * A small greedy LZ4 compressor for data that firmware wants to store compressed
+ * itself, e.g. memory training results. It trades ratio for a small footprint: one
+ * hash table probe per position and a table that fits on a stage stack. The output
+ * is a standard LZ4F frame with independent 64KiB blocks and no checksums, so it can
+ * be read with ulz4fn() and the reference lz4 tool alike.
+ */
+
+#define LZ4F_MAGICNUMBER	0x184D2204
+#define LZ4F_FLG		0x60	/* Version 1, independent blocks */
+#define LZ4F_BD			0x40	/* 64KiB maximum block size */
+#define LZ4F_HC			0x82	/* (xxh32({FLG, BD}, 0) >> 8) & 0xff */
+#define LZ4F_BLOCK_SIZE		(64 * KiB)
+#define NOT_COMPRESSED		0x80000000
+
+#define MIN_MATCH		4
+#define MFLIMIT			12	/* The last match must start this far from the end */
+#define LAST_LITERALS		5	/* and must end this far from the end of the block */
+#define MAX_DISTANCE		0xffff
+#define HASH_LOG		10
+
+static uint32_t read32(const uint8_t *p)
+{
+	uint32_t v;
+
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static size_t hash4(uint32_t v)
+{
+	return (v * 2654435761U) >> (32 - HASH_LOG);
+}
+
+/* Returns the new output position, or NULL if the length doesn't fit. */
+static uint8_t *put_length(uint8_t *op, const uint8_t *oend, size_t len)
+{
+	for (; len >= 255; len -= 255) {
+		if (op >= oend)
+			return NULL;
+		*op++ = 255;
+	}
+
+	if (op >= oend)
+		return NULL;
+	*op++ = len;
+
+	return op;
+}
+
+/* Returns the new output position, or NULL if the sequence doesn't fit. */
+static uint8_t *put_sequence(uint8_t *op, const uint8_t *oend, const uint8_t *literals,
+			     size_t lit_len, size_t distance, size_t match_len)
+{
+	uint8_t *token = op;
+
+	if (op >= oend)
+		return NULL;
+	op++;
+
+	*token = MIN(lit_len, 15) << 4;
+	if (lit_len >= 15 && !(op = put_length(op, oend, lit_len - 15)))
+		return NULL;
+
+	if ((size_t)(oend - op) < lit_len)
+		return NULL;
+	memcpy(op, literals, lit_len);
+	op += lit_len;
+
+	/* The last sequence only has literals. */
+	if (!distance)
+		return op;
+
+	if (oend - op < 2)
+		return NULL;
+	*op++ = distance & 0xff;
+	*op++ = distance >> 8;
+
+	match_len -= MIN_MATCH;
+	*token |= MIN(match_len, 15);
+	if (match_len >= 15)
+		op = put_length(op, oend, match_len - 15);
+
+	return op;
+}
+
+/* Returns the size of the compressed block, or 0 if it would not fit into dstn. */
+static size_t compress_block(const uint8_t *src, size_t srcn, uint8_t *dst, size_t dstn)
+{
+	uint16_t table[1 << HASH_LOG];
+	const uint8_t *ip = src;
+	const uint8_t *anchor = src;
+	const uint8_t *const iend = src + srcn;
+	uint8_t *op = dst;
+	const uint8_t *const oend = dst + dstn;
+
+	memset(table, 0, sizeof(table));
+
+	if (srcn > MFLIMIT) {
+		const uint8_t *const mflimit = iend - MFLIMIT;
+		const uint8_t *const matchlimit = iend - LAST_LITERALS;
+
+		while (ip < mflimit) {
+			const uint32_t seq = read32(ip);
+			const size_t h = hash4(seq);
+			const uint8_t *ref = src + table[h];
+			const uint8_t *end;
+
+			table[h] = ip - src;
+
+			if (ref >= ip || ip - ref > MAX_DISTANCE || read32(ref) != seq) {
+				ip++;
+				continue;
+			}
+
+			for (end = ip + MIN_MATCH; end < matchlimit; end++) {
+				if (*end != ref[end - ip])
+					break;
+			}
+
+			op = put_sequence(op, oend, anchor, ip - anchor, ip - ref, end - ip);
+			if (!op)
+				return 0;
+
+			ip = anchor = end;
+		}
+	}
+
+	op = put_sequence(op, oend, anchor, iend - anchor, 0, 0);
+	if (!op)
+		return 0;
+
+	return op - dst;
+}
+
+static void put_le32(uint8_t *p, uint32_t v)
+{
+	v = htole32(v);
+	memcpy(p, &v, sizeof(v));
+}
+
+size_t lz4f_compress(const void *src, size_t srcn, void *dst, size_t dstn)
+{
+	const uint8_t *in = src;
+	uint8_t *out = dst;
+	const uint8_t *const oend = out + dstn;
+	size_t done, len, size;
+
+	/* Frame header and end mark */
+	if (dstn < 7 + sizeof(uint32_t))
+		return 0;
+
+	put_le32(out, LZ4F_MAGICNUMBER);
+	out[4] = LZ4F_FLG;
+	out[5] = LZ4F_BD;
+	out[6] = LZ4F_HC;
+	out += 7;
+
+	for (done = 0; done < srcn; done += len) {
+		len = MIN(LZ4F_BLOCK_SIZE, srcn - done);
+
+		if ((size_t)(oend - out) < 2 * sizeof(uint32_t))
+			return 0;
+
+		size = compress_block(in + done, len, out + sizeof(uint32_t),
+				      oend - out - 2 * sizeof(uint32_t));
+
+		/* Store blocks that don't shrink as they are. */
+		if (!size || size >= len) {
+			if ((size_t)(oend - out) < 2 * sizeof(uint32_t) + len)
+				return 0;
+			memcpy(out + sizeof(uint32_t), in + done, len);
+			put_le32(out, NOT_COMPRESSED | len);
+			out += sizeof(uint32_t) + len;
+			continue;
+		}
+
+		put_le32(out, size);
+		out += sizeof(uint32_t) + size;
+	}
+
+	put_le32(out, 0);
+	out += sizeof(uint32_t);
+
+	return out - (uint8_t *)dst;
+}
@@ -164,6 +164,35 @@ size_t ulz4fn(const void *src, size_t srcn, void *dst, size_t dstn)
 	return out_size;
 }
 
+size_t ulz4_block(const void *src, size_t srcn, void *dst, size_t dstn)
+{
+	if (srcn < sizeof(struct lz4_block_header))
+		return 0;	/* input overrun */
+
+	struct lz4_block_header b = {
+		.raw = le32toh(*(const uint32_t *)src)
+	};
+	const void *in = src + sizeof(struct lz4_block_header);
+
+	if (sizeof(struct lz4_block_header) + (b.raw & BH_SIZE) > srcn)
+		return 0;	/* input overrun */
+
+	if (b.raw & NOT_COMPRESSED) {
+		if ((b.raw & BH_SIZE) > dstn)
+			return 0;	/* output overrun */
+		memcpy(dst, in, b.raw & BH_SIZE);
+		return b.raw & BH_SIZE;
+	}
+
+	/* constant folding essential, do not touch params! */
+	int ret = LZ4_decompress_generic(in, dst, (b.raw & BH_SIZE), dstn,
+			endOnInputSize, full, 0, noDict, dst, NULL, 0);
+	if (ret < 0)
+		return 0;	/* decompression error */
+
+	return ret;
+}
+
 size_t ulz4f(const void *src, void *dst)
 {
 	/* LZ4 uses signed size parameters, so can't just use ((u32)-1) here. */
@@ -0,0 +1,47 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#ifndef COMMONLIB_BOOT_PROFILE_SERIALIZED_H
+#define COMMONLIB_BOOT_PROFILE_SERIALIZED_H
+
+#include <commonlib/bsd/helpers.h>
+#include <stdint.h>
+
+#define BOOT_PROFILE_NAME_LEN 40
+
+/* parent of an entry that is not nested in any other entry. */
+#define BOOT_PROFILE_NO_PARENT 0xffffffff
+
+enum boot_profile_type {
+	BOOT_PROFILE_STATE = 1,		/* A boot state, from entry callbacks to exit callbacks */
+	BOOT_PROFILE_PHASE,		/* Entry callbacks, state function or exit callbacks */
+	BOOT_PROFILE_CALLBACK,		/* A boot state callback */
+	BOOT_PROFILE_DEV_INIT,		/* device_operations.init */
+	BOOT_PROFILE_DEV_ENABLE,	/* device_operations.enable_resources */
+	BOOT_PROFILE_DEV_FINAL,		/* device_operations.final */
+	BOOT_PROFILE_BLOCKED,		/* A thread waiting in thread_join() or for a mutex */
+};
+
+/* The entry was never closed, e.g. the state that jumps to the payload. */
+#define BOOT_PROFILE_FLAG_OPEN		(1 << 0)
+
+struct boot_profile_entry {
+	uint64_t start_us;		/* Monotonic timer */
+	uint32_t duration_us;
+	uint32_t parent;		/* Index of the enclosing entry */
+	uint64_t addr;			/* Function called, 0 if none */
+	uint8_t type;			/* enum boot_profile_type */
+	uint8_t flags;			/* BOOT_PROFILE_FLAG_* */
+	uint8_t thread;			/* Cooperative thread the entry ran on, 0 for main */
+	uint8_t reserved;
+	char name[BOOT_PROFILE_NAME_LEN];
+} __packed;
+
+struct boot_profile_table {
+	uint32_t max_entries;
+	uint32_t num_entries;
+	uint32_t dropped;		/* Entries not recorded because the table was full */
+	uint32_t reserved;
+	struct boot_profile_entry entries[]; /* Variable number of entries, in start order */
+} __packed;
+
+#endif
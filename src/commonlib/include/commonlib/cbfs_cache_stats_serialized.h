@@ -0,0 +1,29 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#ifndef COMMONLIB_CBFS_CACHE_STATS_SERIALIZED_H
+#define COMMONLIB_CBFS_CACHE_STATS_SERIALIZED_H
+
+#include <commonlib/bsd/helpers.h>
+#include <stdint.h>
+
+#define CBFS_CACHE_STATS_STAGE_LEN 16
+#define CBFS_CACHE_STATS_MAX_STAGES 8
+
+/* Usage of one stage's cbfs_cache, taken when the stage hands over to the next program. */
+struct cbfs_cache_stats_entry {
+	char stage[CBFS_CACHE_STATS_STAGE_LEN];
+	uint32_t size;
+	uint32_t high_water;		/* Most bytes in use at the same time */
+	uint32_t peak_allocs;		/* Most allocations alive at the same time */
+	uint32_t failed_allocs;
+	uint32_t fragmented_failures;	/* Failures with enough free space in total */
+	uint32_t used;			/* Still in use at the end of the stage */
+	uint32_t largest_free;		/* Largest free block at the end of the stage */
+} __packed;
+
+struct cbfs_cache_stats_table {
+	uint32_t num_entries;
+	struct cbfs_cache_stats_entry entries[CBFS_CACHE_STATS_MAX_STAGES];
+} __packed;
+
+#endif
@@ -0,0 +1,40 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#ifndef COMMONLIB_CBFS_TRACE_SERIALIZED_H
+#define COMMONLIB_CBFS_TRACE_SERIALIZED_H
+
+#include <commonlib/bsd/helpers.h>
+#include <stdint.h>
+
+#define CBFS_TRACE_STAGE_LEN 16
+#define CBFS_TRACE_NAME_LEN 64
+
+/* The file was served from a cbfs_preload() buffer instead of the boot device. */
+#define CBFS_TRACE_FLAG_PRELOADED	(1 << 0)
+/* The file was loaded as a stage by cbfs_prog_stage_load(). */
+#define CBFS_TRACE_FLAG_STAGE		(1 << 1)
+/* The file was only mapped (cbfs_map()), not copied into a caller buffer. */
+#define CBFS_TRACE_FLAG_MAPPED		(1 << 2)
+/* Loading, decompressing or verifying the file failed. */
+#define CBFS_TRACE_FLAG_FAILED		(1 << 3)
+
+struct cbfs_trace_entry {
+	uint32_t offset;		/* Offset of the file data on the boot device */
+	uint32_t size;			/* Size of the file data on the boot device */
+	uint32_t decompressed_size;
+	uint32_t read_us;		/* Time spent reading/mapping the boot device */
+	uint32_t decompress_us;		/* Time spent verifying and decompressing */
+	uint8_t compression;		/* enum cbfs_compression */
+	uint8_t flags;			/* CBFS_TRACE_FLAG_* */
+	uint16_t reserved;
+	char stage[CBFS_TRACE_STAGE_LEN];
+	char name[CBFS_TRACE_NAME_LEN];
+} __packed;
+
+struct cbfs_trace_table {
+	uint32_t max_entries;
+	uint32_t num_entries;
+	struct cbfs_trace_entry entries[]; /* Variable number of entries, in access order */
+} __packed;
+
+#endif
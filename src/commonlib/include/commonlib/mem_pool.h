@@ -9,44 +9,58 @@
 
 /*
  * The memory pool allows one to allocate memory from a fixed size buffer that
- * also allows freeing semantics for reuse. However, the current limitation is
- * that only the two most recent allocations  can be freed (in exact reverse
- * order). If one tries to free any allocation that isn't at the top of the
- * allocation stack, or one allocates more than two buffers in a row without
- * freeing, it will result in a leak within the memory pool. (Two allocations
- * were chosen to optimize for the CBFS cache case which may need two buffers
- * to map a single compressed file, and will free them in reverse order.)
+ * also allows freeing semantics for reuse. Allocations can be freed in any
+ * order. The pool keeps a small table of live allocations sorted by address;
+ * the gaps between them are the free space, so freed neighbours coalesce
+ * without any bookkeeping inside the buffer itself. New allocations go into
+ * the lowest gap that fits them. The owner of the pool provides the table
+ * through MEM_POOL_INIT() and sizes it for the live allocations it needs;
+ * allocating beyond max_allocs fails like running out of space does.
+ *
+ * Freeing an address that doesn't belong to the pool is a no-op.
  *
  * You must ensure the backing buffer is 'alignment' aligned.
  */
 
+struct mem_pool_block {
+	uint32_t offset;
+	uint32_t size;
+};
+
 struct mem_pool {
 	uint8_t *buf;
 	size_t size;
 	size_t alignment;
-	uint8_t *last_alloc;
-	uint8_t *second_to_last_alloc;
-	size_t free_offset;
+	struct mem_pool_block *allocs;
+	size_t max_allocs;
+	size_t num_allocs;
+	/* Usage statistics, kept since the last mem_pool_init(). */
+	size_t used;
+	size_t high_water;
+	size_t peak_allocs;
+	size_t failed_allocs;
+	/* Failures that happened even though enough space was free in total. */
+	size_t fragmented_failures;
 };
 
-#define MEM_POOL_INIT(buf_, size_, alignment_)	\
-	{					\
-		.buf = (buf_),			\
-		.size = (size_),		\
-		.alignment = (alignment_),	\
-		.last_alloc = NULL,		\
-		.second_to_last_alloc = NULL,	\
-		.free_offset = 0,		\
+#define MEM_POOL_INIT(buf_, size_, alignment_, allocs_, max_allocs_)	\
+	{								\
+		.buf = (buf_),						\
+		.size = (size_),					\
+		.alignment = (alignment_),				\
+		.allocs = (allocs_),					\
+		.max_allocs = (max_allocs_),				\
+		.num_allocs = 0,					\
+		.used = 0,						\
 	}
 
 static inline void mem_pool_reset(struct mem_pool *mp)
 {
-	mp->last_alloc = NULL;
-	mp->second_to_last_alloc = NULL;
-	mp->free_offset = 0;
+	mp->num_allocs = 0;
+	mp->used = 0;
 }
 
-/* Initialize a memory pool. */
+/* Initialize a memory pool with a new buffer. It keeps the table from MEM_POOL_INIT(). */
 static inline void mem_pool_init(struct mem_pool *mp, void *buf, size_t sz,
 					 size_t alignment)
 {
@@ -56,6 +70,10 @@ static inline void mem_pool_init(struct mem_pool *mp, void *buf, size_t sz,
 	mp->buf = buf;
 	mp->size = sz;
 	mp->alignment = alignment;
+	mp->high_water = 0;
+	mp->peak_allocs = 0;
+	mp->failed_allocs = 0;
+	mp->fragmented_failures = 0;
 	mem_pool_reset(mp);
 }
 
@@ -65,4 +83,7 @@ void *mem_pool_alloc(struct mem_pool *mp, size_t sz);
 /* Free allocation from memory pool. */
 void mem_pool_free(struct mem_pool *mp, void *alloc);
 
+/* Returns the size of the largest allocation that would currently succeed. */
+size_t mem_pool_largest_free(const struct mem_pool *mp);
+
 #endif /* _MEM_POOL_H_ */
@@ -0,0 +1,54 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#ifndef COMMONLIB_PRINTK_TOKEN_SERIALIZED_H
+#define COMMONLIB_PRINTK_TOKEN_SERIALIZED_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * With CONSOLE_TOKENIZED, a printk() call writes a line of '$' followed by the base64
+ * encoded record:
+ *
+ *   uint32_t token;	little endian, printk_token_hash() of the format string
+ *   varint types;	PRINTK_ARG_* of each argument, 2 bits each, first one lowest
+ *   arguments;		integers as varint, strings as varint length and the bytes
+ *
+ * Varints are unsigned LEB128. Signed 32-bit values are sent as their 32-bit two's
+ * complement. If the record doesn't fit PRINTK_TOKEN_MAX_RECORD, arguments are left off
+ * at the end and strings are cut at PRINTK_TOKEN_MAX_STRING.
+ *
+ * The format strings are kept, NUL-terminated, in the .printk_tokens section of each
+ * stage's ELF file, which isn't loaded.
+ */
+#define PRINTK_TOKEN_PREFIX		'$'
+#define PRINTK_TOKEN_SECTION		".printk_tokens"
+#define PRINTK_TOKEN_MAX_RECORD		256
+#define PRINTK_TOKEN_MAX_STRING		128
+
+#define PRINTK_ARG_NONE			0
+#define PRINTK_ARG_32			1
+#define PRINTK_ARG_64			2
+#define PRINTK_ARG_STRING		3
+#define PRINTK_ARG_BITS			2
+#define PRINTK_MAX_ARGS			32
+
+/* Only this many characters of the format string are hashed, plus its length. */
+#define PRINTK_TOKEN_HASH_LEN		128
+#define PRINTK_TOKEN_HASH_K		65599u
+
+static inline uint32_t printk_token_hash(const char *s, size_t len)
+{
+	uint32_t hash = len;
+	uint32_t k = PRINTK_TOKEN_HASH_K;
+	size_t i;
+
+	for (i = 0; i < len && i < PRINTK_TOKEN_HASH_LEN; i++) {
+		hash += k * (uint8_t)s[i];
+		k *= PRINTK_TOKEN_HASH_K;
+	}
+
+	return hash;
+}
+
+#endif
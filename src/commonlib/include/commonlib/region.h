@@ -64,6 +64,8 @@ int rdev_chain(struct region_device *child, const struct region_device *parent,
 		size_t offset, size_t size);
 
 /* A region_device operations. */
+struct rdev_async_read;
+
 struct region_device_ops {
 	void *(*mmap)(const struct region_device *, size_t, size_t);
 	int (*munmap)(const struct region_device *, void *);
@@ -71,6 +73,13 @@ struct region_device_ops {
 	ssize_t (*writeat)(const struct region_device *, const void *, size_t,
 		size_t);
 	ssize_t (*eraseat)(const struct region_device *, size_t, size_t);
+	/*
+	 * Optional, see <rdev_async.h>. readat_async queues a read and returns
+	 * 0, or < 0 if it can't. async_poll lets controllers without completion
+	 * interrupts make progress on queued reads.
+	 */
+	int (*readat_async)(const struct region_device *, struct rdev_async_read *);
+	void (*async_poll)(const struct region_device *);
 };
 
 struct region {
@@ -59,6 +59,26 @@ enum timestamp_id {
 	TS_READ_UCODE_END = 113,
 	TS_ELOG_INIT_START = 114,
 	TS_ELOG_INIT_END = 115,
+	TS_SPD_READ_START = 116,
+	TS_SPD_PAGE0_READ = 117,
+	TS_SPD_READ_END = 118,
+	TS_MEMORY_CLEAR_START = 119,
+	TS_MEMORY_CLEAR_END = 120,
+	TS_MEMORY_TEST_START = 121,
+	TS_MEMORY_TEST_END = 122,
+	TS_MP_INIT_START = 123,
+	TS_MP_AP_SIPI_FIRST = 124,
+	TS_MP_AP_SIPI_LAST = 125,
+	TS_MP_AP_MICROCODE_FIRST = 126,
+	TS_MP_AP_MICROCODE_LAST = 127,
+	TS_MP_AP_MSRS_FIRST = 128,
+	TS_MP_AP_MSRS_LAST = 129,
+	TS_MP_AP_SMM_FIRST = 130,
+	TS_MP_AP_SMM_LAST = 131,
+	TS_MP_AP_CPU_INIT_FIRST = 132,
+	TS_MP_AP_CPU_INIT_LAST = 133,
+	TS_MP_INIT_END = 134,
+	TS_SPD_PAGE1_READ = 135,
 
 	/* 500+ reserved for vendorcode extensions (500-600: google/chromeos) */
 	TS_COPYVER_START = 501,
@@ -107,7 +127,6 @@ enum timestamp_id {
 	TS_AGESA_S3_FINAL_START = 918,
 	TS_AGESA_S3_FINAL_END = 919,
 	TS_AMD_APOB_READ_START = 920,
-	TS_AMD_APOB_ERASE_START = 921,
 	TS_AMD_APOB_WRITE_START = 922,
 	TS_AMD_APOB_END = 923,
 
@@ -236,6 +255,26 @@ static const struct timestamp_id_to_name {
 	TS_NAME_DEF(TS_READ_UCODE_END, 0, "finished reading uCode"),
 	TS_NAME_DEF(TS_ELOG_INIT_START, TS_ELOG_INIT_END, "started elog init"),
 	TS_NAME_DEF(TS_ELOG_INIT_END, 0, "finished elog init"),
+	TS_NAME_DEF(TS_SPD_READ_START, TS_SPD_READ_END, "started reading SPD over SMBus"),
+	TS_NAME_DEF(TS_SPD_PAGE0_READ, 0, "finished reading SPD page 0 of a DIMM"),
+	TS_NAME_DEF(TS_SPD_READ_END, 0, "finished reading SPD over SMBus"),
+	TS_NAME_DEF(TS_MEMORY_CLEAR_START, TS_MEMORY_CLEAR_END, "started clearing DRAM"),
+	TS_NAME_DEF(TS_MEMORY_CLEAR_END, 0, "finished clearing DRAM"),
+	TS_NAME_DEF(TS_MEMORY_TEST_START, TS_MEMORY_TEST_END, "started testing DRAM"),
+	TS_NAME_DEF(TS_MEMORY_TEST_END, 0, "finished testing DRAM"),
+	TS_NAME_DEF(TS_MP_INIT_START, TS_MP_INIT_END, "started MP init, sending INIT/SIPI"),
+	TS_NAME_DEF(TS_MP_AP_SIPI_FIRST, 0, "first AP woke up"),
+	TS_NAME_DEF(TS_MP_AP_SIPI_LAST, 0, "last AP woke up"),
+	TS_NAME_DEF(TS_MP_AP_MICROCODE_FIRST, 0, "first AP loaded microcode"),
+	TS_NAME_DEF(TS_MP_AP_MICROCODE_LAST, 0, "last AP loaded microcode"),
+	TS_NAME_DEF(TS_MP_AP_MSRS_FIRST, 0, "first AP synced MTRRs"),
+	TS_NAME_DEF(TS_MP_AP_MSRS_LAST, 0, "last AP synced MTRRs"),
+	TS_NAME_DEF(TS_MP_AP_SMM_FIRST, 0, "first AP relocated SMM"),
+	TS_NAME_DEF(TS_MP_AP_SMM_LAST, 0, "last AP relocated SMM"),
+	TS_NAME_DEF(TS_MP_AP_CPU_INIT_FIRST, 0, "first AP ran CPU init"),
+	TS_NAME_DEF(TS_MP_AP_CPU_INIT_LAST, 0, "last AP ran CPU init"),
+	TS_NAME_DEF(TS_MP_INIT_END, 0, "finished MP init"),
+	TS_NAME_DEF(TS_SPD_PAGE1_READ, 0, "finished reading SPD page 1 of a DIMM"),
 
 	/* Google related timestamps */
 	TS_NAME_DEF(TS_COPYVER_START, TS_COPYVER_START, "starting to load verstage"),
@@ -291,7 +330,6 @@ static const struct timestamp_id_to_name {
 		    "calling AmdS3FinalRestore"),
 	TS_NAME_DEF(TS_AGESA_S3_FINAL_END, 0, "back from AmdS3FinalRestore"),
 	TS_NAME_DEF(TS_AMD_APOB_READ_START, TS_AMD_APOB_END, "starting APOB read"),
-	TS_NAME_DEF(TS_AMD_APOB_ERASE_START, TS_AMD_APOB_WRITE_START, "starting APOB erase"),
 	TS_NAME_DEF(TS_AMD_APOB_WRITE_START, TS_AMD_APOB_END, "starting APOB write"),
 	TS_NAME_DEF(TS_AMD_APOB_END, 0, "finished APOB"),
 
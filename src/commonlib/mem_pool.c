@@ -2,38 +2,89 @@
 
 #include <commonlib/helpers.h>
 #include <commonlib/mem_pool.h>
+#include <string.h>
+
+/* Returns the start of the free gap in front of allocs[i] (or of the pool end for i == n). */
+static size_t gap_start(const struct mem_pool *mp, size_t i)
+{
+	if (i == 0)
+		return 0;
+	return mp->allocs[i - 1].offset + mp->allocs[i - 1].size;
+}
+
+static size_t gap_end(const struct mem_pool *mp, size_t i)
+{
+	if (i == mp->num_allocs)
+		return mp->size;
+	return mp->allocs[i].offset;
+}
 
 void *mem_pool_alloc(struct mem_pool *mp, size_t sz)
 {
-	void *p;
+	size_t i;
 
 	if (mp->alignment == 0)
 		return NULL;
 
 	/* We assume that mp->buf started mp->alignment aligned */
-	sz = ALIGN_UP(sz, mp->alignment);
+	sz = ALIGN_UP(MAX(sz, (size_t)1), mp->alignment);
 
-	/* Determine if any space available. */
-	if ((mp->size - mp->free_offset) < sz)
-		return NULL;
+	if (sz <= mp->size && mp->num_allocs < mp->max_allocs) {
+		for (i = 0; i <= mp->num_allocs; i++) {
+			const size_t start = gap_start(mp, i);
+
+			if (gap_end(mp, i) - start < sz)
+				continue;
+
+			memmove(&mp->allocs[i + 1], &mp->allocs[i],
+				(mp->num_allocs - i) * sizeof(mp->allocs[0]));
+			mp->allocs[i].offset = start;
+			mp->allocs[i].size = sz;
+			mp->num_allocs++;
 
-	p = &mp->buf[mp->free_offset];
+			mp->used += sz;
+			mp->high_water = MAX(mp->high_water, mp->used);
+			mp->peak_allocs = MAX(mp->peak_allocs, mp->num_allocs);
 
-	mp->free_offset += sz;
-	mp->second_to_last_alloc = mp->last_alloc;
-	mp->last_alloc = p;
+			return &mp->buf[start];
+		}
+	}
 
-	return p;
+	mp->failed_allocs++;
+	if (mp->size - mp->used >= sz)
+		mp->fragmented_failures++;
+
+	return NULL;
 }
 
 void mem_pool_free(struct mem_pool *mp, void *p)
 {
-	/* Determine if p was the most recent allocation. */
-	if (p == NULL || mp->last_alloc != p)
+	const uintptr_t addr = (uintptr_t)p;
+	const uintptr_t base = (uintptr_t)mp->buf;
+	size_t i;
+
+	/* Determine if p was allocated from this pool. */
+	if (p == NULL || addr < base || addr >= base + mp->size)
+		return;
+
+	for (i = 0; i < mp->num_allocs; i++) {
+		if (mp->allocs[i].offset != addr - base)
+			continue;
+
+		mp->used -= mp->allocs[i].size;
+		mp->num_allocs--;
+		memmove(&mp->allocs[i], &mp->allocs[i + 1],
+			(mp->num_allocs - i) * sizeof(mp->allocs[0]));
 		return;
+	}
+}
+
+size_t mem_pool_largest_free(const struct mem_pool *mp)
+{
+	size_t i, largest = 0;
+
+	for (i = 0; i <= mp->num_allocs; i++)
+		largest = MAX(largest, gap_end(mp, i) - gap_start(mp, i));
 
-	mp->free_offset = mp->last_alloc - mp->buf;
-	mp->last_alloc = mp->second_to_last_alloc;
-	/* No way to track allocation before this one. */
-	mp->second_to_last_alloc = NULL;
+	return largest;
 }
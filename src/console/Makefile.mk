@@ -4,6 +4,7 @@ ramstage-y += vtxprintf.c printk.c vsprintf.c
 ramstage-y += init.c console.c
 ramstage-y += post.c
 ramstage-y += die.c
+ramstage-$(CONFIG_CONSOLE_ASYNC) += async.c
 ifeq ($(CONFIG_HWBASE_DEBUG_CB),y)
 ramstage-$(CONFIG_RAMSTAGE_LIBHWBASE) += hw-debug_sink.ads
 ramstage-$(CONFIG_RAMSTAGE_LIBHWBASE) += hw-debug_sink.adb
@@ -42,3 +43,23 @@ bootblock-y += post.c
 bootblock-y += die.c
 
 decompressor-y += die.c
+
+ifeq ($(CONFIG_CONSOLE_TOKENIZED),y)
+printk-token-stages := ramstage
+printk-token-stages += $(if $(CONFIG_BOOTBLOCK_CONSOLE),bootblock)
+printk-token-stages += $(if $(CONFIG_SEPARATE_ROMSTAGE),romstage)
+printk-token-stages += $(if $(CONFIG_POSTCAR_CONSOLE),postcar)
+printk-token-stages += $(if $(CONFIG_VBOOT_SEPARATE_VERSTAGE),verstage)
+
+# The printk() format strings of all stages, NUL-separated, for `cbmem -k`.
+$(obj)/printk_tokens.db: $(foreach stage,$(printk-token-stages),$(objcbfs)/$(stage).debug)
+	printf "    PRINTK     $(subst $(obj)/,,$(@))\n"
+	rm -f $@.tmp
+	$(foreach stage,$(printk-token-stages), \
+		$(OBJCOPY_$(stage)) --dump-section .printk_tokens=$@.$(stage) \
+			$(objcbfs)/$(stage).debug /dev/null && \
+		cat $@.$(stage) >> $@.tmp && rm -f $@.$(stage) && ) true
+	mv $@.tmp $@
+
+build_complete:: $(obj)/printk_tokens.db
+endif
@@ -0,0 +1,98 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <bootstate.h>
+#include <console/async.h>
+#include <console/streams.h>
+#include <smp/spinlock.h>
+#include <types.h>
+
+/*
+ * Output for the interactive consoles is queued here instead of waiting for e.g. a UART
+ * at 115200 baud inside printk(). The idle thread writes it out while all other threads
+ * wait, the rest is written out before ramstage hands off to the payload or OS.
+ *
+ * async_lock is held while a byte is written out, so that bytes from printk() on
+ * another CPU or from a concurrent drain can't overtake it.
+ */
+DECLARE_SPIN_LOCK(async_lock)
+
+static u8 buffer[CONFIG_CONSOLE_ASYNC_BUFFER_SIZE];
+static size_t head;
+static size_t count;
+static bool stopped;
+
+static void drain_byte(void)
+{
+	const u8 byte = buffer[head];
+
+	head = (head + 1) % sizeof(buffer);
+	count--;
+	console_interactive_hw_tx_byte(byte);
+}
+
+bool console_async_active(void)
+{
+	return !stopped;
+}
+
+bool console_async_tx_byte(unsigned char byte)
+{
+	spin_lock(&async_lock);
+
+	if (stopped) {
+		spin_unlock(&async_lock);
+		return false;
+	}
+
+	/* Rather than losing output, make room the slow way. */
+	if (count == sizeof(buffer))
+		drain_byte();
+
+	buffer[(head + count) % sizeof(buffer)] = byte;
+	count++;
+
+	spin_unlock(&async_lock);
+
+	return true;
+}
+
+size_t console_async_drain(size_t max_bytes)
+{
+	size_t drained = 0;
+	bool empty = false;
+
+	while (drained < max_bytes && !empty) {
+		spin_lock(&async_lock);
+		if (count) {
+			drain_byte();
+			drained++;
+		}
+		empty = !count;
+		spin_unlock(&async_lock);
+	}
+
+	/* Consoles that send packets (e.g. USB debug) hold on to a partial one until then. */
+	if (drained && empty)
+		console_interactive_hw_tx_flush();
+
+	return drained;
+}
+
+void console_async_flush(void)
+{
+	spin_lock(&async_lock);
+	while (count)
+		drain_byte();
+	stopped = true;
+	spin_unlock(&async_lock);
+
+	console_interactive_hw_tx_flush();
+}
+
+static void console_async_flush_cb(void *unused)
+{
+	console_async_flush();
+}
+
+BOOT_STATE_INIT_ENTRY(BS_OS_RESUME, BS_ON_ENTRY, console_async_flush_cb, NULL);
+BOOT_STATE_INIT_ENTRY(BS_PAYLOAD_BOOT, BS_ON_ENTRY, console_async_flush_cb, NULL);
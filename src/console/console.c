@@ -1,5 +1,6 @@
 /* SPDX-License-Identifier: GPL-2.0-only */
 
+#include <console/async.h>
 #include <console/cbmem_console.h>
 #include <console/flash.h>
 #include <console/i2c_smbus.h>
@@ -32,7 +33,7 @@ void console_hw_init(void)
 	__simnow_console_init();
 }
 
-void console_interactive_tx_byte(unsigned char byte, void *data_unused)
+void console_interactive_hw_tx_byte(unsigned char byte)
 {
 	if (byte == '\n') {
 		/* Some consoles want newline conversion to keep terminals happy. */
@@ -52,6 +53,12 @@ void console_interactive_tx_byte(unsigned char byte, void *data_unused)
 	__simnow_console_tx_byte(byte);
 }
 
+void console_interactive_tx_byte(unsigned char byte, void *data_unused)
+{
+	if (!console_async_tx_byte(byte))
+		console_interactive_hw_tx_byte(byte);
+}
+
 void console_stored_tx_byte(unsigned char byte, void *data_unused)
 {
 	__flashconsole_tx_byte(byte);
@@ -64,15 +71,22 @@ void console_tx_byte(unsigned char byte)
 	console_stored_tx_byte(byte, NULL);
 }
 
-void console_tx_flush(void)
+void console_interactive_hw_tx_flush(void)
 {
 	__uart_tx_flush();
 	__ne2k_tx_flush();
 	__usb_tx_flush();
-	__flashconsole_tx_flush();
 	__system76_ec_tx_flush();
 }
 
+void console_tx_flush(void)
+{
+	/* Queued output is flushed once it has been written out. */
+	if (!console_async_active())
+		console_interactive_hw_tx_flush();
+	__flashconsole_tx_flush();
+}
+
 void console_write_line(uint8_t *buffer, size_t number_of_bytes)
 {
 	/* Finish displaying all of the console data if requested */
@@ -1,5 +1,6 @@
 /* SPDX-License-Identifier: GPL-2.0-only */
 
+#include <console/async.h>
 #include <console/console.h>
 #include <halt.h>
 #include <stdarg.h>
@@ -23,6 +24,8 @@ void __noreturn die(const char *fmt, ...)
 	vprintk(BIOS_EMERG, fmt, args);
 	va_end(args);
 
+	console_async_flush();
+
 	die_notify();
 	halt();
 }
@@ -4,12 +4,14 @@
  * blatantly copied from linux/kernel/printk.c
  */
 
+#include <commonlib/printk_token_serialized.h>
 #include <console/cbmem_console.h>
 #include <console/console.h>
 #include <console/streams.h>
 #include <console/vtxprintf.h>
 #include <smp/spinlock.h>
 #include <smp/node.h>
+#include <string.h>
 #include <timer.h>
 #include <types.h>
 
@@ -153,7 +155,8 @@ int vprintk(int msg_level, const char *fmt, va_list args)
 	return i;
 }
 
-int printk(int msg_level, const char *fmt, ...)
+/* In parentheses, so that this is also defined if printk() is the tokenizing macro. */
+int (printk)(int msg_level, const char *fmt, ...)
 {
 	va_list args;
 	int i;
@@ -164,3 +167,126 @@ int printk(int msg_level, const char *fmt, ...)
 
 	return i;
 }
+
+#if CONSOLE_TOKENIZED_ENABLED
+static size_t put_varint(uint8_t *p, uint64_t val)
+{
+	size_t n = 0;
+
+	do {
+		p[n] = val & 0x7f;
+		val >>= 7;
+		if (val)
+			p[n] |= 0x80;
+		n++;
+	} while (val);
+
+	return n;
+}
+
+/* Fill the record, see commonlib/printk_token_serialized.h. Returns its length. */
+static size_t encode_record(uint8_t *rec, uint32_t token, uint64_t arg_types, va_list args)
+{
+	/* Room for the largest varint, so each argument can be checked before it's added. */
+	const size_t limit = PRINTK_TOKEN_MAX_RECORD - 10;
+	uint64_t types = arg_types, sent_types = 0;
+	uint8_t arg_buf[PRINTK_TOKEN_MAX_RECORD];
+	size_t arg_len = 0, types_len, n, i;
+	uint8_t tmp[10];
+	const char *s;
+	uint64_t val;
+
+	/* The type varint goes before the arguments, so they're collected separately. */
+	types_len = put_varint(tmp, arg_types);
+
+	for (i = 0; types && i < PRINTK_MAX_ARGS; i++, types >>= PRINTK_ARG_BITS) {
+		const unsigned int type = types & ((1 << PRINTK_ARG_BITS) - 1);
+
+		if (type == PRINTK_ARG_STRING) {
+			s = va_arg(args, const char *);
+			if (!s)
+				s = "<NULL>";
+			n = strnlen(s, PRINTK_TOKEN_MAX_STRING);
+			if (4 + types_len + arg_len + 2 + n > limit)
+				break;
+			arg_len += put_varint(&arg_buf[arg_len], n);
+			memcpy(&arg_buf[arg_len], s, n);
+			arg_len += n;
+		} else {
+			if (type == PRINTK_ARG_64)
+				val = va_arg(args, unsigned long long);
+			else
+				val = va_arg(args, unsigned int);
+			if (4 + types_len + arg_len > limit)
+				break;
+			arg_len += put_varint(&arg_buf[arg_len], val);
+		}
+		sent_types |= (uint64_t)type << (i * PRINTK_ARG_BITS);
+	}
+
+	rec[0] = token;
+	rec[1] = token >> 8;
+	rec[2] = token >> 16;
+	rec[3] = token >> 24;
+	n = 4 + put_varint(&rec[4], sent_types);
+	memcpy(&rec[n], arg_buf, arg_len);
+
+	return n + arg_len;
+}
+
+static void put_base64(const uint8_t *data, size_t len, void *state)
+{
+	static const char digits[] =
+		"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+	uint32_t v;
+	size_t i;
+
+	for (i = 0; i < len; i += 3) {
+		v = data[i] << 16;
+		if (i + 1 < len)
+			v |= data[i + 1] << 8;
+		if (i + 2 < len)
+			v |= data[i + 2];
+
+		wrap_putchar(digits[(v >> 18) & 0x3f], state);
+		wrap_putchar(digits[(v >> 12) & 0x3f], state);
+		wrap_putchar(i + 1 < len ? digits[(v >> 6) & 0x3f] : '=', state);
+		wrap_putchar(i + 2 < len ? digits[v & 0x3f] : '=', state);
+	}
+}
+
+int printk_tokenized(int msg_level, uint32_t token, uint64_t arg_types, ...)
+{
+	union log_state state = { .level = msg_level };
+	uint8_t rec[PRINTK_TOKEN_MAX_RECORD];
+	va_list args;
+	size_t len;
+
+	if (CONFIG(SQUELCH_EARLY_SMP) && ENV_ROMSTAGE_OR_BEFORE && !boot_cpu())
+		return 0;
+
+	state.speed = console_log_level(msg_level);
+	if (state.speed < CONSOLE_LOG_FAST)
+		return 0;
+
+	va_start(args, arg_types);
+	len = encode_record(rec, token, arg_types, args);
+	va_end(args);
+
+	spin_lock(&console_lock);
+
+	console_time_run();
+
+	wrap_putchar(PRINTK_TOKEN_PREFIX, state.as_ptr);
+	put_base64(rec, len, state.as_ptr);
+	wrap_putchar('\n', state.as_ptr);
+	if (LOG_FAST(state))
+		console_tx_flush();
+
+	console_time_stop();
+
+	spin_unlock(&console_lock);
+
+	return len;
+}
+#endif
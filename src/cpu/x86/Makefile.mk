@@ -25,6 +25,9 @@ endif
 
 $(call src-to-obj,ramstage,$(dir)/mp_init.c): $(obj)/ramstage/cpu/x86/smm_start32_offset.h
 ramstage-$(CONFIG_PARALLEL_MP) += mp_init.c
+ramstage-$(CONFIG_MP_TASK_POOL) += mp_task.c
+ramstage-$(CONFIG_MP_MEM_PARALLEL) += mp_mem.c
+ramstage-$(CONFIG_CBFS_LZ4_PARALLEL) += lz4_parallel.c
 
 ramstage-y += backup_default_smm.c
 ramstage-y += smi_trigger.c
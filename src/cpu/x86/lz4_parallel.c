@@ -0,0 +1,129 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <cbfs.h>
+#include <commonlib/bsd/compression.h>
+#include <commonlib/helpers.h>
+#include <console/console.h>
+#include <cpu/cpu.h>
+#include <cpu/x86/mp.h>
+#include <smp/atomic.h>
+#include <smp/spinlock.h>
+#include <timer.h>
+#include <types.h>
+
+/*
+ * Decompresses the independent blocks of an LZ4 frame on the BSP and all APs that are
+ * waiting for work. Blocks are handed out through a shared counter, so slow and fast CPUs
+ * balance themselves. The job lives in BSS rather than on the BSP stack because an AP that
+ * accepts the callback late may still look at it after the BSP has returned.
+ */
+struct lz4_parallel_job {
+	const void *src;
+	size_t srcn;
+	void *dst;
+	size_t dstn;
+	const struct cbfs_file_attr_lz4_blocks *index;
+	uint32_t block_size;
+	uint32_t num_blocks;
+	uint32_t next_block;
+	size_t last_block_size;
+	atomic_t blocks_done;
+	atomic_t errors;
+};
+
+static struct lz4_parallel_job job;
+DECLARE_SPIN_LOCK(job_lock);
+
+static bool take_block(uint32_t *block)
+{
+	bool ret = false;
+
+	spin_lock(&job_lock);
+	if (job.next_block < job.num_blocks) {
+		*block = job.next_block++;
+		ret = true;
+	}
+	spin_unlock(&job_lock);
+
+	return ret;
+}
+
+static void lz4_block_worker(void *unused)
+{
+	uint32_t i;
+
+	while (take_block(&i)) {
+		const uint32_t start = be32toh(job.index->offsets[i]);
+		const uint32_t end = i + 1 < job.num_blocks ?
+			be32toh(job.index->offsets[i + 1]) : job.srcn;
+		const size_t out_offset = (size_t)i * job.block_size;
+		size_t out_size = 0;
+
+		if (start < end && end <= job.srcn && out_offset < job.dstn)
+			out_size = ulz4_block(job.src + start, end - start, job.dst + out_offset,
+					      MIN(job.block_size, job.dstn - out_offset));
+
+		if (i + 1 < job.num_blocks) {
+			if (out_size != job.block_size)
+				atomic_inc(&job.errors);
+		} else {
+			if (!out_size)
+				atomic_inc(&job.errors);
+			job.last_block_size = out_size;
+		}
+
+		atomic_inc(&job.blocks_done);
+	}
+}
+
+size_t _cbfs_lz4_parallel_decompress(const void *src, size_t srcn, void *dst, size_t dstn,
+				     const struct cbfs_file_attr_lz4_blocks *index)
+{
+	const uint32_t num_blocks = be32toh(index->num_blocks);
+	const uint32_t block_size = be32toh(index->block_size);
+	struct stopwatch sw;
+
+	if (be32toh(index->len) < sizeof(*index) + num_blocks * sizeof(index->offsets[0]) ||
+	    !num_blocks || !block_size) {
+		printk(BIOS_ERR, "LZ4: invalid block index\n");
+		return 0;
+	}
+
+	/* Blocks are written out of order, which in-place decompression cannot handle. */
+	if (!mp_aps_accept_work() || (src < dst + dstn && dst < src + srcn))
+		return ulz4fn(src, srcn, dst, dstn);
+
+	job.src = src;
+	job.srcn = srcn;
+	job.dst = dst;
+	job.dstn = dstn;
+	job.index = index;
+	job.block_size = block_size;
+	job.last_block_size = 0;
+	atomic_set(&job.blocks_done, 0);
+	atomic_set(&job.errors, 0);
+	spin_lock(&job_lock);
+	job.next_block = 0;
+	job.num_blocks = num_blocks;
+	spin_unlock(&job_lock);
+
+	stopwatch_init(&sw);
+
+	/* If the APs don't pick the job up, the BSP below just does all of the work. */
+	if (mp_run_on_aps(lz4_block_worker, NULL, MP_RUN_ON_ALL_CPUS,
+			  100 * USECS_PER_MSEC) != CB_SUCCESS)
+		printk(BIOS_WARNING, "LZ4: APs did not accept work, decompressing on BSP\n");
+
+	lz4_block_worker(NULL);
+
+	while (atomic_read(&job.blocks_done) < num_blocks)
+		cpu_relax();
+
+	printk(BIOS_DEBUG, "LZ4: %u blocks decompressed in parallel in %lld us\n",
+	       num_blocks, stopwatch_duration_usecs(&sw));
+
+	if (atomic_read(&job.errors))
+		return 0;
+
+	return (size_t)(num_blocks - 1) * block_size + job.last_block_size;
+}
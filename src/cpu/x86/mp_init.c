@@ -14,7 +14,9 @@
 #include <cpu/x86/mtrr.h>
 #include <cpu/x86/smm.h>
 #include <cpu/x86/topology.h>
+#include <cpu/x86/tsc.h>
 #include <cpu/x86/mp.h>
+#include <cpu/x86/mp_task.h>
 #include <delay.h>
 #include <device/device.h>
 #include <device/path.h>
@@ -23,6 +25,7 @@
 #include <symbols.h>
 #include <timer.h>
 #include <thread.h>
+#include <timestamp.h>
 #include <types.h>
 
 /* Generated header */
@@ -94,11 +97,13 @@ struct sipi_params {
 	uint32_t stack_top;
 	uint32_t stack_size;
 	uint32_t microcode_lock; /* 0xffffffff means parallel loading. */
+	uint32_t microcode_lock_shift;
 	uint32_t microcode_ptr;
 	uint32_t msr_table_ptr;
 	uint32_t msr_count;
 	uint32_t c_handler;
 	uint32_t cr3;
+	uint32_t phase_tsc;
 	atomic_t ap_count;
 } __packed;
 
@@ -126,6 +131,27 @@ struct mp_flight_plan {
 static int global_num_aps;
 static struct mp_flight_plan mp_info;
 
+/*
+ * The TSC when each CPU got through each part of MP init. The SIPI vector stamps the first
+ * two rows, so their layout has to match phase_tsc there.
+ */
+enum mp_phase {
+	MP_PHASE_SIPI,		/* Woke up in the SIPI vector. */
+	MP_PHASE_MICROCODE,	/* Loaded microcode. */
+	MP_PHASE_MSRS,		/* Copied the BSP's MTRRs and entered ap_init(). */
+	MP_PHASE_SMM,		/* Relocated SMM. */
+	MP_PHASE_CPU_INIT,	/* Ran the CPU driver init. */
+	MP_NUM_PHASES
+};
+
+static uint64_t phase_tsc[MP_NUM_PHASES][CONFIG_MAX_CPUS];
+
+static void record_phase(enum mp_phase phase, unsigned long cpu)
+{
+	if (cpu < CONFIG_MAX_CPUS)
+		phase_tsc[phase][cpu] = rdtscll();
+}
+
 static inline void barrier_wait(atomic_t *b)
 {
 	while (atomic_read(b) == 0)
@@ -183,6 +209,8 @@ static struct bus *g_cpu_bus;
  * been loaded. */
 static asmlinkage void ap_init(unsigned int index)
 {
+	record_phase(MP_PHASE_MSRS, index);
+
 	/* Ensure the local APIC is enabled */
 	enable_lapic();
 	setup_lapic_interrupts();
@@ -357,12 +385,19 @@ static atomic_t *load_sipi_vector(struct mp_params *mp_params)
 	/* Provide pointer to microcode patch. */
 	sp->microcode_ptr = (uintptr_t)mp_params->microcode_pointer;
 	/* Pass on ability to load microcode in parallel. */
-	if (mp_params->parallel_microcode_load)
+	sp->microcode_lock = 0;
+	sp->microcode_lock_shift = 31;
+	if (mp_params->parallel_microcode_load == MP_MICROCODE_PER_PACKAGE) {
+		unsigned int shift;
+
+		if (get_cpu_package_shift(&shift) == CB_SUCCESS)
+			sp->microcode_lock_shift = MIN(shift, 31);
+	} else if (mp_params->parallel_microcode_load) {
 		sp->microcode_lock = ~0;
-	else
-		sp->microcode_lock = 0;
+	}
 	sp->c_handler = (uintptr_t)&ap_init;
 	sp->cr3 = read_cr3();
+	sp->phase_tsc = (uintptr_t)phase_tsc;
 	ap_count = &sp->ap_count;
 	atomic_set(ap_count, 0);
 
@@ -545,6 +580,52 @@ static enum cb_err bsp_do_flight_plan(struct mp_params *mp_params)
 	return ret;
 }
 
+/* Add timestamps for the first and the last AP to get through each part of MP init. */
+static void report_ap_phases(int num_aps)
+{
+	static const struct {
+		const char *name;
+		enum timestamp_id first;
+		enum timestamp_id last;
+	} phases[MP_NUM_PHASES] = {
+		[MP_PHASE_SIPI] = { "SIPI", TS_MP_AP_SIPI_FIRST, TS_MP_AP_SIPI_LAST },
+		[MP_PHASE_MICROCODE] = { "microcode", TS_MP_AP_MICROCODE_FIRST,
+					 TS_MP_AP_MICROCODE_LAST },
+		[MP_PHASE_MSRS] = { "MTRR sync", TS_MP_AP_MSRS_FIRST, TS_MP_AP_MSRS_LAST },
+		[MP_PHASE_SMM] = { "SMM relocation", TS_MP_AP_SMM_FIRST, TS_MP_AP_SMM_LAST },
+		[MP_PHASE_CPU_INIT] = { "CPU init", TS_MP_AP_CPU_INIT_FIRST,
+					TS_MP_AP_CPU_INIT_LAST },
+	};
+	const int mhz = timestamp_tick_freq_mhz();
+	uint64_t first, last;
+	int phase, cpu;
+
+	if (!CONFIG(COLLECT_TIMESTAMPS_TSC) || num_aps < 1)
+		return;
+
+	num_aps = MIN(num_aps, CONFIG_MAX_CPUS - 1);
+
+	for (phase = 0; phase < MP_NUM_PHASES; phase++) {
+		first = UINT64_MAX;
+		last = 0;
+		for (cpu = 1; cpu <= num_aps; cpu++) {
+			/* APs that didn't get there. */
+			if (!phase_tsc[phase][cpu])
+				continue;
+			first = MIN(first, phase_tsc[phase][cpu]);
+			last = MAX(last, phase_tsc[phase][cpu]);
+		}
+		if (!last)
+			continue;
+
+		timestamp_add(phases[phase].first, first);
+		timestamp_add(phases[phase].last, last);
+		if (mhz)
+			printk(BIOS_DEBUG, "MP init: %s done on all APs within %llu us\n",
+			       phases[phase].name, (last - first) / mhz);
+	}
+}
+
 static enum cb_err init_bsp(struct bus *cpu_bus)
 {
 	struct cpu_info *info;
@@ -599,6 +680,7 @@ static enum cb_err mp_init(struct bus *cpu_bus, struct mp_params *p)
 {
 	int num_cpus;
 	atomic_t *ap_count;
+	enum cb_err ret;
 
 	g_cpu_bus = cpu_bus;
 
@@ -635,6 +717,8 @@ static enum cb_err mp_init(struct bus *cpu_bus, struct mp_params *p)
 	if (ap_count == NULL)
 		return CB_ERR;
 
+	timestamp_add_now(TS_MP_INIT_START);
+
 	/* Start the APs providing number of APs and the cpus_entered field. */
 	global_num_aps = p->num_cpus - 1;
 	if (start_aps(cpu_bus, global_num_aps, ap_count) != CB_SUCCESS) {
@@ -645,7 +729,12 @@ static enum cb_err mp_init(struct bus *cpu_bus, struct mp_params *p)
 	}
 
 	/* Walk the flight plan for the BSP. */
-	return bsp_do_flight_plan(p);
+	ret = bsp_do_flight_plan(p);
+
+	report_ap_phases(global_num_aps);
+	timestamp_add_now(TS_MP_INIT_END);
+
+	return ret;
 }
 
 void smm_initiate_relocation_parallel(void)
@@ -849,6 +938,18 @@ static void trigger_smm_relocation(void)
 	mp_state.ops.per_cpu_smm_trigger();
 }
 
+static void ap_smm_relocation(void)
+{
+	trigger_smm_relocation();
+	record_phase(MP_PHASE_SMM, cpu_index());
+}
+
+static void ap_initialize(void)
+{
+	cpu_initialize();
+	record_phase(MP_PHASE_CPU_INIT, cpu_index());
+}
+
 static struct mp_callback *ap_callbacks[CONFIG_MAX_CPUS];
 
 enum AP_STATUS {
@@ -859,6 +960,7 @@ enum AP_STATUS {
 };
 
 static atomic_t ap_status[CONFIG_MAX_CPUS];
+static bool aps_accept_work;
 
 static struct mp_callback *read_callback(struct mp_callback **slot)
 {
@@ -968,7 +1070,8 @@ static void ap_wait_for_instruction(void)
 		struct mp_callback *cb = read_callback(per_cpu_slot);
 
 		if (cb == NULL) {
-			asm ("pause");
+			if (!mp_task_run_one())
+				asm ("pause");
 			continue;
 		}
 		/*
@@ -1029,6 +1132,11 @@ enum cb_err mp_run_on_all_aps(void (*func)(void *), void *arg, long expire_us,
 	return CB_SUCCESS;
 }
 
+bool mp_aps_accept_work(void)
+{
+	return aps_accept_work;
+}
+
 enum cb_err mp_run_on_all_cpus(void (*func)(void *), void *arg)
 {
 	/* Run on BSP first. */
@@ -1056,6 +1164,10 @@ enum cb_err mp_park_aps(void)
 
 	stopwatch_init(&sw);
 
+	/* The APs won't look at the task pool anymore. */
+	mp_task_wait_all();
+
+	aps_accept_work = false;
 	ret = mp_run_on_aps(park_this_cpu, NULL, MP_RUN_ON_ALL_CPUS,
 				1000 * USECS_PER_MSEC);
 
@@ -1075,13 +1187,23 @@ static struct mp_flight_record mp_steps[] = {
 	/* Once the APs are up load the SMM handlers. */
 	MP_FR_BLOCK_APS(NULL, load_smm_handlers),
 	/* Perform SMM relocation. */
-	MP_FR_NOBLOCK_APS(trigger_smm_relocation, trigger_smm_relocation),
+	MP_FR_NOBLOCK_APS(ap_smm_relocation, trigger_smm_relocation),
 	/* Initialize each CPU through the driver framework. */
-	MP_FR_BLOCK_APS(cpu_initialize, cpu_initialize),
+	MP_FR_BLOCK_APS(ap_initialize, cpu_initialize),
 	/* Wait for APs to finish then optionally start looking for work. */
 	MP_FR_BLOCK_APS(ap_wait_for_instruction, NULL),
 };
 
+/*
+ * With MP_PARALLEL_FLIGHT_PLAN the SMM handlers are loaded before the APs are started,
+ * so the APs only wait for each other at the end.
+ */
+static struct mp_flight_record mp_steps_parallel[] = {
+	MP_FR_NOBLOCK_APS(ap_smm_relocation, trigger_smm_relocation),
+	MP_FR_NOBLOCK_APS(ap_initialize, cpu_initialize),
+	MP_FR_BLOCK_APS(ap_wait_for_instruction, NULL),
+};
+
 static void fill_mp_state_smm(struct mp_state *state, const struct mp_ops *ops)
 {
 	if (ops->get_smm_info != NULL)
@@ -1151,18 +1273,31 @@ static enum cb_err do_mp_init_with_smm(struct bus *cpu_bus, const struct mp_ops
 	if (mp_state.ops.get_microcode_info != NULL)
 		mp_state.ops.get_microcode_info(&mp_params.microcode_pointer,
 			&mp_params.parallel_microcode_load);
-	mp_params.flight_plan = &mp_steps[0];
-	mp_params.num_records = ARRAY_SIZE(mp_steps);
+	if (CONFIG(MP_PARALLEL_FLIGHT_PLAN)) {
+		mp_params.flight_plan = &mp_steps_parallel[0];
+		mp_params.num_records = ARRAY_SIZE(mp_steps_parallel);
+	} else {
+		mp_params.flight_plan = &mp_steps[0];
+		mp_params.num_records = ARRAY_SIZE(mp_steps);
+	}
 
 	/* Perform backup of default SMM area when using SMM relocation handler. */
 	if (!CONFIG(X86_SMM_SKIP_RELOCATION_HANDLER))
 		default_smm_area = backup_default_smm_area();
 
+	/* The relocation handler at SMM_DEFAULT_BASE + 0x8000 is clear of the SIPI vector. */
+	if (CONFIG(MP_PARALLEL_FLIGHT_PLAN))
+		load_smm_handlers();
+
 	ret = mp_init(cpu_bus, &mp_params);
 
 	if (!CONFIG(X86_SMM_SKIP_RELOCATION_HANDLER))
 		restore_default_smm_area(default_smm_area);
 
+	/* The last flight record leaves the APs in ap_wait_for_instruction(). */
+	if (ret == CB_SUCCESS && CONFIG(PARALLEL_MP_AP_WORK))
+		aps_accept_work = true;
+
 	/* Signal callback on success if it's provided. */
 	if (ret == CB_SUCCESS && mp_state.ops.post_mp_init != NULL)
 		mp_state.ops.post_mp_init();
@@ -0,0 +1,262 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <cbmem.h>
+#include <commonlib/helpers.h>
+#include <console/console.h>
+#include <cpu/x86/mp_mem.h>
+#include <cpu/x86/mp_task.h>
+#include <cpu/x86/pae.h>
+#include <memrange.h>
+#include <smp/spinlock.h>
+#include <symbols.h>
+#include <timer.h>
+#include <timestamp.h>
+#include <types.h>
+
+#define CHUNK_SIZE	(2 * MiB)
+
+/* Whether a 32-bit stage has to map memory above 4 GiB to reach it. */
+#define NEEDS_MAPPING	(sizeof(resource_t) != sizeof(void *))
+
+/*
+ * One task per CPU takes chunks through a shared cursor until there are none left, so a
+ * CPU that is busy with other tasks or slow to start just ends up clearing less.
+ */
+struct mem_job {
+	unsigned long tag;
+	bool test;
+	/* The next chunk starts at offset into entry. */
+	const struct range_entry *entry;
+	resource_t offset;
+	uint32_t num_chunks;
+	bool unmapped;
+	/* Words that read back wrong and the first of them. */
+	uint64_t bad_words;
+	uint64_t first_bad;
+};
+
+static struct mem_job job;
+static struct mp_task tasks[CONFIG_MAX_CPUS];
+DECLARE_SPIN_LOCK(job_lock);
+
+static void skip_entries(void)
+{
+	while (job.entry && (range_entry_tag(job.entry) != job.tag ||
+			     job.offset >= range_entry_size(job.entry))) {
+		job.entry = job.entry->next;
+		job.offset = 0;
+	}
+}
+
+/* Take the next chunk, which never crosses a 2 MiB boundary. */
+static bool take_chunk(uint64_t *base, size_t *size)
+{
+	bool ret = false;
+
+	spin_lock(&job_lock);
+	skip_entries();
+	if (job.entry) {
+		*base = range_entry_base(job.entry) + job.offset;
+		*size = MIN(range_entry_end(job.entry), ALIGN_DOWN(*base, CHUNK_SIZE) +
+			    CHUNK_SIZE) - *base;
+		job.offset += *size;
+		ret = true;
+	}
+	spin_unlock(&job_lock);
+
+	return ret;
+}
+
+static void *map_chunk(uint64_t base)
+{
+	void *page;
+
+	if (!NEEDS_MAPPING)
+		return (void *)(uintptr_t)base;
+
+	page = map_2M_page(base / CHUNK_SIZE);
+	if (page == MAPPING_ERROR)
+		return NULL;
+
+	return page + base % CHUNK_SIZE;
+}
+
+/* The address pattern, folded so it differs between words in all 4 GiB windows. */
+static inline uintptr_t address_pattern(uint64_t addr)
+{
+	return (uintptr_t)addr ^ (uintptr_t)(addr >> 32);
+}
+
+/*
+ * Non-temporal stores go to memory through the write-combining buffers without reading
+ * the lines into the caches first, which would only evict everything else. MOVNTI works
+ * on general purpose registers, so it needs no SSE state.
+ */
+static void fill_nt(uintptr_t *p, size_t words, uint64_t addr, bool pattern, uintptr_t xor)
+{
+	for (size_t i = 0; i < words; i++, addr += sizeof(*p)) {
+		const uintptr_t v = (pattern ? address_pattern(addr) : 0) ^ xor;
+
+		asm volatile ("movnti %1, %0" : "=m" (p[i]) : "r" (v));
+	}
+	asm volatile ("sfence" ::: "memory");
+}
+
+static uint64_t check(const uintptr_t *p, size_t words, uint64_t addr, uintptr_t xor,
+		      uint64_t *first_bad)
+{
+	uint64_t bad = 0;
+
+	for (size_t i = 0; i < words; i++, addr += sizeof(*p)) {
+		if (p[i] == (address_pattern(addr) ^ xor))
+			continue;
+		if (!bad++)
+			*first_bad = addr;
+	}
+
+	return bad;
+}
+
+static void mem_worker(void *unused)
+{
+	uint64_t base, first_bad = 0, bad = 0;
+	size_t size;
+	uintptr_t *p;
+
+	while (take_chunk(&base, &size)) {
+		const size_t words = size / sizeof(*p);
+
+		p = map_chunk(base);
+		if (p && job.test) {
+			fill_nt(p, words, base, true, 0);
+			bad += check(p, words, base, 0, &first_bad);
+			fill_nt(p, words, base, true, ~(uintptr_t)0);
+			bad += check(p, words, base, ~(uintptr_t)0, &first_bad);
+		}
+		if (p)
+			fill_nt(p, words, base, false, 0);
+		else
+			job.unmapped = true;
+	}
+
+	/* Leave paging disabled again. */
+	if (NEEDS_MAPPING)
+		map_2M_page(0);
+
+	if (!bad)
+		return;
+
+	spin_lock(&job_lock);
+	if (!job.bad_words || first_bad < job.first_bad)
+		job.first_bad = first_bad;
+	job.bad_words += bad;
+	spin_unlock(&job_lock);
+}
+
+/*
+ * map_2M_page() maps memory above 4 GiB into the upper 2 GiB of the address space, so
+ * everything a CPU touches while it works has to be below that.
+ */
+static bool reachable(const struct memranges *mem, unsigned long tag)
+{
+	const struct range_entry *r;
+
+	if (!NEEDS_MAPPING)
+		return true;
+
+	if ((uintptr_t)_eprogram <= 2ULL * GiB && (uintptr_t)cbmem_top() <= 2ULL * GiB)
+		return true;
+
+	memranges_each_entry(r, mem) {
+		if (range_entry_tag(r) == tag && range_entry_end(r) > 4ULL * GiB)
+			return false;
+	}
+
+	return true;
+}
+
+static enum cb_err run_job(const struct memranges *mem, unsigned long tag, bool test)
+{
+	const struct range_entry *r;
+	uint64_t bytes = 0;
+	struct stopwatch sw;
+	int64_t usecs;
+	uint64_t rate;
+	size_t i;
+
+	job.bad_words = 0;
+	job.first_bad = 0;
+
+	if (!reachable(mem, tag)) {
+		printk(BIOS_ERR, "%s: coreboot is above 2 GiB, can't map memory above 4 GiB\n",
+		       __func__);
+		return CB_ERR_ARG;
+	}
+
+	job.tag = tag;
+	job.test = test;
+	job.num_chunks = 0;
+	job.unmapped = false;
+
+	memranges_each_entry(r, mem) {
+		if (range_entry_tag(r) != tag)
+			continue;
+		job.num_chunks += (ALIGN_UP(range_entry_end(r), CHUNK_SIZE) -
+				   ALIGN_DOWN(range_entry_base(r), CHUNK_SIZE)) / CHUNK_SIZE;
+		bytes += range_entry_size(r);
+	}
+
+	spin_lock(&job_lock);
+	job.entry = mem->entries;
+	job.offset = 0;
+	spin_unlock(&job_lock);
+
+	stopwatch_init(&sw);
+
+	/* Without APs in the task pool, the first task runs right away and does everything. */
+	for (i = 0; i < MIN(job.num_chunks, ARRAY_SIZE(tasks)); i++)
+		mp_task_submit(&tasks[i], mem_worker, NULL);
+
+	mp_task_wait_all();
+
+	usecs = MAX(stopwatch_duration_usecs(&sw), 1);
+	rate = (bytes / MiB) * 100 * USECS_PER_SEC / 1024 / usecs;
+	printk(BIOS_DEBUG, "%s %llu MiB in %lld ms (%llu.%02llu GiB/s)\n",
+	       test ? "Tested" : "Cleared", bytes / MiB, usecs / USECS_PER_MSEC,
+	       rate / 100, rate % 100);
+
+	if (job.unmapped) {
+		printk(BIOS_ERR, "%s: Failed to map memory\n", __func__);
+		return CB_ERR;
+	}
+
+	return CB_SUCCESS;
+}
+
+enum cb_err mp_mem_clear(const struct memranges *mem, unsigned long tag)
+{
+	enum cb_err ret;
+
+	timestamp_add_now(TS_MEMORY_CLEAR_START);
+	ret = run_job(mem, tag, false);
+	timestamp_add_now(TS_MEMORY_CLEAR_END);
+
+	return ret;
+}
+
+enum cb_err mp_mem_test(const struct memranges *mem, unsigned long tag, uint64_t *bad_words)
+{
+	enum cb_err ret;
+
+	timestamp_add_now(TS_MEMORY_TEST_START);
+	ret = run_job(mem, tag, true);
+	timestamp_add_now(TS_MEMORY_TEST_END);
+
+	if (job.bad_words)
+		printk(BIOS_ERR, "Memory test: %llu bad words, the first at 0x%llx\n",
+		       job.bad_words, job.first_bad);
+
+	*bad_words = job.bad_words;
+
+	return ret;
+}
@@ -0,0 +1,149 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <arch/cpu.h>
+#include <commonlib/helpers.h>
+#include <cpu/x86/mp.h>
+#include <cpu/x86/mp_task.h>
+#include <types.h>
+
+#define QUEUE_SIZE	CONFIG_MP_TASK_QUEUE_SIZE
+
+_Static_assert(!(QUEUE_SIZE & (QUEUE_SIZE - 1)), "MP_TASK_QUEUE_SIZE must be a power of 2");
+
+/*
+ * Per-CPU work-stealing deque (Chase and Lev, with the memory ordering of Le et al.):
+ * only the owning CPU pushes and pops at the bottom, the other CPUs steal from the top.
+ * top and bottom never wrap around, they index the ring modulo QUEUE_SIZE.
+ */
+struct task_queue {
+	long top;
+	long bottom;
+	struct mp_task *tasks[QUEUE_SIZE];
+} __aligned(CACHELINE_SIZE);
+
+static struct task_queue queues[CONFIG_MAX_CPUS];
+
+/* Tasks submitted but not done yet. */
+static int pending;
+
+static bool queue_push(struct task_queue *q, struct mp_task *task)
+{
+	const long b = __atomic_load_n(&q->bottom, __ATOMIC_RELAXED);
+	const long t = __atomic_load_n(&q->top, __ATOMIC_ACQUIRE);
+
+	if (b - t >= QUEUE_SIZE)
+		return false;
+
+	__atomic_store_n(&q->tasks[b % QUEUE_SIZE], task, __ATOMIC_RELAXED);
+	__atomic_store_n(&q->bottom, b + 1, __ATOMIC_RELEASE);
+
+	return true;
+}
+
+static struct mp_task *queue_pop(struct task_queue *q)
+{
+	const long b = __atomic_load_n(&q->bottom, __ATOMIC_RELAXED) - 1;
+	struct mp_task *task;
+	long t;
+
+	__atomic_store_n(&q->bottom, b, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	t = __atomic_load_n(&q->top, __ATOMIC_RELAXED);
+
+	if (t > b) {
+		/* Empty. */
+		__atomic_store_n(&q->bottom, b + 1, __ATOMIC_RELAXED);
+		return NULL;
+	}
+
+	task = __atomic_load_n(&q->tasks[b % QUEUE_SIZE], __ATOMIC_RELAXED);
+	if (t == b) {
+		/* The last task, which a thief might be taking at the same time. */
+		if (!__atomic_compare_exchange_n(&q->top, &t, t + 1, false, __ATOMIC_SEQ_CST,
+						 __ATOMIC_RELAXED))
+			task = NULL;
+		__atomic_store_n(&q->bottom, b + 1, __ATOMIC_RELAXED);
+	}
+
+	return task;
+}
+
+static struct mp_task *queue_steal(struct task_queue *q)
+{
+	long t = __atomic_load_n(&q->top, __ATOMIC_ACQUIRE);
+	struct mp_task *task;
+	long b;
+
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	b = __atomic_load_n(&q->bottom, __ATOMIC_ACQUIRE);
+
+	if (t >= b)
+		return NULL;
+
+	task = __atomic_load_n(&q->tasks[t % QUEUE_SIZE], __ATOMIC_RELAXED);
+	if (!__atomic_compare_exchange_n(&q->top, &t, t + 1, false, __ATOMIC_SEQ_CST,
+					 __ATOMIC_RELAXED))
+		return NULL;
+
+	return task;
+}
+
+static void run_task(struct mp_task *task)
+{
+	task->func(task->arg);
+	__atomic_store_n(&task->done, 1, __ATOMIC_RELEASE);
+	__atomic_fetch_sub(&pending, 1, __ATOMIC_RELEASE);
+}
+
+void mp_task_submit(struct mp_task *task, void (*func)(void *arg), void *arg)
+{
+	const unsigned long cpu = cpu_index();
+
+	task->func = func;
+	task->arg = arg;
+	task->done = 0;
+	__atomic_fetch_add(&pending, 1, __ATOMIC_RELAXED);
+
+	/* Without APs to share the work with, there's no point in queueing it. */
+	if (!mp_aps_accept_work() || cpu >= ARRAY_SIZE(queues) ||
+	    !queue_push(&queues[cpu], task))
+		run_task(task);
+}
+
+bool mp_task_run_one(void)
+{
+	const unsigned long cpu = cpu_index();
+	struct mp_task *task;
+	size_t i;
+
+	if (cpu >= ARRAY_SIZE(queues))
+		return false;
+
+	task = queue_pop(&queues[cpu]);
+
+	/* Start with the next CPU, so the thieves don't all go for the same queue. */
+	for (i = 1; !task && i < ARRAY_SIZE(queues); i++)
+		task = queue_steal(&queues[(cpu + i) % ARRAY_SIZE(queues)]);
+
+	if (!task)
+		return false;
+
+	run_task(task);
+	return true;
+}
+
+void mp_task_join(struct mp_task *task)
+{
+	while (!__atomic_load_n(&task->done, __ATOMIC_ACQUIRE)) {
+		if (!mp_task_run_one())
+			asm volatile ("pause");
+	}
+}
+
+void mp_task_wait_all(void)
+{
+	while (__atomic_load_n(&pending, __ATOMIC_ACQUIRE)) {
+		if (!mp_task_run_one())
+			asm volatile ("pause");
+	}
+}
@@ -61,6 +61,17 @@ static enum cb_err get_cpu_core_thread_bits(uint32_t *core_bits, uint32_t *threa
 	return CB_SUCCESS;
 }
 
+enum cb_err get_cpu_package_shift(unsigned int *shift)
+{
+	uint32_t core_bits, thread_bits;
+
+	if (get_cpu_core_thread_bits(&core_bits, &thread_bits) != CB_SUCCESS)
+		return CB_ERR;
+
+	*shift = core_bits + thread_bits;
+	return CB_SUCCESS;
+}
+
 static void set_cpu_topology(struct device *cpu, unsigned int node,
 		      unsigned int package, unsigned int core,
 		      unsigned int thread)
@@ -4,6 +4,7 @@
  * Originally based on the Linux kernel (arch/i386/kernel/pci-pc.c).
  */
 
+#include <boot_profile.h>
 #include <console/console.h>
 #include <device/device.h>
 #include <device/pci_def.h>
@@ -12,6 +13,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <smp/spinlock.h>
+#include <thread.h>
 #include <timer.h>
 
 /** Pointer to the last device */
@@ -337,8 +339,13 @@ static void enable_resources(struct bus *link)
 
 	for (dev = link->children; dev; dev = dev->sibling) {
 		if (dev->enabled && dev->ops && dev->ops->enable_resources) {
+			int prof;
+
 			post_log_path(dev);
+			prof = boot_profile_begin(BOOT_PROFILE_DEV_ENABLE, dev_path(dev),
+						  (uintptr_t)dev->ops->enable_resources);
 			dev->ops->enable_resources(dev);
+			boot_profile_end(prof);
 		}
 	}
 
@@ -544,6 +551,7 @@ static void init_dev(struct device *dev)
 	if (!dev->initialized && dev->ops && dev->ops->init) {
 		struct stopwatch sw;
 		long init_time;
+		int prof;
 
 		if (dev->path.type == DEVICE_PATH_I2C) {
 			printk(BIOS_DEBUG, "smbus: %s->", dev_path(dev->upstream->dev));
@@ -553,7 +561,10 @@ static void init_dev(struct device *dev)
 
 		stopwatch_init(&sw);
 		dev->initialized = 1;
+		prof = boot_profile_begin(BOOT_PROFILE_DEV_INIT, dev_path(dev),
+					  (uintptr_t)dev->ops->init);
 		dev->ops->init(dev);
+		boot_profile_end(prof);
 
 		init_time = stopwatch_duration_msecs(&sw);
 		printk(BIOS_DEBUG, "%s init finished in %ld msecs\n", dev_path(dev),
@@ -576,6 +587,253 @@ static void init_link(struct bus *link)
 			init_link(dev->downstream);
 }
 
+#if CONFIG(PARALLEL_DEVICE_INIT)
+
+enum init_state {
+	INIT_PENDING,
+	INIT_RUNNING,
+	INIT_DONE,
+};
+
+struct init_node {
+	struct device *dev;
+	/* Closest ancestor with an init() to wait for. */
+	struct init_node *parent;
+	enum init_state state;
+	long start_us;
+	long end_us;
+	/* Longest chain of dependent inits ending with this one. */
+	long path_us;
+	struct init_node *path_prev;
+};
+
+static struct init_node *init_nodes;
+static size_t init_node_count;
+static size_t init_nodes_pending;
+static struct mono_time init_base;
+
+static long init_time_us(void)
+{
+	struct mono_time now;
+
+	timer_monotonic_get(&now);
+	return mono_time_diff_microseconds(&init_base, &now);
+}
+
+static struct init_node *find_node(const struct device *dev)
+{
+	size_t i;
+
+	for (i = 0; init_nodes && i < init_node_count; i++) {
+		if (init_nodes[i].dev == dev)
+			return &init_nodes[i];
+	}
+	return NULL;
+}
+
+/* Same order as init_link(), so without any concurrency the result is the same. */
+static void collect_link(struct bus *link, struct init_node *parent)
+{
+	struct init_node *node;
+	struct device *dev;
+
+	for (dev = link->children; dev; dev = dev->sibling) {
+		if (!dev->enabled || dev->initialized || !dev->ops || !dev->ops->init)
+			continue;
+		if (init_nodes) {
+			node = &init_nodes[init_node_count];
+			node->dev = dev;
+			node->parent = parent;
+			node->state = INIT_PENDING;
+		}
+		init_node_count++;
+	}
+
+	for (dev = link->children; dev; dev = dev->sibling) {
+		if (!dev->downstream)
+			continue;
+		node = find_node(dev);
+		collect_link(dev->downstream, node ? node : parent);
+	}
+}
+
+static void for_each_dep(struct init_node *node,
+			 void (*func)(struct init_node *node, struct init_node *dep, void *arg),
+			 void *arg)
+{
+	struct device *const *after;
+	struct init_node *dep;
+
+	if (node->parent)
+		func(node, node->parent, arg);
+
+	for (after = node->dev->init_after; after && *after; after++) {
+		dep = find_node(*after);
+		if (dep)
+			func(node, dep, arg);
+	}
+}
+
+static void check_dep_done(struct init_node *node, struct init_node *dep, void *arg)
+{
+	bool *ready = arg;
+
+	if (dep->state != INIT_DONE)
+		*ready = false;
+}
+
+static void extend_path(struct init_node *node, struct init_node *dep, void *arg)
+{
+	if (dep->state != INIT_DONE)
+		return;
+	if (!node->path_prev || dep->path_us > node->path_prev->path_us)
+		node->path_prev = dep;
+}
+
+/* Returns the first device whose dependencies are all initialized. */
+static struct init_node *next_node(void)
+{
+	struct init_node *pending = NULL;
+	bool running = false;
+	bool ready;
+	size_t i;
+
+	for (i = 0; i < init_node_count; i++) {
+		if (init_nodes[i].state == INIT_RUNNING)
+			running = true;
+		if (init_nodes[i].state != INIT_PENDING)
+			continue;
+
+		ready = true;
+		for_each_dep(&init_nodes[i], check_dep_done, &ready);
+		if (ready)
+			return &init_nodes[i];
+		if (!pending)
+			pending = &init_nodes[i];
+	}
+
+	if (pending && !running) {
+		printk(BIOS_ERR, "%s: circular init dependency, initializing anyway\n",
+		       dev_path(pending->dev));
+		return pending;
+	}
+
+	return NULL;
+}
+
+static void run_node(struct init_node *node)
+{
+	node->state = INIT_RUNNING;
+	init_nodes_pending--;
+
+	post_code(POSTCODE_BS_DEV_INIT);
+	post_log_path(node->dev);
+
+	node->start_us = init_time_us();
+	init_dev(node->dev);
+	node->end_us = init_time_us();
+
+	for_each_dep(node, extend_path, NULL);
+	node->path_us = node->end_us - node->start_us;
+	if (node->path_prev)
+		node->path_us += node->path_prev->path_us;
+
+	node->state = INIT_DONE;
+}
+
+static enum cb_err init_worker(void *unused)
+{
+	struct init_node *node;
+
+	while (init_nodes_pending) {
+		node = next_node();
+		if (node)
+			run_node(node);
+		else
+			thread_yield();
+	}
+
+	return CB_SUCCESS;
+}
+
+static void report_critical_path(long wall_us)
+{
+	struct init_node *node, *last = NULL;
+	long total_us = 0;
+	size_t i;
+
+	for (i = 0; i < init_node_count; i++) {
+		node = &init_nodes[i];
+		total_us += node->end_us - node->start_us;
+		if (!last || node->path_us > last->path_us)
+			last = node;
+	}
+
+	if (!last)
+		return;
+
+	printk(BIOS_INFO, "Device init took %ld ms for %ld ms of init methods\n",
+	       wall_us / USECS_PER_MSEC, total_us / USECS_PER_MSEC);
+	printk(BIOS_INFO, "Critical path of %ld ms, last device first:\n",
+	       last->path_us / USECS_PER_MSEC);
+	for (node = last; node; node = node->path_prev)
+		printk(BIOS_INFO, "  %s: %ld ms\n", dev_path(node->dev),
+		       (node->end_us - node->start_us) / USECS_PER_MSEC);
+}
+
+/*
+ * Run device init methods on several cooperative threads. Whenever one init waits in
+ * udelay() or yields otherwise, another thread picks up the next device whose parent
+ * and the devices listed with `init_after` in the devicetree are already initialized.
+ */
+static bool init_parallel(void)
+{
+	struct thread_handle workers[CONFIG_PARALLEL_DEVICE_INIT_THREADS];
+	size_t i, started = 0;
+
+	if (!dev_root.downstream)
+		return true;
+
+	collect_link(dev_root.downstream, NULL);
+	init_nodes = calloc(init_node_count, sizeof(*init_nodes));
+	if (!init_nodes)
+		return false;
+
+	init_node_count = 0;
+	collect_link(dev_root.downstream, NULL);
+	init_nodes_pending = init_node_count;
+
+	timer_monotonic_get(&init_base);
+
+	for (i = 0; i < ARRAY_SIZE(workers); i++) {
+		if (thread_run(&workers[started], init_worker, NULL) < 0)
+			break;
+		started++;
+	}
+
+	init_worker(NULL);
+
+	for (i = 0; i < started; i++)
+		thread_join(&workers[i]);
+
+	report_critical_path(init_time_us());
+
+	free(init_nodes);
+	init_nodes = NULL;
+	init_node_count = 0;
+
+	return true;
+}
+
+#else
+
+static bool init_parallel(void)
+{
+	return false;
+}
+
+#endif
+
 /**
  * Initialize all devices in the global device tree.
  *
@@ -590,7 +848,7 @@ void dev_initialize(void)
 	init_dev(&dev_root);
 
 	/* Now initialize everything. */
-	if (dev_root.downstream)
+	if (!init_parallel() && dev_root.downstream)
 		init_link(dev_root.downstream);
 	post_log_clear();
 
@@ -613,8 +871,13 @@ static void final_dev(struct device *dev)
 		return;
 
 	if (dev->ops && dev->ops->final) {
+		int prof;
+
 		printk(BIOS_DEBUG, "%s final\n", dev_path(dev));
+		prof = boot_profile_begin(BOOT_PROFILE_DEV_FINAL, dev_path(dev),
+					  (uintptr_t)dev->ops->final);
 		dev->ops->final(dev);
+		boot_profile_end(prof);
 	}
 }
 
@@ -691,6 +691,51 @@ static int elog_sync_to_nv(void)
 	return 0;
 }
 
+/*
+ * With ELOG_DEFERRED_SYNC, events are only added to the mirror and the flash
+ * catches up in a single write from elog_flush(). Events that typically
+ * precede the system going down, and everything logged at runtime from SMM,
+ * are still written right away.
+ */
+static bool elog_event_needs_sync(u8 event_type)
+{
+	if (!CONFIG(ELOG_DEFERRED_SYNC) || ENV_SMM)
+		return true;
+
+	switch (event_type) {
+	case ELOG_TYPE_POST_ERR:
+	case ELOG_TYPE_CPU_FAIL:
+	case ELOG_TYPE_OS_EVENT:
+	case ELOG_TYPE_EC_SHUTDOWN:
+	case ELOG_TYPE_THERM_TRIP:
+	case ELOG_TYPE_CR50_NEED_RESET:
+	case ELOG_TYPE_PSR_DATA_LOST:
+		return true;
+	default:
+		return false;
+	}
+}
+
+#if CONFIG(ELOG_DEFERRED_SYNC) && !ENV_SMM
+/*
+ * Commit deferred events to flash. Called before handing off to the next
+ * stage or the payload, on OS resume and before a board reset.
+ */
+int elog_flush(void)
+{
+	if (elog_state.elog_initialized != ELOG_INITIALIZED)
+		return 0;
+
+	if (!elog_nv_needs_update())
+		return 0;
+
+	elog_debug("%s(offset=0x%zx size=0x%zx)\n", __func__, elog_state.nv_last_write,
+		   elog_state.mirror_last_write - elog_state.nv_last_write);
+
+	return elog_sync_to_nv();
+}
+#endif
+
 /*
  * Do not log boot count events in S3 resume or SMM.
  */
@@ -852,6 +897,9 @@ int elog_add_event_raw(u8 event_type, void *data, u8 data_size)
 	if (elog_shrink() < 0)
 		return -1;
 
+	if (!elog_event_needs_sync(event_type))
+		return 0;
+
 	/* Ensure the updates hit the non-volatile storage. */
 	return elog_sync_to_nv();
 }
@@ -899,3 +947,7 @@ int elog_add_extended_event(u8 type, u32 complement)
 /* Make sure elog_init() runs at least once to log System Boot event. */
 static void elog_bs_init(void *unused) { elog_init(); }
 BOOT_STATE_INIT_ENTRY(BS_POST_DEVICE, BS_ON_ENTRY, elog_bs_init, NULL);
+
+static void elog_bs_flush(void *unused) { elog_flush(); }
+BOOT_STATE_INIT_ENTRY(BS_WRITE_TABLES, BS_ON_EXIT, elog_bs_flush, NULL);
+BOOT_STATE_INIT_ENTRY(BS_OS_RESUME, BS_ON_ENTRY, elog_bs_flush, NULL);
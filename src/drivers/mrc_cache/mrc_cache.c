@@ -4,6 +4,8 @@
 #include <boot_device.h>
 #include <bootstate.h>
 #include <bootmode.h>
+#include <cbfs.h>
+#include <commonlib/bsd/compression.h>
 #include <console/console.h>
 #include <cbmem.h>
 #include <elog.h>
@@ -13,6 +15,7 @@
 #include <security/vboot/mrc_cache_hash_tpm.h>
 #include <security/vboot/vboot_common.h>
 #include <spi_flash.h>
+#include <stdlib.h>
 #include <xxhash.h>
 
 #include "mrc_cache.h"
@@ -24,17 +27,31 @@
 
 /* Signature "MRCD" was used for older header format before CB:67670. */
 #define MRC_DATA_SIGNATURE       (('M'<<0)|('R'<<8)|('C'<<16)|('d'<<24))
+/* Slots holding an LZ4F image of the data (MRC_CACHE_COMPRESS). */
+#define MRC_DATA_SIGNATURE_LZ4   (('M'<<0)|('R'<<8)|('C'<<16)|('z'<<24))
 
 static const uint32_t mrc_invalid_sig = ~MRC_DATA_SIGNATURE;
 
+/*
+ * For compressed slots data_size is the size of the LZ4F image, while data_hash and
+ * uncompressed_size describe the data after decompression. Uncompressed slots and
+ * the cbmem stash only use the header up to and excluding uncompressed_size, so
+ * they keep the layout older firmware wrote and reads.
+ */
 struct mrc_metadata {
 	uint32_t signature;
 	uint32_t data_size;
 	uint32_t data_hash;
 	uint32_t header_hash;
 	uint32_t version;
+	uint32_t uncompressed_size;
 } __packed;
 
+#define MRC_PLAIN_METADATA_SIZE	offsetof(struct mrc_metadata, uncompressed_size)
+
+/* LZ4 in-place decompression needs the input to end this far behind the output. */
+#define LZ4_INPLACE_MARGIN(csize)	(((csize) >> 8) + 32)
+
 enum result {
 	UPDATE_FAILURE		= -1,
 	UPDATE_SUCCESS		= 0,
@@ -122,6 +139,22 @@ _Static_assert(!CONFIG(MRC_SAVE_HASH_IN_TPM) ||
 	       CONFIG(VBOOT_STARTS_IN_BOOTBLOCK),
 	       "for TPM MRC hash functionality, vboot must start in bootblock");
 
+static bool mrc_compressed(const struct mrc_metadata *md)
+{
+	return md->signature == MRC_DATA_SIGNATURE_LZ4;
+}
+
+static size_t mrc_metadata_size(const struct mrc_metadata *md)
+{
+	return mrc_compressed(md) ? sizeof(*md) : MRC_PLAIN_METADATA_SIZE;
+}
+
+/* Size of the data as handed to and from the memory init code. */
+static size_t mrc_data_size(const struct mrc_metadata *md)
+{
+	return mrc_compressed(md) ? md->uncompressed_size : md->data_size;
+}
+
 static int lookup_region_by_name(const char *name, struct region *r)
 {
 	if (fmap_locate_area(name, r) == 0)
@@ -174,7 +207,7 @@ static int mrc_header_valid(struct region_device *rdev, struct mrc_metadata *md)
 	uint32_t hash_result;
 	size_t size;
 
-	if (rdev_readat(rdev, md, 0, sizeof(*md)) < 0) {
+	if (rdev_readat(rdev, md, 0, MRC_PLAIN_METADATA_SIZE) < 0) {
 		/* When the metadata was invalidated intentionally (for example from the
 		   previous recovery boot), print a warning instead of an error. */
 		if (rdev_readat(rdev, md, 0, sizeof(mrc_invalid_sig)) >= 0 &&
@@ -187,15 +220,22 @@ static int mrc_header_valid(struct region_device *rdev, struct mrc_metadata *md)
 		return -1;
 	}
 
-	if (md->signature != MRC_DATA_SIGNATURE) {
+	if (md->signature != MRC_DATA_SIGNATURE && md->signature != MRC_DATA_SIGNATURE_LZ4) {
 		printk(BIOS_ERR, "MRC: invalid header signature\n");
 		return -1;
 	}
 
+	if (mrc_compressed(md) &&
+	    rdev_readat(rdev, &md->uncompressed_size, MRC_PLAIN_METADATA_SIZE,
+			sizeof(md->uncompressed_size)) < 0) {
+		printk(BIOS_ERR, "MRC: couldn't read metadata\n");
+		return -1;
+	}
+
 	/* Compute hash over header with 0 as the value. */
 	hash = md->header_hash;
 	md->header_hash = 0;
-	hash_result = xxh32(md, sizeof(*md), 0);
+	hash_result = xxh32(md, mrc_metadata_size(md), 0);
 
 	if (hash != hash_result) {
 		printk(BIOS_ERR, "MRC: header hash mismatch: %x vs %x\n",
@@ -208,7 +248,7 @@ static int mrc_header_valid(struct region_device *rdev, struct mrc_metadata *md)
 
 	/* Re-size the region device according to the metadata as a region_file
 	 * does block allocation. */
-	size = sizeof(*md) + md->data_size;
+	size = mrc_metadata_size(md) + md->data_size;
 	if (rdev_chain(rdev, rdev, 0, size) < 0) {
 		printk(BIOS_ERR, "MRC: size exceeds rdev size: %zx vs %zx\n",
 			size, region_device_sz(rdev));
@@ -228,7 +268,7 @@ static int mrc_data_valid(int type, const struct mrc_metadata *md,
 	if (cr == NULL)
 		return -1;
 
-	if (md->data_size != data_size)
+	if (mrc_data_size(md) != data_size)
 		return -1;
 
 	hash_idx = cr->tpm_hash_index;
@@ -255,6 +295,8 @@ static int mrc_cache_get_latest_slot_info(const char *name,
 				struct region_device *rdev,
 				bool fail_bad_data)
 {
+	memset(md, 0, sizeof(*md));
+
 	/* Init and obtain a handle to the file data. */
 	if (region_file_init(cache_file, backing_rdev) < 0) {
 		printk(BIOS_ERR, "MRC: region file invalid in '%s'\n", name);
@@ -273,8 +315,10 @@ static int mrc_cache_get_latest_slot_info(const char *name,
 
 	/* Validate header and resize region to reflect actual usage on the
 	 * saved medium (including metadata and data). */
-	if (mrc_header_valid(rdev, md) < 0)
+	if (mrc_header_valid(rdev, md) < 0) {
+		memset(md, 0, sizeof(*md));
 		return fail_bad_data ? -1 : 0;
+	}
 
 	return 0;
 }
@@ -288,7 +332,6 @@ static int mrc_cache_find_current(int type, uint32_t version,
 	struct region_device read_rdev;
 	struct region_file cache_file;
 	size_t data_size;
-	const size_t md_size = sizeof(*md);
 	const bool fail_bad_data = true;
 
 	/*
@@ -323,7 +366,49 @@ static int mrc_cache_find_current(int type, uint32_t version,
 
 	/* Re-size rdev to only contain the data. i.e. remove metadata. */
 	data_size = md->data_size;
-	return rdev_chain(rdev, rdev, md_size, data_size);
+	return rdev_chain(rdev, rdev, mrc_metadata_size(md), data_size);
+}
+
+/*
+ * Decompress the LZ4F image in rdev into buffer. Where the boot device isn't memory
+ * mapped, the image is read to the end of the caller's buffer and decompressed in
+ * place, so no scratch space is needed as long as the buffer has a little slack.
+ */
+static ssize_t mrc_decompress(const struct region_device *rdev,
+			      const struct mrc_metadata *md, void *buffer,
+			      size_t buffer_size)
+{
+	const size_t in_size = region_device_sz(rdev);
+	const size_t out_size = md->uncompressed_size;
+	void *in;
+	size_t size;
+
+	if (buffer_size < out_size)
+		return -1;
+
+	if (!CONFIG(BOOT_DEVICE_MEMORY_MAPPED) &&
+	    buffer_size >= out_size + LZ4_INPLACE_MARGIN(in_size) &&
+	    buffer_size >= in_size) {
+		in = buffer + buffer_size - in_size;
+		if (rdev_readat(rdev, in, 0, in_size) != in_size)
+			return -1;
+		size = ulz4fn(in, in_size, buffer, out_size);
+	} else {
+		in = rdev_mmap_full(rdev);
+		if (in == NULL) {
+			printk(BIOS_INFO, "MRC: mmap failure.\n");
+			return -1;
+		}
+		size = ulz4fn(in, in_size, buffer, out_size);
+		rdev_munmap(rdev, in);
+	}
+
+	if (size != out_size) {
+		printk(BIOS_ERR, "MRC: decompression failed\n");
+		return -1;
+	}
+
+	return size;
 }
 
 ssize_t mrc_cache_load_current(int type, uint32_t version, void *buffer,
@@ -336,12 +421,18 @@ ssize_t mrc_cache_load_current(int type, uint32_t version, void *buffer,
 	if (mrc_cache_find_current(type, version, &rdev, &md) < 0)
 		return -1;
 
-	data_size = region_device_sz(&rdev);
-	if (buffer_size < data_size)
-		return -1;
+	if (mrc_compressed(&md)) {
+		data_size = mrc_decompress(&rdev, &md, buffer, buffer_size);
+		if (data_size < 0)
+			return -1;
+	} else {
+		data_size = region_device_sz(&rdev);
+		if (buffer_size < data_size)
+			return -1;
 
-	if (rdev_readat(&rdev, buffer, 0, data_size) != data_size)
-		return -1;
+		if (rdev_readat(&rdev, buffer, 0, data_size) != data_size)
+			return -1;
+	}
 
 	if (mrc_data_valid(type, &md, buffer, data_size) < 0)
 		return -1;
@@ -360,16 +451,33 @@ void *mrc_cache_current_mmap_leak(int type, uint32_t version,
 	if (mrc_cache_find_current(type, version, &rdev, &md) < 0)
 		return NULL;
 
-	region_device_size = region_device_sz(&rdev);
-	if (data_size)
-		*data_size = region_device_size;
-	data = rdev_mmap_full(&rdev);
+	if (mrc_compressed(&md)) {
+		/* The caller keeps using the data, so it has to live in the cbfs_cache. */
+		region_device_size = md.uncompressed_size;
+		data = mem_pool_alloc(&cbfs_cache, region_device_size);
+		if (data == NULL) {
+			printk(BIOS_ERR, "MRC: no cbfs_cache space to decompress %zu bytes\n",
+			       region_device_size);
+			return NULL;
+		}
 
-	if (data == NULL) {
-		printk(BIOS_INFO, "MRC: mmap failure.\n");
-		return NULL;
+		if (mrc_decompress(&rdev, &md, data, region_device_size) < 0) {
+			mem_pool_free(&cbfs_cache, data);
+			return NULL;
+		}
+	} else {
+		region_device_size = region_device_sz(&rdev);
+		data = rdev_mmap_full(&rdev);
+
+		if (data == NULL) {
+			printk(BIOS_INFO, "MRC: mmap failure.\n");
+			return NULL;
+		}
 	}
 
+	if (data_size)
+		*data_size = region_device_size;
+
 	if (mrc_data_valid(type, &md, data, region_device_size) < 0)
 		return NULL;
 
@@ -377,13 +485,25 @@ void *mrc_cache_current_mmap_leak(int type, uint32_t version,
 }
 
 static bool mrc_cache_needs_update(const struct region_device *rdev,
+				   const struct mrc_metadata *old_md,
 				   const struct mrc_metadata *new_md,
 				   size_t new_data_size)
 {
 	void *mapping;
-	size_t old_data_size = region_device_sz(rdev) - sizeof(struct mrc_metadata);
+	size_t old_data_size;
 	bool need_update = false;
 
+	/*
+	 * Compressed slots are compared by the version, hash and size of the data they
+	 * decompress to, as the compressed image itself isn't reproduced here.
+	 */
+	if (mrc_compressed(old_md))
+		return !CONFIG(MRC_CACHE_COMPRESS) ||
+			old_md->version != new_md->version ||
+			old_md->data_hash != new_md->data_hash ||
+			old_md->uncompressed_size != new_data_size;
+
+	old_data_size = region_device_sz(rdev) - MRC_PLAIN_METADATA_SIZE;
 	if (new_data_size != old_data_size)
 		return true;
 
@@ -397,7 +517,7 @@ static bool mrc_cache_needs_update(const struct region_device *rdev,
 	 * Compare the old and new metadata only. If the data hashes don't
 	 * match, the comparison will fail.
 	 */
-	if (memcmp(new_md, mapping, sizeof(struct mrc_metadata)))
+	if (memcmp(new_md, mapping, MRC_PLAIN_METADATA_SIZE))
 		need_update = true;
 
 	rdev_munmap(rdev, mapping);
@@ -405,6 +525,43 @@ static bool mrc_cache_needs_update(const struct region_device *rdev,
 	return need_update;
 }
 
+/*
+ * Compress new_data into a newly allocated buffer and fill in lz4_md to match.
+ * Returns the compressed size, or 0 if the data should be stored as is.
+ */
+static size_t mrc_compress(const struct mrc_metadata *new_md, const void *new_data,
+			   size_t new_data_size, struct mrc_metadata *lz4_md,
+			   void **lz4_data)
+{
+	size_t size;
+
+	if (!CONFIG(MRC_CACHE_COMPRESS) || !ENV_RAMSTAGE)
+		return 0;
+
+	*lz4_data = malloc(new_data_size);
+	if (*lz4_data == NULL)
+		return 0;
+
+	size = lz4f_compress(new_data, new_data_size, *lz4_data, new_data_size);
+	if (size == 0) {
+		printk(BIOS_DEBUG, "MRC: data doesn't compress, storing it as is.\n");
+		return 0;
+	}
+
+	*lz4_md = (struct mrc_metadata){
+		.signature = MRC_DATA_SIGNATURE_LZ4,
+		.data_size = size,
+		.data_hash = new_md->data_hash,
+		.version = new_md->version,
+		.uncompressed_size = new_data_size,
+	};
+	lz4_md->header_hash = xxh32(lz4_md, sizeof(*lz4_md), 0);
+
+	printk(BIOS_DEBUG, "MRC: compressed %zu bytes to %zu.\n", new_data_size, size);
+
+	return size;
+}
+
 static void log_event_cache_update(uint8_t slot, enum result res)
 {
 	const int type = ELOG_TYPE_MEM_CACHE_UPDATE;
@@ -448,6 +605,10 @@ static void update_mrc_cache_by_type(int type,
 	struct region_device latest_rdev;
 	const bool fail_bad_data = false;
 	uint32_t hash_idx;
+	struct mrc_metadata lz4_md;
+	void *lz4_data = NULL;
+	size_t lz4_size = 0;
+	bool needs_update;
 
 	cr = lookup_region(&region, type);
 
@@ -482,9 +643,19 @@ static void update_mrc_cache_by_type(int type,
 
 		return;
 
-	if (!mrc_cache_needs_update(&latest_rdev, new_md, new_data_size)) {
+	needs_update = mrc_cache_needs_update(&latest_rdev, &md, new_md, new_data_size);
+
+	/*
+	 * Uncompressed slots with current data get converted if the data compresses,
+	 * at the cost of another attempt each boot when it doesn't.
+	 */
+	if (needs_update || !mrc_compressed(&md))
+		lz4_size = mrc_compress(new_md, new_data, new_data_size, &lz4_md, &lz4_data);
+
+	if (!needs_update && !lz4_size) {
 		printk(BIOS_DEBUG, "MRC: '%s' does not need update.\n", cr->name);
 		log_event_cache_update(cr->elog_slot, ALREADY_UPTODATE);
+		free(lz4_data);
 		return;
 	}
 
@@ -492,7 +663,7 @@ static void update_mrc_cache_by_type(int type,
 
 	struct update_region_file_entry entries[] = {
 		[0] = {
-			.size = sizeof(*new_md),
+			.size = MRC_PLAIN_METADATA_SIZE,
 			.data = new_md,
 		},
 		[1] = {
@@ -500,6 +671,14 @@ static void update_mrc_cache_by_type(int type,
 			.data = new_data,
 		},
 	};
+
+	if (lz4_size) {
+		entries[0].size = sizeof(lz4_md);
+		entries[0].data = &lz4_md;
+		entries[1].size = lz4_size;
+		entries[1].data = lz4_data;
+	}
+
 	if (region_file_update_data_arr(&cache_file, entries, ARRAY_SIZE(entries)) < 0) {
 		printk(BIOS_ERR, "MRC: failed to update '%s'.\n", cr->name);
 		log_event_cache_update(cr->elog_slot, UPDATE_FAILURE);
@@ -510,6 +689,8 @@ static void update_mrc_cache_by_type(int type,
 		if (hash_idx && CONFIG(MRC_SAVE_HASH_IN_TPM))
 			mrc_cache_update_hash(hash_idx, new_data, new_data_size);
 	}
+
+	free(lz4_data);
 }
 
 /* Read flash status register to determine if write protect is active */
@@ -670,10 +851,10 @@ static void update_mrc_cache_from_cbmem(int type)
 				 cbmem_entry_start(to_be_updated),
 				 /* pointer to start of mrc_cache entry data */
 				 cbmem_entry_start(to_be_updated) +
-					sizeof(struct mrc_metadata),
+					MRC_PLAIN_METADATA_SIZE,
 				 /* size of just data portion of the entry */
 				 cbmem_entry_size(to_be_updated) -
-					sizeof(struct mrc_metadata));
+					MRC_PLAIN_METADATA_SIZE);
 }
 
 static void finalize_mrc_cache(void *unused)
@@ -701,13 +882,13 @@ int mrc_cache_stash_data(int type, uint32_t version, const void *data,
 		.version = version,
 		.data_hash = xxh32(data, size, 0),
 	};
-	md.header_hash = xxh32(&md, sizeof(md), 0);
+	md.header_hash = xxh32(&md, MRC_PLAIN_METADATA_SIZE, 0);
 
 	if (CONFIG(MRC_STASH_TO_CBMEM)) {
 		/* Store data in cbmem for use in ramstage */
-		struct mrc_metadata *cbmem_md;
+		void *cbmem_md;
 		size_t cbmem_size;
-		cbmem_size = sizeof(*cbmem_md) + size;
+		cbmem_size = MRC_PLAIN_METADATA_SIZE + size;
 
 		cr = lookup_region_type(type);
 		if (cr == NULL) {
@@ -724,9 +905,9 @@ int mrc_cache_stash_data(int type, uint32_t version, const void *data,
 			return -1;
 		}
 
-		memcpy(cbmem_md, &md, sizeof(*cbmem_md));
-		/* cbmem_md + 1 is the pointer to the mrc_cache data */
-		memcpy(cbmem_md + 1, data, size);
+		memcpy(cbmem_md, &md, MRC_PLAIN_METADATA_SIZE);
+		/* The mrc_cache data follows the metadata */
+		memcpy(cbmem_md + MRC_PLAIN_METADATA_SIZE, data, size);
 	} else {
 		/* Otherwise store to mrc_cache right away */
 		update_mrc_cache_by_type(type, &md, data, size);
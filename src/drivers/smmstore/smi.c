@@ -60,6 +60,28 @@ static uint32_t smmstorev1_exec(uint8_t command, void *param)
 		break;
 	}
 
+	case SMMSTORE_CMD_LOOKUP: {
+		printk(BIOS_DEBUG, "Looking up key in SMM store\n");
+		struct smmstore_params_lookup *params = param;
+
+		if (!CONFIG(SMMSTORE_INDEX)) {
+			ret = SMMSTORE_RET_UNSUPPORTED;
+			break;
+		}
+
+		if (range_check(params, sizeof(*params)) != 0)
+			break;
+		if (range_check(params->key, params->keysize) != 0)
+			break;
+		if (range_check(params->val, params->valsize) != 0)
+			break;
+
+		if (smmstore_lookup_data(params->key, params->keysize,
+					 params->val, &params->valsize) == 0)
+			ret = SMMSTORE_RET_SUCCESS;
+		break;
+	}
+
 	case SMMSTORE_CMD_CLEAR: {
 		if (smmstore_clear_region() == 0)
 			ret = SMMSTORE_RET_SUCCESS;
@@ -7,6 +7,7 @@
 #include <commonlib/region.h>
 #include <console/console.h>
 #include <smmstore.h>
+#include <string.h>
 #include <types.h>
 
 #define SMMSTORE_REGION "SMMSTORE"
@@ -34,10 +35,9 @@ _Static_assert(SMM_BLOCK_SIZE <= FMAP_SECTION_SMMSTORE_SIZE,
  * the constraint that entries are either complete or will be ignored, as long
  * as flash is written sequentially and into a fully erased block.
  *
- * Future additions to the format will split the region in half with an active
- * block marker to allow safe compaction (ie. write the new data in the unused
- * region, mark it active after the write completed). Otherwise a well-timed
- * crash/reboot could clear out all variables.
+ * Without SMMSTORE_INDEX the log can only be cleared as a whole. With it, the
+ * last block is kept as a spare that live records are compacted into, see
+ * "Indexed version 1 store" below.
  */
 
 static enum cb_err lookup_store_region(struct region *region)
@@ -194,6 +194,501 @@ static enum cb_err scan_end(struct region_device *store)
 
 	return CB_SUCCESS;
 }
+/* Write one record at the start of store, which must be erased. */
+static int write_record(struct region_device *store, void *key, uint32_t key_sz,
+			void *value, uint32_t value_sz)
+{
+	ssize_t offset = 0;
+	uint8_t nul = 0;
+
+	if (rdev_writeat(store, &key_sz, offset, sizeof(key_sz))
+	    != sizeof(key_sz)) {
+		printk(BIOS_WARNING, "failed writing key size\n");
+		return -1;
+	}
+	offset += sizeof(key_sz);
+	if (rdev_writeat(store, &value_sz, offset, sizeof(value_sz))
+	    != sizeof(value_sz)) {
+		printk(BIOS_WARNING, "failed writing value size\n");
+		return -1;
+	}
+	offset += sizeof(value_sz);
+	if (rdev_writeat(store, key, offset, key_sz) != key_sz) {
+		printk(BIOS_WARNING, "failed writing key data\n");
+		return -1;
+	}
+	offset += key_sz;
+	if (rdev_writeat(store, value, offset, value_sz) != value_sz) {
+		printk(BIOS_WARNING, "failed writing value data\n");
+		return -1;
+	}
+	offset += value_sz;
+	if (rdev_writeat(store, &nul, offset, sizeof(nul)) != sizeof(nul)) {
+		printk(BIOS_WARNING, "failed writing termination\n");
+		return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * Indexed version 1 store
+ *
+ * With SMMSTORE_INDEX the last block of the region is reserved as a spare
+ * and the log occupies the blocks before it. The log is scanned once to
+ * build a hash table from each key to its latest active record; appends
+ * and lookups are then served from the table instead of walking the log.
+ *
+ * Once an append would fill the log past SMMSTORE_COMPACT_THRESHOLD percent,
+ * the live records are copied into the spare block and a footer is written
+ * behind them to mark the copy complete. Then the log is erased, rewritten
+ * from the spare block, and the spare block is erased. A compaction that is
+ * interrupted after the footer was written is finished when the index is
+ * built again, so no record is lost to a badly timed reset.
+ *
+ * Appends always leave room for the end marker in the log. A log that runs
+ * into the last block was written without the index, and compacting it would
+ * erase the records kept there. Such a store stays a plain log until it is
+ * cleared.
+ */
+
+#define RECORD_HDR_SZ		(2 * sizeof(uint32_t))
+#define RECORD_END_MARKER	0xffffffff
+#define SPARE_MAGIC		0x43534d53	/* "SMSC" */
+#define FNV_OFFSET_BASIS	0x811c9dc5
+#define FNV_PRIME		0x01000193
+
+_Static_assert((CONFIG_SMMSTORE_INDEX_ENTRIES & (CONFIG_SMMSTORE_INDEX_ENTRIES - 1)) == 0,
+	       "SMMSTORE_INDEX_ENTRIES must be a power of two");
+
+struct spare_footer {
+	uint32_t magic;
+	uint32_t size;
+};
+
+struct index_slot {
+	uint32_t hash;		/* 0 marks an empty slot */
+	uint32_t offset;	/* of the latest active record within the log */
+	uint32_t key_sz;
+	uint32_t value_sz;
+};
+
+static struct {
+	bool valid;
+	bool unindexed;		/* the log runs into the spare block */
+	uint32_t end;		/* first free byte of the log */
+	uint32_t live;		/* bytes taken up by the records in slot[] */
+	uint32_t keys;
+	struct index_slot slot[CONFIG_SMMSTORE_INDEX_ENTRIES];
+} idx;
+
+static uint32_t record_size(uint32_t key_sz, uint32_t value_sz)
+{
+	return ALIGN_UP(RECORD_HDR_SZ + key_sz + value_sz + sizeof(uint8_t),
+			sizeof(uint32_t));
+}
+
+static uint32_t hash_update(uint32_t hash, const uint8_t *data, size_t len)
+{
+	while (len--) {
+		hash ^= *data++;
+		hash *= FNV_PRIME;
+	}
+
+	return hash;
+}
+
+static uint32_t hash_key(const void *key, uint32_t key_sz)
+{
+	const uint32_t hash = hash_update(FNV_OFFSET_BASIS, key, key_sz);
+
+	return hash ? hash : 1;
+}
+
+static int hash_record_key(const struct region_device *log, uint32_t offset,
+			   uint32_t key_sz, uint32_t *hash)
+{
+	uint32_t h = FNV_OFFSET_BASIS;
+	uint8_t chunk[64];
+	size_t done, len;
+
+	for (done = 0; done < key_sz; done += len) {
+		len = MIN(sizeof(chunk), key_sz - done);
+		if (rdev_readat(log, chunk, offset + RECORD_HDR_SZ + done, len) != len)
+			return -1;
+		h = hash_update(h, chunk, len);
+	}
+
+	*hash = h ? h : 1;
+
+	return 0;
+}
+
+/*
+ * Compare the key of the record at offset with key, or with the key of the
+ * record at other_offset if key is NULL. Both keys are key_sz bytes long.
+ */
+static bool record_key_equal(const struct region_device *log, uint32_t offset,
+			     const uint8_t *key, uint32_t other_offset, uint32_t key_sz)
+{
+	uint8_t chunk[32], other[32];
+	size_t done, len;
+
+	for (done = 0; done < key_sz; done += len) {
+		len = MIN(sizeof(chunk), key_sz - done);
+		if (rdev_readat(log, chunk, offset + RECORD_HDR_SZ + done, len) != len)
+			return false;
+		if (key) {
+			if (memcmp(chunk, key + done, len))
+				return false;
+			continue;
+		}
+		if (rdev_readat(log, other, other_offset + RECORD_HDR_SZ + done, len) != len)
+			return false;
+		if (memcmp(chunk, other, len))
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * Find the slot holding the given key, or the empty slot it would go into.
+ * Returns NULL when the key isn't indexed and there is no space left.
+ */
+static struct index_slot *index_slot(const struct region_device *log, uint32_t hash,
+				     const void *key, uint32_t other_offset, uint32_t key_sz)
+{
+	const size_t mask = ARRAY_SIZE(idx.slot) - 1;
+	size_t i, pos;
+
+	for (i = 0, pos = hash & mask; i <= mask; i++, pos = (pos + 1) & mask) {
+		struct index_slot *slot = &idx.slot[pos];
+
+		if (!slot->hash)
+			return slot;
+
+		if (slot->hash == hash && slot->key_sz == key_sz &&
+		    record_key_equal(log, slot->offset, key, other_offset, key_sz))
+			return slot;
+	}
+
+	return NULL;
+}
+
+static void index_set(struct index_slot *slot, uint32_t hash, uint32_t offset,
+		      uint32_t key_sz, uint32_t value_sz)
+{
+	if (slot->hash) {
+		idx.live -= record_size(slot->key_sz, slot->value_sz);
+	} else {
+		slot->hash = hash;
+		idx.keys++;
+	}
+
+	slot->offset = offset;
+	slot->key_sz = key_sz;
+	slot->value_sz = value_sz;
+	idx.live += record_size(key_sz, value_sz);
+}
+
+/* Split the store into the log and the spare block used for compaction. */
+static int index_split(const struct region_device *store, struct region_device *log,
+		       struct region_device *spare)
+{
+	const size_t size = region_device_sz(store);
+
+	if (size < 2 * SMM_BLOCK_SIZE) {
+		printk(BIOS_ERR, "smm store: indexing needs at least two blocks\n");
+		return -1;
+	}
+
+	if (rdev_chain(log, store, 0, size - SMM_BLOCK_SIZE))
+		return -1;
+
+	return rdev_chain(spare, store, size - SMM_BLOCK_SIZE, SMM_BLOCK_SIZE);
+}
+
+static int copy_data(const struct region_device *from, uint32_t from_offset,
+		     const struct region_device *to, uint32_t to_offset, uint32_t size)
+{
+	uint8_t buf[256];
+	size_t done, len;
+
+	for (done = 0; done < size; done += len) {
+		len = MIN(sizeof(buf), size - done);
+		if (rdev_readat(from, buf, from_offset + done, len) != len)
+			return -1;
+		if (rdev_writeat(to, buf, to_offset + done, len) != len)
+			return -1;
+	}
+
+	return 0;
+}
+
+static int erase_full(const struct region_device *rdev)
+{
+	const ssize_t size = region_device_sz(rdev);
+
+	if (rdev_eraseat(rdev, 0, size) != size) {
+		printk(BIOS_WARNING, "smm store: erasing region failed\n");
+		return -1;
+	}
+
+	return 0;
+}
+
+/* Rewrite the log from the first size bytes of the spare block. */
+static int restore_from_spare(const struct region_device *log,
+			      const struct region_device *spare, uint32_t size)
+{
+	if (erase_full(log) < 0)
+		return -1;
+
+	if (copy_data(spare, 0, log, 0, size) < 0) {
+		printk(BIOS_WARNING, "smm store: copying back compacted log failed\n");
+		return -1;
+	}
+
+	return erase_full(spare);
+}
+
+static int finish_compaction(const struct region_device *log,
+			     const struct region_device *spare)
+{
+	const size_t footer_offset = region_device_sz(spare) - sizeof(struct spare_footer);
+	struct spare_footer footer;
+
+	if (rdev_readat(spare, &footer, footer_offset, sizeof(footer)) != sizeof(footer))
+		return -1;
+
+	/* Anything short of a complete footer is an aborted copy the log doesn't need. */
+	if (footer.magic != SPARE_MAGIC || footer.size > footer_offset)
+		return 0;
+
+	printk(BIOS_INFO, "smm store: finishing interrupted compaction\n");
+
+	return restore_from_spare(log, spare, footer.size);
+}
+
+static int index_compact(const struct region_device *log, const struct region_device *spare)
+{
+	const size_t footer_offset = region_device_sz(spare) - sizeof(struct spare_footer);
+	struct spare_footer footer = { .magic = SPARE_MAGIC };
+	size_t i;
+
+	if (idx.live > footer_offset) {
+		printk(BIOS_WARNING, "smm store: 0x%x live bytes don't fit the spare block\n",
+		       idx.live);
+		return -1;
+	}
+
+	printk(BIOS_INFO, "smm store: compacting log, 0x%x of 0x%x bytes live\n",
+	       idx.live, idx.end);
+
+	/* Slot offsets are rewritten as records are copied; rebuild if this fails. */
+	idx.valid = false;
+
+	if (erase_full(spare) < 0)
+		return -1;
+
+	footer.size = 0;
+	for (i = 0; i < ARRAY_SIZE(idx.slot); i++) {
+		struct index_slot *slot = &idx.slot[i];
+		const uint32_t size = record_size(slot->key_sz, slot->value_sz);
+
+		if (!slot->hash)
+			continue;
+
+		if (copy_data(log, slot->offset, spare, footer.size, size) < 0) {
+			printk(BIOS_WARNING, "smm store: copying live records failed\n");
+			return -1;
+		}
+
+		slot->offset = footer.size;
+		footer.size += size;
+	}
+
+	if (rdev_writeat(spare, &footer, footer_offset, sizeof(footer)) != sizeof(footer)) {
+		printk(BIOS_WARNING, "smm store: failed writing spare block footer\n");
+		return -1;
+	}
+
+	if (restore_from_spare(log, spare, footer.size) < 0)
+		return -1;
+
+	idx.end = footer.size;
+	idx.live = footer.size;
+	idx.valid = true;
+
+	return 0;
+}
+
+static int index_build(const struct region_device *store)
+{
+	struct region_device log, spare;
+	const uint32_t store_sz = region_device_sz(store);
+	uint32_t offset = 0;
+	bool corrupt = false, unindexed = false;
+
+	memset(&idx, 0, sizeof(idx));
+
+	if (index_split(store, &log, &spare) < 0)
+		return -1;
+
+	if (finish_compaction(&log, &spare) < 0)
+		return -1;
+
+	const uint32_t log_sz = region_device_sz(&log);
+
+	while (offset < log_sz) {
+		struct index_slot *slot;
+		uint32_t hdr[2], hash, size;
+		uint8_t active;
+
+		if (rdev_readat(&log, &hdr[0], offset, sizeof(hdr[0])) != sizeof(hdr[0]))
+			return -1;
+
+		if (hdr[0] == RECORD_END_MARKER)
+			break;
+
+		if (offset + RECORD_HDR_SZ > log_sz) {
+			unindexed = true;
+			break;
+		}
+
+		if (rdev_readat(&log, &hdr[1], offset + sizeof(hdr[0]), sizeof(hdr[1]))
+		    != sizeof(hdr[1]))
+			return -1;
+
+		/* Catches torn headers too, as unwritten sizes read as 0xffffffff. */
+		if (hdr[0] > store_sz || hdr[1] > store_sz ||
+		    record_size(hdr[0], hdr[1]) > store_sz - offset) {
+			corrupt = true;
+			break;
+		}
+
+		size = record_size(hdr[0], hdr[1]);
+		if (size > log_sz - offset) {
+			unindexed = true;
+			break;
+		}
+
+		if (rdev_readat(&log, &active, offset + RECORD_HDR_SZ + hdr[0] + hdr[1],
+				sizeof(active)) != sizeof(active))
+			return -1;
+
+		/* Records without the termination byte were never completely written. */
+		if (active == 0) {
+			if (hash_record_key(&log, offset, hdr[0], &hash) < 0)
+				return -1;
+
+			slot = index_slot(&log, hash, NULL, offset, hdr[0]);
+			if (!slot) {
+				printk(BIOS_ERR, "smm store: more than %d keys, index full\n",
+				       CONFIG_SMMSTORE_INDEX_ENTRIES);
+				return -1;
+			}
+			index_set(slot, hash, offset, hdr[0], hdr[1]);
+		}
+
+		offset += size;
+	}
+
+	if (unindexed || offset == log_sz) {
+		printk(BIOS_WARNING, "smm store: log runs into the spare block, "
+		       "clear the store to index it\n");
+		memset(&idx, 0, sizeof(idx));
+		idx.unindexed = true;
+		return -1;
+	}
+
+	idx.end = offset;
+	idx.valid = true;
+
+	printk(BIOS_DEBUG, "smm store: indexed %u keys, 0x%x of 0x%x bytes live\n",
+	       idx.keys, idx.live, idx.end);
+
+	if (corrupt) {
+		printk(BIOS_WARNING, "smm store: log corrupted at 0x%x\n", offset);
+		return index_compact(&log, &spare);
+	}
+
+	return 0;
+}
+
+static int index_prepare(const struct region_device *store, struct region_device *log,
+			 struct region_device *spare)
+{
+	if (!idx.valid && index_build(store) < 0)
+		return -1;
+
+	return index_split(store, log, spare);
+}
+
+/* Tell whether the store has to be appended to as a plain log. */
+static bool index_refused(const struct region_device *store)
+{
+	if (!idx.valid)
+		index_build(store);
+
+	return idx.unindexed;
+}
+
+static int index_append(const struct region_device *store, void *key, uint32_t key_sz,
+			void *value, uint32_t value_sz)
+{
+	struct region_device log, spare, record;
+	struct index_slot *slot;
+	const uint32_t hash = hash_key(key, key_sz);
+	uint32_t size, offset, log_sz;
+
+	if (index_prepare(store, &log, &spare) < 0)
+		return -1;
+
+	log_sz = region_device_sz(&log);
+	if (key_sz > log_sz || value_sz > log_sz) {
+		printk(BIOS_WARNING, "not enough space for new data\n");
+		return -1;
+	}
+	size = record_size(key_sz, value_sz);
+
+	/* Only compact when that frees something, and keep going if it doesn't fit. */
+	if ((uint64_t)(idx.end + size) * 100 > (uint64_t)log_sz * CONFIG_SMMSTORE_COMPACT_THRESHOLD
+	    && idx.live < idx.end) {
+		if (index_compact(&log, &spare) < 0 && !idx.valid)
+			return -1;
+	}
+
+	/* The end marker has to stay in the log, see above. */
+	if (size + sizeof(uint32_t) > log_sz - idx.end) {
+		printk(BIOS_WARNING, "not enough space for new data\n");
+		return -1;
+	}
+
+	slot = index_slot(&log, hash, key, 0, key_sz);
+	if (!slot) {
+		printk(BIOS_WARNING, "smm store: more than %d keys, index full\n",
+		       CONFIG_SMMSTORE_INDEX_ENTRIES);
+		return -1;
+	}
+
+	offset = idx.end;
+	if (rdev_chain(&record, &log, offset, size))
+		return -1;
+
+	/* A partially written record still takes up log space; rescan next time. */
+	idx.valid = false;
+	if (write_record(&record, key, key_sz, value, value_sz) < 0)
+		return -1;
+
+	index_set(slot, hash, offset, key_sz, value_sz);
+	idx.end = offset + size;
+	idx.valid = true;
+
+	return 0;
+}
+
 /*
  * Append data to region
  *
@@ -209,9 +704,10 @@ int smmstore_append_data(void *key, uint32_t key_sz, void *value,
 		return -1;
 	}
 
-	ssize_t offset = 0;
+	if (CONFIG(SMMSTORE_INDEX) && !index_refused(&store))
+		return index_append(&store, key, key_sz, value, value_sz);
+
 	ssize_t size;
-	uint8_t nul = 0;
 	if (scan_end(&store) != CB_SUCCESS)
 		return -1;
 
@@ -221,39 +717,55 @@ int smmstore_append_data(void *key, uint32_t key_sz, void *value,
 		region_device_offset(&store), region_device_sz(&store));
 
 	size = sizeof(key_sz) + sizeof(value_sz) + key_sz + value_sz
-		+ sizeof(nul);
+		+ sizeof(uint8_t);
 	if (rdev_chain(&store, &store, 0, size)) {
 		printk(BIOS_WARNING, "not enough space for new data\n");
 		return -1;
 	}
 
-	if (rdev_writeat(&store, &key_sz, offset, sizeof(key_sz))
-	    != sizeof(key_sz)) {
-		printk(BIOS_WARNING, "failed writing key size\n");
+	return write_record(&store, key, key_sz, value, value_sz);
+}
+
+/*
+ * Look up the latest value stored for a key. Needs SMMSTORE_INDEX.
+ *
+ * Returns 0 on success, -1 on failure or if the key isn't found
+ * writes the value into `value` and its size into `*value_sz`. If the value
+ * is larger than `*value_sz`, only its size is returned in `*value_sz`.
+ */
+int smmstore_lookup_data(void *key, uint32_t key_sz, void *value, size_t *value_sz)
+{
+	struct region_device store, log, spare;
+	struct index_slot *slot;
+
+	if (!CONFIG(SMMSTORE_INDEX))
 		return -1;
-	}
-	offset += sizeof(key_sz);
-	if (rdev_writeat(&store, &value_sz, offset, sizeof(value_sz))
-	    != sizeof(value_sz)) {
-		printk(BIOS_WARNING, "failed writing value size\n");
+
+	if (lookup_store(&store) < 0) {
+		printk(BIOS_WARNING, "reading region failed\n");
 		return -1;
 	}
-	offset += sizeof(value_sz);
-	if (rdev_writeat(&store, key, offset, key_sz) != key_sz) {
-		printk(BIOS_WARNING, "failed writing key data\n");
+
+	if (index_prepare(&store, &log, &spare) < 0)
 		return -1;
-	}
-	offset += key_sz;
-	if (rdev_writeat(&store, value, offset, value_sz) != value_sz) {
-		printk(BIOS_WARNING, "failed writing value data\n");
+
+	slot = index_slot(&log, hash_key(key, key_sz), key, 0, key_sz);
+	if (!slot || !slot->hash)
+		return -1;
+
+	if (*value_sz < slot->value_sz) {
+		*value_sz = slot->value_sz;
 		return -1;
 	}
-	offset += value_sz;
-	if (rdev_writeat(&store, &nul, offset, sizeof(nul)) != sizeof(nul)) {
-		printk(BIOS_WARNING, "failed writing termination\n");
+
+	if (rdev_readat(&log, value, slot->offset + RECORD_HDR_SZ + key_sz, slot->value_sz)
+	    != slot->value_sz) {
+		printk(BIOS_WARNING, "failed reading value data\n");
 		return -1;
 	}
 
+	*value_sz = slot->value_sz;
+
 	return 0;
 }
 
@@ -271,6 +783,10 @@ int smmstore_clear_region(void)
 		return -1;
 	}
 
+	/* Rebuilding the index of an empty log is cheap. */
+	if (CONFIG(SMMSTORE_INDEX))
+		idx.valid = false;
+
 	ssize_t res = rdev_eraseat(&store, 0, region_device_sz(&store));
 	if (res != region_device_sz(&store)) {
 		printk(BIOS_WARNING, "smm store: erasing region failed\n");
@@ -38,6 +38,15 @@ $(eval $(call add_spi_stage,romstage,_EARLY))
 $(eval $(call add_spi_stage,verstage,_EARLY))
 $(eval $(call add_spi_stage,postcar,_EARLY))
 $(eval $(call add_spi_stage,ramstage))
+
+ifeq ($(CONFIG_SPI_FLASH_READ_CACHE),y)
+bootblock-y += spi_flash_cache.c
+verstage-y += spi_flash_cache.c
+romstage-y += spi_flash_cache.c
+postcar-y += spi_flash_cache.c
+ramstage-y += spi_flash_cache.c
+endif
+
 ifeq ($(CONFIG_SPI_FLASH_SMM),y)
 $(eval $(call add_spi_stage,smm))
 endif
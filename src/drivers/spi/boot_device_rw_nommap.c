@@ -11,7 +11,7 @@ static bool sfg_init_done;
 static ssize_t spi_readat(const struct region_device *rd, void *b,
 				size_t offset, size_t size)
 {
-	if (spi_flash_read(&sfg, offset, size, b))
+	if (spi_flash_cached_read(&sfg, offset, size, b))
 		return -1;
 
 	return size;
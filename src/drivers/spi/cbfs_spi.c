@@ -33,7 +33,7 @@ static ssize_t spi_readat(const struct region_device *rd, void *b,
 
 	if (show)
 		stopwatch_init(&sw);
-	if (spi_flash_read(&spi_flash_info, offset, size, b))
+	if (spi_flash_cached_read(&spi_flash_info, offset, size, b))
 		return -1;
 	if (show) {
 		long usecs;
@@ -47,6 +47,7 @@ static ssize_t spi_readat(const struct region_device *rd, void *b,
 
 		printk(BIOS_DEBUG, "read SPI %#zx %#zx: %ld us, %lld KB/s, %d.%03d Mbps\n",
 		       offset, size, usecs, speed, bps / 1000, bps % 1000);
+		spi_flash_cache_report();
 	}
 	return size;
 }
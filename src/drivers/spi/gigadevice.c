@@ -32,6 +32,8 @@ static const struct spi_flash_part_id flash_table[] = {
 		.nr_sectors_shift		= 8,
 		.fast_read_dual_output_support	= 1,
 		.fast_read_dual_io_support	= 1,
+		.fast_read_quad_output_support	= 1,
+		.fast_read_quad_io_support	= 1,
 	},					/* also GD25Q80B */
 	{
 		/* GD25Q16 */
@@ -39,6 +41,8 @@ static const struct spi_flash_part_id flash_table[] = {
 		.nr_sectors_shift		= 9,
 		.fast_read_dual_output_support	= 1,
 		.fast_read_dual_io_support	= 1,
+		.fast_read_quad_output_support	= 1,
+		.fast_read_quad_io_support	= 1,
 	},					/* also GD25Q16B */
 	{
 		/* GD25Q32B */
@@ -46,6 +50,8 @@ static const struct spi_flash_part_id flash_table[] = {
 		.nr_sectors_shift		= 10,
 		.fast_read_dual_output_support	= 1,
 		.fast_read_dual_io_support	= 1,
+		.fast_read_quad_output_support	= 1,
+		.fast_read_quad_io_support	= 1,
 	},					/* also GD25Q32B */
 	{
 		/* GD25Q64 */
@@ -53,6 +59,8 @@ static const struct spi_flash_part_id flash_table[] = {
 		.nr_sectors_shift		= 11,
 		.fast_read_dual_output_support	= 1,
 		.fast_read_dual_io_support	= 1,
+		.fast_read_quad_output_support	= 1,
+		.fast_read_quad_io_support	= 1,
 	},					/* also GD25Q64B, GD25B64C */
 	{
 		/* GD25Q128 */
@@ -60,6 +68,8 @@ static const struct spi_flash_part_id flash_table[] = {
 		.nr_sectors_shift		= 12,
 		.fast_read_dual_output_support	= 1,
 		.fast_read_dual_io_support	= 1,
+		.fast_read_quad_output_support	= 1,
+		.fast_read_quad_io_support	= 1,
 	},					/* also GD25Q128B */
 	{
 		/* GD25VQ80C */
@@ -67,6 +77,8 @@ static const struct spi_flash_part_id flash_table[] = {
 		.nr_sectors_shift		= 8,
 		.fast_read_dual_output_support	= 1,
 		.fast_read_dual_io_support	= 1,
+		.fast_read_quad_output_support	= 1,
+		.fast_read_quad_io_support	= 1,
 	},
 	{
 		/* GD25VQ16C */
@@ -74,6 +86,8 @@ static const struct spi_flash_part_id flash_table[] = {
 		.nr_sectors_shift		= 9,
 		.fast_read_dual_output_support	= 1,
 		.fast_read_dual_io_support	= 1,
+		.fast_read_quad_output_support	= 1,
+		.fast_read_quad_io_support	= 1,
 	},
 	{
 		/* GD25LQ80 */
@@ -81,6 +95,8 @@ static const struct spi_flash_part_id flash_table[] = {
 		.nr_sectors_shift		= 8,
 		.fast_read_dual_output_support	= 1,
 		.fast_read_dual_io_support	= 1,
+		.fast_read_quad_output_support	= 1,
+		.fast_read_quad_io_support	= 1,
 	},
 	{
 		/* GD25LQ16 */
@@ -88,6 +104,8 @@ static const struct spi_flash_part_id flash_table[] = {
 		.nr_sectors_shift		= 9,
 		.fast_read_dual_output_support	= 1,
 		.fast_read_dual_io_support	= 1,
+		.fast_read_quad_output_support	= 1,
+		.fast_read_quad_io_support	= 1,
 	},
 	{
 		/* GD25LQ32 */
@@ -95,6 +113,8 @@ static const struct spi_flash_part_id flash_table[] = {
 		.nr_sectors_shift		= 10,
 		.fast_read_dual_output_support	= 1,
 		.fast_read_dual_io_support	= 1,
+		.fast_read_quad_output_support	= 1,
+		.fast_read_quad_io_support	= 1,
 	},
 	{
 		/* GD25LQ64C */
@@ -102,6 +122,8 @@ static const struct spi_flash_part_id flash_table[] = {
 		.nr_sectors_shift		= 11,
 		.fast_read_dual_output_support	= 1,
 		.fast_read_dual_io_support	= 1,
+		.fast_read_quad_output_support	= 1,
+		.fast_read_quad_io_support	= 1,
 	},					/* also GD25LB64C */
 	{
 		/* GD25LQ128 */
@@ -109,6 +131,8 @@ static const struct spi_flash_part_id flash_table[] = {
 		.nr_sectors_shift		= 12,
 		.fast_read_dual_output_support	= 1,
 		.fast_read_dual_io_support	= 1,
+		.fast_read_quad_output_support	= 1,
+		.fast_read_quad_io_support	= 1,
 	},
 	{
 		/* GD25LQ255E */
@@ -116,6 +140,8 @@ static const struct spi_flash_part_id flash_table[] = {
 		.nr_sectors_shift		= 13,
 		.fast_read_dual_output_support	= 1,
 		.fast_read_dual_io_support	= 1,
+		.fast_read_quad_output_support	= 1,
+		.fast_read_quad_io_support	= 1,
 	},
 };
 
@@ -127,4 +153,5 @@ const struct spi_flash_vendor_info spi_flash_gigadevice_vi = {
 	.ids = flash_table,
 	.nr_part_ids = ARRAY_SIZE(flash_table),
 	.desc = &spi_flash_pp_0x20_sector_desc,
+	.quad_enable = spi_flash_quad_enable_sr2,
 };
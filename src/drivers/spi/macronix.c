@@ -78,60 +78,80 @@ static const struct spi_flash_part_id flash_table[] = {
 		.id[0] = 0x2515,
 		.nr_sectors_shift = 9,
 		.fast_read_dual_io_support = 1,
+		.fast_read_quad_output_support = 1,
+		.fast_read_quad_io_support = 1,
 	},
 	{
 		/* MX25U8032E */
 		.id[0] = 0x2534,
 		.nr_sectors_shift = 8,
 		.fast_read_dual_io_support = 1,
+		.fast_read_quad_output_support = 1,
+		.fast_read_quad_io_support = 1,
 	},
 	{
 		/* MX25U1635E/MX25U1635F */
 		.id[0] = 0x2535,
 		.nr_sectors_shift = 9,
 		.fast_read_dual_io_support = 1,
+		.fast_read_quad_output_support = 1,
+		.fast_read_quad_io_support = 1,
 	},
 	{
 		/* MX25U3235E/MX25U3235F */
 		.id[0] = 0x2536,
 		.nr_sectors_shift = 10,
 		.fast_read_dual_io_support = 1,
+		.fast_read_quad_output_support = 1,
+		.fast_read_quad_io_support = 1,
 	},
 	{
 		/* MX25U6435E/MX25U6435F */
 		.id[0] = 0x2537,
 		.nr_sectors_shift = 11,
 		.fast_read_dual_io_support = 1,
+		.fast_read_quad_output_support = 1,
+		.fast_read_quad_io_support = 1,
 	},
 	{
 		/* MX25U12835F */
 		.id[0] = 0x2538,
 		.nr_sectors_shift = 12,
 		.fast_read_dual_io_support = 1,
+		.fast_read_quad_output_support = 1,
+		.fast_read_quad_io_support = 1,
 	},
 	{
 		/* MX25U25635F */
 		.id[0] = 0x2539,
 		.nr_sectors_shift = 13,
 		.fast_read_dual_io_support = 1,
+		.fast_read_quad_output_support = 1,
+		.fast_read_quad_io_support = 1,
 	},
 	{
 		/* MX25U51235F */
 		.id[0] = 0x253a,
 		.nr_sectors_shift = 14,
 		.fast_read_dual_io_support = 1,
+		.fast_read_quad_output_support = 1,
+		.fast_read_quad_io_support = 1,
 	},
 	{
 		/* MX25L12855E */
 		.id[0] = 0x2618,
 		.nr_sectors_shift = 12,
 		.fast_read_dual_io_support = 1,
+		.fast_read_quad_output_support = 1,
+		.fast_read_quad_io_support = 1,
 	},
 	{
 		/* MX25L3235D/MX25L3225D/MX25L3236D/MX25L3237D */
 		.id[0] = 0x5e16,
 		.nr_sectors_shift = 10,
 		.fast_read_dual_io_support = 1,
+		.fast_read_quad_output_support = 1,
+		.fast_read_quad_io_support = 1,
 	},
 	{
 		/* MX25L6495F */
@@ -153,4 +173,5 @@ const struct spi_flash_vendor_info spi_flash_macronix_vi = {
 	.ids = flash_table,
 	.nr_part_ids = ARRAY_SIZE(flash_table),
 	.desc = &spi_flash_pp_0x20_sector_desc,
+	.quad_enable = spi_flash_quad_enable_sr1,
 };
@@ -67,8 +67,17 @@ static int do_spi_flash_cmd(const struct spi_slave *spi, const u8 *dout,
 	return ret;
 }
 
-static int do_dual_output_cmd(const struct spi_slave *spi, const u8 *dout,
-			      size_t bytes_out, void *din, size_t bytes_in)
+/*
+ * Multi I/O commands always send the opcode in "single" mode. The address and
+ * dummy bytes follow in "single" mode for 1-1-x reads (addr_wide == false) or
+ * on all lanes for 1-x-x reads, and the data is received on all lanes.
+ * xfer_wide is the controller's .xfer_dual() or .xfer_quad().
+ */
+static int do_multi_io_cmd(const struct spi_slave *spi,
+			   int (*xfer_wide)(const struct spi_slave *slave, const void *dout,
+					    size_t bytesout, void *din, size_t bytesin),
+			   bool addr_wide, const u8 *dout, size_t bytes_out,
+			   void *din, size_t bytes_in)
 {
 	int ret;
 
@@ -79,7 +88,7 @@ static int do_dual_output_cmd(const struct spi_slave *spi, const u8 *dout,
 	 * and (the non-vector based) .xfer_dual() but not .xfer() would be
 	 * pretty odd.
 	 */
-	struct spi_op vector = { .dout = dout, .bytesout = bytes_out,
+	struct spi_op vector = { .dout = dout, .bytesout = addr_wide ? 1 : bytes_out,
 				 .din = NULL, .bytesin = 0 };
 
 	ret = spi_claim_bus(spi);
@@ -88,36 +97,42 @@ static int do_dual_output_cmd(const struct spi_slave *spi, const u8 *dout,
 
 	ret = spi_xfer_vector(spi, &vector, 1);
 
+	if (!ret && addr_wide)
+		ret = xfer_wide(spi, &dout[1], bytes_out - 1, NULL, 0);
+
 	if (!ret)
-		ret = spi->ctrlr->xfer_dual(spi, NULL, 0, din, bytes_in);
+		ret = xfer_wide(spi, NULL, 0, din, bytes_in);
 
 	spi_release_bus(spi);
 	return ret;
 }
 
+static int do_dual_output_cmd(const struct spi_slave *spi, const u8 *dout,
+			      size_t bytes_out, void *din, size_t bytes_in)
+{
+	return do_multi_io_cmd(spi, spi->ctrlr->xfer_dual, false, dout, bytes_out,
+			       din, bytes_in);
+}
+
 static int do_dual_io_cmd(const struct spi_slave *spi, const u8 *dout,
 			  size_t bytes_out, void *din, size_t bytes_in)
 {
-	int ret;
-
-	/* Only the very first byte (opcode) is transferred in "single" mode. */
-	struct spi_op vector = { .dout = dout, .bytesout = 1,
-				 .din = NULL, .bytesin = 0 };
-
-	ret = spi_claim_bus(spi);
-	if (ret)
-		return ret;
-
-	ret = spi_xfer_vector(spi, &vector, 1);
-
-	if (!ret)
-		ret = spi->ctrlr->xfer_dual(spi, &dout[1], bytes_out - 1, NULL, 0);
+	return do_multi_io_cmd(spi, spi->ctrlr->xfer_dual, true, dout, bytes_out,
+			       din, bytes_in);
+}
 
-	if (!ret)
-		ret = spi->ctrlr->xfer_dual(spi, NULL, 0, din, bytes_in);
+static int do_quad_output_cmd(const struct spi_slave *spi, const u8 *dout,
+			      size_t bytes_out, void *din, size_t bytes_in)
+{
+	return do_multi_io_cmd(spi, spi->ctrlr->xfer_quad, false, dout, bytes_out,
+			       din, bytes_in);
+}
 
-	spi_release_bus(spi);
-	return ret;
+static int do_quad_io_cmd(const struct spi_slave *spi, const u8 *dout,
+			  size_t bytes_out, void *din, size_t bytes_in)
+{
+	return do_multi_io_cmd(spi, spi->ctrlr->xfer_quad, true, dout, bytes_out,
+			       din, bytes_in);
 }
 
 int spi_flash_cmd(const struct spi_slave *spi, u8 cmd, void *response, size_t len)
@@ -158,7 +173,7 @@ int spi_flash_cmd_write(const struct spi_slave *spi, const u8 *cmd,
 int spi_flash_cmd_read(const struct spi_flash *flash, u32 offset,
 				  size_t len, void *buf)
 {
-	u8 cmd[5 + ADDR_MOD];
+	u8 cmd[7 + ADDR_MOD];
 	int ret, cmd_len;
 	int (*do_cmd)(const struct spi_slave *spi, const u8 *din,
 		      size_t in_bytes, void *out, size_t out_bytes);
@@ -167,6 +182,19 @@ int spi_flash_cmd_read(const struct spi_flash *flash, u32 offset,
 		cmd_len = 4 + ADDR_MOD;
 		cmd[0] = CMD_READ_ARRAY_SLOW;
 		do_cmd = do_spi_flash_cmd;
+	} else if (flash->flags.quad_io && flash->spi.ctrlr->xfer_quad) {
+		/* Mode byte and 4 dummy clocks, all on four lanes. */
+		cmd_len = 7 + ADDR_MOD;
+		cmd[0] = CMD_READ_FAST_QUAD_IO;
+		cmd[4 + ADDR_MOD] = 0;
+		cmd[5 + ADDR_MOD] = 0;
+		cmd[6 + ADDR_MOD] = 0;
+		do_cmd = do_quad_io_cmd;
+	} else if (flash->flags.quad_output && flash->spi.ctrlr->xfer_quad) {
+		cmd_len = 5 + ADDR_MOD;
+		cmd[0] = CMD_READ_FAST_QUAD_OUTPUT;
+		cmd[4 + ADDR_MOD] = 0;
+		do_cmd = do_quad_output_cmd;
 	} else if (flash->flags.dual_io && flash->spi.ctrlr->xfer_dual) {
 		cmd_len = 5 + ADDR_MOD;
 		cmd[0] = CMD_READ_FAST_DUAL_IO;
@@ -299,6 +327,67 @@ int spi_flash_cmd_status(const struct spi_flash *flash, u8 *reg)
 	return spi_flash_cmd(&flash->spi, flash->status_cmd, reg, sizeof(*reg));
 }
 
+int spi_flash_quad_enable_sr2(const struct spi_flash *flash)
+{
+	u8 cmd[3];
+	int ret;
+
+	ret = spi_flash_cmd(&flash->spi, CMD_READ_STATUS2, &cmd[2], 1);
+	if (ret || (cmd[2] & STATUS_QE_SR2_BIT1))
+		return ret;
+
+	ret = spi_flash_cmd(&flash->spi, CMD_READ_STATUS, &cmd[1], 1);
+	if (ret)
+		return ret;
+
+	/* The volatile write leaves the non-volatile bit alone and doesn't wear the part. */
+	ret = spi_flash_cmd(&flash->spi, CMD_VOLATILE_SR_WRITE_ENABLE, NULL, 0);
+	if (ret)
+		return ret;
+
+	cmd[0] = CMD_WRITE_STATUS;
+	cmd[2] |= STATUS_QE_SR2_BIT1;
+	ret = spi_flash_cmd_write(&flash->spi, cmd, sizeof(cmd), NULL, 0);
+	if (ret)
+		return ret;
+
+	ret = spi_flash_cmd(&flash->spi, CMD_READ_STATUS2, &cmd[2], 1);
+	if (ret)
+		return ret;
+
+	return cmd[2] & STATUS_QE_SR2_BIT1 ? 0 : -1;
+}
+
+int spi_flash_quad_enable_sr1(const struct spi_flash *flash)
+{
+	u8 cmd[2];
+	int ret;
+
+	ret = spi_flash_cmd(&flash->spi, CMD_READ_STATUS, &cmd[1], 1);
+	if (ret || (cmd[1] & STATUS_QE_SR1_BIT6))
+		return ret;
+
+	ret = spi_flash_cmd(&flash->spi, flash->wren_cmd, NULL, 0);
+	if (ret)
+		return ret;
+
+	cmd[0] = CMD_WRITE_STATUS;
+	cmd[1] |= STATUS_QE_SR1_BIT6;
+	ret = spi_flash_cmd_write(&flash->spi, cmd, sizeof(cmd), NULL, 0);
+	if (ret)
+		return ret;
+
+	ret = spi_flash_cmd_wait_ready(flash, SPI_FLASH_PROG_TIMEOUT_MS);
+	if (ret)
+		return ret;
+
+	ret = spi_flash_cmd(&flash->spi, CMD_READ_STATUS, &cmd[1], 1);
+	if (ret)
+		return ret;
+
+	return cmd[1] & STATUS_QE_SR1_BIT6 ? 0 : -1;
+}
+
 int spi_flash_cmd_write_page_program(const struct spi_flash *flash, u32 offset,
 				size_t len, const void *buf)
 {
@@ -421,11 +510,23 @@ static int fill_spi_flash(const struct spi_slave *spi, struct spi_flash *flash,
 
 	flash->flags.dual_output = part->fast_read_dual_output_support;
 	flash->flags.dual_io = part->fast_read_dual_io_support;
+	flash->flags.quad_output = 0;
+	flash->flags.quad_io = 0;
 
 	flash->ops = &vi->desc->ops;
 	flash->prot_ops = vi->prot_ops;
 	flash->part = part;
 
+	if (CONFIG(SPI_FLASH_QUAD_IO) && spi->ctrlr->xfer_quad && vi->quad_enable &&
+	    (part->fast_read_quad_output_support || part->fast_read_quad_io_support)) {
+		if (vi->quad_enable(flash) == 0) {
+			flash->flags.quad_output = part->fast_read_quad_output_support;
+			flash->flags.quad_io = part->fast_read_quad_io_support;
+		} else {
+			printk(BIOS_WARNING, "SF: Could not set Quad Enable bit\n");
+		}
+	}
+
 	if (vi->after_probe)
 		return vi->after_probe(flash);
 
@@ -540,7 +641,11 @@ int spi_flash_probe(unsigned int bus, unsigned int cs, struct spi_flash *flash)
 	}
 
 	const char *mode_string = "";
-	if (flash->flags.dual_io && spi.ctrlr->xfer_dual)
+	if (flash->flags.quad_io && spi.ctrlr->xfer_quad)
+		mode_string = " (Quad I/O mode)";
+	else if (flash->flags.quad_output && spi.ctrlr->xfer_quad)
+		mode_string = " (Quad Output mode)";
+	else if (flash->flags.dual_io && spi.ctrlr->xfer_dual)
 		mode_string = " (Dual I/O mode)";
 	else if (flash->flags.dual_output && spi.ctrlr->xfer_dual)
 		mode_string = " (Dual Output mode)";
@@ -577,6 +682,7 @@ int spi_flash_write(const struct spi_flash *flash, u32 offset, size_t len,
 		return -1;
 
 	ret = flash->ops->write(flash, offset, len, buf);
+	spi_flash_cache_invalidate(offset, len);
 
 	if (spi_flash_volatile_group_end(flash))
 		return -1;
@@ -592,6 +698,7 @@ int spi_flash_erase(const struct spi_flash *flash, u32 offset, size_t len)
 		return -1;
 
 	ret = flash->ops->erase(flash, offset, len);
+	spi_flash_cache_invalidate(offset, len);
 
 	if (spi_flash_volatile_group_end(flash))
 		return -1;
@@ -0,0 +1,182 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+/*
+ * Read cache for the SPI boot device. CBFS walks issue lots of tiny reads (a file
+ * header, then its name and attributes, then the next header), each of which costs a
+ * full SPI command and address phase. Small reads are served from a handful of 4 KiB
+ * lines instead. When misses hit consecutive lines, the following lines are read ahead
+ * so that a linear walk through the CBFS only pays for one miss per stream.
+ *
+ * Large reads already amortize the command overhead and go straight to the flash.
+ * Writes and erases through spi_flash_write() and spi_flash_erase() invalidate any
+ * overlapping lines.
+ */
+
+#include <commonlib/helpers.h>
+#include <console/console.h>
+#include <spi_flash.h>
+#include <string.h>
+#include <types.h>
+
+#define LINE_SIZE	(4 * KiB)
+#define NUM_LINES	CONFIG_SPI_FLASH_READ_CACHE_LINES
+#define MAX_READAHEAD	MIN(CONFIG_SPI_FLASH_READ_CACHE_READAHEAD, NUM_LINES - 1)
+#define NO_LINE		UINT32_MAX
+
+struct cache_line {
+	uint32_t base;
+	uint32_t last_used;
+	bool valid;
+	bool prefetched;
+	uint8_t data[LINE_SIZE];
+};
+
+static struct cache_line lines[NUM_LINES];
+static uint32_t lru_clock;
+
+/* Line index following the most recent demand miss (or readahead), for stream detection. */
+static uint32_t next_sequential = NO_LINE;
+static unsigned int readahead_window;
+
+static struct {
+	uint32_t hits;
+	uint32_t misses;
+	uint32_t readahead;
+	uint32_t readahead_hits;
+	uint32_t bypassed;
+	uint64_t bytes_saved;
+} stats;
+
+static bool is_boot_flash(const struct spi_flash *flash)
+{
+	return flash->spi.bus == CONFIG_BOOT_DEVICE_SPI_FLASH_BUS && flash->spi.cs == 0;
+}
+
+static struct cache_line *lookup(uint32_t base)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(lines); i++) {
+		if (lines[i].valid && lines[i].base == base)
+			return &lines[i];
+	}
+
+	return NULL;
+}
+
+static struct cache_line *pick_victim(void)
+{
+	struct cache_line *victim = &lines[0];
+
+	for (size_t i = 0; i < ARRAY_SIZE(lines); i++) {
+		if (!lines[i].valid)
+			return &lines[i];
+		if (lines[i].last_used < victim->last_used)
+			victim = &lines[i];
+	}
+
+	return victim;
+}
+
+static struct cache_line *fill(const struct spi_flash *flash, uint32_t base, bool prefetch)
+{
+	struct cache_line *line = pick_victim();
+
+	line->valid = false;
+	if (spi_flash_read(flash, base, LINE_SIZE, line->data))
+		return NULL;
+
+	line->base = base;
+	line->last_used = ++lru_clock;
+	line->prefetched = prefetch;
+	line->valid = true;
+
+	return line;
+}
+
+static struct cache_line *miss(const struct spi_flash *flash, uint32_t base)
+{
+	const uint32_t index = base / LINE_SIZE;
+	struct cache_line *line;
+	unsigned int i;
+
+	stats.misses++;
+
+	/* Grow the window while misses keep following each other, reset it otherwise. */
+	if (index == next_sequential)
+		readahead_window = MIN(MAX(readahead_window * 2, 1U), MAX_READAHEAD);
+	else
+		readahead_window = 0;
+
+	line = fill(flash, base, false);
+	if (!line)
+		return NULL;
+
+	for (i = 1; i <= readahead_window; i++) {
+		const uint32_t ahead = base + i * LINE_SIZE;
+
+		if (ahead + LINE_SIZE > flash->size)
+			break;
+		if (lookup(ahead))
+			continue;
+		/* A failed readahead is not fatal, the line is simply not cached. */
+		if (!fill(flash, ahead, true))
+			break;
+		stats.readahead++;
+	}
+
+	next_sequential = index + i;
+
+	return line;
+}
+
+int spi_flash_cached_read(const struct spi_flash *flash, u32 offset, size_t len, void *buf)
+{
+	uint8_t *dst = buf;
+
+	if (len >= LINE_SIZE || !is_boot_flash(flash) || offset + len > flash->size) {
+		stats.bypassed++;
+		return spi_flash_read(flash, offset, len, buf);
+	}
+
+	while (len) {
+		const uint32_t base = ALIGN_DOWN(offset, LINE_SIZE);
+		const size_t chunk = MIN(len, base + LINE_SIZE - offset);
+		struct cache_line *line = lookup(base);
+
+		if (line) {
+			stats.hits++;
+			stats.bytes_saved += chunk;
+			if (line->prefetched) {
+				stats.readahead_hits++;
+				line->prefetched = false;
+			}
+			line->last_used = ++lru_clock;
+		} else {
+			line = miss(flash, base);
+			if (!line)
+				return -1;
+		}
+
+		memcpy(dst, &line->data[offset - base], chunk);
+		dst += chunk;
+		offset += chunk;
+		len -= chunk;
+	}
+
+	return 0;
+}
+
+void spi_flash_cache_invalidate(u32 offset, size_t len)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(lines); i++) {
+		if (lines[i].valid && lines[i].base < offset + len &&
+		    offset < lines[i].base + LINE_SIZE)
+			lines[i].valid = false;
+	}
+}
+
+void spi_flash_cache_report(void)
+{
+	printk(BIOS_DEBUG, "SPI read cache: %u hits, %u misses, %u/%u readahead lines used, "
+	       "%u bypassed, %llu bytes saved\n", stats.hits, stats.misses,
+	       stats.readahead_hits, stats.readahead, stats.bypassed, stats.bytes_saved);
+}
@@ -16,9 +16,14 @@
 
 #define CMD_READ_FAST_DUAL_OUTPUT	0x3b
 #define CMD_READ_FAST_DUAL_IO		0xbb
+#define CMD_READ_FAST_QUAD_OUTPUT	0x6b
+#define CMD_READ_FAST_QUAD_IO		0xeb
 
 #define CMD_READ_STATUS			0x05
+#define CMD_READ_STATUS2		0x35
+#define CMD_WRITE_STATUS		0x01
 #define CMD_WRITE_ENABLE		0x06
+#define CMD_VOLATILE_SR_WRITE_ENABLE	0x50
 
 #define CMD_BLOCK_ERASE			0xD8
 
@@ -26,6 +31,8 @@
 
 /* Common status */
 #define STATUS_WIP			0x01
+#define STATUS_QE_SR1_BIT6		0x40
+#define STATUS_QE_SR2_BIT1		0x02
 
 /* Send a single-byte command to the device and read the response */
 int spi_flash_cmd(const struct spi_slave *spi, u8 cmd, void *response, size_t len);
@@ -60,6 +67,16 @@ int spi_flash_cmd_write_page_program(const struct spi_flash *flash, u32 offset,
 /* Read len bytes into buf at offset. */
 int spi_flash_cmd_read(const struct spi_flash *flash, u32 offset, size_t len, void *buf);
 
+/*
+ * Set the Quad Enable bit so that IO2 and IO3 carry data instead of WP# and
+ * HOLD#. The _sr2 variant sets bit 1 of status register 2 with a volatile
+ * write (Winbond, GigaDevice), the _sr1 variant sets bit 6 of status
+ * register 1, which is non-volatile (Macronix, ISSI). Both only write when
+ * the bit isn't set yet and fail if the register turns out to be locked.
+ */
+int spi_flash_quad_enable_sr2(const struct spi_flash *flash);
+int spi_flash_quad_enable_sr1(const struct spi_flash *flash);
+
 /* Release from deep sleep an provide alternative rdid information. */
 int stmicro_release_deep_sleep_identify(const struct spi_slave *spi, u8 *idcode);
 
@@ -74,7 +91,8 @@ struct spi_flash_part_id {
 	uint16_t nr_sectors_shift : 4;
 	uint16_t fast_read_dual_output_support : 1;	/*  1-1-2 read */
 	uint16_t fast_read_dual_io_support : 1;		/*  1-2-2 read */
-	uint16_t _reserved_for_flags : 2;
+	uint16_t fast_read_quad_output_support : 1;	/*  1-1-4 read */
+	uint16_t fast_read_quad_io_support : 1;		/*  1-4-4 read */
 	/* Block protection. Currently used by Winbond. */
 	uint16_t protection_granularity_shift : 5;
 	uint16_t bp_bits : 3;
@@ -103,6 +121,8 @@ struct spi_flash_vendor_info {
 	const struct spi_flash_protection_ops *prot_ops;
 	/* Returns 0 on success. !0 otherwise. */
 	int (*after_probe)(const struct spi_flash *flash);
+	/* Set the Quad Enable bit. Returns 0 on success. !0 otherwise. */
+	int (*quad_enable)(const struct spi_flash *flash);
 };
 
 /* Manufacturer-specific probe information */
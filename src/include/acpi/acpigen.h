@@ -467,6 +467,50 @@ void acpigen_write_processor_package(const char *name,
 				     unsigned int first_core,
 				     unsigned int core_count);
 void acpigen_write_processor_cnot(const unsigned int number_of_cores);
+
+/*
+ * Templates stamp out copies of an object that only differ in a few fields, e.g. one
+ * processor Device per thread. The first copy is generated between acpigen_template_begin()
+ * and acpigen_template_end(), with the fields that differ written by the acpigen_template_*
+ * functions. These use a fixed-size encoding and record where the field is, so that
+ * acpigen_template_stamp() can memcpy() the object and only patch the fields, instead of
+ * emitting it again and computing and moving its PkgLengths.
+ */
+#define ACPIGEN_TEMPLATE_MAX_FIELDS	8
+
+enum acpigen_field_type {
+	ACPIGEN_FIELD_CPU_NAMESEG,	/* CONFIG_ACPI_CPU_STRING of the value */
+	ACPIGEN_FIELD_DWORD,		/* DWordConst data */
+};
+
+struct acpigen_template {
+	const char *start;
+	size_t size;
+	size_t num_fields;
+	struct {
+		size_t offset;
+		enum acpigen_field_type type;
+	} fields[ACPIGEN_TEMPLATE_MAX_FIELDS];
+};
+
+void acpigen_template_begin(struct acpigen_template *t);
+void acpigen_template_end(struct acpigen_template *t);
+/* \_SB.CPxx with the CPU's NameSeg as a field. */
+void acpigen_template_write_processor_namestring(struct acpigen_template *t,
+						 unsigned int cpu_index);
+/* A DWordConst field, even if the value has a shorter encoding. */
+void acpigen_template_write_dword(struct acpigen_template *t, uint32_t value);
+/* Like acpigen_write_processor_device(), with the name and _UID as fields. */
+void acpigen_template_write_processor_device(struct acpigen_template *t,
+					     unsigned int cpu_index);
+/* Append a copy of the template with its fields, in the order written, set to values. */
+void acpigen_template_stamp(const struct acpigen_template *t, const uint32_t *values);
+
+/*
+ * Write the processor Devices of CPUs 0 to count - 1, each with the objects emitted by
+ * body, if any. body is only called for CPU 0, so it must emit the same AML for all CPUs.
+ */
+void acpigen_write_processor_devices(unsigned int count, void (*body)(void *arg), void *arg);
 void acpigen_write_TSS_package(int entries, acpi_tstate_t *tstate_list);
 void acpigen_write_TSD_package(u32 domain, u32 numprocs, PSD_coord coordtype);
 void acpigen_write_mem32fixed(int readwrite, u32 base, u32 size);
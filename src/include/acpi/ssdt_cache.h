@@ -0,0 +1,23 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#ifndef __ACPI_SSDT_CACHE_H__
+#define __ACPI_SSDT_CACHE_H__
+
+#include <types.h>
+
+/*
+ * Emit the acpi_fill_ssdt output of all enabled devices at the current acpigen position.
+ * For devices with acpi_ssdt_cacheable set, the AML of a previous boot is reused if the
+ * cache key still matches. Those callbacks must not have side effects and may only depend
+ * on the device tree (device paths, IDs, resources), fw_config, the CPUs found and what
+ * acpi_ssdt_cache_platform_key() covers.
+ */
+void acpi_ssdt_cache_fill(void);
+
+/*
+ * Hash of the platform state that cacheable callbacks read from outside the device tree,
+ * e.g. P-state limits from MSRs that differ between CPU SKUs. Defaults to 0.
+ */
+uint64_t acpi_ssdt_cache_platform_key(void);
+
+#endif /* __ACPI_SSDT_CACHE_H__ */
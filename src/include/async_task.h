@@ -0,0 +1,91 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#ifndef ASYNC_TASK_H
+#define ASYNC_TASK_H
+
+#include <rdev_async.h>
+#include <timer.h>
+#include <types.h>
+
+/*
+ * Stackless tasks for work that spends most of its time waiting, e.g. on flash reads or
+ * for a device to become ready. A task is a step function which is called again each
+ * time what it waits for has happened. Between the calls, its state lives in a frame
+ * which embeds the struct async_task, so an outstanding task costs the size of that frame
+ * rather than a thread stack:
+ *
+ *	struct poll_op {
+ *		struct async_task task;
+ *		int tries;
+ *	};
+ *
+ *	static enum async_status poll_step(struct async_task *task)
+ *	{
+ *		struct poll_op *op = container_of(task, struct poll_op, task);
+ *
+ *		ASYNC_BEGIN(task);
+ *		for (op->tries = 0; op->tries < 10 && !ready(); op->tries++)
+ *			ASYNC_SLEEP_US(task, 100);
+ *		ASYNC_END(task);
+ *	}
+ *
+ * Local variables of the step function are lost at each ASYNC_* wait, and the waits
+ * can't be inside a switch statement of the step function.
+ *
+ * Tasks are run by the idle thread of COOP_MULTITASKING, and by async_task_wait() and
+ * async_tasks_wait_all() on whichever thread waits for them.
+ */
+
+enum async_status {
+	ASYNC_PENDING,
+	ASYNC_DONE,
+};
+
+struct async_task {
+	enum async_status (*step)(struct async_task *task);
+	/* Where ASYNC_BEGIN() resumes the step function. */
+	int resume;
+	volatile bool done;
+
+	/* For the scheduler only. */
+	bool queued;
+	struct mono_time expiration;
+	struct rdev_async_read *read;
+	struct async_task *next;
+};
+
+/* Start running step on the task. The task must stay valid until it's done. */
+void async_task_start(struct async_task *task, enum async_status (*step)(struct async_task *));
+
+/*
+ * Make the task wait for us microseconds, or until req has completed. Its step function
+ * is called again afterwards, once it has returned ASYNC_PENDING. A step function that
+ * returns ASYNC_PENDING without either of these is just called again later.
+ */
+void async_task_sleep_us(struct async_task *task, uint64_t us);
+void async_task_wait_read(struct async_task *task, struct rdev_async_read *req);
+
+/* Run the step functions of the tasks that can go on. Returns false if there were none. */
+bool async_tasks_run(void);
+
+/* Wait until the task, or all tasks, are done. */
+void async_task_wait(struct async_task *task);
+void async_tasks_wait_all(void);
+
+#define ASYNC_BEGIN(task)	switch ((task)->resume) { case 0:
+
+#define ASYNC_AWAIT(task, wait)							\
+	do {									\
+		(task)->resume = __LINE__;					\
+		wait;								\
+		return ASYNC_PENDING;						\
+	case __LINE__:;								\
+	} while (0)
+
+#define ASYNC_YIELD(task)		ASYNC_AWAIT(task, (void)0)
+#define ASYNC_SLEEP_US(task, us)	ASYNC_AWAIT(task, async_task_sleep_us(task, us))
+#define ASYNC_WAIT_READ(task, req)	ASYNC_AWAIT(task, async_task_wait_read(task, req))
+
+#define ASYNC_END(task)		} return ASYNC_DONE
+
+#endif /* ASYNC_TASK_H */
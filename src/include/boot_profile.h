@@ -0,0 +1,30 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#ifndef _BOOT_PROFILE_H_
+#define _BOOT_PROFILE_H_
+
+#include <commonlib/boot_profile_serialized.h>
+#include <types.h>
+
+#define BOOT_PROFILE_ENABLED (CONFIG(BOOT_PROFILE) && ENV_RAMSTAGE)
+
+#if BOOT_PROFILE_ENABLED
+/*
+ * Open an entry in the CBMEM_ID_BOOT_PROFILE table, nested in the innermost open entry of
+ * the running thread. A thread without open entries is nested in the innermost entry of
+ * the main thread that doesn't wait for it. |name| is copied and may be NULL. Returns a
+ * handle for boot_profile_end(), < 0 if nothing was recorded.
+ */
+int boot_profile_begin(enum boot_profile_type type, const char *name, uintptr_t addr);
+/* Close the entry, which has to be the innermost open one of the running thread. */
+void boot_profile_end(int handle);
+#else
+static inline int boot_profile_begin(enum boot_profile_type type, const char *name,
+				     uintptr_t addr)
+{
+	return -1;
+}
+static inline void boot_profile_end(int handle) {}
+#endif
+
+#endif /* _BOOT_PROFILE_H_ */
@@ -104,6 +104,9 @@ struct boot_state_callback {
 #if CONFIG(DEBUG_BOOT_STATE)
 	const char *location;
 #endif
+#if CONFIG(BOOT_PROFILE)
+	const char *name;
+#endif
 };
 
 static inline const char *bscb_location(const struct boot_state_callback *bscb)
@@ -115,6 +118,16 @@ static inline const char *bscb_location(const struct boot_state_callback *bscb)
 #endif
 }
 
+/* Name of the callback function, NULL if it wasn't set up with the macros below. */
+static inline const char *bscb_name(const struct boot_state_callback *bscb)
+{
+#if CONFIG(BOOT_PROFILE)
+	return bscb->name;
+#else
+	return NULL;
+#endif
+}
+
 #if CONFIG(DEBUG_BOOT_STATE)
 #define BOOT_STATE_CALLBACK_LOC __FILE__ ":" STRINGIFY(__LINE__)
 #define BOOT_STATE_CALLBACK_INIT_DEBUG .location = BOOT_STATE_CALLBACK_LOC,
@@ -127,12 +140,19 @@ static inline const char *bscb_location(const struct boot_state_callback *bscb)
 #define INIT_BOOT_STATE_CALLBACK_DEBUG(bscb_)
 #endif
 
+#if CONFIG(BOOT_PROFILE)
+#define BOOT_STATE_CALLBACK_INIT_PROFILE(func_) .name = #func_,
+#else
+#define BOOT_STATE_CALLBACK_INIT_PROFILE(func_)
+#endif
+
 #define BOOT_STATE_CALLBACK_INIT(func_, arg_)		\
 	{						\
 		.arg = arg_,				\
 		.callback = func_,			\
 		.next = NULL,				\
 		BOOT_STATE_CALLBACK_INIT_DEBUG		\
+		BOOT_STATE_CALLBACK_INIT_PROFILE(func_)	\
 	}
 
 #define BOOT_STATE_CALLBACK(name_, func_, arg_)	\
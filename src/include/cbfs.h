@@ -127,8 +127,8 @@ static inline void *cbfs_unverified_area_cbmem_alloc(const char *area, const cha
  */
 void cbfs_preload(const char *name);
 
-/* Removes a previously allocated CBFS mapping. Should try to unmap mappings in strict LIFO
-   order where possible, since mapping backends often don't support more complicated cases. */
+/* Removes a previously allocated CBFS mapping. Mappings backed by the cbfs_cache can be
+   unmapped in any order. */
 void cbfs_unmap(void *mapping);
 
 /* Load stage into memory filling in prog. Return 0 on success. < 0 on error. */
@@ -158,6 +158,13 @@ static inline bool cbfs_ro_file_exists(const char *name);
  */
 extern struct mem_pool cbfs_cache;
 
+/* Appends this stage's cbfs_cache usage to CBMEM (CONFIG_CBFS_CACHE_STATS). */
+#if CONFIG(CBFS_CACHE_STATS) && ENV_HAS_CBMEM
+void cbfs_cache_record_stats(void);
+#else
+static inline void cbfs_cache_record_stats(void) {}
+#endif
+
 /*
  * Data structure that represents "a" CBFS boot device, with optional metadata cache. Generally
  * we only have one of these, or two (RO and RW) when CONFIG(VBOOT) is set. The region device
@@ -209,6 +216,9 @@ void *_cbfs_default_allocator(void *arg, size_t size, const union cbfs_mdata *un
 
 void *_cbfs_cbmem_allocator(void *arg, size_t size, const union cbfs_mdata *unused);
 
+size_t _cbfs_lz4_parallel_decompress(const void *src, size_t srcn, void *dst, size_t dstn,
+				     const struct cbfs_file_attr_lz4_blocks *index);
+
 /**********************************************************************************************
  *                                  INLINE IMPLEMENTATIONS                                    *
  **********************************************************************************************/
@@ -0,0 +1,48 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#ifndef _CBFS_TRACE_H_
+#define _CBFS_TRACE_H_
+
+#include <commonlib/bsd/cbfs_mdata.h>
+#include <commonlib/cbfs_trace_serialized.h>
+#include <timer.h>
+#include <types.h>
+
+/* Tracing is only built into the stages that can hand the trace over through CBMEM. */
+#define CBFS_TRACE_ENABLED \
+	(CONFIG(CBFS_ACCESS_TRACE) && (ENV_SEPARATE_ROMSTAGE || ENV_POSTCAR || ENV_RAMSTAGE))
+
+struct cbfs_trace_times {
+	uint32_t read_us;
+	uint32_t decompress_us;
+};
+
+static inline void cbfs_trace_start(struct stopwatch *sw)
+{
+	if (CBFS_TRACE_ENABLED)
+		stopwatch_init(sw);
+}
+
+/* Adds the time since the last lap to *us and restarts the stopwatch. */
+static inline void cbfs_trace_lap(struct stopwatch *sw, uint32_t *us)
+{
+	if (!CBFS_TRACE_ENABLED)
+		return;
+	*us += stopwatch_duration_usecs(sw);
+	stopwatch_init(sw);
+}
+
+#if CBFS_TRACE_ENABLED
+/*
+ * Append an access to |mdata|'s file, whose data starts at |offset| on the boot device, to
+ * the CBMEM_ID_CBFS_TRACE table. Accesses before CBMEM is up are buffered and flushed from a
+ * CBMEM init hook, as long as the small early buffer lasts.
+ */
+void cbfs_trace_record(const union cbfs_mdata *mdata, size_t offset, uint8_t flags,
+		       const struct cbfs_trace_times *times);
+#else
+static inline void cbfs_trace_record(const union cbfs_mdata *mdata, size_t offset,
+				     uint8_t flags, const struct cbfs_trace_times *times) {}
+#endif
+
+#endif /* _CBFS_TRACE_H_ */
@@ -0,0 +1,30 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#ifndef _CONSOLE_ASYNC_H_
+#define _CONSOLE_ASYNC_H_
+
+#include <stddef.h>
+#include <types.h>
+
+#define CONSOLE_ASYNC_ENABLED (CONFIG(CONSOLE_ASYNC) && ENV_RAMSTAGE)
+
+#if CONSOLE_ASYNC_ENABLED
+/* True until console_async_flush(), while interactive console output is queued. */
+bool console_async_active(void);
+/*
+ * Queue a byte for the interactive consoles. If the buffer is full, the oldest byte is
+ * written out first. Returns false once queueing has stopped.
+ */
+bool console_async_tx_byte(unsigned char byte);
+/* Write up to max_bytes queued bytes to the interactive consoles. Returns the count. */
+size_t console_async_drain(size_t max_bytes);
+/* Write out and flush everything queued, later output is written synchronously. */
+void console_async_flush(void);
+#else
+static inline bool console_async_active(void) { return false; }
+static inline bool console_async_tx_byte(unsigned char byte) { return false; }
+static inline size_t console_async_drain(size_t max_bytes) { return 0; }
+static inline void console_async_flush(void) {}
+#endif
+
+#endif /* _CONSOLE_ASYNC_H_ */
@@ -74,6 +74,31 @@ enum { CONSOLE_LOG_NONE = 0, CONSOLE_LOG_FAST, CONSOLE_LOG_ALL };
 	CONFIG(EM100PRO_SPI_CONSOLE) || CONFIG(CONSOLE_SPI_FLASH) || \
 	CONFIG(CONSOLE_SYSTEM76_EC) || CONFIG(CONSOLE_AMD_SIMNOW))
 
+/* SMM and AGESA are linked without the .printk_tokens section placement. */
+#define CONSOLE_TOKENIZED_ENABLED (CONFIG(CONSOLE_TOKENIZED) && !ENV_SMM && !ENV_LIBAGESA)
+
+#if CONSOLE_TOKENIZED_ENABLED
+#include <console/tokenize.h>
+
+int printk_tokenized(int msg_level, uint32_t token, uint64_t arg_types, ...);
+
+static inline __printf(1, 2) void printk_format_check(const char *fmt, ...) {}
+
+/*
+ * Log the hash of the format string and the raw arguments instead of formatting them.
+ * The format string, which has to be a literal, only goes into the .printk_tokens
+ * section that the host tools read it back from.
+ */
+#define printk(LEVEL, fmt, ...) ({							\
+	static const char __printk_fmt[] __attribute__((used))			\
+		__section(PRINTK_TOKEN_SECTION) = fmt;					\
+	if (0)										\
+		printk_format_check(fmt, ##__VA_ARGS__);				\
+	printk_tokenized(LEVEL, PRINTK_TOKEN(fmt), PRINTK_ARG_TYPES(__VA_ARGS__),	\
+			 ##__VA_ARGS__);						\
+})
+#endif
+
 #else
 static inline int get_log_level(void) { return -1; }
 static inline void console_init(void) {}
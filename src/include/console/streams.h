@@ -15,6 +15,10 @@ void console_interactive_tx_byte(unsigned char byte, void *data_unused);
 /* Consoles that store logs on some medium for later retrieval. */
 void console_stored_tx_byte(unsigned char byte, void *data_unused);
 
+/* Write to and flush the interactive consoles right away, even with CONSOLE_ASYNC. */
+void console_interactive_hw_tx_byte(unsigned char byte);
+void console_interactive_hw_tx_flush(void);
+
 /*
  * Write number_of_bytes data bytes from buffer to the serial device.
  * If number_of_bytes is zero, wait until all serial data is output.
@@ -0,0 +1,242 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#ifndef _CONSOLE_TOKENIZE_H_
+#define _CONSOLE_TOKENIZE_H_
+
+#include <commonlib/printk_token_serialized.h>
+#include <stdint.h>
+
+/*
+ * Compile-time version of printk_token_hash() for string literals. The compiler folds it
+ * into a constant, so the format string itself doesn't end up in the stage.
+ */
+#define PRINTK_TOKEN_CHAR(s, i, k) \
+	((i) < sizeof(s) - 1 ? (uint32_t)(uint8_t)(s)[(i) < sizeof(s) ? (i) : 0] * (k) : 0u)
+
+#define PRINTK_TOKEN(s) ((uint32_t)(sizeof(s) - 1) + \
+	PRINTK_TOKEN_CHAR(s, 0, 0x0001003fu) + \
+	PRINTK_TOKEN_CHAR(s, 1, 0x007e0f81u) + \
+	PRINTK_TOKEN_CHAR(s, 2, 0x2e86d0bfu) + \
+	PRINTK_TOKEN_CHAR(s, 3, 0x43ec5f01u) + \
+	PRINTK_TOKEN_CHAR(s, 4, 0x162c613fu) + \
+	PRINTK_TOKEN_CHAR(s, 5, 0xd62aee81u) + \
+	PRINTK_TOKEN_CHAR(s, 6, 0xa311b1bfu) + \
+	PRINTK_TOKEN_CHAR(s, 7, 0xd319be01u) + \
+	PRINTK_TOKEN_CHAR(s, 8, 0xb156c23fu) + \
+	PRINTK_TOKEN_CHAR(s, 9, 0x6698cd81u) + \
+	PRINTK_TOKEN_CHAR(s, 10, 0x0d1b92bfu) + \
+	PRINTK_TOKEN_CHAR(s, 11, 0xcc881d01u) + \
+	PRINTK_TOKEN_CHAR(s, 12, 0x7280233fu) + \
+	PRINTK_TOKEN_CHAR(s, 13, 0x50c7ac81u) + \
+	PRINTK_TOKEN_CHAR(s, 14, 0x8da473bfu) + \
+	PRINTK_TOKEN_CHAR(s, 15, 0x4f377c01u) + \
+	PRINTK_TOKEN_CHAR(s, 16, 0xfaa8843fu) + \
+	PRINTK_TOKEN_CHAR(s, 17, 0x33b78b81u) + \
+	PRINTK_TOKEN_CHAR(s, 18, 0x45ac54bfu) + \
+	PRINTK_TOKEN_CHAR(s, 19, 0x7a27db01u) + \
+	PRINTK_TOKEN_CHAR(s, 20, 0xeacfe53fu) + \
+	PRINTK_TOKEN_CHAR(s, 21, 0xae686a81u) + \
+	PRINTK_TOKEN_CHAR(s, 22, 0x563335bfu) + \
+	PRINTK_TOKEN_CHAR(s, 23, 0x6c593a01u) + \
+	PRINTK_TOKEN_CHAR(s, 24, 0xe3f6463fu) + \
+	PRINTK_TOKEN_CHAR(s, 25, 0x5fda4981u) + \
+	PRINTK_TOKEN_CHAR(s, 26, 0xe03916bfu) + \
+	PRINTK_TOKEN_CHAR(s, 27, 0x44cb9901u) + \
+	PRINTK_TOKEN_CHAR(s, 28, 0x871ba73fu) + \
+	PRINTK_TOKEN_CHAR(s, 29, 0xe70d2881u) + \
+	PRINTK_TOKEN_CHAR(s, 30, 0x04bdf7bfu) + \
+	PRINTK_TOKEN_CHAR(s, 31, 0x227ef801u) + \
+	PRINTK_TOKEN_CHAR(s, 32, 0x7540083fu) + \
+	PRINTK_TOKEN_CHAR(s, 33, 0xe3010781u) + \
+	PRINTK_TOKEN_CHAR(s, 34, 0xe4c1d8bfu) + \
+	PRINTK_TOKEN_CHAR(s, 35, 0x24735701u) + \
+	PRINTK_TOKEN_CHAR(s, 36, 0x4f63693fu) + \
+	PRINTK_TOKEN_CHAR(s, 37, 0xf2b5e681u) + \
+	PRINTK_TOKEN_CHAR(s, 38, 0xa144b9bfu) + \
+	PRINTK_TOKEN_CHAR(s, 39, 0x69a8b601u) + \
+	PRINTK_TOKEN_CHAR(s, 40, 0xb685ca3fu) + \
+	PRINTK_TOKEN_CHAR(s, 41, 0xb52bc581u) + \
+	PRINTK_TOKEN_CHAR(s, 42, 0x5b469abfu) + \
+	PRINTK_TOKEN_CHAR(s, 43, 0x111f1501u) + \
+	PRINTK_TOKEN_CHAR(s, 44, 0x4ba72b3fu) + \
+	PRINTK_TOKEN_CHAR(s, 45, 0xc962a481u) + \
+	PRINTK_TOKEN_CHAR(s, 46, 0x33c77bbfu) + \
+	PRINTK_TOKEN_CHAR(s, 47, 0x39d67401u) + \
+	PRINTK_TOKEN_CHAR(s, 48, 0xafc78c3fu) + \
+	PRINTK_TOKEN_CHAR(s, 49, 0xce5a8381u) + \
+	PRINTK_TOKEN_CHAR(s, 50, 0x4bc75cbfu) + \
+	PRINTK_TOKEN_CHAR(s, 51, 0x02ced301u) + \
+	PRINTK_TOKEN_CHAR(s, 52, 0x83e6ed3fu) + \
+	PRINTK_TOKEN_CHAR(s, 53, 0x63136281u) + \
+	PRINTK_TOKEN_CHAR(s, 54, 0xc4463dbfu) + \
+	PRINTK_TOKEN_CHAR(s, 55, 0x8b083201u) + \
+	PRINTK_TOKEN_CHAR(s, 56, 0x69054e3fu) + \
+	PRINTK_TOKEN_CHAR(s, 57, 0x268d4181u) + \
+	PRINTK_TOKEN_CHAR(s, 58, 0xbe441ebfu) + \
+	PRINTK_TOKEN_CHAR(s, 59, 0xf1829101u) + \
+	PRINTK_TOKEN_CHAR(s, 60, 0x0022af3fu) + \
+	PRINTK_TOKEN_CHAR(s, 61, 0xb7c82081u) + \
+	PRINTK_TOKEN_CHAR(s, 62, 0x5ac0ffbfu) + \
+	PRINTK_TOKEN_CHAR(s, 63, 0x553df001u) + \
+	PRINTK_TOKEN_CHAR(s, 64, 0xea3f103fu) + \
+	PRINTK_TOKEN_CHAR(s, 65, 0xb5c3ff81u) + \
+	PRINTK_TOKEN_CHAR(s, 66, 0xbabce0bfu) + \
+	PRINTK_TOKEN_CHAR(s, 67, 0xd53a4f01u) + \
+	PRINTK_TOKEN_CHAR(s, 68, 0xc85a713fu) + \
+	PRINTK_TOKEN_CHAR(s, 69, 0xbf80de81u) + \
+	PRINTK_TOKEN_CHAR(s, 70, 0xff37c1bfu) + \
+	PRINTK_TOKEN_CHAR(s, 71, 0x9077ae01u) + \
+	PRINTK_TOKEN_CHAR(s, 72, 0x3b74d23fu) + \
+	PRINTK_TOKEN_CHAR(s, 73, 0x73febd81u) + \
+	PRINTK_TOKEN_CHAR(s, 74, 0x4931a2bfu) + \
+	PRINTK_TOKEN_CHAR(s, 75, 0xa5f60d01u) + \
+	PRINTK_TOKEN_CHAR(s, 76, 0xe48e333fu) + \
+	PRINTK_TOKEN_CHAR(s, 77, 0x723d9c81u) + \
+	PRINTK_TOKEN_CHAR(s, 78, 0xb9aa83bfu) + \
+	PRINTK_TOKEN_CHAR(s, 79, 0x34b56c01u) + \
+	PRINTK_TOKEN_CHAR(s, 80, 0x64a6943fu) + \
+	PRINTK_TOKEN_CHAR(s, 81, 0x593d7b81u) + \
+	PRINTK_TOKEN_CHAR(s, 82, 0x71a264bfu) + \
+	PRINTK_TOKEN_CHAR(s, 83, 0x5bb5cb01u) + \
+	PRINTK_TOKEN_CHAR(s, 84, 0x5cbdf53fu) + \
+	PRINTK_TOKEN_CHAR(s, 85, 0xc7fe5a81u) + \
+	PRINTK_TOKEN_CHAR(s, 86, 0x921945bfu) + \
+	PRINTK_TOKEN_CHAR(s, 87, 0x39f72a01u) + \
+	PRINTK_TOKEN_CHAR(s, 88, 0x6dd4563fu) + \
+	PRINTK_TOKEN_CHAR(s, 89, 0x5d803981u) + \
+	PRINTK_TOKEN_CHAR(s, 90, 0x3c0f26bfu) + \
+	PRINTK_TOKEN_CHAR(s, 91, 0xee798901u) + \
+	PRINTK_TOKEN_CHAR(s, 92, 0x38e9b73fu) + \
+	PRINTK_TOKEN_CHAR(s, 93, 0xb8c31881u) + \
+	PRINTK_TOKEN_CHAR(s, 94, 0x908407bfu) + \
+	PRINTK_TOKEN_CHAR(s, 95, 0x983ce801u) + \
+	PRINTK_TOKEN_CHAR(s, 96, 0x5efe183fu) + \
+	PRINTK_TOKEN_CHAR(s, 97, 0x78c6f781u) + \
+	PRINTK_TOKEN_CHAR(s, 98, 0xb077e8bfu) + \
+	PRINTK_TOKEN_CHAR(s, 99, 0x56414701u) + \
+	PRINTK_TOKEN_CHAR(s, 100, 0x8111793fu) + \
+	PRINTK_TOKEN_CHAR(s, 101, 0x3c8bd681u) + \
+	PRINTK_TOKEN_CHAR(s, 102, 0xbceac9bfu) + \
+	PRINTK_TOKEN_CHAR(s, 103, 0x4786a601u) + \
+	PRINTK_TOKEN_CHAR(s, 104, 0x4023da3fu) + \
+	PRINTK_TOKEN_CHAR(s, 105, 0xa311b581u) + \
+	PRINTK_TOKEN_CHAR(s, 106, 0xd6dcaabfu) + \
+	PRINTK_TOKEN_CHAR(s, 107, 0x8b0d0501u) + \
+	PRINTK_TOKEN_CHAR(s, 108, 0x3d353b3fu) + \
+	PRINTK_TOKEN_CHAR(s, 109, 0x4b589481u) + \
+	PRINTK_TOKEN_CHAR(s, 110, 0x1f4d8bbfu) + \
+	PRINTK_TOKEN_CHAR(s, 111, 0x3fd46401u) + \
+	PRINTK_TOKEN_CHAR(s, 112, 0x19459c3fu) + \
+	PRINTK_TOKEN_CHAR(s, 113, 0xd4607381u) + \
+	PRINTK_TOKEN_CHAR(s, 114, 0xb73d6cbfu) + \
+	PRINTK_TOKEN_CHAR(s, 115, 0x84dcc301u) + \
+	PRINTK_TOKEN_CHAR(s, 116, 0x7554fd3fu) + \
+	PRINTK_TOKEN_CHAR(s, 117, 0xdd295281u) + \
+	PRINTK_TOKEN_CHAR(s, 118, 0xbfac4dbfu) + \
+	PRINTK_TOKEN_CHAR(s, 119, 0x79262201u) + \
+	PRINTK_TOKEN_CHAR(s, 120, 0xf2635e3fu) + \
+	PRINTK_TOKEN_CHAR(s, 121, 0x04b33181u) + \
+	PRINTK_TOKEN_CHAR(s, 122, 0x599a2ebfu) + \
+	PRINTK_TOKEN_CHAR(s, 123, 0x3bb08101u) + \
+	PRINTK_TOKEN_CHAR(s, 124, 0x3170bf3fu) + \
+	PRINTK_TOKEN_CHAR(s, 125, 0xe9fe1081u) + \
+	PRINTK_TOKEN_CHAR(s, 126, 0xa6070fbfu) + \
+	PRINTK_TOKEN_CHAR(s, 127, 0xeb7be001u))
+
+_Static_assert(PRINTK_TOKEN_HASH_LEN == 128, "PRINTK_TOKEN() hashes 128 characters");
+
+/* Pointers are passed like longs in all ABIs coreboot supports. */
+#define PRINTK_ARG_LONG (sizeof(long) > sizeof(uint32_t) ? PRINTK_ARG_64 : PRINTK_ARG_32)
+
+/*
+ * The format string isn't parsed, so any `char *` is logged as a string, even for a %p.
+ * __builtin_classify_type() rather than sizeof(), which doesn't work on bit-fields.
+ */
+#define PRINTK_ARG_TYPE(x) _Generic((x),					\
+	char *: PRINTK_ARG_STRING,						\
+	const char *: PRINTK_ARG_STRING,					\
+	long long: PRINTK_ARG_64,						\
+	unsigned long long: PRINTK_ARG_64,					\
+	long: PRINTK_ARG_LONG,							\
+	unsigned long: PRINTK_ARG_LONG,						\
+	default: (__builtin_classify_type(x) == 5 ? PRINTK_ARG_LONG : PRINTK_ARG_32))
+
+#define PRINTK_NARGS(...) PRINTK_NARGS_(_, ##__VA_ARGS__,				\
+	32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17,		\
+	16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define PRINTK_NARGS_(_, _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14,	\
+	_15, _16, _17, _18, _19, _20, _21, _22, _23, _24, _25, _26, _27, _28, _29, _30,	\
+	_31, _32, n, ...) n
+
+#define PRINTK_CAT(a, b) PRINTK_CAT_(a, b)
+#define PRINTK_CAT_(a, b) a##b
+
+/* PRINTK_ARG_* of each argument, PRINTK_ARG_BITS each with the first one lowest. */
+#define PRINTK_ARG_TYPES(...) \
+	PRINTK_CAT(PRINTK_ARG_TYPES_, PRINTK_NARGS(__VA_ARGS__))(__VA_ARGS__)
+#define PRINTK_ARG_TYPES_0() 0ull
+#define PRINTK_ARG_TYPES_1(a) ((uint64_t)PRINTK_ARG_TYPE(a))
+#define PRINTK_ARG_TYPES_2(a, ...) \
+	(PRINTK_ARG_TYPES_1(a) | PRINTK_ARG_TYPES_1(__VA_ARGS__) << PRINTK_ARG_BITS)
+#define PRINTK_ARG_TYPES_3(a, ...) \
+	(PRINTK_ARG_TYPES_1(a) | PRINTK_ARG_TYPES_2(__VA_ARGS__) << PRINTK_ARG_BITS)
+#define PRINTK_ARG_TYPES_4(a, ...) \
+	(PRINTK_ARG_TYPES_1(a) | PRINTK_ARG_TYPES_3(__VA_ARGS__) << PRINTK_ARG_BITS)
+#define PRINTK_ARG_TYPES_5(a, ...) \
+	(PRINTK_ARG_TYPES_1(a) | PRINTK_ARG_TYPES_4(__VA_ARGS__) << PRINTK_ARG_BITS)
+#define PRINTK_ARG_TYPES_6(a, ...) \
+	(PRINTK_ARG_TYPES_1(a) | PRINTK_ARG_TYPES_5(__VA_ARGS__) << PRINTK_ARG_BITS)
+#define PRINTK_ARG_TYPES_7(a, ...) \
+	(PRINTK_ARG_TYPES_1(a) | PRINTK_ARG_TYPES_6(__VA_ARGS__) << PRINTK_ARG_BITS)
+#define PRINTK_ARG_TYPES_8(a, ...) \
+	(PRINTK_ARG_TYPES_1(a) | PRINTK_ARG_TYPES_7(__VA_ARGS__) << PRINTK_ARG_BITS)
+#define PRINTK_ARG_TYPES_9(a, ...) \
+	(PRINTK_ARG_TYPES_1(a) | PRINTK_ARG_TYPES_8(__VA_ARGS__) << PRINTK_ARG_BITS)
+#define PRINTK_ARG_TYPES_10(a, ...) \
+	(PRINTK_ARG_TYPES_1(a) | PRINTK_ARG_TYPES_9(__VA_ARGS__) << PRINTK_ARG_BITS)
+#define PRINTK_ARG_TYPES_11(a, ...) \
+	(PRINTK_ARG_TYPES_1(a) | PRINTK_ARG_TYPES_10(__VA_ARGS__) << PRINTK_ARG_BITS)
+#define PRINTK_ARG_TYPES_12(a, ...) \
+	(PRINTK_ARG_TYPES_1(a) | PRINTK_ARG_TYPES_11(__VA_ARGS__) << PRINTK_ARG_BITS)
+#define PRINTK_ARG_TYPES_13(a, ...) \
+	(PRINTK_ARG_TYPES_1(a) | PRINTK_ARG_TYPES_12(__VA_ARGS__) << PRINTK_ARG_BITS)
+#define PRINTK_ARG_TYPES_14(a, ...) \
+	(PRINTK_ARG_TYPES_1(a) | PRINTK_ARG_TYPES_13(__VA_ARGS__) << PRINTK_ARG_BITS)
+#define PRINTK_ARG_TYPES_15(a, ...) \
+	(PRINTK_ARG_TYPES_1(a) | PRINTK_ARG_TYPES_14(__VA_ARGS__) << PRINTK_ARG_BITS)
+#define PRINTK_ARG_TYPES_16(a, ...) \
+	(PRINTK_ARG_TYPES_1(a) | PRINTK_ARG_TYPES_15(__VA_ARGS__) << PRINTK_ARG_BITS)
+#define PRINTK_ARG_TYPES_17(a, ...) \
+	(PRINTK_ARG_TYPES_1(a) | PRINTK_ARG_TYPES_16(__VA_ARGS__) << PRINTK_ARG_BITS)
+#define PRINTK_ARG_TYPES_18(a, ...) \
+	(PRINTK_ARG_TYPES_1(a) | PRINTK_ARG_TYPES_17(__VA_ARGS__) << PRINTK_ARG_BITS)
+#define PRINTK_ARG_TYPES_19(a, ...) \
+	(PRINTK_ARG_TYPES_1(a) | PRINTK_ARG_TYPES_18(__VA_ARGS__) << PRINTK_ARG_BITS)
+#define PRINTK_ARG_TYPES_20(a, ...) \
+	(PRINTK_ARG_TYPES_1(a) | PRINTK_ARG_TYPES_19(__VA_ARGS__) << PRINTK_ARG_BITS)
+#define PRINTK_ARG_TYPES_21(a, ...) \
+	(PRINTK_ARG_TYPES_1(a) | PRINTK_ARG_TYPES_20(__VA_ARGS__) << PRINTK_ARG_BITS)
+#define PRINTK_ARG_TYPES_22(a, ...) \
+	(PRINTK_ARG_TYPES_1(a) | PRINTK_ARG_TYPES_21(__VA_ARGS__) << PRINTK_ARG_BITS)
+#define PRINTK_ARG_TYPES_23(a, ...) \
+	(PRINTK_ARG_TYPES_1(a) | PRINTK_ARG_TYPES_22(__VA_ARGS__) << PRINTK_ARG_BITS)
+#define PRINTK_ARG_TYPES_24(a, ...) \
+	(PRINTK_ARG_TYPES_1(a) | PRINTK_ARG_TYPES_23(__VA_ARGS__) << PRINTK_ARG_BITS)
+#define PRINTK_ARG_TYPES_25(a, ...) \
+	(PRINTK_ARG_TYPES_1(a) | PRINTK_ARG_TYPES_24(__VA_ARGS__) << PRINTK_ARG_BITS)
+#define PRINTK_ARG_TYPES_26(a, ...) \
+	(PRINTK_ARG_TYPES_1(a) | PRINTK_ARG_TYPES_25(__VA_ARGS__) << PRINTK_ARG_BITS)
+#define PRINTK_ARG_TYPES_27(a, ...) \
+	(PRINTK_ARG_TYPES_1(a) | PRINTK_ARG_TYPES_26(__VA_ARGS__) << PRINTK_ARG_BITS)
+#define PRINTK_ARG_TYPES_28(a, ...) \
+	(PRINTK_ARG_TYPES_1(a) | PRINTK_ARG_TYPES_27(__VA_ARGS__) << PRINTK_ARG_BITS)
+#define PRINTK_ARG_TYPES_29(a, ...) \
+	(PRINTK_ARG_TYPES_1(a) | PRINTK_ARG_TYPES_28(__VA_ARGS__) << PRINTK_ARG_BITS)
+#define PRINTK_ARG_TYPES_30(a, ...) \
+	(PRINTK_ARG_TYPES_1(a) | PRINTK_ARG_TYPES_29(__VA_ARGS__) << PRINTK_ARG_BITS)
+#define PRINTK_ARG_TYPES_31(a, ...) \
+	(PRINTK_ARG_TYPES_1(a) | PRINTK_ARG_TYPES_30(__VA_ARGS__) << PRINTK_ARG_BITS)
+#define PRINTK_ARG_TYPES_32(a, ...) \
+	(PRINTK_ARG_TYPES_1(a) | PRINTK_ARG_TYPES_31(__VA_ARGS__) << PRINTK_ARG_BITS)
+
+#endif /* _CONSOLE_TOKENIZE_H_ */
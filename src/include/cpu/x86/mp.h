@@ -20,6 +20,12 @@ static inline void mfence(void)
 		__asm__ __volatile__("lock; addl $0,0(%%esp)": : : "memory");
 }
 
+/* How the APs load microcode, see get_microcode_info() below. */
+#define MP_MICROCODE_SERIAL		0
+#define MP_MICROCODE_PARALLEL		1
+/* One CPU at a time in each package, but all packages in parallel. */
+#define MP_MICROCODE_PER_PACKAGE	2
+
 /* The sequence of the callbacks are in calling order. */
 struct mp_ops {
 	/*
@@ -45,7 +51,7 @@ struct mp_ops {
 				size_t *smm_save_state_size);
 	/*
 	 * Optionally fill in pointer to microcode and indicate if the APs
-	 * can load the microcode in parallel.
+	 * can load the microcode in parallel, as one of MP_MICROCODE_*.
 	 */
 	void (*get_microcode_info)(const void **microcode, int *parallel);
 	/*
@@ -94,6 +100,8 @@ struct mp_ops {
  *    relocation_handler() in SMM.
  * 8. mp_initialize_cpu() for each cpu
  * 9. post_mp_init()
+ * With MP_PARALLEL_FLIGHT_PLAN, 6. runs before the APs are started, and the
+ * APs go through 7. and 8. without waiting for the BSP.
  */
 enum cb_err mp_init_with_smm(struct bus *cpu_bus, const struct mp_ops *mp_ops);
 
@@ -122,6 +130,12 @@ enum cb_err mp_run_on_aps(void (*func)(void *), void *arg, int logical_cpu_num,
 enum cb_err mp_run_on_all_aps(void (*func)(void *), void *arg, long expire_us,
 			      bool run_parallel);
 
+/*
+ * Returns true while the APs are waiting for work issued through mp_run_on_aps(), i.e.
+ * after MP init completed with PARALLEL_MP_AP_WORK and before mp_park_aps().
+ */
+bool mp_aps_accept_work(void);
+
 /* Like mp_run_on_aps() but also runs func on BSP. */
 enum cb_err mp_run_on_all_cpus(void (*func)(void *), void *arg);
 
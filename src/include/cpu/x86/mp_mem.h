@@ -0,0 +1,25 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#ifndef CPU_X86_MP_MEM_H
+#define CPU_X86_MP_MEM_H
+
+#include <memrange.h>
+#include <types.h>
+
+/*
+ * Clear or test all ranges of mem tagged tag on the BSP and all APs waiting for work, in
+ * chunks of up to 2 MiB. With a 32-bit ramstage, each CPU maps memory above 4 GiB through
+ * its own map_2M_page() window. Ranges must be 4 KiB aligned and must not hold anything
+ * coreboot still uses.
+ */
+
+/* Fill the ranges with zeros. Returns CB_ERR_ARG without touching them if they can't
+   be reached from this stage. */
+enum cb_err mp_mem_clear(const struct memranges *mem, unsigned long tag);
+
+/* Write an address pattern and its complement to the ranges and read each back, storing
+   the number of words that read back wrong in bad_words. The ranges are left cleared.
+   Returns CB_ERR_ARG like mp_mem_clear(). */
+enum cb_err mp_mem_test(const struct memranges *mem, unsigned long tag, uint64_t *bad_words);
+
+#endif /* CPU_X86_MP_MEM_H */
@@ -0,0 +1,51 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#ifndef _X86_MP_TASK_H_
+#define _X86_MP_TASK_H_
+
+#include <types.h>
+
+/*
+ * A pool of small jobs which the BSP and the APs run while the APs wait for work issued
+ * through mp_run_on_aps(), i.e. after MP init with PARALLEL_MP_AP_WORK and before
+ * mp_park_aps(). Each CPU has its own queue: it runs the newest of its own tasks first
+ * and, once it has none left, steals the oldest ones from the others. Tasks may submit
+ * and join tasks themselves.
+ *
+ * Outside of that window, or when the queue of the CPU is full, mp_task_submit() just
+ * runs the task right away. While an AP runs a task, it doesn't pick up mp_run_on_aps()
+ * calls, so tasks should be short.
+ */
+struct mp_task {
+	void (*func)(void *arg);
+	void *arg;
+	/* Set once func returned. */
+	int done;
+};
+
+#if CONFIG(MP_TASK_POOL)
+/* Queue func(arg) in the task, which must stay valid until it's done. */
+void mp_task_submit(struct mp_task *task, void (*func)(void *arg), void *arg);
+
+/* Wait until the task is done, running queued tasks in the meantime. */
+void mp_task_join(struct mp_task *task);
+
+/* Wait until all tasks are done, running queued tasks in the meantime. */
+void mp_task_wait_all(void);
+
+/* Run one queued task on this CPU. Returns false if there was none. */
+bool mp_task_run_one(void);
+#else
+static inline void mp_task_submit(struct mp_task *task, void (*func)(void *arg), void *arg)
+{
+	task->func = func;
+	task->arg = arg;
+	func(arg);
+	task->done = 1;
+}
+static inline void mp_task_join(struct mp_task *task) {}
+static inline void mp_task_wait_all(void) {}
+static inline bool mp_task_run_one(void) { return false; }
+#endif
+
+#endif /* _X86_MP_TASK_H_ */
@@ -11,4 +11,7 @@
  */
 void set_cpu_topology_from_leaf_b(struct device *cpu);
 
+/* Get the number of APIC ID bits below the package ID from CPUID EAX=0xb. */
+enum cb_err get_cpu_package_shift(unsigned int *shift);
+
 #endif
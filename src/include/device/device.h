@@ -56,6 +56,8 @@ struct device_operations {
 	unsigned long (*write_acpi_tables)(const struct device *dev,
 		unsigned long start, struct acpi_rsdp *rsdp);
 	void (*acpi_fill_ssdt)(const struct device *dev);
+	/* acpi_fill_ssdt output may be reused across boots, see ACPI_SSDT_CACHE. */
+	bool acpi_ssdt_cacheable;
 	const char *(*acpi_name)(const struct device *dev);
 	/* Returns the optional _HID (Hardware ID) */
 	const char *(*acpi_hid)(const struct device *dev);
@@ -128,6 +130,8 @@ struct device {
 	struct device_operations *ops;
 	struct chip_operations *chip_ops;
 	const char *name;
+	/* NULL-terminated list of devices to initialize before this one, or NULL. */
+	DEVTREE_CONST struct device *const *init_after;
 #if CONFIG(GENERATE_SMBIOS_TABLES)
 	u8 smbios_slot_type;
 	u8 smbios_slot_data_width;
@@ -37,6 +37,13 @@ static inline int elog_smbios_write_type15(unsigned long *current,
 static inline int elog_add_extended_event(u8 type, u32 complement) { return 0; }
 #endif
 
+/* Write events held back by ELOG_DEFERRED_SYNC to flash. Returns < 0 on failure. */
+#if CONFIG(ELOG_DEFERRED_SYNC) && !ENV_DECOMPRESSOR && !ENV_SMM
+int elog_flush(void);
+#else
+static inline int elog_flush(void) { return 0; }
+#endif
+
 #if CONFIG(ELOG_GSMI)
 #define elog_gsmi_add_event elog_add_event
 #define elog_gsmi_add_event_byte elog_add_event_byte
@@ -0,0 +1,61 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#ifndef RDEV_ASYNC_H
+#define RDEV_ASYNC_H
+
+#include <commonlib/region.h>
+#include <types.h>
+
+/*
+ * Asynchronous reads from region devices. A caller queues any number of reads
+ * with rdev_readat_async() and later collects them with rdev_async_wait() (or
+ * checks on them with rdev_async_poll()), optionally getting a callback when
+ * each one finishes.
+ *
+ * Region devices backed by a controller with DMA or FIFO interrupts implement
+ * .readat_async natively and call rdev_async_complete() when a read is done.
+ * For all others, the reads are serviced in order by a single worker thread
+ * when cooperative multitasking is available, or right away otherwise.
+ */
+
+struct rdev_async_read;
+
+/* Called on completion, from whichever context completed the read. */
+typedef void (*rdev_async_done_t)(struct rdev_async_read *req);
+
+struct rdev_async_read {
+	/* Filled in by rdev_readat_async(). Offset is relative to the root device. */
+	const struct region_device *rdev;
+	void *buffer;
+	size_t offset;
+	size_t size;
+	rdev_async_done_t done;
+	void *arg;
+
+	/* Valid once complete is set. Number of bytes read, or < 0 on error. */
+	ssize_t result;
+	volatile bool complete;
+
+	/* For use by whoever services the read while it's in flight. */
+	struct rdev_async_read *next;
+	void *priv;
+};
+
+/*
+ * Queue a read of size bytes at offset within rd into b. The request must stay
+ * valid until it has completed. Returns 0 if the read was queued (or already
+ * completed), < 0 on invalid arguments, in which case done isn't called.
+ */
+int rdev_readat_async(const struct region_device *rd, struct rdev_async_read *req, void *b,
+		      size_t offset, size_t size, rdev_async_done_t done, void *arg);
+
+/* Returns true once req has completed, driving polled controllers forward. */
+bool rdev_async_poll(struct rdev_async_read *req);
+
+/* Wait for req to complete. Returns the number of bytes read, or < 0 on error. */
+ssize_t rdev_async_wait(struct rdev_async_read *req);
+
+/* Called by region device implementations to finish a request. */
+void rdev_async_complete(struct rdev_async_read *req, ssize_t result);
+
+#endif /* RDEV_ASYNC_H */
@@ -0,0 +1,29 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#ifndef RDEV_UPDATE_H
+#define RDEV_UPDATE_H
+
+#include <commonlib/bsd/helpers.h>
+#include <commonlib/region.h>
+#include <types.h>
+
+/* Erase granularity assumed for the flash behind the region device. */
+#define RDEV_UPDATE_SECTOR_SIZE	(4 * KiB)
+/* Granularity at which the current contents are compared and programmed. */
+#define RDEV_UPDATE_PAGE_SIZE	256
+
+/*
+ * Make the region device hold size bytes of data followed by erased (0xff) bytes, i.e.
+ * the same result as erasing the whole region and writing data to its start. The
+ * current contents are read back first, so that:
+ *  - sectors which already hold the right bytes are neither erased nor programmed,
+ *  - sectors which only need bits cleared are programmed without an erase,
+ *  - only the differing pages of a sector are programmed, consecutive ones in one write.
+ *
+ * Within a sector, pages are programmed in ascending order, so data placed behind the
+ * bytes it validates (e.g. a checksum) is still written last. The region must start and
+ * end on sector boundaries of the underlying flash.
+ */
+enum cb_err rdev_update(const struct region_device *rd, const void *data, size_t size);
+
+#endif /* RDEV_UPDATE_H */
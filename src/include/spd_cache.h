@@ -9,16 +9,20 @@
 
 #define SPD_CACHE_FMAP_NAME	(CONFIG_SPD_CACHE_FMAP_NAME)
 #define SC_SPD_NUMS		(CONFIG_DIMM_MAX)
-#define SC_SPD_OFFSET(n)	(CONFIG_DIMM_SPD_SIZE * n)
-#define SC_CRC_OFFSET		(CONFIG_DIMM_MAX * CONFIG_DIMM_SPD_SIZE)
+#define SC_SPD_OFFSET(n)	(CONFIG_DIMM_SPD_SIZE * (n))
+#define SC_CRC_OFFSET(n)	(SC_SPD_TOTAL_LEN + SC_CRC_LEN * (n))
 #define SC_SPD_TOTAL_LEN	(CONFIG_DIMM_MAX * CONFIG_DIMM_SPD_SIZE)
 #define SC_SPD_LEN		(CONFIG_DIMM_SPD_SIZE)
 #define SC_CRC_LEN		(sizeof(uint16_t))
+#define SC_CACHE_LEN		(SC_SPD_TOTAL_LEN + CONFIG_DIMM_MAX * SC_CRC_LEN)
 
 enum cb_err update_spd_cache(struct spd_block *blk);
 enum cb_err load_spd_cache(uint8_t **spd_cache, size_t *spd_cache_sz);
 bool spd_cache_is_valid(uint8_t *spd_cache, size_t spd_cache_sz);
 bool check_if_dimm_changed(u8 *spd_cache, struct spd_block *blk);
+uint32_t spd_cache_changed_dimms(u8 *spd_cache, struct spd_block *blk);
 enum cb_err spd_fill_from_cache(uint8_t *spd_cache, struct spd_block *blk);
+void spd_fill_changed_from_smbus(uint8_t *spd_cache, struct spd_block *blk,
+				 uint32_t changed);
 
 #endif
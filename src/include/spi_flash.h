@@ -99,7 +99,9 @@ struct spi_flash {
 		struct {
 			u8 dual_output	: 1;
 			u8 dual_io	: 1;
-			u8 _reserved	: 6;
+			u8 quad_output	: 1;
+			u8 quad_io	: 1;
+			u8 _reserved	: 4;
 		};
 	} flags;
 	u16 model;
@@ -157,6 +159,27 @@ int spi_flash_write(const struct spi_flash *flash, u32 offset, size_t len,
 int spi_flash_erase(const struct spi_flash *flash, u32 offset, size_t len);
 int spi_flash_status(const struct spi_flash *flash, u8 *reg);
 
+/*
+ * Boot device reads go through a small block cache with readahead when
+ * SPI_FLASH_READ_CACHE is enabled. spi_flash_write() and spi_flash_erase()
+ * invalidate the lines they touch. SMM never caches since the OS may write
+ * the flash behind its back.
+ */
+#if CONFIG(SPI_FLASH_READ_CACHE) && !ENV_SMM
+int spi_flash_cached_read(const struct spi_flash *flash, u32 offset, size_t len,
+			  void *buf);
+void spi_flash_cache_invalidate(u32 offset, size_t len);
+void spi_flash_cache_report(void);
+#else
+static inline int spi_flash_cached_read(const struct spi_flash *flash, u32 offset,
+					size_t len, void *buf)
+{
+	return spi_flash_read(flash, offset, len, buf);
+}
+static inline void spi_flash_cache_invalidate(u32 offset, size_t len) {}
+static inline void spi_flash_cache_report(void) {}
+#endif
+
 /*
  * Return the vendor dependent SPI flash write protection state.
  * @param flash : A SPI flash device
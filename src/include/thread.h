@@ -72,6 +72,9 @@ void thread_coop_disable(void);
 void thread_mutex_lock(struct thread_mutex *mutex);
 void thread_mutex_unlock(struct thread_mutex *mutex);
 
+/* Return the id of the running thread, 0 for the main thread and < 0 off the BSP. */
+int thread_current_id(void);
+
 /* Architecture specific thread functions. */
 asmlinkage void switch_to_thread(uintptr_t new_stack, uintptr_t *saved_stack);
 /* Set up the stack frame for a new thread so that a switch_to_thread() call
@@ -94,6 +97,11 @@ static inline void thread_coop_disable(void) {}
 static inline void thread_mutex_lock(struct thread_mutex *mutex) {}
 
 static inline void thread_mutex_unlock(struct thread_mutex *mutex) {}
+
+static inline int thread_current_id(void)
+{
+	return 0;
+}
 #endif
 
 #endif /* THREAD_H_ */
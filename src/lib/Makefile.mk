@@ -93,6 +93,7 @@ $(foreach arch,$(ARCH_SUPPORTED),\
 romstage-y += fmap.c
 romstage-y += delay.c
 romstage-y += cbfs.c
+romstage-$(CONFIG_COOP_MULTITASKING) += rdev_async.c
 ifneq ($(CONFIG_COMPRESS_RAMSTAGE_LZMA)$(CONFIG_FSP_COMPRESS_FSP_M_LZMA),)
 romstage-y += lzma.c lzmadecode.c
 endif
@@ -104,6 +105,8 @@ romstage-y += ramtest.c
 romstage-$(CONFIG_GENERIC_GPIO_LIB) += gpio.c
 ramstage-y += region_file.c
 romstage-y += region_file.c
+ramstage-y += rdev_update.c
+romstage-y += rdev_update.c
 ramstage-y += romstage_handoff.c
 romstage-y += romstage_handoff.c
 romstage-y += selfboot.c
@@ -142,6 +145,11 @@ ramstage-y += dimm_info_util.c
 ramstage-y += delay.c
 ramstage-y += fallback_boot.c
 ramstage-y += cbfs.c
+ramstage-y += rdev_async.c
+romstage-$(CONFIG_CBFS_ACCESS_TRACE) += cbfs_trace.c
+postcar-$(CONFIG_CBFS_ACCESS_TRACE) += cbfs_trace.c
+ramstage-$(CONFIG_CBFS_ACCESS_TRACE) += cbfs_trace.c
+ramstage-$(CONFIG_BOOT_PROFILE) += boot_profile.c
 ramstage-y += lzma.c lzmadecode.c
 ramstage-y += stack.c
 ramstage-y += hexstrtobin.c
@@ -169,6 +177,8 @@ ramstage-$(CONFIG_TIMER_QUEUE) += timer_queue.c
 
 romstage-$(CONFIG_COOP_MULTITASKING) += thread.c
 ramstage-$(CONFIG_COOP_MULTITASKING) += thread.c
+romstage-$(CONFIG_ASYNC_TASKS) += async_task.c rdev_async.c
+ramstage-$(CONFIG_ASYNC_TASKS) += async_task.c
 
 romstage-y += cbmem_common.c
 romstage-y += imd_cbmem.c
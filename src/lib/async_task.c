@@ -0,0 +1,134 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <async_task.h>
+#include <rdev_async.h>
+#include <thread.h>
+#include <timer.h>
+
+/* Tasks whose step function can be called, in order. */
+static struct async_task *ready_head;
+static struct async_task *ready_tail;
+/* Tasks that sleep or wait for a read. */
+static struct async_task *waiting;
+/* Tasks started but not done yet. */
+static unsigned int pending;
+/* Step functions don't yield, but a udelay() in one might let the idle thread run. */
+static bool running;
+
+static void make_ready(struct async_task *task)
+{
+	task->next = NULL;
+	task->queued = true;
+	if (ready_tail)
+		ready_tail->next = task;
+	else
+		ready_head = task;
+	ready_tail = task;
+}
+
+static void make_waiting(struct async_task *task)
+{
+	task->queued = true;
+	task->next = waiting;
+	waiting = task;
+}
+
+void async_task_start(struct async_task *task, enum async_status (*step)(struct async_task *))
+{
+	task->step = step;
+	task->resume = 0;
+	task->done = false;
+	task->read = NULL;
+	pending++;
+	make_ready(task);
+}
+
+void async_task_sleep_us(struct async_task *task, uint64_t us)
+{
+	timer_monotonic_get(&task->expiration);
+	mono_time_add_usecs(&task->expiration, us);
+	task->read = NULL;
+	make_waiting(task);
+}
+
+void async_task_wait_read(struct async_task *task, struct rdev_async_read *req)
+{
+	task->read = req;
+	make_waiting(task);
+}
+
+/* Move the tasks whose wait is over to the ready list. */
+static void wake_tasks(void)
+{
+	struct async_task **link = &waiting;
+	struct async_task *task;
+	struct mono_time now;
+	bool woken;
+
+	timer_monotonic_get(&now);
+
+	while ((task = *link)) {
+		if (task->read)
+			woken = rdev_async_poll(task->read);
+		else
+			woken = !mono_time_before(&now, &task->expiration);
+
+		if (woken) {
+			*link = task->next;
+			task->read = NULL;
+			make_ready(task);
+		} else {
+			link = &task->next;
+		}
+	}
+}
+
+bool async_tasks_run(void)
+{
+	struct async_task *task, *batch;
+	bool ran;
+
+	if (running)
+		return false;
+	running = true;
+
+	wake_tasks();
+
+	/* Only what's ready now, so tasks that keep yielding don't hold up the caller. */
+	batch = ready_head;
+	ready_head = NULL;
+	ready_tail = NULL;
+	ran = batch != NULL;
+
+	while ((task = batch)) {
+		batch = task->next;
+		task->queued = false;
+
+		if (task->step(task) == ASYNC_DONE) {
+			task->done = true;
+			pending--;
+		} else if (!task->queued) {
+			make_ready(task);
+		}
+	}
+
+	running = false;
+
+	return ran;
+}
+
+void async_task_wait(struct async_task *task)
+{
+	while (!task->done) {
+		if (!async_tasks_run())
+			thread_yield();
+	}
+}
+
+void async_tasks_wait_all(void)
+{
+	while (pending) {
+		if (!async_tasks_run())
+			thread_yield();
+	}
+}
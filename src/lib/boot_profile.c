@@ -0,0 +1,127 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <boot_profile.h>
+#include <cbmem.h>
+#include <console/console.h>
+#include <smp/node.h>
+#include <string.h>
+#include <thread.h>
+#include <timer.h>
+
+#if ENV_SUPPORTS_COOP
+#define PROFILE_THREADS (CONFIG_NUM_THREADS + 1)
+#else
+#define PROFILE_THREADS 1
+#endif
+
+static enum {
+	PROFILE_UNINITIALIZED,
+	PROFILE_ACTIVE,
+	PROFILE_FAILED,
+} profile_state;
+
+static struct boot_profile_table *profile;
+
+/* Innermost open entry of each thread. */
+static uint32_t open_entry[PROFILE_THREADS];
+
+static bool profile_init(void)
+{
+	const size_t entries = CONFIG_BOOT_PROFILE_ENTRIES;
+	size_t i;
+
+	if (profile_state == PROFILE_ACTIVE)
+		return true;
+	if (profile_state == PROFILE_FAILED || !cbmem_online())
+		return false;
+
+	/* Set before printing, the console may take a mutex and end up back here. */
+	profile_state = PROFILE_FAILED;
+
+	/* On S3 resume the table of the previous boot is found and started over. */
+	profile = cbmem_add(CBMEM_ID_BOOT_PROFILE,
+			    sizeof(*profile) + entries * sizeof(profile->entries[0]));
+	if (!profile) {
+		printk(BIOS_ERR, "Boot profile: could not allocate CBMEM table\n");
+		return false;
+	}
+
+	profile->max_entries = entries;
+	profile->num_entries = 0;
+	profile->dropped = 0;
+	for (i = 0; i < ARRAY_SIZE(open_entry); i++)
+		open_entry[i] = BOOT_PROFILE_NO_PARENT;
+
+	profile_state = PROFILE_ACTIVE;
+	return true;
+}
+
+/* A new thread is nested where the main thread is, unless that is waiting for it. */
+static uint32_t main_thread_parent(void)
+{
+	uint32_t i = open_entry[0];
+
+	while (i != BOOT_PROFILE_NO_PARENT && profile->entries[i].type == BOOT_PROFILE_BLOCKED)
+		i = profile->entries[i].parent;
+
+	return i;
+}
+
+int boot_profile_begin(enum boot_profile_type type, const char *name, uintptr_t addr)
+{
+	const int thread = thread_current_id();
+	struct boot_profile_entry *e;
+	struct mono_time now;
+	uint32_t i;
+
+	/* Only the BSP and its cooperative threads are recorded. */
+	if (!boot_cpu() || thread < 0 || thread >= PROFILE_THREADS || !profile_init())
+		return -1;
+
+	if (profile->num_entries >= profile->max_entries) {
+		profile->dropped++;
+		return -1;
+	}
+
+	i = profile->num_entries++;
+	e = &profile->entries[i];
+	memset(e, 0, sizeof(*e));
+
+	timer_monotonic_get(&now);
+	e->start_us = now.microseconds;
+	e->parent = open_entry[thread];
+	if (e->parent == BOOT_PROFILE_NO_PARENT && thread != 0)
+		e->parent = main_thread_parent();
+	e->addr = addr;
+	e->type = type;
+	e->flags = BOOT_PROFILE_FLAG_OPEN;
+	e->thread = thread;
+	if (name)
+		strncpy(e->name, name, sizeof(e->name) - 1);
+
+	open_entry[thread] = i;
+
+	return i;
+}
+
+void boot_profile_end(int handle)
+{
+	struct boot_profile_entry *e;
+	struct mono_time now;
+
+	if (handle < 0 || profile_state != PROFILE_ACTIVE ||
+	    (uint32_t)handle >= profile->num_entries)
+		return;
+
+	e = &profile->entries[handle];
+	timer_monotonic_get(&now);
+	e->duration_us = now.microseconds - e->start_us;
+	e->flags &= ~BOOT_PROFILE_FLAG_OPEN;
+
+	/* The first entry of a thread may be nested in one of the main thread. */
+	if (e->parent != BOOT_PROFILE_NO_PARENT &&
+	    profile->entries[e->parent].thread != e->thread)
+		open_entry[e->thread] = BOOT_PROFILE_NO_PARENT;
+	else
+		open_entry[e->thread] = e->parent;
+}
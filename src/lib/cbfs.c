@@ -3,32 +3,48 @@
 #include <assert.h>
 #include <boot_device.h>
 #include <cbfs.h>
+#include <cbfs_trace.h>
 #include <cbmem.h>
 #include <commonlib/bsd/cbfs_private.h>
+#include <commonlib/cbfs_cache_stats_serialized.h>
 #include <commonlib/bsd/compression.h>
 #include <commonlib/list.h>
 #include <console/console.h>
 #include <fmap.h>
 #include <lib.h>
 #include <metadata_hash.h>
+#include <rdev_async.h>
 #include <security/tpm/tspi/crtm.h>
 #include <security/vboot/vboot_common.h>
 #include <security/vboot/misc.h>
 #include <stdlib.h>
 #include <string.h>
 #include <symbols.h>
-#include <thread.h>
 #include <timestamp.h>
 
+/*
+ * Live allocations of the CBFS cache. Pre-RAM stages only keep a few mappings, the later
+ * ones also hold decompression buffers and preloads.
+ */
+#if ENV_RAMSTAGE || ENV_SEPARATE_ROMSTAGE
+#define CBFS_CACHE_MAX_ALLOCS	32
+#else
+#define CBFS_CACHE_MAX_ALLOCS	8
+#endif
+
 #if ENV_X86 && (ENV_POSTCAR || ENV_SMM)
-struct mem_pool cbfs_cache = MEM_POOL_INIT(NULL, 0, 0);
+struct mem_pool cbfs_cache = MEM_POOL_INIT(NULL, 0, 0, NULL, 0);
 #elif CONFIG(POSTRAM_CBFS_CACHE_IN_BSS) && ENV_RAMSTAGE
 static u8 cache_buffer[CONFIG_RAMSTAGE_CBFS_CACHE_SIZE];
+static struct mem_pool_block cache_allocs[CBFS_CACHE_MAX_ALLOCS];
 struct mem_pool cbfs_cache =
-	MEM_POOL_INIT(cache_buffer, sizeof(cache_buffer), CONFIG_CBFS_CACHE_ALIGN);
+	MEM_POOL_INIT(cache_buffer, sizeof(cache_buffer), CONFIG_CBFS_CACHE_ALIGN,
+		      cache_allocs, ARRAY_SIZE(cache_allocs));
 #else
+static struct mem_pool_block cache_allocs[CBFS_CACHE_MAX_ALLOCS];
 struct mem_pool cbfs_cache =
-	MEM_POOL_INIT(_cbfs_cache, REGION_SIZE(cbfs_cache), CONFIG_CBFS_CACHE_ALIGN);
+	MEM_POOL_INIT(_cbfs_cache, REGION_SIZE(cbfs_cache), CONFIG_CBFS_CACHE_ALIGN,
+		      cache_allocs, ARRAY_SIZE(cache_allocs));
 #endif
 
 static void switch_to_postram_cache(int unused)
@@ -94,7 +110,7 @@ enum cb_err _cbfs_boot_lookup(const char *name, bool force_ro,
 void cbfs_unmap(void *mapping)
 {
 	/*
-	 * This is save to call with mappings that weren't allocated in the cache (e.g. x86
+	 * This is safe to call with mappings that weren't allocated in the cache (e.g. x86
 	 * direct mappings) -- mem_pool_free() just does nothing for addresses it doesn't
 	 * recognize. This hardcodes the assumption that if platforms implement an rdev_mmap()
 	 * that requires a free() for the boot_device, they need to implement it via the
@@ -103,6 +119,47 @@ void cbfs_unmap(void *mapping)
 	mem_pool_free(&cbfs_cache, mapping);
 }
 
+#if CONFIG(CBFS_CACHE_STATS) && ENV_HAS_CBMEM
+void cbfs_cache_record_stats(void)
+{
+	struct cbfs_cache_stats_table *table;
+	struct cbfs_cache_stats_entry *entry;
+
+	if (!cbfs_cache.size || !cbmem_online())
+		return;
+
+	table = cbmem_find(CBMEM_ID_CBFS_CACHE_STATS);
+	/*
+	 * On S3 resume CBMEM still holds the entries of the stages from the cold boot. Start
+	 * over so that they aren't mixed with this boot's and don't fill up the table.
+	 */
+	if (ENV_CREATES_CBMEM || !table) {
+		table = cbmem_add(CBMEM_ID_CBFS_CACHE_STATS, sizeof(*table));
+		if (!table)
+			return;
+		table->num_entries = 0;
+	}
+	if (table->num_entries >= ARRAY_SIZE(table->entries))
+		return;
+
+	entry = &table->entries[table->num_entries++];
+	memset(entry, 0, sizeof(*entry));
+	strncpy(entry->stage, ENV_STRING, sizeof(entry->stage) - 1);
+	entry->size = cbfs_cache.size;
+	entry->high_water = cbfs_cache.high_water;
+	entry->peak_allocs = cbfs_cache.peak_allocs;
+	entry->failed_allocs = cbfs_cache.failed_allocs;
+	entry->fragmented_failures = cbfs_cache.fragmented_failures;
+	entry->used = cbfs_cache.used;
+	entry->largest_free = mem_pool_largest_free(&cbfs_cache);
+
+	printk(BIOS_DEBUG, "CBFS cache: %zu/%zu bytes peak, %zu allocations peak, "
+	       "%zu failed (%zu fragmented)\n", cbfs_cache.high_water, cbfs_cache.size,
+	       cbfs_cache.peak_allocs, cbfs_cache.failed_allocs,
+	       cbfs_cache.fragmented_failures);
+}
+#endif
+
 static inline bool fsps_env(void)
 {
 	/* FSP-S is assumed to be loaded in ramstage. */
@@ -208,10 +265,12 @@ static bool cbfs_file_hash_mismatch(const void *buffer, size_t size,
 
 static size_t cbfs_load_and_decompress(const struct region_device *rdev, void *buffer,
 				       size_t buffer_size, uint32_t compression,
-				       const union cbfs_mdata *mdata, bool skip_verification)
+				       const union cbfs_mdata *mdata, bool skip_verification,
+				       struct cbfs_trace_times *times)
 {
 	size_t in_size = region_device_sz(rdev);
 	size_t out_size = 0;
+	struct stopwatch sw;
 	void *map;
 
 	DEBUG("Decompressing %zu bytes from '%s' to %p with algo %d\n",
@@ -224,14 +283,20 @@ static size_t cbfs_load_and_decompress(const struct region_device *rdev, void *b
 		return 0;
 	}
 
+	cbfs_trace_start(&sw);
+
 	switch (compression) {
 	case CBFS_COMPRESS_NONE:
 		if (buffer_size < in_size)
 			return 0;
 		if (rdev_readat(rdev, buffer, 0, in_size) != in_size)
 			return 0;
+		if (times)
+			cbfs_trace_lap(&sw, &times->read_us);
 		if (cbfs_file_hash_mismatch(buffer, in_size, mdata, skip_verification))
 			return 0;
+		if (times)
+			cbfs_trace_lap(&sw, &times->decompress_us);
 		return in_size;
 
 	case CBFS_COMPRESS_LZ4:
@@ -243,12 +308,24 @@ static size_t cbfs_load_and_decompress(const struct region_device *rdev, void *b
 		map = rdev_mmap_full(rdev);
 		if (map == NULL)
 			return 0;
+		if (times)
+			cbfs_trace_lap(&sw, &times->read_us);
 
 		if (!cbfs_file_hash_mismatch(map, in_size, mdata, skip_verification)) {
+			const struct cbfs_file_attr_lz4_blocks *index = NULL;
+			if (CONFIG(CBFS_LZ4_PARALLEL) && ENV_RAMSTAGE)
+				index = cbfs_find_attr(mdata, CBFS_FILE_ATTR_TAG_LZ4_BLOCKS, 0);
+
 			timestamp_add_now(TS_ULZ4F_START);
-			out_size = ulz4fn(map, in_size, buffer, buffer_size);
+			if (index)
+				out_size = _cbfs_lz4_parallel_decompress(map, in_size, buffer,
+									 buffer_size, index);
+			else
+				out_size = ulz4fn(map, in_size, buffer, buffer_size);
 			timestamp_add_now(TS_ULZ4F_END);
 		}
+		if (times)
+			cbfs_trace_lap(&sw, &times->decompress_us);
 
 		rdev_munmap(rdev, map);
 
@@ -260,6 +337,8 @@ static size_t cbfs_load_and_decompress(const struct region_device *rdev, void *b
 		map = rdev_mmap_full(rdev);
 		if (map == NULL)
 			return 0;
+		if (times)
+			cbfs_trace_lap(&sw, &times->read_us);
 
 		if (!cbfs_file_hash_mismatch(map, in_size, mdata, skip_verification)) {
 			/* Note: timestamp not useful for memory-mapped media (x86) */
@@ -267,6 +346,8 @@ static size_t cbfs_load_and_decompress(const struct region_device *rdev, void *b
 			out_size = ulzman(map, in_size, buffer, buffer_size);
 			timestamp_add_now(TS_ULZMA_END);
 		}
+		if (times)
+			cbfs_trace_lap(&sw, &times->decompress_us);
 
 		rdev_munmap(rdev, map);
 
@@ -279,7 +360,7 @@ static size_t cbfs_load_and_decompress(const struct region_device *rdev, void *b
 
 struct cbfs_preload_context {
 	struct region_device rdev;
-	struct thread_handle handle;
+	struct rdev_async_read read;
 	struct list_node list_node;
 	void *buffer;
 	char name[];
@@ -287,6 +368,13 @@ struct cbfs_preload_context {
 
 static struct list_node cbfs_preload_context_list;
 
+/* rdev_async.c is only built into the stages whose threads can service the reads. */
+static bool cbfs_preload_supported(void)
+{
+	return CONFIG(CBFS_PRELOAD) && ENV_SUPPORTS_COOP &&
+	       (ENV_RAMSTAGE || ENV_SEPARATE_ROMSTAGE);
+}
+
 static struct cbfs_preload_context *alloc_cbfs_preload_context(size_t additional)
 {
 	struct cbfs_preload_context *context;
@@ -314,18 +402,6 @@ static void free_cbfs_preload_context(struct cbfs_preload_context *context)
 	mem_pool_free(&cbfs_cache, context);
 }
 
-static enum cb_err cbfs_preload_thread_entry(void *arg)
-{
-	struct cbfs_preload_context *context = arg;
-
-	if (rdev_read_full(&context->rdev, context->buffer) < 0) {
-		ERROR("%s(name='%s') readat failed\n", __func__, context->name);
-		return CB_ERR;
-	}
-
-	return CB_SUCCESS;
-}
-
 void cbfs_preload(const char *name)
 {
 	struct region_device rdev;
@@ -337,6 +413,9 @@ void cbfs_preload(const char *name)
 	if (!CONFIG(CBFS_PRELOAD))
 		dead_code();
 
+	if (!cbfs_preload_supported())
+		return;
+
 	/* We don't want to cross the vboot boundary */
 	if (ENV_SEPARATE_ROMSTAGE && CONFIG(VBOOT_STARTS_IN_ROMSTAGE))
 		return;
@@ -366,10 +445,11 @@ void cbfs_preload(const char *name)
 
 	append_cbfs_preload_context(context);
 
-	if (thread_run(&context->handle, cbfs_preload_thread_entry, context) == 0)
+	if (rdev_readat_async(&context->rdev, &context->read, context->buffer, 0, size,
+			      NULL, NULL) == 0)
 		return;
 
-	ERROR("%s(name='%s') failed to start preload thread\n", __func__, name);
+	ERROR("%s(name='%s') failed to queue preload read\n", __func__, name);
 	mem_pool_free(&cbfs_cache, context->buffer);
 
 out:
@@ -393,17 +473,17 @@ static enum cb_err get_preload_rdev(struct region_device *rdev, const char *name
 	enum cb_err err;
 	struct cbfs_preload_context *context;
 
-	if (!CONFIG(CBFS_PRELOAD) || !ENV_SUPPORTS_COOP)
+	if (!cbfs_preload_supported())
 		return CB_ERR_ARG;
 
 	context = find_cbfs_preload_context(name);
 	if (!context)
 		return CB_ERR_ARG;
 
-	err = thread_join(&context->handle);
-	if (err != CB_SUCCESS) {
-		ERROR("%s(name='%s') Preload thread failed: %u\n", __func__, name, err);
+	if (rdev_async_wait(&context->read) != region_device_sz(&context->rdev)) {
+		ERROR("%s(name='%s') Preload read failed\n", __func__, name);
 
+		err = CB_ERR;
 		goto out;
 	}
 
@@ -426,7 +506,7 @@ out:
 
 static void *do_alloc(union cbfs_mdata *mdata, struct region_device *rdev,
 		      cbfs_allocator_t allocator, void *arg, size_t *size_out,
-		      bool skip_verification)
+		      bool skip_verification, struct cbfs_trace_times *times)
 {
 	size_t size = region_device_sz(rdev);
 	void *loc = NULL;
@@ -446,13 +526,19 @@ static void *do_alloc(union cbfs_mdata *mdata, struct region_device *rdev,
 	if (allocator) {
 		loc = allocator(arg, size, mdata);
 	} else if (compression == CBFS_COMPRESS_NONE) {
+		struct stopwatch sw;
+		cbfs_trace_start(&sw);
 		void *mapping = rdev_mmap_full(rdev);
 		if (!mapping)
 			return NULL;
+		if (times)
+			cbfs_trace_lap(&sw, &times->read_us);
 		if (cbfs_file_hash_mismatch(mapping, size, mdata, skip_verification)) {
 			rdev_munmap(rdev, mapping);
 			return NULL;
 		}
+		if (times)
+			cbfs_trace_lap(&sw, &times->decompress_us);
 		return mapping;
 	} else if (!cbfs_cache.size) {
 		/* In order to use the cbfs_cache you need to add a CBFS_CACHE to your
@@ -468,7 +554,8 @@ static void *do_alloc(union cbfs_mdata *mdata, struct region_device *rdev,
 		return NULL;
 	}
 
-	size = cbfs_load_and_decompress(rdev, loc, size, compression, mdata, skip_verification);
+	size = cbfs_load_and_decompress(rdev, loc, size, compression, mdata, skip_verification,
+					times);
 	if (!size)
 		return NULL;
 
@@ -480,7 +567,10 @@ void *_cbfs_alloc(const char *name, cbfs_allocator_t allocator, void *arg,
 {
 	struct region_device rdev;
 	bool preload_successful = false;
+	struct cbfs_trace_times times = { 0 };
+	uint8_t trace_flags = 0;
 	union cbfs_mdata mdata;
+	size_t offset;
 
 	DEBUG("%s(name='%s', alloc=%p(%p), force_ro=%s, type=%d)\n", __func__, name, allocator,
 	      arg, force_ro ? "true" : "false", type ? *type : -1);
@@ -499,11 +589,23 @@ void *_cbfs_alloc(const char *name, cbfs_allocator_t allocator, void *arg,
 		}
 	}
 
+	/* Remember where the file lives on flash before the rdev may point to a preload. */
+	offset = region_device_offset(&rdev);
+
 	/* Update the rdev with the preload content */
-	if (!force_ro && get_preload_rdev(&rdev, name) == CB_SUCCESS)
+	if (!force_ro && get_preload_rdev(&rdev, name) == CB_SUCCESS) {
 		preload_successful = true;
+		trace_flags |= CBFS_TRACE_FLAG_PRELOADED;
+	}
+
+	void *ret = do_alloc(&mdata, &rdev, allocator, arg, size_out, false,
+			     CBFS_TRACE_ENABLED ? &times : NULL);
 
-	void *ret = do_alloc(&mdata, &rdev, allocator, arg, size_out, false);
+	if (!allocator)
+		trace_flags |= CBFS_TRACE_FLAG_MAPPED;
+	if (!ret)
+		trace_flags |= CBFS_TRACE_FLAG_FAILED;
+	cbfs_trace_record(&mdata, offset, trace_flags, &times);
 
 	/* When using cbfs_preload we need to free the preload buffer after populating the
 	 * destination buffer. We know we must have a mem_rdev here, so extra mmap is fine. */
@@ -533,7 +635,7 @@ void *_cbfs_unverified_area_alloc(const char *area, const char *name,
 	if (rdev_chain(&file_rdev, &area_rdev, data_offset, be32toh(mdata.h.len)))
 		return NULL;
 
-	return do_alloc(&mdata, &file_rdev, allocator, arg, size_out, true);
+	return do_alloc(&mdata, &file_rdev, allocator, arg, size_out, true, NULL);
 }
 
 void *_cbfs_default_allocator(void *arg, size_t size, const union cbfs_mdata *unused)
@@ -553,7 +655,10 @@ enum cb_err cbfs_prog_stage_load(struct prog *pstage)
 {
 	union cbfs_mdata mdata;
 	struct region_device rdev;
+	struct cbfs_trace_times times = { 0 };
+	struct stopwatch sw;
 	enum cb_err err;
+	size_t offset;
 
 	prog_locate_hook(pstage);
 
@@ -562,6 +667,7 @@ enum cb_err cbfs_prog_stage_load(struct prog *pstage)
 
 	assert(be32toh(mdata.h.type) == CBFS_TYPE_STAGE);
 	pstage->cbfs_type = CBFS_TYPE_STAGE;
+	offset = region_device_offset(&rdev);
 
 	enum cbfs_compression compression = CBFS_COMPRESS_NONE;
 	const struct cbfs_file_attr_compression *cattr = cbfs_find_attr(&mdata,
@@ -595,13 +701,18 @@ enum cb_err cbfs_prog_stage_load(struct prog *pstage)
 	if (cbfs_lz4_enabled() && compression == CBFS_COMPRESS_LZ4) {
 		size_t in_size = region_device_sz(&rdev);
 		void *compr_start = prog_start(pstage) + prog_size(pstage) - in_size;
+		cbfs_trace_start(&sw);
 		if (rdev_readat(&rdev, compr_start, 0, in_size) != in_size)
 			return CB_ERR;
+		cbfs_trace_lap(&sw, &times.read_us);
 		rdev_chain_mem(&rdev, compr_start, in_size);
 	}
 
 	size_t fsize = cbfs_load_and_decompress(&rdev, prog_start(pstage), prog_size(pstage),
-						compression, &mdata, false);
+						compression, &mdata, false,
+						CBFS_TRACE_ENABLED ? &times : NULL);
+	cbfs_trace_record(&mdata, offset,
+			  CBFS_TRACE_FLAG_STAGE | (fsize ? 0 : CBFS_TRACE_FLAG_FAILED), &times);
 	if (!fsize)
 		return CB_ERR;
 
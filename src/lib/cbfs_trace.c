@@ -0,0 +1,87 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <cbfs_trace.h>
+#include <cbmem.h>
+#include <commonlib/bsd/cbfs_serialized.h>
+#include <commonlib/helpers.h>
+#include <console/console.h>
+#include <endian.h>
+#include <string.h>
+
+/* Romstage loads a few files (e.g. FSP-M, SPD data) before CBMEM exists. */
+#define CBFS_TRACE_EARLY_ENTRIES 8
+
+static struct cbfs_trace_entry early_entries[CBFS_TRACE_EARLY_ENTRIES];
+static size_t num_early_entries;
+static size_t num_dropped;
+static struct cbfs_trace_table *trace_table;
+
+static void append(const struct cbfs_trace_entry *entry)
+{
+	if (trace_table) {
+		if (trace_table->num_entries < trace_table->max_entries)
+			trace_table->entries[trace_table->num_entries++] = *entry;
+		else
+			num_dropped++;
+	} else if (num_early_entries < ARRAY_SIZE(early_entries)) {
+		early_entries[num_early_entries++] = *entry;
+	} else {
+		num_dropped++;
+	}
+}
+
+void cbfs_trace_record(const union cbfs_mdata *mdata, size_t offset, uint8_t flags,
+		       const struct cbfs_trace_times *times)
+{
+	struct cbfs_trace_entry entry = {
+		.offset = offset,
+		.size = be32toh(mdata->h.len),
+		.decompressed_size = be32toh(mdata->h.len),
+		.read_us = times->read_us,
+		.decompress_us = times->decompress_us,
+		.compression = CBFS_COMPRESS_NONE,
+		.flags = flags,
+	};
+
+	const struct cbfs_file_attr_compression *cattr = cbfs_find_attr(mdata,
+				CBFS_FILE_ATTR_TAG_COMPRESSION, sizeof(*cattr));
+	if (cattr) {
+		entry.compression = be32toh(cattr->compression);
+		entry.decompressed_size = be32toh(cattr->decompressed_size);
+	}
+
+	strncpy(entry.stage, ENV_STRING, sizeof(entry.stage) - 1);
+	strncpy(entry.name, mdata->h.filename, sizeof(entry.name) - 1);
+
+	append(&entry);
+}
+
+static void cbfs_trace_cbmem_init(int is_recovery)
+{
+	const size_t entries = CONFIG_CBFS_ACCESS_TRACE_ENTRIES;
+	struct cbfs_trace_table *table = cbmem_find(CBMEM_ID_CBFS_TRACE);
+	size_t i;
+
+	/* The stage creating CBMEM starts a new trace, also on S3 resume. */
+	if (ENV_CREATES_CBMEM || !table) {
+		table = cbmem_add(CBMEM_ID_CBFS_TRACE,
+				  sizeof(*table) + entries * sizeof(table->entries[0]));
+		if (!table) {
+			printk(BIOS_ERR, "CBFS trace: could not allocate CBMEM table\n");
+			return;
+		}
+		table->max_entries = entries;
+		table->num_entries = 0;
+	}
+
+	trace_table = table;
+
+	for (i = 0; i < num_early_entries; i++)
+		append(&early_entries[i]);
+	num_early_entries = 0;
+
+	if (num_dropped)
+		printk(BIOS_WARNING, "CBFS trace: %zu accesses were not recorded\n",
+		       num_dropped);
+}
+CBMEM_READY_HOOK(cbfs_trace_cbmem_init);
@@ -10,6 +10,7 @@
 #include <adainit.h>
 #include <arch/exception.h>
 #include <boot/tables.h>
+#include <boot_profile.h>
 #include <bootstate.h>
 #include <cbmem.h>
 #include <commonlib/console/post_codes.h>
@@ -268,6 +269,7 @@ static void bs_call_callbacks(struct boot_state *state,
 	while (1) {
 		if (phase->callbacks != NULL) {
 			struct boot_state_callback *bscb;
+			int prof;
 
 			/* Remove the first callback. */
 			bscb = phase->callbacks;
@@ -279,7 +281,10 @@ static void bs_call_callbacks(struct boot_state *state,
 					bscb, bscb_location(bscb));
 				timer_monotonic_get(&mt_start);
 			}
+			prof = boot_profile_begin(BOOT_PROFILE_CALLBACK, bscb_name(bscb),
+						  (uintptr_t)bscb->callback);
 			bscb->callback(bscb->arg);
+			boot_profile_end(prof);
 			if (CONFIG(DEBUG_BOOT_STATE)) {
 				timer_monotonic_get(&mt_stop);
 				printk(BIOS_DEBUG, "BS: callback (%p) @ %s (%lld ms).\n", bscb,
@@ -320,6 +325,7 @@ static void bs_walk_state_machine(void)
 	while (1) {
 		struct boot_state *state;
 		boot_state_t next_id;
+		int state_prof, phase_prof;
 
 		state = &boot_states[current_phase.state_id];
 
@@ -337,7 +343,11 @@ static void bs_walk_state_machine(void)
 
 		bs_sample_time(state);
 
+		state_prof = boot_profile_begin(BOOT_PROFILE_STATE, state->name,
+						(uintptr_t)state->run_state);
+		phase_prof = boot_profile_begin(BOOT_PROFILE_PHASE, "entry", 0);
 		bs_call_callbacks(state, current_phase.seq);
+		boot_profile_end(phase_prof);
 		/* Update the current sequence so that any calls to block the
 		 * current state from the run_state() function will place a
 		 * block on the correct phase. */
@@ -347,7 +357,10 @@ static void bs_walk_state_machine(void)
 
 		post_code(state->post_code);
 
+		phase_prof = boot_profile_begin(BOOT_PROFILE_PHASE, "run",
+						(uintptr_t)state->run_state);
 		next_id = state->run_state(state->arg);
+		boot_profile_end(phase_prof);
 
 		if (CONFIG(DEBUG_BOOT_STATE))
 			printk(BIOS_DEBUG, "BS: Exiting %s state.\n",
@@ -357,7 +370,10 @@ static void bs_walk_state_machine(void)
 
 		bs_run_timers(0);
 
+		phase_prof = boot_profile_begin(BOOT_PROFILE_PHASE, "exit", 0);
 		bs_call_callbacks(state, current_phase.seq);
+		boot_profile_end(phase_prof);
+		boot_profile_end(state_prof);
 
 		if (CONFIG(DEBUG_BOOT_STATE))
 			printk(BIOS_DEBUG,
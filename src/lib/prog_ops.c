@@ -1,5 +1,7 @@
 /* SPDX-License-Identifier: GPL-2.0-only */
 
+#include <cbfs.h>
+#include <elog.h>
 #include <program_loading.h>
 #include <types.h>
 
@@ -24,6 +26,8 @@ void __weak arch_segment_loaded(uintptr_t start, size_t size,
 
 void prog_run(struct prog *prog)
 {
+	cbfs_cache_record_stats();
+	elog_flush();
 	platform_prog_run(prog);
 	arch_prog_run(prog);
 }
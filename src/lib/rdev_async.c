@@ -0,0 +1,166 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <console/console.h>
+#include <rdev_async.h>
+#include <thread.h>
+
+/*
+ * Fallback for region devices without .readat_async: one worker thread services
+ * all queued reads in order with the synchronous .readat. This costs one thread
+ * no matter how many reads are outstanding.
+ */
+static struct rdev_async_read *queue_head;
+static struct rdev_async_read *queue_tail;
+static struct thread_handle worker_handle;
+static bool worker_running;
+
+static void service(struct rdev_async_read *req)
+{
+	const struct region_device *rdev = req->rdev;
+
+	rdev_async_complete(req, rdev->ops->readat(rdev, req->buffer, req->offset, req->size));
+}
+
+static void enqueue(struct rdev_async_read *req)
+{
+	req->next = NULL;
+	if (queue_tail)
+		queue_tail->next = req;
+	else
+		queue_head = req;
+	queue_tail = req;
+}
+
+static struct rdev_async_read *dequeue(void)
+{
+	struct rdev_async_read *req = queue_head;
+
+	if (req) {
+		queue_head = req->next;
+		if (!queue_head)
+			queue_tail = NULL;
+		req->next = NULL;
+	}
+
+	return req;
+}
+
+/* Take req back out of the queue if the worker hasn't started on it yet. */
+static bool unqueue(struct rdev_async_read *req)
+{
+	struct rdev_async_read **link = &queue_head;
+	struct rdev_async_read *prev = NULL;
+
+	while (*link && *link != req) {
+		prev = *link;
+		link = &(*link)->next;
+	}
+
+	if (!*link)
+		return false;
+
+	*link = req->next;
+	if (queue_tail == req)
+		queue_tail = prev;
+	req->next = NULL;
+
+	return true;
+}
+
+static enum cb_err worker(void *unused)
+{
+	struct rdev_async_read *req;
+
+	while ((req = dequeue()))
+		service(req);
+
+	worker_running = false;
+
+	return CB_SUCCESS;
+}
+
+static void fallback_readat_async(struct rdev_async_read *req)
+{
+	if (!ENV_SUPPORTS_COOP) {
+		service(req);
+		return;
+	}
+
+	enqueue(req);
+
+	if (worker_running)
+		return;
+
+	worker_running = true;
+	if (thread_run(&worker_handle, worker, NULL) == 0)
+		return;
+
+	/* No thread available, so do the work right here. */
+	worker(NULL);
+}
+
+int rdev_readat_async(const struct region_device *rd, struct rdev_async_read *req, void *b,
+		      size_t offset, size_t size, rdev_async_done_t done, void *arg)
+{
+	const struct region_device *root = rd->root ? rd->root : rd;
+	struct region r = {
+		.offset = region_offset(&rd->region) + offset,
+		.size = size,
+	};
+
+	if (r.offset < offset || !region_is_subregion(&rd->region, &r))
+		return -1;
+
+	req->rdev = root;
+	req->buffer = b;
+	req->offset = r.offset;
+	req->size = size;
+	req->done = done;
+	req->arg = arg;
+	req->result = 0;
+	req->complete = false;
+	req->next = NULL;
+	req->priv = NULL;
+
+	if (root->ops->readat_async && root->ops->readat_async(root, req) == 0)
+		return 0;
+
+	fallback_readat_async(req);
+
+	return 0;
+}
+
+bool rdev_async_poll(struct rdev_async_read *req)
+{
+	const struct region_device *rdev = req->rdev;
+
+	if (!req->complete && rdev->ops->async_poll)
+		rdev->ops->async_poll(rdev);
+
+	return req->complete;
+}
+
+ssize_t rdev_async_wait(struct rdev_async_read *req)
+{
+	while (!rdev_async_poll(req)) {
+		if (thread_yield() == 0)
+			continue;
+
+		/* Can't let the worker run, so service the read here if it's still queued. */
+		if (unqueue(req))
+			service(req);
+		else if (!req->rdev->ops->async_poll)
+			die("%s: Can't yield to the read in progress\n", __func__);
+	}
+
+	return req->result;
+}
+
+void rdev_async_complete(struct rdev_async_read *req, ssize_t result)
+{
+	req->result = result;
+	req->complete = true;
+
+	if (req->done)
+		req->done(req);
+}
@@ -0,0 +1,137 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <console/console.h>
+#include <rdev_update.h>
+
+#define SECTOR_SIZE	RDEV_UPDATE_SECTOR_SIZE
+#define PAGE_SIZE	RDEV_UPDATE_PAGE_SIZE
+#define SECTOR_PAGES	(SECTOR_SIZE / PAGE_SIZE)
+
+_Static_assert(SECTOR_PAGES <= 32, "Page mask doesn't cover a sector");
+
+struct update_stats {
+	size_t erased;
+	size_t programmed;
+};
+
+static uint8_t new_byte(const uint8_t *data, size_t size, size_t offset)
+{
+	return offset < size ? data[offset] : 0xff;
+}
+
+/*
+ * Compare the sector at offset with what it should hold. Sets a bit in *dirty for each
+ * page that differs, and returns 1 if bits would have to go from 0 to 1, so the sector
+ * needs an erase, 0 if not and -1 on read errors.
+ */
+static int compare_sector(const struct region_device *rd, const uint8_t *data, size_t size,
+			  size_t offset, size_t len, uint32_t *dirty)
+{
+	uint8_t cur[PAGE_SIZE];
+	int need_erase = 0;
+	size_t page, i, n;
+
+	*dirty = 0;
+
+	for (page = 0; page * PAGE_SIZE < len; page++) {
+		const size_t page_offset = offset + page * PAGE_SIZE;
+
+		n = MIN(PAGE_SIZE, len - page * PAGE_SIZE);
+		if (rdev_readat(rd, cur, page_offset, n) != n)
+			return -1;
+
+		for (i = 0; i < n; i++) {
+			const uint8_t b = new_byte(data, size, page_offset + i);
+
+			if (cur[i] == b)
+				continue;
+			*dirty |= 1 << page;
+			if (b & ~cur[i])
+				need_erase = 1;
+		}
+	}
+
+	return need_erase;
+}
+
+/* Pages of an erased sector that hold anything but 0xff. */
+static uint32_t erased_sector_dirty(const uint8_t *data, size_t size, size_t offset,
+				    size_t len)
+{
+	uint32_t dirty = 0;
+	size_t i;
+
+	for (i = 0; i < len && offset + i < size; i++) {
+		if (data[offset + i] != 0xff)
+			dirty |= 1 << (i / PAGE_SIZE);
+	}
+
+	return dirty;
+}
+
+/* Program the dirty pages of the sector, each run of consecutive pages in one write. */
+static enum cb_err program_sector(const struct region_device *rd, const uint8_t *data,
+				  size_t size, size_t offset, uint32_t dirty,
+				  struct update_stats *stats)
+{
+	size_t first, last, start, end;
+
+	for (first = 0; first < SECTOR_PAGES; first = last) {
+		if (!(dirty & (1 << first))) {
+			last = first + 1;
+			continue;
+		}
+
+		for (last = first + 1; last < SECTOR_PAGES; last++) {
+			if (!(dirty & (1 << last)))
+				break;
+		}
+
+		/* The bytes past the data are left erased. */
+		start = offset + first * PAGE_SIZE;
+		end = MIN(offset + last * PAGE_SIZE, size);
+		if (start >= end)
+			continue;
+
+		if (rdev_writeat(rd, data + start, start, end - start) != end - start)
+			return CB_ERR;
+		stats->programmed += end - start;
+	}
+
+	return CB_SUCCESS;
+}
+
+enum cb_err rdev_update(const struct region_device *rd, const void *data, size_t size)
+{
+	const size_t region_size = region_device_sz(rd);
+	struct update_stats stats = { 0 };
+	size_t offset, len;
+	uint32_t dirty;
+	int ret;
+
+	if (size > region_size)
+		return CB_ERR;
+
+	for (offset = 0; offset < region_size; offset += SECTOR_SIZE) {
+		len = MIN(SECTOR_SIZE, region_size - offset);
+
+		ret = compare_sector(rd, data, size, offset, len, &dirty);
+		if (ret < 0)
+			return CB_ERR;
+
+		if (ret) {
+			if (rdev_eraseat(rd, offset, len) != len)
+				return CB_ERR;
+			stats.erased += len;
+			dirty = erased_sector_dirty(data, size, offset, len);
+		}
+
+		if (dirty && program_sector(rd, data, size, offset, dirty, &stats) != CB_SUCCESS)
+			return CB_ERR;
+	}
+
+	printk(BIOS_DEBUG, "RDEV_UPDATE: %zu bytes, erased %zu, programmed %zu\n", size,
+	       stats.erased, stats.programmed);
+
+	return CB_SUCCESS;
+}
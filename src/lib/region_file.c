@@ -1,5 +1,6 @@
 /* SPDX-License-Identifier: GPL-2.0-only */
 
+#include <cbmem.h>
 #include <commonlib/helpers.h>
 #include <console/console.h>
 #include <region_file.h>
@@ -136,6 +137,131 @@ static void find_latest_slot(struct metadata_block *mb, struct region_file *f)
 	f->slot += i;
 }
 
+/*
+ * The latest slot of each region file seen during this boot, keyed by the region's
+ * place on its device. They are carried to later stages and across S3 resume in
+ * CBMEM, so that region_file_init() can confirm the previous result with a single
+ * read instead of searching the metadata again. Hints are only ever trusted after
+ * checking them against the metadata.
+ *
+ * Nothing is kept on flash, so the first lookup of a boot, e.g. the romstage MRC
+ * cache lookup before CBMEM is up, always searches. Only readers running once CBMEM
+ * is available (ramstage, SMM) start out with a hint.
+ */
+#define REGF_MAX_HINTS	4
+
+struct regf_hint {
+	uint32_t offset;
+	uint32_t size;
+	int32_t slot;
+};
+
+static struct regf_hint local_hints[REGF_MAX_HINTS] = {
+	[0 ... REGF_MAX_HINTS - 1] = { .slot = -1 },
+};
+static struct regf_hint *regf_hints = local_hints;
+
+static struct regf_hint *find_hint(struct regf_hint *hints, const struct region_file *f)
+{
+	size_t i;
+
+	for (i = 0; i < REGF_MAX_HINTS; i++) {
+		if (hints[i].slot >= 0 &&
+		    hints[i].offset == region_device_offset(&f->rdev) &&
+		    hints[i].size == region_device_sz(&f->rdev))
+			return &hints[i];
+	}
+
+	return NULL;
+}
+
+static void store_hint(struct regf_hint *hints, uint32_t offset, uint32_t size, int slot)
+{
+	struct regf_hint *h = NULL;
+	size_t i;
+
+	for (i = 0; i < REGF_MAX_HINTS; i++) {
+		if (hints[i].slot < 0 || (hints[i].offset == offset && hints[i].size == size)) {
+			h = &hints[i];
+			break;
+		}
+	}
+
+	/* Evict the last one if the table is full. */
+	if (!h)
+		h = &hints[REGF_MAX_HINTS - 1];
+
+	h->offset = offset;
+	h->size = size;
+	h->slot = slot;
+}
+
+static void remember_slot(const struct region_file *f)
+{
+	struct regf_hint *h = find_hint(regf_hints, f);
+
+	if (f->slot >= RF_ONLY_METADATA)
+		store_hint(regf_hints, region_device_offset(&f->rdev),
+			   region_device_sz(&f->rdev), f->slot);
+	else if (h)
+		h->slot = -1;
+}
+
+static void regf_hints_cbmem_init(int is_recovery)
+{
+	struct regf_hint *table;
+	size_t i;
+
+	table = cbmem_find(CBMEM_ID_REGF_HINTS);
+	if (!table) {
+		table = cbmem_add(CBMEM_ID_REGF_HINTS, sizeof(local_hints));
+		if (!table)
+			return;
+		for (i = 0; i < REGF_MAX_HINTS; i++)
+			table[i].slot = -1;
+	}
+
+	/* What this stage found so far is newer than what's in CBMEM. */
+	for (i = 0; i < REGF_MAX_HINTS; i++) {
+		if (local_hints[i].slot >= 0)
+			store_hint(table, local_hints[i].offset, local_hints[i].size,
+				   local_hints[i].slot);
+	}
+
+	regf_hints = table;
+}
+CBMEM_READY_HOOK(regf_hints_cbmem_init);
+
+/*
+ * The metadata is filled in order, so the hinted slot still holds the latest update
+ * if it is allocated and the one after it isn't.
+ */
+static int use_hint(struct region_file *f)
+{
+	const struct regf_hint *h = find_hint(regf_hints, f);
+	const size_t num_slots = region_device_sz(&f->metadata) / sizeof(uint16_t);
+	uint16_t blocks[2];
+	size_t size = sizeof(blocks);
+
+	if (!h || h->slot >= num_slots)
+		return -1;
+
+	/* The last slot has nothing after it. */
+	if (h->slot + 1 == num_slots)
+		size = sizeof(blocks[0]);
+	blocks[1] = REGF_UNALLOCATED_BLOCK;
+
+	if (rdev_readat(&f->metadata, blocks, h->slot * sizeof(uint16_t), size) < 0)
+		return -1;
+
+	if (block_offset_unallocated(blocks[0]) || !block_offset_unallocated(blocks[1]))
+		return -1;
+
+	f->slot = h->slot;
+
+	return 0;
+}
+
 static int fill_data_boundaries(struct region_file *f)
 {
 	struct region_device slots;
@@ -221,14 +347,16 @@ int region_file_init(struct region_file *f, const struct region_device *p)
 		return 0;
 	}
 
-	/* Locate latest metadata block with latest update. */
-	if (find_latest_mb(&mb, mb.blocks[0], f)) {
-		printk(BIOS_ERR, "REGF fail locating latest metadata block.\n");
-		f->slot = RF_FATAL;
-		return -1;
-	}
+	/* Locate latest metadata block with latest update, unless the hint has it. */
+	if (use_hint(f)) {
+		if (find_latest_mb(&mb, mb.blocks[0], f)) {
+			printk(BIOS_ERR, "REGF fail locating latest metadata block.\n");
+			f->slot = RF_FATAL;
+			return -1;
+		}
 
-	find_latest_slot(&mb, f);
+		find_latest_slot(&mb, f);
+	}
 
 	/* Fill in the data blocks marking the latest update. */
 	if (fill_data_boundaries(f)) {
@@ -237,6 +365,8 @@ int region_file_init(struct region_file *f, const struct region_device *p)
 		return -1;
 	}
 
+	remember_slot(f);
+
 	return 0;
 }
 
@@ -467,6 +597,8 @@ int region_file_update_data_arr(struct region_file *f,
 			break;
 	}
 
+	remember_slot(f);
+
 	return ret;
 }
 
@@ -1,13 +1,17 @@
 /* SPDX-License-Identifier: GPL-2.0-only */
 
 #include <arch/cache.h>
+#include <console/async.h>
 #include <console/console.h>
+#include <elog.h>
 #include <halt.h>
 #include <reset.h>
 
 __noreturn void board_reset(void)
 {
 	printk(BIOS_INFO, "%s() called!\n", __func__);
+	console_async_flush();
+	elog_flush();
 	dcache_clean_all();
 	do_board_reset();
 	halt();
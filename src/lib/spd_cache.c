@@ -4,6 +4,7 @@
 #include <console/console.h>
 #include <crc_byte.h>
 #include <fmap.h>
+#include <rdev_update.h>
 #include <spd_cache.h>
 #include <spd_bin.h>
 #include <string.h>
@@ -19,14 +20,61 @@
  *    +----------+ offset CONFIG_DIMM_SPD_SIZE * (N -1)
  *    |DIMM N SPD|   N = CONFIG_DIMM_MAX
  *    +----------+ offset CONFIG_DIMM_SPD_SIZE * CONFIG_DIMM_MAX
- *    |  CRC 16  |   Use to verify the data correctness.
+ *    | CRC 16 1 |   CRC of the DIMM 1 SPD, used to verify the data correctness.
+ *    +----------+   Left erased (0xffff) while the slot is empty.
+ *         ...
+ *    | CRC 16 N |
  *    +==========+
  *
  *  The size of the RW_SPD_CACHE needs to be aligned with 4KiB.
+ *
+ *  With one CRC per slot, a DIMM added to an empty slot is written without erasing
+ *  the region, and the CRC is written last so an interrupted write isn't mistaken
+ *  for valid data. Any other change only erases the 4KiB sectors holding changed
+ *  bytes and programs the pages that differ, see rdev_update().
  */
 
+/* The new cache contents, staged in RAM since blk may point into the cache itself. */
+static uint8_t cache_image[SC_CACHE_LEN];
+
+static bool slot_erased(const uint8_t *slot, uint16_t crc)
+{
+	int i;
+
+	for (i = 0; i < SC_SPD_LEN; i++) {
+		if (slot[i] != 0xff)
+			return false;
+	}
+
+	return crc == 0xffff;
+}
+
+static uint16_t cached_crc(const uint8_t *spd_cache, int idx)
+{
+	return *(uint16_t *)(spd_cache + SC_CRC_OFFSET(idx));
+}
+
+static void stage_cache_image(const struct spd_block *blk)
+{
+	uint16_t crc;
+	int i;
+
+	memset(cache_image, 0xff, sizeof(cache_image));
+	for (i = 0; i < SC_SPD_NUMS; i++) {
+		uint8_t *slot = cache_image + SC_SPD_OFFSET(i);
+
+		if (blk->spd_array[i] == NULL)
+			continue;
+
+		/* If the blk->len < SC_SPD_LEN, the rest of the slot stays 0xff. */
+		memcpy(slot, blk->spd_array[i], blk->len);
+		crc = CRC(slot, SC_SPD_LEN, crc16_byte);
+		memcpy(cache_image + SC_CRC_OFFSET(i), &crc, SC_CRC_LEN);
+	}
+}
+
 /*
- * Use to update SPD cache.
+ * Use to update SPD cache. Only slots whose data changed get written.
  *  *blk : the new SPD data will be stash into the cache.
  *
  *  return CB_SUCCESS , update SPD cache successfully.
@@ -35,8 +83,6 @@
 enum cb_err update_spd_cache(struct spd_block *blk)
 {
 	struct region_device rdev;
-	uint16_t data_crc = 0;
-	int i, j;
 
 	assert(blk->len <= SC_SPD_LEN);
 
@@ -45,42 +91,17 @@ enum cb_err update_spd_cache(struct spd_block *blk)
 		return CB_ERR;
 	}
 
-	/* Erase whole area, it's for align with 4KiB which is the size of SPI rom sector. */
-	if (rdev_eraseat(&rdev, 0, region_device_sz(&rdev)) < 0) {
-		printk(BIOS_ERR, "SPD_CACHE: Cannot erase %s region\n", SPD_CACHE_FMAP_NAME);
-		return CB_ERR;
-	}
-
-	/* Write SPD data */
-	for (i = 0; i < SC_SPD_NUMS; i++) {
-		if (blk->spd_array[i] == NULL) {
-			/* If DIMM is not present, we calculate the CRC with 0xff. */
-			for (j = 0; j < SC_SPD_LEN; j++)
-				data_crc = crc16_byte(data_crc, 0xff);
-		} else {
-			if (rdev_writeat(&rdev, blk->spd_array[i], SC_SPD_OFFSET(i), blk->len)
-										< 0) {
-				printk(BIOS_ERR, "SPD_CACHE: Cannot write SPD data at %d\n",
-					SC_SPD_OFFSET(i));
-				return CB_ERR;
-			}
-
-			for (j = 0; j < blk->len; j++)
-				data_crc = crc16_byte(data_crc, blk->spd_array[i][j]);
-
-			/* If the blk->len < SC_SPD_LEN, we calculate the CRC with 0xff. */
-			if (blk->len < SC_SPD_LEN)
-				for (j = 0; j < (SC_SPD_LEN - (blk->len)); j++)
-					data_crc = crc16_byte(data_crc, 0xff);
-		}
-	}
+	stage_cache_image(blk);
 
-	/* Write the crc16 */
-	/* It must be the last step to ensure that the data is written correctly */
-	if (rdev_writeat(&rdev, &data_crc, SC_CRC_OFFSET, SC_CRC_LEN) < 0) {
-		printk(BIOS_ERR, "SPD_CACHE: Cannot write crc at 0x%04x\n", SC_CRC_OFFSET);
+	/*
+	 * The CRCs follow all SPD data, so they are programmed after it. Identical slots
+	 * aren't touched and a DIMM added to an empty slot doesn't need an erase.
+	 */
+	if (rdev_update(&rdev, cache_image, sizeof(cache_image)) != CB_SUCCESS) {
+		printk(BIOS_ERR, "SPD_CACHE: Cannot update %s region\n", SPD_CACHE_FMAP_NAME);
 		return CB_ERR;
 	}
+
 	return CB_SUCCESS;
 }
 
@@ -116,17 +137,25 @@ enum cb_err load_spd_cache(uint8_t **spd_cache, size_t *spd_cache_sz)
 /* Use to verify the cache data is valid. */
 bool spd_cache_is_valid(uint8_t *spd_cache, size_t spd_cache_sz)
 {
-	uint16_t data_crc = 0;
+	const uint8_t *slot;
+	bool present = false;
 	int i;
 
-	if (spd_cache_sz < SC_SPD_TOTAL_LEN + SC_CRC_LEN)
+	if (spd_cache_sz < SC_CACHE_LEN)
 		return false;
 
-	/* Check the spd_cache crc */
-	for (i = 0; i < SC_SPD_TOTAL_LEN; i++)
-		data_crc = crc16_byte(data_crc, *(spd_cache + i));
+	/* Check the crc of each slot, empty slots must be entirely erased. */
+	for (i = 0; i < SC_SPD_NUMS; i++) {
+		slot = spd_cache + SC_SPD_OFFSET(i);
+		if (slot_erased(slot, cached_crc(spd_cache, i)))
+			continue;
+		if (cached_crc(spd_cache, i) != CRC(slot, SC_SPD_LEN, crc16_byte))
+			return false;
+		present = true;
+	}
 
-	return *(uint16_t *)(spd_cache + SC_CRC_OFFSET) == data_crc;
+	/* An erased cache holds no data at all. */
+	return present;
 }
 
 /*
@@ -142,6 +171,55 @@ static bool get_cached_dimm_present(uint8_t *spd_cache, uint8_t idx)
 		return true;
 }
 
+/* Offset of the serial number within the cached SPD of DIMM idx. */
+static size_t cached_sn_offset(uint8_t *spd_cache, int idx)
+{
+	if (*(spd_cache + SC_SPD_OFFSET(idx) + SPD_DRAM_TYPE) == SPD_DRAM_DDR3)
+		return DDR3_SPD_SN_OFF;
+	return DDR4_SPD_SN_OFF;
+}
+
+/*
+ * Check if the DIMM at index i is the same as in the cache, by reading its serial
+ * number. That is only a few SMBus byte reads instead of the whole SPD.
+ *  return true , DIMM changed or cannot be checked.
+ *  return false, DIMM is the same or still not present.
+ */
+static bool dimm_changed(u8 *spd_cache, struct spd_block *blk, int i)
+{
+	u32 sn;
+	bool dimm_present_in_cache;
+
+	if (blk->addr_map[i] == 0) {
+		printk(BIOS_NOTICE, "SPD_CACHE: DIMM%d does not exist\n", i);
+		return false;
+	}
+	/* Return true if any error happened here. */
+	if (get_spd_sn(blk->addr_map[i], &sn) == CB_ERR)
+		return true;
+	dimm_present_in_cache = get_cached_dimm_present(spd_cache, i);
+	/* Dimm is not present now. */
+	if (sn == 0xffffffff) {
+		if (!dimm_present_in_cache) {
+			printk(BIOS_NOTICE, "SPD_CACHE: DIMM%d is not present\n", i);
+			return false;
+		}
+		printk(BIOS_NOTICE, "SPD_CACHE: DIMM%d lost\n", i);
+		return true;
+	}
+
+	/* Dimm is present now. */
+	if (dimm_present_in_cache &&
+	    memcmp(&sn, spd_cache + SC_SPD_OFFSET(i) + cached_sn_offset(spd_cache, i),
+		   SPD_SN_LEN) == 0) {
+		printk(BIOS_NOTICE, "SPD_CACHE: DIMM%d is the same\n", i);
+		return false;
+	}
+
+	printk(BIOS_NOTICE, "SPD_CACHE: DIMM%d is new one\n", i);
+	return true;
+}
+
 /*
  * Use to check if the SODIMM is changed.
  *  spd_cache : it's a valid SPD cache.
@@ -150,45 +228,29 @@ static bool get_cached_dimm_present(uint8_t *spd_cache, uint8_t idx)
 bool check_if_dimm_changed(u8 *spd_cache, struct spd_block *blk)
 {
 	int i;
-	u32 sn;
-	bool dimm_present_in_cache;
-	bool dimm_changed = false;
+
 	/* Check if the dimm is the same with last system boot. */
-	for (i = 0; i < SC_SPD_NUMS && !dimm_changed; i++) {
-		if (blk->addr_map[i] == 0) {
-			printk(BIOS_NOTICE, "SPD_CACHE: DIMM%d does not exist\n", i);
-			continue;
-		}
-		/* Return true if any error happened here. */
-		if (get_spd_sn(blk->addr_map[i], &sn) == CB_ERR)
+	for (i = 0; i < SC_SPD_NUMS; i++) {
+		if (dimm_changed(spd_cache, blk, i))
 			return true;
-		dimm_present_in_cache = get_cached_dimm_present(spd_cache, i);
-		/* Dimm is not present now. */
-		if (sn == 0xffffffff) {
-			if (!dimm_present_in_cache)
-				printk(BIOS_NOTICE, "SPD_CACHE: DIMM%d is not present\n", i);
-			else {
-				printk(BIOS_NOTICE, "SPD_CACHE: DIMM%d lost\n", i);
-				dimm_changed = true;
-			}
-		} else { /* Dimm is present now. */
-			if (dimm_present_in_cache) {
-				if (memcmp(&sn, spd_cache + SC_SPD_OFFSET(i) + DDR4_SPD_SN_OFF,
-						SPD_SN_LEN) == 0)
-					printk(BIOS_NOTICE, "SPD_CACHE: DIMM%d is the same\n",
-											i);
-				else {
-					printk(BIOS_NOTICE, "SPD_CACHE: DIMM%d is new one\n",
-											i);
-					dimm_changed = true;
-				}
-			} else {
-				printk(BIOS_NOTICE, "SPD_CACHE: DIMM%d is new one\n", i);
-				dimm_changed = true;
-			}
-		}
 	}
-	return dimm_changed;
+	return false;
+}
+
+/*
+ * Like check_if_dimm_changed(), but checks every DIMM.
+ *  return a bitmask with bit i set if DIMM i changed.
+ */
+uint32_t spd_cache_changed_dimms(u8 *spd_cache, struct spd_block *blk)
+{
+	uint32_t changed = 0;
+	int i;
+
+	for (i = 0; i < SC_SPD_NUMS; i++) {
+		if (dimm_changed(spd_cache, blk, i))
+			changed |= 1 << i;
+	}
+	return changed;
 }
 
 /* Use to fill the struct spd_block with cache data.*/
@@ -222,3 +284,38 @@ enum cb_err spd_fill_from_cache(uint8_t *spd_cache, struct spd_block *blk)
 
 	return CB_SUCCESS;
 }
+
+/*
+ * Use to fill the struct spd_block with cache data for unchanged DIMMs, and by reading
+ * the DIMMs in changed over SMBus.
+ */
+void spd_fill_changed_from_smbus(uint8_t *spd_cache, struct spd_block *blk,
+				 uint32_t changed)
+{
+	struct spd_block smbus_blk = { .len = 0 };
+	u8 dram_type = 0;
+	int i;
+
+	for (i = 0; i < SC_SPD_NUMS; i++)
+		smbus_blk.addr_map[i] = (changed & (1 << i)) ? blk->addr_map[i] : 0;
+
+	get_spd_smbus(&smbus_blk);
+
+	for (i = 0; i < SC_SPD_NUMS; i++) {
+		if (changed & (1 << i))
+			blk->spd_array[i] = smbus_blk.spd_array[i];
+		else if (blk->addr_map[i] && get_cached_dimm_present(spd_cache, i))
+			blk->spd_array[i] = spd_cache + SC_SPD_OFFSET(i);
+		else
+			blk->spd_array[i] = NULL;
+
+		if (blk->spd_array[i] && !dram_type)
+			dram_type = blk->spd_array[i][SPD_DRAM_TYPE];
+	}
+
+	/* If spd used is DDR4, then its length is 512 byte. */
+	if (dram_type == SPD_DRAM_DDR4)
+		blk->len = SPD_PAGE_LEN_DDR4;
+	else
+		blk->len = SPD_PAGE_LEN;
+}
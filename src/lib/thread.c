@@ -1,7 +1,10 @@
 /* SPDX-License-Identifier: GPL-2.0-only */
 
 #include <assert.h>
+#include <async_task.h>
+#include <boot_profile.h>
 #include <bootstate.h>
+#include <console/async.h>
 #include <console/console.h>
 #include <smp/node.h>
 #include <thread.h>
@@ -101,13 +104,18 @@ static inline void free_thread(struct thread *t)
 
 /* The idle thread is ran whenever there isn't anything else that is runnable.
  * It's sole responsibility is to ensure progress is made by running the timer
- * callbacks. */
+ * callbacks and the async tasks. */
 __noreturn static enum cb_err idle_thread(void *unused)
 {
 	/* This thread never voluntarily yields. */
 	thread_coop_disable();
-	while (1)
+	while (1) {
 		timers_run();
+		if (CONFIG(ASYNC_TASKS))
+			async_tasks_run();
+		/* One byte at a time, so that expired timers aren't held up for long. */
+		console_async_drain(1);
+	}
 }
 
 static void schedule(struct thread *t)
@@ -397,8 +405,14 @@ enum cb_err thread_join(struct thread_handle *handle)
 
 	stopwatch_init(&sw);
 
-	while (handle->state != THREAD_DONE)
-		assert(thread_yield() == 0);
+	if (handle->state != THREAD_DONE) {
+		int prof = boot_profile_begin(BOOT_PROFILE_BLOCKED, "thread_join", 0);
+
+		while (handle->state != THREAD_DONE)
+			assert(thread_yield() == 0);
+
+		boot_profile_end(prof);
+	}
 
 	printk(BIOS_SPEW, "took %lld us\n", stopwatch_duration_usecs(&sw));
 
@@ -411,8 +425,14 @@ void thread_mutex_lock(struct thread_mutex *mutex)
 
 	stopwatch_init(&sw);
 
-	while (mutex->locked)
-		assert(thread_yield() == 0);
+	if (mutex->locked) {
+		int prof = boot_profile_begin(BOOT_PROFILE_BLOCKED, "thread_mutex_lock", 0);
+
+		while (mutex->locked)
+			assert(thread_yield() == 0);
+
+		boot_profile_end(prof);
+	}
 	mutex->locked = true;
 
 	printk(BIOS_SPEW, "took %lld us to acquire mutex\n", stopwatch_duration_usecs(&sw));
@@ -423,3 +443,13 @@ void thread_mutex_unlock(struct thread_mutex *mutex)
 	assert(mutex->locked);
 	mutex->locked = 0;
 }
+
+int thread_current_id(void)
+{
+	struct thread *current = current_thread();
+
+	if (!boot_cpu())
+		return -1;
+
+	return current ? current->id : 0;
+}
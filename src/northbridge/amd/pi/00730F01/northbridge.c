@@ -671,16 +671,12 @@ void mp_init_cpus(struct bus *cpu_bus)
 
 void generate_cpu_entries(const struct device *device)
 {
-	int cpu;
 	const int cores = get_cpu_count();
 
 	printk(BIOS_DEBUG, "ACPI \\_SB report %d core(s)\n", cores);
 
 	/* Generate \_SB.Pxxx */
-	for (cpu = 0; cpu < cores; cpu++) {
-		acpigen_write_processor_device(cpu);
-		acpigen_write_processor_device_end();
-	}
+	acpigen_write_processor_devices(cores, NULL, NULL);
 }
 
 struct device_operations amd_fam16_mod30_cpu_bus_ops = {
@@ -1,8 +1,11 @@
 /* SPDX-License-Identifier: GPL-2.0-only */
 
 #if ENV_X86
+#include <cpu/x86/mp_mem.h>
 #include <cpu/x86/pae.h>
 #else
+#define mp_mem_clear(a, b) CB_ERR
+#define mp_mem_test(a, b, c) ((void)(c), CB_ERR)
 #define memset_pae(a, b, c, d, e) 0
 #define MEMSET_PAE_PGTL_ALIGN 0
 #define MEMSET_PAE_PGTL_SIZE 0
@@ -45,53 +48,25 @@ static uintptr_t get_free_memory_range(struct memranges *mem,
 }
 
 /*
- * Clears all memory regions marked as BM_MEM_RAM.
+ * Clears all memory regions marked as BM_MEM_RAM on the BSP.
  * Uses memset_pae if the memory region can't be accessed by memset and
  * architecture is x86.
- *
- * @return 0 on success, 1 on error
  */
-static void clear_memory(void *unused)
+static void clear_memory_on_bsp(struct memranges *mem)
 {
 	const struct range_entry *r;
-	struct memranges mem;
 	uintptr_t pgtbl, vmem_addr;
 
-	if (acpi_is_wakeup_s3())
-		return;
-
-	if (!security_clear_dram_request())
-		return;
-
-	/* FSP1.0 is marked as MMIO and won't appear here */
-
-	memranges_init(&mem, IORESOURCE_MEM | IORESOURCE_FIXED |
-			IORESOURCE_STORED | IORESOURCE_ASSIGNED |
-			IORESOURCE_CACHEABLE,
-			IORESOURCE_MEM | IORESOURCE_FIXED |
-			IORESOURCE_STORED | IORESOURCE_ASSIGNED |
-			IORESOURCE_CACHEABLE,
-			BM_MEM_RAM);
-
-	/* Add reserved entries */
-	void *baseptr = NULL;
-	size_t size = 0;
-
-	/* Only skip CBMEM, stage program, stack and heap are included there. */
-
-	cbmem_get_region(&baseptr, &size);
-	memranges_insert(&mem, (uintptr_t)baseptr, size, BM_MEM_TABLE);
-
 	if (ENV_X86) {
 		/* Find space for PAE enabled memset */
-		pgtbl = get_free_memory_range(&mem, MEMSET_PAE_PGTL_ALIGN,
+		pgtbl = get_free_memory_range(mem, MEMSET_PAE_PGTL_ALIGN,
 					MEMSET_PAE_PGTL_SIZE);
 
 		/* Don't touch page tables while clearing */
-		memranges_insert(&mem, pgtbl, MEMSET_PAE_PGTL_SIZE,
+		memranges_insert(mem, pgtbl, MEMSET_PAE_PGTL_SIZE,
 					BM_MEM_TABLE);
 
-		vmem_addr = get_free_memory_range(&mem, MEMSET_PAE_VMEM_ALIGN,
+		vmem_addr = get_free_memory_range(mem, MEMSET_PAE_VMEM_ALIGN,
 						MEMSET_PAE_PGTL_SIZE);
 
 		printk(BIOS_SPEW, "%s: pgtbl at %p, virt memory at %p\n",
@@ -99,7 +74,7 @@ static void clear_memory(void *unused)
 	}
 
 	/* Now clear all usable DRAM */
-	memranges_each_entry(r, &mem) {
+	memranges_each_entry(r, mem) {
 		if (range_entry_tag(r) != BM_MEM_RAM)
 			continue;
 		printk(BIOS_DEBUG, "%s: Clearing DRAM %016llx-%016llx\n",
@@ -132,6 +107,55 @@ static void clear_memory(void *unused)
 
 		memset((void *)pgtbl, 0, MEMSET_PAE_PGTL_SIZE);
 	}
+}
+
+/*
+ * Tests and/or clears all memory regions marked as BM_MEM_RAM, on all CPUs
+ * with MP_MEM_PARALLEL.
+ */
+static void clear_memory(void *unused)
+{
+	struct memranges mem;
+	uint64_t bad_words;
+	bool clear;
+
+	if (acpi_is_wakeup_s3())
+		return;
+
+	clear = security_clear_dram_request();
+	if (!clear && !CONFIG(TEST_DRAM_ON_REGULAR_BOOT))
+		return;
+
+	/* FSP1.0 is marked as MMIO and won't appear here */
+
+	memranges_init(&mem, IORESOURCE_MEM | IORESOURCE_FIXED |
+			IORESOURCE_STORED | IORESOURCE_ASSIGNED |
+			IORESOURCE_CACHEABLE,
+			IORESOURCE_MEM | IORESOURCE_FIXED |
+			IORESOURCE_STORED | IORESOURCE_ASSIGNED |
+			IORESOURCE_CACHEABLE,
+			BM_MEM_RAM);
+
+	/* Add reserved entries */
+	void *baseptr = NULL;
+	size_t size = 0;
+
+	/* Only skip CBMEM, stage program, stack and heap are included there. */
+
+	cbmem_get_region(&baseptr, &size);
+	memranges_insert(&mem, (uintptr_t)baseptr, size, BM_MEM_TABLE);
+
+	/* Tested memory is left cleared. */
+	if (CONFIG(TEST_DRAM_ON_REGULAR_BOOT) &&
+	    mp_mem_test(&mem, BM_MEM_RAM, &bad_words) == CB_SUCCESS)
+		clear = false;
+
+	if (clear && CONFIG(MP_MEM_PARALLEL) &&
+	    mp_mem_clear(&mem, BM_MEM_RAM) == CB_SUCCESS)
+		clear = false;
+
+	if (clear)
+		clear_memory_on_bsp(&mem);
 
 	memranges_teardown(&mem);
 }
@@ -3,6 +3,7 @@
 #include <arch/exception.h>
 #include <arch/hlt.h>
 #include <console/console.h>
+#include <elog.h>
 #include <program_loading.h>
 #include <security/vboot/vboot_common.h>
 
@@ -19,6 +20,7 @@ void main(void)
 
 	if (CONFIG(VBOOT_RETURN_FROM_VERSTAGE)) {
 		verstage_main();
+		elog_flush();
 		printk(BIOS_DEBUG, "VBOOT: Returning from verstage.\n");
 	} else {
 		run_romstage();
@@ -10,6 +10,7 @@
 #include <console/console.h>
 #include <fmap.h>
 #include <fmap_config.h>
+#include <rdev_update.h>
 #include <security/vboot/vboot_common.h>
 #include <spi_flash.h>
 #include <string.h>
@@ -254,17 +255,10 @@ static void soc_update_apob_cache(void *unused)
 	if (get_nv_rdev_rw(&write_rdev) != CB_SUCCESS)
 		return;
 
-	timestamp_add_now(TS_AMD_APOB_ERASE_START);
-
-	/* write data to flash region */
-	if (rdev_eraseat(&write_rdev, 0, DEFAULT_MRC_CACHE_SIZE) < 0) {
-		printk(BIOS_ERR, "APOB flash region erase failed\n");
-		return;
-	}
-
 	timestamp_add_now(TS_AMD_APOB_WRITE_START);
 
-	if (rdev_writeat(&write_rdev, apob_src_ram, 0, apob_src_ram->size) < 0) {
+	/* Only erase and program the parts of the flash region that changed. */
+	if (rdev_update(&write_rdev, apob_src_ram, apob_src_ram->size) != CB_SUCCESS) {
 		printk(BIOS_ERR, "APOB flash region update failed\n");
 		return;
 	}
@@ -11,6 +11,7 @@
 #include <device/device.h>
 #include <device/pci.h>
 #include <fmap.h>
+#include <rdev_update.h>
 #include <security/vboot/vbios_cache_hash_tpm.h>
 #include <soc/intel/common/vbt.h>
 #include <timestamp.h>
@@ -249,9 +250,9 @@ static void write_vbios_cache_to_fmap(void *unused)
 	}
 
 	/* copy from PCI_VGA_RAM_IMAGE_START to rdev */
-	if (rdev_writeat(&rw_vbios_cache, (void *)PCI_VGA_RAM_IMAGE_START, 0,
-						VBIOS_CACHE_FMAP_SIZE) != VBIOS_CACHE_FMAP_SIZE)
-		printk(BIOS_ERR, "Failed to save vbios data to flash; rdev_writeat() failed.\n");
+	if (rdev_update(&rw_vbios_cache, (void *)PCI_VGA_RAM_IMAGE_START,
+			VBIOS_CACHE_FMAP_SIZE) != CB_SUCCESS)
+		printk(BIOS_ERR, "Failed to save vbios data to flash; rdev_update() failed.\n");
 
 	/* copy modified vbios data from PCI_VGA_RAM_IMAGE_START to buffer before hashing */
 	memcpy(vbios_data, (void *)PCI_VGA_RAM_IMAGE_START, VBIOS_CACHE_FMAP_SIZE);
@@ -13,6 +13,7 @@
 #include <intelblocks/cse.h>
 #include <intelblocks/cse_layout.h>
 #include <intelblocks/spi.h>
+#include <rdev_update.h>
 #include <security/vboot/misc.h>
 #include <security/vboot/vboot_common.h>
 #include <soc/intel/common/reset.h>
@@ -1318,13 +1319,11 @@ static enum csme_failure_reason cse_sub_part_trigger_update(enum bpdt_entry_type
 		return CSE_LITE_SKU_SUB_PART_LAYOUT_MISMATCH_ERROR;
 	}
 
-	/* Erase CSE Lite sub-partition */
-	if (cse_erase_rw_region(target_rdev) != CB_SUCCESS)
-		return CSE_LITE_SKU_SUB_PART_UPDATE_FAIL;
-
-	/* Update CSE Lite sub-partition */
-	if (cse_copy_rw(target_rdev, (void *)subpart_cbfs_rw, 0, blob_sz) != CB_SUCCESS)
+	/* Update CSE Lite sub-partition, only erasing and programming what changed */
+	if (rdev_update(target_rdev, subpart_cbfs_rw, blob_sz) != CB_SUCCESS) {
+		printk(BIOS_ERR, "cse_lite: Failed to update CSE sub-partition\n");
 		return CSE_LITE_SKU_SUB_PART_UPDATE_FAIL;
+	}
 
 	printk(BIOS_INFO, "cse_lite: CSE %s %s Update successful\n", GET_BP_STR(bp),
 			cse_sub_part_str(type));
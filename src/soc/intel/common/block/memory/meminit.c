@@ -124,14 +124,16 @@ static bool read_spd_dimm(FSPM_UPD *memupd, const struct soc_mem_cfg *soc_mem_cf
 		uint8_t *spd_cache;
 		size_t spd_cache_sz;
 		bool need_update_cache = false;
-		bool dimm_changed = true;
+		bool cache_valid = false;
+		uint32_t dimm_changed = ~0;
 
 		/* load spd cache from RW_SPD_CACHE */
 		if (load_spd_cache(&spd_cache, &spd_cache_sz) == CB_SUCCESS) {
 			if (!spd_cache_is_valid(spd_cache, spd_cache_sz)) {
 				printk(BIOS_WARNING, "Invalid SPD cache\n");
 			} else {
-				dimm_changed = check_if_dimm_changed(spd_cache, &blk);
+				cache_valid = true;
+				dimm_changed = spd_cache_changed_dimms(spd_cache, &blk);
 				if (dimm_changed && memupd->FspmArchUpd.NvsBufferPtr != 0) {
 					/*
 					 * Set FSP-M Arch UPD to indicate that the
@@ -150,8 +152,11 @@ static bool read_spd_dimm(FSPM_UPD *memupd, const struct soc_mem_cfg *soc_mem_cf
 			printk(BIOS_INFO, "Use the SPD cache data\n");
 			spd_fill_from_cache(spd_cache, &blk);
 		} else {
-			/* Access memory info through SMBUS. */
-			get_spd_smbus(&blk);
+			/* Access memory info through SMBUS, only for changed DIMMs if possible. */
+			if (cache_valid)
+				spd_fill_changed_from_smbus(spd_cache, &blk, dimm_changed);
+			else
+				get_spd_smbus(&blk);
 
 			if (need_update_cache &&
 				update_spd_cache(&blk) == CB_ERR)
@@ -4,6 +4,7 @@
 #include <spd_bin.h>
 #include <device/smbus_def.h>
 #include <device/smbus_host.h>
+#include <timestamp.h>
 #include "smbuslib.h"
 
 static void update_spd_len(struct spd_block *blk)
@@ -37,14 +38,17 @@ static void smbus_read_spd(u8 *spd, u8 addr)
 	}
 }
 
-/* return -1 if SMBus errors otherwise return 0 */
-static int get_spd(u8 *spd, u8 addr)
+static void read_spd_page(u8 *spd, u8 addr)
 {
-	if (CONFIG_DIMM_SPD_SIZE > SPD_PAGE_LEN) {
-		/* Restore to page 0 before reading */
-		smbus_write_byte(SPD_PAGE_0, 0, 0);
+	if (i2c_eeprom_read(addr, 0, SPD_PAGE_LEN, spd) < 0) {
+		printk(BIOS_INFO, "do_i2c_eeprom_read failed, using fallback\n");
+		smbus_read_spd(spd, addr);
 	}
+}
 
+/* return -1 if SMBus errors otherwise return 0 */
+static int get_spd_page0(u8 *spd, u8 addr)
+{
 	/* If address is not 0, it will return CB_ERR(-1) if no dimm */
 	if (smbus_read_byte(addr, 0) < 0) {
 		printk(BIOS_INFO, "No memory dimm at address %02X\n",
@@ -52,44 +56,69 @@ static int get_spd(u8 *spd, u8 addr)
 		return -1;
 	}
 
-	if (i2c_eeprom_read(addr, 0, SPD_PAGE_LEN, spd) < 0) {
-		printk(BIOS_INFO, "do_i2c_eeprom_read failed, using fallback\n");
-		smbus_read_spd(spd, addr);
-	}
+	read_spd_page(spd, addr);
+	return 0;
+}
 
+static bool spd_has_page1(const u8 *spd)
+{
 	/* Check if module is DDR4, DDR4 spd is 512 byte. */
-	if (spd[SPD_DRAM_TYPE] == SPD_DRAM_DDR4 && CONFIG_DIMM_SPD_SIZE > SPD_PAGE_LEN) {
-		/* Switch to page 1 */
-		smbus_write_byte(SPD_PAGE_1, 0, 0);
-
-		if (i2c_eeprom_read(addr, 0, SPD_PAGE_LEN, spd + SPD_PAGE_LEN) < 0) {
-			printk(BIOS_INFO, "do_i2c_eeprom_read failed, using fallback\n");
-			smbus_read_spd(spd + SPD_PAGE_LEN, addr);
-		}
-		/* Restore to page 0 */
-		smbus_write_byte(SPD_PAGE_0, 0, 0);
-	}
-	return 0;
+	return spd[SPD_DRAM_TYPE] == SPD_DRAM_DDR4 && CONFIG_DIMM_SPD_SIZE > SPD_PAGE_LEN;
 }
 
 static u8 spd_data[CONFIG_DIMM_MAX * CONFIG_DIMM_SPD_SIZE];
 
+/*
+ * The SPD page select addresses are broadcast to every DIMM on the bus, so read page 0
+ * of all DIMMs first and then page 1 of all DDR4 DIMMs, switching pages only twice
+ * instead of around every DIMM. A timestamp is added after each page read, so the n-th
+ * page 0 and page 1 timestamps belong to the n-th DIMM found and the n-th DDR4 DIMM.
+ */
 void get_spd_smbus(struct spd_block *blk)
 {
+	bool page1 = false;
 	u8 i;
+
+	timestamp_add_now(TS_SPD_READ_START);
+
+	if (CONFIG_DIMM_SPD_SIZE > SPD_PAGE_LEN) {
+		/* Restore to page 0 before reading */
+		smbus_write_byte(SPD_PAGE_0, 0, 0);
+	}
+
 	for (i = 0 ; i < CONFIG_DIMM_MAX; i++) {
-		if (blk->addr_map[i] == 0) {
+		u8 *spd = &spd_data[i * CONFIG_DIMM_SPD_SIZE];
+
+		if (blk->addr_map[i] == 0 || get_spd_page0(spd, blk->addr_map[i]) < 0) {
 			blk->spd_array[i] = NULL;
 			continue;
 		}
 
-		if (get_spd(&spd_data[i * CONFIG_DIMM_SPD_SIZE], blk->addr_map[i]) == 0)
-			blk->spd_array[i] = &spd_data[i * CONFIG_DIMM_SPD_SIZE];
-		else
-			blk->spd_array[i] = NULL;
+		timestamp_add_now(TS_SPD_PAGE0_READ);
+		blk->spd_array[i] = spd;
+		if (spd_has_page1(spd))
+			page1 = true;
+	}
+
+	if (page1) {
+		/* Switch to page 1 */
+		smbus_write_byte(SPD_PAGE_1, 0, 0);
+
+		for (i = 0 ; i < CONFIG_DIMM_MAX; i++) {
+			if (blk->spd_array[i] == NULL || !spd_has_page1(blk->spd_array[i]))
+				continue;
+
+			read_spd_page(blk->spd_array[i] + SPD_PAGE_LEN, blk->addr_map[i]);
+			timestamp_add_now(TS_SPD_PAGE1_READ);
+		}
+
+		/* Restore to page 0 */
+		smbus_write_byte(SPD_PAGE_0, 0, 0);
 	}
 
 	update_spd_len(blk);
+
+	timestamp_add_now(TS_SPD_READ_END);
 }
 
 /*
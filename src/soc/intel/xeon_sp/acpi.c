@@ -1,12 +1,19 @@
 /* SPDX-License-Identifier: GPL-2.0-or-later */
 
+#include <acpi/ssdt_cache.h>
+#include <arch/cpu.h>
 #include <assert.h>
 #include <commonlib/stdlib.h>
+#include <cpu/intel/turbo.h>
+#include <cpu/x86/msr.h>
 #include <intelblocks/acpi.h>
+#include <intelblocks/cpulib.h>
 #include <soc/chip_common.h>
+#include <soc/msr.h>
 #include <soc/pci_devs.h>
 #include <soc/util.h>
 #include <stdint.h>
+#include <xxhash.h>
 
 #include "chip.h"
 
@@ -90,6 +97,23 @@ const acpi_cstate_t *soc_get_cstate_map(size_t *entries)
 	return map;
 }
 
+/* soc_power_states_generation() and the CPPC objects read these for every thread. */
+uint64_t acpi_ssdt_cache_platform_key(void)
+{
+	uint64_t pstates[] = {
+		rdmsr(MSR_MISC_PWR_MGMT).lo,
+		rdmsr(MSR_PLATFORM_INFO).raw,
+		cpu_config_tdp_levels() ? rdmsr(MSR_CONFIG_TDP_NOMINAL).lo : 0,
+		rdmsr(MSR_PKG_POWER_SKU_UNIT).lo,
+		rdmsr(MSR_PKG_POWER_SKU).lo,
+		rdmsr(MSR_TURBO_RATIO_LIMIT).lo,
+		get_turbo_state(),
+		cpuid_eax(6),
+	};
+
+	return xxh64(pstates, sizeof(pstates), 0);
+}
+
 static uintptr_t xeonsp_ioapic_bases[CONFIG(XEON_SP_HAVE_IIO_IOAPIC) * 8 + 1];
 
 size_t soc_get_ioapic_info(const uintptr_t *ioapic_bases[])
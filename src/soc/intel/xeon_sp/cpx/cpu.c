@@ -72,6 +72,8 @@ void get_microcode_info(const void **microcode, int *parallel)
 {
 	*microcode = intel_microcode_find();
 	*parallel = 0;
+	if (CONFIG(XEON_SP_MICROCODE_PER_PACKAGE))
+		*parallel = MP_MICROCODE_PER_PACKAGE;
 }
 
 static void each_cpu_init(struct device *cpu)
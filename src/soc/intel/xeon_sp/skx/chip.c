@@ -30,6 +30,7 @@ static struct device_operations cpu_bus_ops = {
 #if CONFIG(HAVE_ACPI_TABLES)
 	/* defined in src/soc/intel/common/block/acpi/acpi.c */
 	.acpi_fill_ssdt = generate_cpu_entries,
+	.acpi_ssdt_cacheable = true,
 #endif
 };
 
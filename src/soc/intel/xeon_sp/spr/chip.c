@@ -54,6 +54,7 @@ static struct device_operations cpu_bus_ops = {
 	.set_resources = noop_set_resources,
 	.init = mp_cpu_bus_init,
 	.acpi_fill_ssdt = generate_cpu_entries,
+	.acpi_ssdt_cacheable = true,
 };
 
 struct pci_operations soc_pci_ops = {
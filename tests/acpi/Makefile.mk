@@ -5,3 +5,21 @@ tests-y += acpigen-test
 acpigen-test-srcs += tests/acpi/acpigen-test.c
 acpigen-test-srcs += src/acpi/acpigen.c
 acpigen-test-srcs += tests/stubs/console.c
+
+tests-y += ssdt_cache-test
+
+ssdt_cache-test-srcs += tests/acpi/ssdt_cache-test.c
+ssdt_cache-test-srcs += src/acpi/ssdt_cache.c
+ssdt_cache-test-srcs += src/acpi/acpigen.c
+ssdt_cache-test-srcs += src/commonlib/region.c
+ssdt_cache-test-srcs += src/device/device_util.c
+ssdt_cache-test-srcs += src/lib/xxhash.c
+ssdt_cache-test-srcs += tests/stubs/console.c
+ssdt_cache-test-config += CONFIG_ACPI_SSDT_CACHE=1 \
+			  CONFIG_ACPI_SSDT_CACHE_FMAP_NAME=\"RW_SSDT_CACHE\"
+
+tests-y += acpigen_bulk-test
+
+acpigen_bulk-test-srcs += tests/acpi/acpigen_bulk-test.c
+acpigen_bulk-test-srcs += src/acpi/acpigen.c
+acpigen_bulk-test-srcs += tests/stubs/console.c
@@ -0,0 +1,216 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <acpi/acpigen.h>
+#include <stdlib.h>
+#include <string.h>
+#include <tests/test.h>
+#include <time.h>
+#include <types.h>
+
+#define NUM_CPUS	512
+#define BUFFER_SIZE	(1 * MiB)
+
+struct buffers {
+	char *regular;
+	char *bulk;
+	char *scratch;
+};
+
+static int setup_buffers(void **state)
+{
+	static struct buffers b;
+
+	b.regular = malloc(BUFFER_SIZE);
+	b.bulk = malloc(BUFFER_SIZE);
+	b.scratch = malloc(BUFFER_SIZE);
+	if (!b.regular || !b.bulk || !b.scratch)
+		return -1;
+
+	memset(b.regular, 0, BUFFER_SIZE);
+	memset(b.bulk, 0, BUFFER_SIZE);
+	*state = &b;
+	return 0;
+}
+
+static int teardown_buffers(void **state)
+{
+	struct buffers *b = *state;
+
+	free(b->regular);
+	free(b->bulk);
+	free(b->scratch);
+	return 0;
+}
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* What the per-package and CNOT helpers emitted before they wrote PkgLengths up front. */
+static void write_processor_package_backpatched(const char *name, unsigned int first_core,
+						unsigned int core_count)
+{
+	acpigen_write_name(name);
+	acpigen_write_package(core_count);
+	for (unsigned int i = first_core; i < first_core + core_count; ++i)
+		acpigen_write_processor_namestring(i);
+	acpigen_pop_len();
+}
+
+static void write_processor_cnot_backpatched(unsigned int number_of_cores)
+{
+	acpigen_write_method("\\_SB.CNOT", 1);
+	for (unsigned int core_id = 0; core_id < number_of_cores; core_id++) {
+		acpigen_emit_byte(NOTIFY_OP);
+		acpigen_write_processor_namestring(core_id);
+		acpigen_emit_byte(ARG0_OP);
+	}
+	acpigen_pop_len();
+}
+
+static void test_processor_arrays(void **state)
+{
+	struct buffers *b = *state;
+	const unsigned int counts[] = { 0, 1, 5, 6, 7, 100, 255 };
+	size_t size;
+
+	/* Sizes around the 1, 2 and 3 byte PkgLength boundaries. */
+	for (size_t i = 0; i < ARRAY_SIZE(counts); i++) {
+		acpigen_set_current(b->regular);
+		write_processor_package_backpatched("PPKG", 3, counts[i]);
+		write_processor_cnot_backpatched(counts[i] * 30);
+		size = acpigen_get_current() - b->regular;
+
+		acpigen_set_current(b->bulk);
+		acpigen_write_processor_package("PPKG", 3, counts[i]);
+		acpigen_write_processor_cnot(counts[i] * 30);
+
+		assert_int_equal(size, acpigen_get_current() - b->bulk);
+		assert_memory_equal(b->regular, b->bulk, size);
+	}
+}
+
+/* The objects of a processor Device, much like generate_cpu_entry() emits them. */
+static void write_cpu_body(void *arg)
+{
+	const acpi_cstate_t cstates[] = {
+		{ .ctype = 1, .latency = 1, .power = 1000 },
+		{ .ctype = 2, .latency = 100, .power = 500 },
+		{ .ctype = 3, .latency = 400, .power = 100 },
+	};
+
+	acpigen_write_CST_package(cstates, ARRAY_SIZE(cstates));
+	acpigen_write_empty_PCT();
+	acpigen_write_PPC_NVS();
+	acpigen_write_PSD_package(0, NUM_CPUS, SW_ALL);
+
+	acpigen_write_name("_PSS");
+	acpigen_write_package(16);
+	for (int ratio = 40; ratio > 8; ratio -= 2)
+		acpigen_write_PSS_package(ratio * 100, ratio * 3000, 10, 10, ratio << 8,
+					  ratio << 8);
+	acpigen_pop_len();
+}
+
+static void test_processor_devices(void **state)
+{
+	struct buffers *b = *state;
+	struct acpigen_template t;
+	uint64_t start, regular_ns, bulk_ns;
+	size_t regular_size, bulk_size, size;
+	const char *copy;
+
+	start = now_ns();
+	acpigen_set_current(b->regular);
+	for (unsigned int cpu = 0; cpu < NUM_CPUS; cpu++) {
+		acpigen_write_processor_device(cpu);
+		write_cpu_body(NULL);
+		acpigen_write_processor_device_end();
+	}
+	regular_ns = now_ns() - start;
+	regular_size = acpigen_get_current() - b->regular;
+
+	start = now_ns();
+	acpigen_set_current(b->bulk);
+	acpigen_write_processor_devices(NUM_CPUS, write_cpu_body, NULL);
+	bulk_ns = now_ns() - start;
+	bulk_size = acpigen_get_current() - b->bulk;
+
+	print_message("%d processor Devices: %zu bytes in %llu us\n", NUM_CPUS, regular_size,
+		      regular_ns / 1000);
+	print_message("Stamped from a template: %zu bytes in %llu us\n", bulk_size,
+		      bulk_ns / 1000);
+
+	/* Each stamped Device is what the template functions emit for its CPU. */
+	copy = b->bulk;
+	for (unsigned int cpu = 0; cpu < NUM_CPUS; cpu++) {
+		acpigen_set_current(b->scratch);
+		acpigen_template_begin(&t);
+		acpigen_template_write_processor_device(&t, cpu);
+		write_cpu_body(NULL);
+		acpigen_write_processor_device_end();
+		acpigen_template_end(&t);
+
+		size = acpigen_get_current() - b->scratch;
+		assert_memory_equal(b->scratch, copy, size);
+		copy += size;
+	}
+	assert_ptr_equal(b->bulk + bulk_size, copy);
+
+	/* Only the _UID encoding differs: a DWordConst instead of the shortest one. */
+	assert_int_equal(regular_size + 4 * 2 + 3 * 254 + 2 * 256, bulk_size);
+}
+
+/* Fields keep their place when a PkgLength before them shrinks. */
+static void test_template_fields(void **state)
+{
+	struct buffers *b = *state;
+	struct acpigen_template t;
+	const uint32_t values[] = { 0x1234, 0xabcdef01, 7 };
+	size_t size;
+
+	acpigen_set_current(b->bulk);
+	acpigen_template_begin(&t);
+	acpigen_write_scope("\\_SB");
+	acpigen_template_write_processor_namestring(&t, 0);
+	acpigen_write_package(2);
+	acpigen_template_write_dword(&t, 0);
+	acpigen_write_package(1);
+	acpigen_template_write_dword(&t, 0);
+	acpigen_pop_len();
+	acpigen_pop_len();
+	acpigen_pop_len();
+	acpigen_template_end(&t);
+	acpigen_template_stamp(&t, values);
+	size = acpigen_get_current() - b->bulk - t.size;
+
+	acpigen_set_current(b->regular);
+	acpigen_write_scope("\\_SB");
+	acpigen_write_processor_namestring(0x1234);
+	acpigen_write_package(2);
+	acpigen_write_dword(0xabcdef01);
+	acpigen_write_package(1);
+	acpigen_write_dword(7);
+	acpigen_pop_len();
+	acpigen_pop_len();
+	acpigen_pop_len();
+
+	assert_int_equal(t.size, size);
+	assert_int_equal(size, acpigen_get_current() - b->regular);
+	assert_memory_equal(b->regular, b->bulk + t.size, size);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_processor_arrays),
+		cmocka_unit_test(test_processor_devices),
+		cmocka_unit_test(test_template_fields),
+	};
+
+	return cb_run_group_tests(tests, setup_buffers, teardown_buffers);
+}
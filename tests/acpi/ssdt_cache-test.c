@@ -0,0 +1,242 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <acpi/acpigen.h>
+#include <acpi/ssdt_cache.h>
+#include <commonlib/region.h>
+#include <device/device.h>
+#include <string.h>
+#include <tests/test.h>
+#include <version.h>
+
+const char coreboot_version[] = "4.0";
+const char coreboot_extra_version[] = "";
+const char coreboot_build[] = "test";
+const char coreboot_compile_time[] = "00:00:00";
+
+#define FLASH_SIZE	(8 * KiB)
+
+static uint8_t flash_buffer[FLASH_SIZE];
+static int erase_calls;
+static bool fail_data_writes;
+
+static ssize_t flash_readat(const struct region_device *rd, void *b, size_t offset,
+			    size_t size)
+{
+	memcpy(b, &flash_buffer[offset], size);
+	return size;
+}
+
+/* Like SPI flash, programming can only clear bits. */
+static ssize_t flash_writeat(const struct region_device *rd, const void *b, size_t offset,
+			     size_t size)
+{
+	const uint8_t *data = b;
+
+	if (fail_data_writes && offset >= 4 * KiB)
+		return -1;
+
+	for (size_t i = 0; i < size; i++)
+		flash_buffer[offset + i] &= data[i];
+	return size;
+}
+
+static ssize_t flash_eraseat(const struct region_device *rd, size_t offset, size_t size)
+{
+	memset(&flash_buffer[offset], 0xff, size);
+	erase_calls++;
+	return size;
+}
+
+static const struct region_device_ops flash_ops = {
+	.readat = flash_readat,
+	.writeat = flash_writeat,
+	.eraseat = flash_eraseat,
+};
+
+int fmap_locate_area_as_rdev(const char *name, struct region_device *area)
+{
+	return rdev_chain_mem(area, flash_buffer, sizeof(flash_buffer));
+}
+
+int fmap_locate_area_as_rdev_rw(const char *name, struct region_device *area)
+{
+	*area = (struct region_device)REGION_DEV_INIT(&flash_ops, 0, sizeof(flash_buffer));
+	return 0;
+}
+
+/* A CPU cluster emitting many processor objects, and a device that isn't cacheable. */
+static int cpu_fills;
+static int uncore_fills;
+static int num_cpus;
+
+static void cpu_fill_ssdt(const struct device *dev)
+{
+	cpu_fills++;
+	for (int i = 0; i < num_cpus; i++) {
+		acpigen_write_processor_device(i);
+		acpigen_write_processor_device_end();
+	}
+}
+
+static void uncore_fill_ssdt(const struct device *dev)
+{
+	uncore_fills++;
+	acpigen_write_scope("\\_SB");
+	acpigen_write_name_byte("UNCR", uncore_fills);
+	acpigen_pop_len();
+}
+
+static struct device_operations cpu_bus_ops = {
+	.acpi_fill_ssdt = cpu_fill_ssdt,
+	.acpi_ssdt_cacheable = true,
+};
+
+static struct device_operations uncore_ops = {
+	.acpi_fill_ssdt = uncore_fill_ssdt,
+};
+
+static struct resource uncore_res = {
+	.base = 0xfe000000,
+	.size = 4 * KiB,
+	.flags = IORESOURCE_MEM | IORESOURCE_ASSIGNED,
+};
+
+static struct bus pci_bus;
+
+static struct device uncore = {
+	.path = { .type = DEVICE_PATH_PCI, .pci.devfn = 0x10 },
+	.upstream = &pci_bus,
+	.ops = &uncore_ops,
+	.resource_list = &uncore_res,
+	.enabled = 1,
+};
+
+static struct device cpu_bus = {
+	.path = { .type = DEVICE_PATH_CPU_CLUSTER },
+	.ops = &cpu_bus_ops,
+	.next = &uncore,
+	.enabled = 1,
+};
+
+struct device *all_devices = &cpu_bus;
+
+static char ssdt[32 * KiB];
+
+static size_t fill_ssdt(void)
+{
+	acpigen_set_current(ssdt);
+	acpi_ssdt_cache_fill();
+	return acpigen_get_current() - ssdt;
+}
+
+static int setup_ssdt_cache(void **state)
+{
+	memset(flash_buffer, 0xff, sizeof(flash_buffer));
+	erase_calls = 0;
+	fail_data_writes = false;
+	cpu_fills = 0;
+	uncore_fills = 0;
+	num_cpus = 8;
+	uncore_res.base = 0xfe000000;
+	uncore.enabled = 1;
+	return 0;
+}
+
+static void test_ssdt_cache_hit(void **state)
+{
+	static char generated[sizeof(ssdt)];
+	size_t size;
+
+	size = fill_ssdt();
+	memcpy(generated, ssdt, size);
+	assert_int_equal(1, cpu_fills);
+	assert_int_equal(1, erase_calls);
+
+	/* The uncore output changes, but only the cluster's output comes from the cache. */
+	memset(ssdt, 0, sizeof(ssdt));
+	assert_int_equal(size, fill_ssdt());
+	assert_int_equal(1, cpu_fills);
+	assert_int_equal(2, uncore_fills);
+	assert_int_equal(1, erase_calls);
+	assert_memory_not_equal(generated, ssdt, size);
+
+	uncore_fills = 0;
+	assert_int_equal(size, fill_ssdt());
+	assert_memory_equal(generated, ssdt, size);
+}
+
+static void test_ssdt_cache_key(void **state)
+{
+	size_t size;
+
+	size = fill_ssdt();
+
+	/* A moved resource invalidates the cache. */
+	uncore_res.base += 4 * KiB;
+	assert_int_equal(size, fill_ssdt());
+	assert_int_equal(2, cpu_fills);
+	assert_int_equal(2, erase_calls);
+
+	/* So does a disabled device, which must not be in the SSDT either. */
+	uncore.enabled = 0;
+	assert_true(fill_ssdt() < size);
+	assert_int_equal(3, cpu_fills);
+	assert_int_equal(2, uncore_fills);
+}
+
+static void test_ssdt_cache_corrupted(void **state)
+{
+	size_t size;
+
+	size = fill_ssdt();
+	flash_buffer[4 * KiB + 8] ^= 1;
+	assert_int_equal(size, fill_ssdt());
+	assert_int_equal(2, cpu_fills);
+	assert_int_equal(2, erase_calls);
+	assert_int_equal(size, fill_ssdt());
+	assert_int_equal(2, cpu_fills);
+}
+
+static void test_ssdt_cache_too_large(void **state)
+{
+	/* The output doesn't fit, so it's generated on every boot and the flash left alone. */
+	num_cpus = 200;
+	fill_ssdt();
+	fill_ssdt();
+	assert_int_equal(2, cpu_fills);
+	assert_int_equal(0, erase_calls);
+}
+
+static void test_ssdt_cache_write_failed(void **state)
+{
+	size_t size;
+
+	/* A failed update is recorded and not retried with the same key. */
+	fail_data_writes = true;
+	size = fill_ssdt();
+	assert_int_equal(2, erase_calls);
+	assert_int_equal(size, fill_ssdt());
+	assert_int_equal(2, cpu_fills);
+	assert_int_equal(2, erase_calls);
+
+	/* A new key tries again. */
+	fail_data_writes = false;
+	uncore_res.base += 4 * KiB;
+	assert_int_equal(size, fill_ssdt());
+	assert_int_equal(3, erase_calls);
+	assert_int_equal(size, fill_ssdt());
+	assert_int_equal(3, cpu_fills);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test_setup(test_ssdt_cache_hit, setup_ssdt_cache),
+		cmocka_unit_test_setup(test_ssdt_cache_key, setup_ssdt_cache),
+		cmocka_unit_test_setup(test_ssdt_cache_corrupted, setup_ssdt_cache),
+		cmocka_unit_test_setup(test_ssdt_cache_too_large, setup_ssdt_cache),
+		cmocka_unit_test_setup(test_ssdt_cache_write_failed, setup_ssdt_cache),
+	};
+
+	return cb_run_group_tests(tests, NULL, NULL);
+}
@@ -3,12 +3,16 @@
 subdirs-y += bsd
 
 tests-y += list-test
+tests-y += mem_pool-test
 tests-y += rational-test
 tests-y += region-test
 
 list-test-srcs += tests/commonlib/list-test.c
 list-test-srcs += src/commonlib/list.c
 
+mem_pool-test-srcs += tests/commonlib/mem_pool-test.c
+mem_pool-test-srcs += src/commonlib/mem_pool.c
+
 rational-test-srcs += tests/commonlib/rational-test.c
 rational-test-srcs += src/commonlib/rational.c
 
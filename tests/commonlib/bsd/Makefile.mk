@@ -3,6 +3,7 @@
 tests-y += helpers-test
 tests-y += gcd-test
 tests-y += ipchksum-test
+tests-y += lz4_compress-test
 
 helpers-test-srcs += tests/commonlib/bsd/helpers-test.c
 
@@ -11,3 +12,7 @@ gcd-test-srcs += src/commonlib/bsd/gcd.c
 
 ipchksum-test-srcs += tests/commonlib/bsd/ipchksum-test.c
 ipchksum-test-srcs += src/commonlib/bsd/ipchksum.c
+
+lz4_compress-test-srcs += tests/commonlib/bsd/lz4_compress-test.c
+lz4_compress-test-srcs += src/commonlib/bsd/lz4_compress.c
+lz4_compress-test-srcs += src/commonlib/bsd/lz4_wrapper.c
@@ -0,0 +1,111 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <commonlib/bsd/compression.h>
+#include <string.h>
+#include <tests/test.h>
+#include <types.h>
+
+#define DATA_SIZE	(200 * KiB)
+
+static uint8_t data[DATA_SIZE];
+static uint8_t image[DATA_SIZE + 1 * KiB];
+static uint8_t out[DATA_SIZE];
+
+/* Something like training data: mostly repeated records with a few varying bytes. */
+static void fill_records(size_t size)
+{
+	for (size_t i = 0; i < size; i++)
+		data[i] = (i % 64 < 48) ? (i % 64) : (i / 64 * 7) & 0xff;
+}
+
+static void fill_noise(size_t size)
+{
+	uint32_t x = 0x12345678;
+
+	for (size_t i = 0; i < size; i++) {
+		x = x * 1103515245 + 12345;
+		data[i] = x >> 24;
+	}
+}
+
+static void round_trip(size_t size)
+{
+	size_t image_size = lz4f_compress(data, size, image, sizeof(image));
+
+	assert_int_not_equal(0, image_size);
+	memset(out, 0xa5, sizeof(out));
+	assert_int_equal(size, ulz4fn(image, image_size, out, sizeof(out)));
+	assert_memory_equal(data, out, size);
+}
+
+static void test_lz4f_compress_records(void **state)
+{
+	fill_records(DATA_SIZE);
+	round_trip(DATA_SIZE);
+
+	/* Shrinks well, over several blocks. */
+	assert_true(lz4f_compress(data, DATA_SIZE, image, sizeof(image)) < DATA_SIZE / 4);
+}
+
+static void test_lz4f_compress_noise(void **state)
+{
+	size_t image_size;
+
+	fill_noise(DATA_SIZE);
+	round_trip(DATA_SIZE);
+
+	/* Incompressible blocks are stored as is, so it doesn't grow much. */
+	image_size = lz4f_compress(data, DATA_SIZE, image, sizeof(image));
+	assert_true(image_size <= DATA_SIZE + 32);
+
+	/* And it doesn't fit into a buffer of the input size. */
+	assert_int_equal(0, lz4f_compress(data, DATA_SIZE, image, DATA_SIZE));
+}
+
+static void test_lz4f_compress_small(void **state)
+{
+	fill_records(DATA_SIZE);
+
+	for (size_t size = 0; size < 300; size += 13)
+		round_trip(size);
+
+	/* Not even room for the frame header and end mark. */
+	assert_int_equal(0, lz4f_compress(data, 0, image, 10));
+}
+
+static void test_lz4f_compress_long_match(void **state)
+{
+	memset(data, 'x', DATA_SIZE);
+	data[DATA_SIZE / 2] = 'y';
+	round_trip(DATA_SIZE);
+	assert_true(lz4f_compress(data, DATA_SIZE, image, sizeof(image)) < 4 * KiB);
+}
+
+static void test_lz4f_compress_overrun(void **state)
+{
+	size_t image_size;
+
+	fill_records(DATA_SIZE);
+	image_size = lz4f_compress(data, DATA_SIZE, image, sizeof(image));
+
+	/* Every too small buffer is refused rather than overrun. */
+	for (size_t dstn = image_size - 1; dstn > image_size - 64; dstn--) {
+		memset(image, 0, sizeof(image));
+		assert_int_equal(0, lz4f_compress(data, DATA_SIZE, image, dstn));
+		for (size_t i = dstn; i < sizeof(image); i++)
+			assert_int_equal(0, image[i]);
+	}
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_lz4f_compress_records),
+		cmocka_unit_test(test_lz4f_compress_noise),
+		cmocka_unit_test(test_lz4f_compress_small),
+		cmocka_unit_test(test_lz4f_compress_long_match),
+		cmocka_unit_test(test_lz4f_compress_overrun),
+	};
+
+	return cb_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,140 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <commonlib/mem_pool.h>
+#include <tests/test.h>
+
+#define POOL_ALIGN 16
+#define POOL_SIZE (16 * POOL_ALIGN)
+#define POOL_MAX_ALLOCS 32
+
+static uint8_t pool_buf[POOL_SIZE] __aligned(POOL_ALIGN);
+static struct mem_pool_block pool_allocs[POOL_MAX_ALLOCS];
+
+static int setup_pool(void **state)
+{
+	static struct mem_pool mp = MEM_POOL_INIT(NULL, 0, 0, pool_allocs, POOL_MAX_ALLOCS);
+
+	mem_pool_init(&mp, pool_buf, sizeof(pool_buf), POOL_ALIGN);
+	*state = &mp;
+
+	return 0;
+}
+
+static void test_mem_pool_lifo(void **state)
+{
+	struct mem_pool *mp = *state;
+	void *a, *b;
+
+	a = mem_pool_alloc(mp, 1);
+	b = mem_pool_alloc(mp, POOL_ALIGN + 1);
+	assert_ptr_equal(a, pool_buf);
+	assert_ptr_equal(b, pool_buf + POOL_ALIGN);
+	assert_int_equal(mp->used, 3 * POOL_ALIGN);
+
+	mem_pool_free(mp, b);
+	mem_pool_free(mp, a);
+	assert_int_equal(mp->used, 0);
+	assert_int_equal(mem_pool_largest_free(mp), POOL_SIZE);
+	assert_int_equal(mp->high_water, 3 * POOL_ALIGN);
+	assert_int_equal(mp->peak_allocs, 2);
+}
+
+static void test_mem_pool_free_any_order(void **state)
+{
+	struct mem_pool *mp = *state;
+	void *a, *b, *c, *d;
+
+	a = mem_pool_alloc(mp, 4 * POOL_ALIGN);
+	b = mem_pool_alloc(mp, 4 * POOL_ALIGN);
+	c = mem_pool_alloc(mp, 4 * POOL_ALIGN);
+	assert_non_null(c);
+
+	/* Freeing the oldest allocation makes its space available again. */
+	mem_pool_free(mp, a);
+	d = mem_pool_alloc(mp, 2 * POOL_ALIGN);
+	assert_ptr_equal(d, a);
+
+	/* Freed neighbours coalesce into one block. */
+	mem_pool_free(mp, b);
+	mem_pool_free(mp, d);
+	assert_int_equal(mem_pool_largest_free(mp), 8 * POOL_ALIGN);
+	a = mem_pool_alloc(mp, 8 * POOL_ALIGN);
+	assert_ptr_equal(a, pool_buf);
+
+	mem_pool_free(mp, c);
+	mem_pool_free(mp, a);
+	assert_int_equal(mp->used, 0);
+	assert_int_equal(mem_pool_largest_free(mp), POOL_SIZE);
+}
+
+static void test_mem_pool_fragmentation(void **state)
+{
+	struct mem_pool *mp = *state;
+	void *blocks[4];
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(blocks); i++)
+		blocks[i] = mem_pool_alloc(mp, 4 * POOL_ALIGN);
+	assert_null(mem_pool_alloc(mp, 1));
+	assert_int_equal(mp->failed_allocs, 1);
+	assert_int_equal(mp->fragmented_failures, 0);
+
+	/* Half of the pool is free, but in two separate blocks. */
+	mem_pool_free(mp, blocks[0]);
+	mem_pool_free(mp, blocks[2]);
+	assert_null(mem_pool_alloc(mp, 8 * POOL_ALIGN));
+	assert_int_equal(mp->failed_allocs, 2);
+	assert_int_equal(mp->fragmented_failures, 1);
+	assert_int_equal(mem_pool_largest_free(mp), 4 * POOL_ALIGN);
+
+	mem_pool_free(mp, blocks[1]);
+	assert_non_null(mem_pool_alloc(mp, 12 * POOL_ALIGN));
+}
+
+static void test_mem_pool_foreign_free(void **state)
+{
+	struct mem_pool *mp = *state;
+	uint8_t other[POOL_ALIGN];
+	uint8_t *a;
+
+	a = mem_pool_alloc(mp, POOL_ALIGN);
+	mem_pool_free(mp, NULL);
+	mem_pool_free(mp, other);
+	mem_pool_free(mp, a + 1);
+	assert_int_equal(mp->used, POOL_ALIGN);
+
+	mem_pool_free(mp, a);
+	assert_int_equal(mp->used, 0);
+}
+
+static void test_mem_pool_max_allocs(void **state)
+{
+	static uint8_t big_buf[2 * POOL_MAX_ALLOCS * POOL_ALIGN] __aligned(POOL_ALIGN);
+	struct mem_pool *mp = *state;
+	void *first;
+	int i;
+
+	mem_pool_init(mp, big_buf, sizeof(big_buf), POOL_ALIGN);
+
+	first = mem_pool_alloc(mp, 1);
+	for (i = 1; i < POOL_MAX_ALLOCS; i++)
+		assert_non_null(mem_pool_alloc(mp, 1));
+	assert_null(mem_pool_alloc(mp, 1));
+	assert_int_equal(mp->fragmented_failures, 1);
+
+	mem_pool_free(mp, first);
+	assert_ptr_equal(mem_pool_alloc(mp, 1), first);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test_setup(test_mem_pool_lifo, setup_pool),
+		cmocka_unit_test_setup(test_mem_pool_free_any_order, setup_pool),
+		cmocka_unit_test_setup(test_mem_pool_fragmentation, setup_pool),
+		cmocka_unit_test_setup(test_mem_pool_foreign_free, setup_pool),
+		cmocka_unit_test_setup(test_mem_pool_max_allocs, setup_pool),
+	};
+
+	return cb_run_group_tests(tests, NULL, NULL);
+}
@@ -8,3 +8,15 @@ routing-with-cbmemcons-test-config += CONFIG_CONSOLE_CBMEM=1
 
 routing-without-cbmemcons-test-srcs += tests/console/routing-test.c
 routing-without-cbmemcons-test-config += CONFIG_CONSOLE_CBMEM=0
+
+tests-y += console_async-test
+
+console_async-test-srcs += tests/console/console_async-test.c
+console_async-test-srcs += src/console/async.c
+console_async-test-config += CONFIG_CONSOLE_ASYNC=1 CONFIG_CONSOLE_ASYNC_BUFFER_SIZE=16
+
+tests-y += printk_tokenized-test
+
+printk_tokenized-test-srcs += tests/console/printk_tokenized-test.c
+printk_tokenized-test-config += CONFIG_CONSOLE_TOKENIZED=1 CONFIG_CONSOLE_CBMEM=1 \
+				CONFIG_HAVE_MONOTONIC_TIMER=0
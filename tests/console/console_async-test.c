@@ -0,0 +1,98 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <console/async.h>
+#include <console/streams.h>
+#include <string.h>
+#include <tests/test.h>
+
+static char written[64];
+static size_t num_written;
+static int num_flushes;
+
+void console_interactive_hw_tx_byte(unsigned char byte)
+{
+	assert_true(num_written < sizeof(written));
+	written[num_written++] = byte;
+}
+
+void console_interactive_hw_tx_flush(void)
+{
+	num_flushes++;
+}
+
+static int setup_output(void **state)
+{
+	memset(written, 0, sizeof(written));
+	num_written = 0;
+	num_flushes = 0;
+
+	return 0;
+}
+
+static void queue(const char *s)
+{
+	while (*s)
+		assert_true(console_async_tx_byte(*s++));
+}
+
+static void test_console_async_drain(void **state)
+{
+	queue("hello");
+	assert_int_equal(0, num_written);
+
+	assert_int_equal(2, console_async_drain(2));
+	assert_int_equal(2, num_written);
+	assert_int_equal(0, num_flushes);
+
+	/* Consoles are flushed once the queue runs empty. */
+	assert_int_equal(3, console_async_drain(100));
+	assert_memory_equal("hello", written, 5);
+	assert_int_equal(1, num_flushes);
+
+	assert_int_equal(0, console_async_drain(100));
+	assert_int_equal(1, num_flushes);
+}
+
+static void test_console_async_full(void **state)
+{
+	const char *msg = "0123456789abcdefghij";
+
+	_Static_assert(CONFIG_CONSOLE_ASYNC_BUFFER_SIZE == 16, "Test expects 16 bytes");
+
+	/* The oldest bytes are written out to make room. */
+	queue(msg);
+	assert_int_equal(4, num_written);
+	assert_memory_equal(msg, written, 4);
+
+	assert_int_equal(16, console_async_drain(100));
+	assert_int_equal(20, num_written);
+	assert_memory_equal(msg, written, 20);
+}
+
+static void test_console_async_flush(void **state)
+{
+	assert_true(console_async_active());
+
+	queue("bye\n");
+	console_async_flush();
+	assert_int_equal(4, num_written);
+	assert_memory_equal("bye\n", written, 4);
+	assert_int_equal(1, num_flushes);
+
+	/* Later output bypasses the queue. */
+	assert_false(console_async_active());
+	assert_false(console_async_tx_byte('x'));
+	assert_int_equal(4, num_written);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test_setup(test_console_async_drain, setup_output),
+		cmocka_unit_test_setup(test_console_async_full, setup_output),
+		/* Has to be last, queueing stays off after a flush. */
+		cmocka_unit_test_setup(test_console_async_flush, setup_output),
+	};
+
+	return cb_run_group_tests(tests, NULL, NULL);
+}
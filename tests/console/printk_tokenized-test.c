@@ -0,0 +1,195 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include "../console/printk.c"
+
+#include <commonlib/printk_token_serialized.h>
+#include <console/console.h>
+#include <string.h>
+#include <tests/test.h>
+
+static char out[1024];
+static size_t out_len;
+
+int console_log_level(int msg_level)
+{
+	return msg_level <= BIOS_DEBUG ? CONSOLE_LOG_ALL : CONSOLE_LOG_NONE;
+}
+
+/* The level markers are left out, only the record line is checked. */
+void cbmemc_tx_byte(unsigned char byte)
+{
+	if (!BIOS_LOG_IS_MARKER(byte) && out_len < sizeof(out) - 1)
+		out[out_len++] = byte;
+}
+
+void console_tx_byte(unsigned char byte)
+{
+	cbmemc_tx_byte(byte);
+}
+
+void console_tx_flush(void) {}
+void console_stored_tx_byte(unsigned char byte, void *data) {}
+void console_interactive_tx_byte(unsigned char byte, void *data) {}
+
+int vtxprintf(void (*tx_byte)(unsigned char byte, void *data), const char *fmt, va_list args,
+	      void *data)
+{
+	return 0;
+}
+
+static int base64_value(char c)
+{
+	static const char digits[] =
+		"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+	const char *p = strchr(digits, c);
+
+	return p && c ? p - digits : -1;
+}
+
+/* Decode the one record line in out[] into rec[], returns its length. */
+static size_t decode_output(uint8_t *rec)
+{
+	size_t i, n = 0;
+	uint32_t v;
+
+	assert_true(out_len >= 2);
+	assert_int_equal(PRINTK_TOKEN_PREFIX, out[0]);
+	assert_int_equal('\n', out[out_len - 1]);
+	assert_int_equal(0, (out_len - 2) % 4);
+
+	for (i = 1; i + 4 <= out_len - 1; i += 4) {
+		v = 0;
+		for (int j = 0; j < 4; j++)
+			v = v << 6 | (out[i + j] == '=' ? 0 : base64_value(out[i + j]));
+		rec[n++] = v >> 16;
+		if (out[i + 2] != '=')
+			rec[n++] = v >> 8;
+		if (out[i + 3] != '=')
+			rec[n++] = v;
+	}
+
+	return n;
+}
+
+static uint64_t get_varint(const uint8_t *rec, size_t *pos)
+{
+	uint64_t val = 0;
+	int shift = 0;
+
+	do {
+		val |= (uint64_t)(rec[*pos] & 0x7f) << shift;
+		shift += 7;
+	} while (rec[(*pos)++] & 0x80);
+
+	return val;
+}
+
+static uint32_t get_token(const uint8_t *rec)
+{
+	return rec[0] | rec[1] << 8 | rec[2] << 16 | (uint32_t)rec[3] << 24;
+}
+
+static int setup_output(void **state)
+{
+	memset(out, 0, sizeof(out));
+	out_len = 0;
+	return 0;
+}
+
+static void test_printk_token(void **state)
+{
+	static const char fmt[] = "%s: Found device %x:%x at %p\n";
+	char long_fmt[300];
+	uint32_t hash;
+
+	assert_int_equal(printk_token_hash(fmt, strlen(fmt)), PRINTK_TOKEN(fmt));
+	assert_int_equal(printk_token_hash("", 0), PRINTK_TOKEN(""));
+	assert_int_not_equal(PRINTK_TOKEN("%d\n"), PRINTK_TOKEN("%u\n"));
+
+	/* Only the first PRINTK_TOKEN_HASH_LEN characters and the length count. */
+	memset(long_fmt, 'a', sizeof(long_fmt));
+	hash = printk_token_hash(long_fmt, 200);
+	long_fmt[150] = 'b';
+	assert_int_equal(hash, printk_token_hash(long_fmt, 200));
+	assert_int_not_equal(hash, printk_token_hash(long_fmt, 201));
+}
+
+static void test_printk_arg_types(void **state)
+{
+	const char *name = "dev";
+	char buf[4];
+	unsigned long long ull = 0;
+	uint8_t u8 = 0;
+	long l = 0;
+
+	assert_int_equal(0, PRINTK_ARG_TYPES());
+	assert_int_equal(PRINTK_ARG_32, PRINTK_ARG_TYPES(u8));
+	assert_int_equal(PRINTK_ARG_STRING, PRINTK_ARG_TYPES(name));
+	assert_int_equal(PRINTK_ARG_STRING, PRINTK_ARG_TYPES(buf));
+	assert_int_equal(PRINTK_ARG_64, PRINTK_ARG_TYPES(ull));
+	assert_int_equal(sizeof(long) == 8 ? PRINTK_ARG_64 : PRINTK_ARG_32,
+			 PRINTK_ARG_TYPES(l));
+	assert_int_equal(sizeof(void *) == 8 ? PRINTK_ARG_64 : PRINTK_ARG_32,
+			 PRINTK_ARG_TYPES(&l));
+	assert_int_equal(PRINTK_ARG_32 | PRINTK_ARG_STRING << 2 | (uint64_t)PRINTK_ARG_64 << 4,
+			 PRINTK_ARG_TYPES(1, "x", ull));
+	assert_int_equal(PRINTK_NARGS(1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16,
+				      17, 18, 19, 20, 21, 22, 23, 24), 24);
+}
+
+static void test_printk_record(void **state)
+{
+	uint8_t rec[PRINTK_TOKEN_MAX_RECORD];
+	const char *null_str = NULL;
+	size_t pos = 4, len;
+
+	printk(BIOS_DEBUG, "%s %d %llx %s\n", "abc", -2, 0x123456789ull, null_str);
+	len = decode_output(rec);
+
+	assert_int_equal(PRINTK_TOKEN("%s %d %llx %s\n"), get_token(rec));
+	assert_int_equal(PRINTK_ARG_STRING | PRINTK_ARG_32 << 2 | PRINTK_ARG_64 << 4 |
+			 PRINTK_ARG_STRING << 6, get_varint(rec, &pos));
+	assert_int_equal(3, get_varint(rec, &pos));
+	assert_memory_equal("abc", &rec[pos], 3);
+	pos += 3;
+	assert_int_equal(0xfffffffe, get_varint(rec, &pos));
+	assert_int_equal(0x123456789ull, get_varint(rec, &pos));
+	assert_int_equal(6, get_varint(rec, &pos));
+	assert_memory_equal("<NULL>", &rec[pos], 6);
+	assert_int_equal(pos + 6, len);
+}
+
+static void test_printk_record_overflow(void **state)
+{
+	uint8_t rec[PRINTK_TOKEN_MAX_RECORD];
+	char s[PRINTK_TOKEN_MAX_STRING + 10];
+	size_t pos = 4;
+
+	memset(s, 'x', sizeof(s) - 1);
+	s[sizeof(s) - 1] = '\0';
+
+	/* The first string is cut, the rest doesn't fit anymore. */
+	printk(BIOS_DEBUG, "%s %s %s %d\n", s, s, s, 5);
+	assert_true(decode_output(rec) <= PRINTK_TOKEN_MAX_RECORD);
+	assert_int_equal(PRINTK_ARG_STRING, get_varint(rec, &pos));
+	assert_int_equal(PRINTK_TOKEN_MAX_STRING, get_varint(rec, &pos));
+}
+
+static void test_printk_level(void **state)
+{
+	printk(BIOS_SPEW, "not shown %d\n", 1);
+	assert_int_equal(0, out_len);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_printk_token),
+		cmocka_unit_test(test_printk_arg_types),
+		cmocka_unit_test_setup(test_printk_record, setup_output),
+		cmocka_unit_test_setup(test_printk_record_overflow, setup_output),
+		cmocka_unit_test_setup(test_printk_level, setup_output),
+	};
+
+	return cb_run_group_tests(tests, NULL, NULL);
+}
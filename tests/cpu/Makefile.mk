@@ -0,0 +1,18 @@
+# SPDX-License-Identifier: GPL-2.0-only
+
+tests-y += mp_task-test
+
+mp_task-test-srcs += tests/cpu/mp_task-test.c
+mp_task-test-config += CONFIG_MP_TASK_POOL=1 CONFIG_MP_TASK_QUEUE_SIZE=4 CONFIG_MAX_CPUS=4
+
+tests-y += mp_mem-test
+
+mp_mem-test-srcs += tests/cpu/mp_mem-test.c
+mp_mem-test-srcs += src/lib/memrange.c
+mp_mem-test-srcs += tests/stubs/console.c
+mp_mem-test-srcs += src/device/device_util.c
+mp_mem-test-config += CONFIG_MP_MEM_PARALLEL=1 \
+		      CONFIG_MP_TASK_POOL=1 \
+		      CONFIG_MP_TASK_QUEUE_SIZE=4 \
+		      CONFIG_MAX_CPUS=4 \
+		      CONFIG_COLLECT_TIMESTAMPS=0
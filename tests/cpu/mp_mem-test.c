@@ -0,0 +1,158 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <arch/cpu.h>
+#include <cpu/x86/mp.h>
+#include <cpu/x86/mp_mem.h>
+#include <memrange.h>
+#include <string.h>
+#include <tests/test.h>
+#include <timer.h>
+
+/* Which CPU the task pool thinks it runs on. */
+static unsigned long current_cpu;
+#define cpu_index() current_cpu
+
+#include "../cpu/x86/mp_task.c"
+#include "../cpu/x86/mp_mem.c"
+
+enum {
+	RAM_TAG = 1,
+	OTHER_TAG,
+};
+
+/* The "physical" memory, so chunks start at 2 MiB boundaries in the middle of ranges. */
+static uint8_t dram[5 * MiB] __aligned(2 * MiB);
+
+/* A clock that advances by 10us each time it's read. */
+static uint64_t now_us;
+
+void timer_monotonic_get(struct mono_time *mt)
+{
+	mono_time_set_usecs(mt, now_us);
+	now_us += 10;
+}
+
+static bool accept_work;
+/* Tasks submitted to the pool, and whether an AP stole the first one right away. */
+static int submitted;
+static bool ap_steals;
+static bool ap_ran;
+
+bool mp_aps_accept_work(void)
+{
+	/* Called once per mp_task_submit(), so the first task is queued by now. */
+	if (accept_work && ap_steals && submitted++ == 1) {
+		current_cpu = 1;
+		ap_ran = mp_task_run_one();
+		current_cpu = 0;
+	}
+
+	return accept_work;
+}
+
+static struct memranges mem;
+static struct range_entry entries[4];
+
+static int setup_dram(void **state)
+{
+	memset(dram, 0xa5, sizeof(dram));
+	current_cpu = 0;
+	accept_work = false;
+	submitted = 0;
+	ap_steals = false;
+	ap_ran = false;
+
+	/* Two RAM ranges which don't start or end at a 2 MiB boundary. */
+	memranges_init_empty(&mem, entries, ARRAY_SIZE(entries));
+	memranges_insert(&mem, (uintptr_t)dram + 4 * KiB, 3 * MiB, RAM_TAG);
+	memranges_insert(&mem, (uintptr_t)dram + 3 * MiB + 4 * KiB, 64 * KiB, OTHER_TAG);
+	memranges_insert(&mem, (uintptr_t)dram + 4 * MiB - 8 * KiB, 8 * KiB, RAM_TAG);
+
+	return 0;
+}
+
+static bool all_bytes(const uint8_t *p, size_t size, uint8_t value)
+{
+	for (size_t i = 0; i < size; i++) {
+		if (p[i] != value)
+			return false;
+	}
+	return true;
+}
+
+static void assert_only_ram_cleared(void)
+{
+	assert_true(all_bytes(dram, 4 * KiB, 0xa5));
+	assert_true(all_bytes(dram + 4 * KiB, 3 * MiB, 0));
+	assert_true(all_bytes(dram + 3 * MiB + 4 * KiB, 1 * MiB - 12 * KiB, 0xa5));
+	assert_true(all_bytes(dram + 4 * MiB - 8 * KiB, 8 * KiB, 0));
+	assert_true(all_bytes(dram + 4 * MiB, 1 * MiB, 0xa5));
+}
+
+static void test_mp_mem_clear_bsp(void **state)
+{
+	assert_int_equal(CB_SUCCESS, mp_mem_clear(&mem, RAM_TAG));
+	assert_only_ram_cleared();
+	/* The 3 MiB range spans two 2 MiB pages, plus one chunk for the 8 KiB range. */
+	assert_int_equal(3, job.num_chunks);
+	assert_int_equal(1, tasks[0].done);
+}
+
+static void test_mp_mem_clear_aps(void **state)
+{
+	/* The queued tasks run while the BSP waits for them. */
+	accept_work = true;
+	assert_int_equal(CB_SUCCESS, mp_mem_clear(&mem, RAM_TAG));
+	assert_only_ram_cleared();
+	assert_int_equal(0, pending);
+
+	/* An AP which steals the first task takes all chunks, the BSP's tasks find none. */
+	setup_dram(state);
+	accept_work = true;
+	ap_steals = true;
+	assert_int_equal(CB_SUCCESS, mp_mem_clear(&mem, RAM_TAG));
+	assert_true(ap_ran);
+	assert_int_equal(3, submitted);
+	assert_only_ram_cleared();
+	assert_int_equal(0, pending);
+}
+
+static void test_mp_mem_test(void **state)
+{
+	uint64_t bad_words = ~0ULL;
+
+	accept_work = true;
+	assert_int_equal(CB_SUCCESS, mp_mem_test(&mem, RAM_TAG, &bad_words));
+	assert_int_equal(0, bad_words);
+	assert_only_ram_cleared();
+}
+
+static void test_mp_mem_check(void **state)
+{
+	uintptr_t *p = (uintptr_t *)(dram + 2 * MiB);
+	const uint64_t addr = (uintptr_t)p;
+	uint64_t first_bad = 0;
+
+	/* A bit stuck in the third word. */
+	fill_nt(p, 16, addr, true, 0);
+	p[2] ^= 1 << 7;
+	assert_int_equal(1, check(p, 16, addr, 0, &first_bad));
+	assert_int_equal(addr + 2 * sizeof(*p), first_bad);
+	assert_int_equal(0, check(p, 2, addr, 0, &first_bad));
+
+	fill_nt(p, 16, addr, true, ~(uintptr_t)0);
+	assert_int_equal(0, check(p, 16, addr, ~(uintptr_t)0, &first_bad));
+	assert_int_equal(16, check(p, 16, addr, 0, &first_bad));
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test_setup(test_mp_mem_clear_bsp, setup_dram),
+		cmocka_unit_test_setup(test_mp_mem_clear_aps, setup_dram),
+		cmocka_unit_test_setup(test_mp_mem_test, setup_dram),
+		cmocka_unit_test_setup(test_mp_mem_check, setup_dram),
+	};
+
+	return cb_run_group_tests(tests, NULL, NULL);
+}
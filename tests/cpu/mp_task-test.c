@@ -0,0 +1,140 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <arch/cpu.h>
+#include <cpu/x86/mp.h>
+#include <string.h>
+#include <tests/test.h>
+
+/* Which CPU the code under test thinks it runs on. */
+static unsigned long current_cpu;
+#define cpu_index() current_cpu
+
+#include "../cpu/x86/mp_task.c"
+
+static bool accept_work;
+
+bool mp_aps_accept_work(void)
+{
+	return accept_work;
+}
+
+static char order[16];
+static size_t order_len;
+
+static void record(void *arg)
+{
+	order[order_len++] = (char)(uintptr_t)arg;
+}
+
+static int setup_pool(void **state)
+{
+	memset(order, 0, sizeof(order));
+	order_len = 0;
+	current_cpu = 0;
+	accept_work = true;
+	return 0;
+}
+
+static void test_mp_task_no_aps(void **state)
+{
+	struct mp_task task;
+
+	/* Without APs waiting for work, the task runs right away. */
+	accept_work = false;
+	mp_task_submit(&task, record, (void *)'a');
+	assert_int_equal(1, task.done);
+	assert_string_equal("a", order);
+	mp_task_wait_all();
+}
+
+static void test_mp_task_steal(void **state)
+{
+	struct mp_task tasks[3];
+
+	mp_task_submit(&tasks[0], record, (void *)'a');
+	mp_task_submit(&tasks[1], record, (void *)'b');
+	mp_task_submit(&tasks[2], record, (void *)'c');
+	assert_int_equal(0, order_len);
+
+	/* Another CPU steals the oldest task, the owner runs its newest one first. */
+	current_cpu = 2;
+	assert_true(mp_task_run_one());
+	assert_string_equal("a", order);
+	current_cpu = 0;
+	assert_true(mp_task_run_one());
+	assert_string_equal("ac", order);
+
+	mp_task_join(&tasks[1]);
+	assert_string_equal("acb", order);
+	assert_false(mp_task_run_one());
+	mp_task_wait_all();
+}
+
+static void test_mp_task_join_other_cpu(void **state)
+{
+	struct mp_task task;
+
+	current_cpu = 3;
+	mp_task_submit(&task, record, (void *)'x');
+	current_cpu = 0;
+	mp_task_join(&task);
+	assert_int_equal(1, task.done);
+	assert_string_equal("x", order);
+}
+
+static void test_mp_task_queue_full(void **state)
+{
+	struct mp_task tasks[QUEUE_SIZE + 2];
+	size_t i;
+
+	/* Tasks that don't fit into the queue run right away. */
+	for (i = 0; i < ARRAY_SIZE(tasks); i++)
+		mp_task_submit(&tasks[i], record, (void *)(uintptr_t)('a' + i));
+	assert_string_equal("ef", order);
+
+	mp_task_wait_all();
+	assert_string_equal("efdcba", order);
+	for (i = 0; i < ARRAY_SIZE(tasks); i++)
+		assert_int_equal(1, tasks[i].done);
+
+	/* The queue is usable again after wrapping around. */
+	mp_task_submit(&tasks[0], record, (void *)'g');
+	current_cpu = 1;
+	mp_task_join(&tasks[0]);
+	assert_string_equal("efdcbag", order);
+}
+
+static void fork_join(void *arg)
+{
+	struct mp_task children[2];
+
+	mp_task_submit(&children[0], record, (void *)'1');
+	mp_task_submit(&children[1], record, (void *)'2');
+	mp_task_join(&children[0]);
+	mp_task_join(&children[1]);
+	record(arg);
+}
+
+static void test_mp_task_nested(void **state)
+{
+	struct mp_task task;
+
+	mp_task_submit(&task, fork_join, (void *)'p');
+	current_cpu = 1;
+	mp_task_wait_all();
+	assert_string_equal("21p", order);
+	assert_false(mp_task_run_one());
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test_setup(test_mp_task_no_aps, setup_pool),
+		cmocka_unit_test_setup(test_mp_task_steal, setup_pool),
+		cmocka_unit_test_setup(test_mp_task_join_other_cpu, setup_pool),
+		cmocka_unit_test_setup(test_mp_task_queue_full, setup_pool),
+		cmocka_unit_test_setup(test_mp_task_nested, setup_pool),
+	};
+
+	return cb_run_group_tests(tests, NULL, NULL);
+}
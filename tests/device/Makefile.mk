@@ -2,6 +2,7 @@
 
 tests-y += i2c-test
 tests-y += ddr4-test
+tests-y += device_init-test
 
 i2c-test-srcs += tests/device/i2c-test.c
 i2c-test-srcs += src/device/i2c.c
@@ -10,3 +11,11 @@ i2c-test-mocks += platform_i2c_transfer
 ddr4-test-srcs += tests/device/ddr4-test.c
 ddr4-test-srcs += tests/stubs/console.c
 ddr4-test-srcs += src/device/dram/ddr4.c
+
+device_init-test-srcs += tests/device/device_init-test.c
+device_init-test-srcs += tests/stubs/console.c
+device_init-test-srcs += src/device/device.c
+device_init-test-srcs += src/device/device_util.c
+device_init-test-config += CONFIG_COOP_MULTITASKING=1 \
+			  CONFIG_PARALLEL_DEVICE_INIT=1 \
+			  CONFIG_PARALLEL_DEVICE_INIT_THREADS=2
@@ -0,0 +1,175 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <device/device.h>
+#include <device/pci_def.h>
+#include <string.h>
+#include <tests/test.h>
+#include <timer.h>
+#include <types.h>
+
+void timer_monotonic_get(struct mono_time *mt)
+{
+	static uint64_t now_us;
+
+	mono_time_set_usecs(mt, now_us);
+	now_us += 10;
+}
+
+/*
+ * No threads are free, so the main thread runs all inits in dependency order. Including
+ * <thread.h> would declare a conflicting main().
+ */
+struct thread_handle;
+
+int thread_run(struct thread_handle *handle, enum cb_err (*func)(void *), void *arg)
+{
+	return -1;
+}
+
+enum cb_err thread_join(struct thread_handle *handle)
+{
+	return CB_SUCCESS;
+}
+
+void post_code(u8 value)
+{
+}
+
+static char order[8];
+static size_t order_len;
+
+static void record_init(struct device *dev)
+{
+	order[order_len++] = 'a' + PCI_SLOT(dev->path.pci.devfn);
+}
+
+static struct device_operations init_ops = {
+	.init = record_init,
+};
+
+/*
+ * dev_root
+ *  domain 0
+ *   pci 00.0 (a)
+ *    pci 02.0 (c)
+ *   pci 01.0 (b)
+ *   pci 03.0 (d)
+ */
+static struct bus root_bus, domain_bus, dev_a_bus;
+static struct device domain, dev_a, dev_b, dev_c, dev_d;
+
+DEVTREE_CONST struct device dev_root = {
+	.path = { .type = DEVICE_PATH_ROOT },
+	.enabled = 1,
+	.downstream = &root_bus,
+};
+
+DEVTREE_CONST struct device *DEVTREE_CONST all_devices = &dev_root;
+
+static struct bus root_bus = { .dev = &dev_root, .children = &domain };
+
+static struct device domain = {
+	.upstream = &root_bus,
+	.path = { .type = DEVICE_PATH_DOMAIN },
+	.enabled = 1,
+	.downstream = &domain_bus,
+};
+
+static struct bus domain_bus = { .dev = &domain, .children = &dev_a };
+
+static struct device dev_a = {
+	.ops = &init_ops,
+	.upstream = &domain_bus,
+	.path = { .type = DEVICE_PATH_PCI, .pci = { .devfn = PCI_DEVFN(0, 0) } },
+	.enabled = 1,
+	.downstream = &dev_a_bus,
+	.sibling = &dev_b,
+};
+
+static struct bus dev_a_bus = { .dev = &dev_a, .children = &dev_c };
+
+static struct device dev_c = {
+	.ops = &init_ops,
+	.upstream = &dev_a_bus,
+	.path = { .type = DEVICE_PATH_PCI, .pci = { .devfn = PCI_DEVFN(2, 0) } },
+	.enabled = 1,
+};
+
+static struct device dev_b = {
+	.ops = &init_ops,
+	.upstream = &domain_bus,
+	.path = { .type = DEVICE_PATH_PCI, .pci = { .devfn = PCI_DEVFN(1, 0) } },
+	.enabled = 1,
+	.sibling = &dev_d,
+};
+
+static struct device dev_d = {
+	.ops = &init_ops,
+	.upstream = &domain_bus,
+	.path = { .type = DEVICE_PATH_PCI, .pci = { .devfn = PCI_DEVFN(3, 0) } },
+	.enabled = 1,
+};
+
+static int setup_tree(void **state)
+{
+	memset(order, 0, sizeof(order));
+	order_len = 0;
+	dev_a.initialized = 0;
+	dev_b.initialized = 0;
+	dev_c.initialized = 0;
+	dev_d.initialized = 0;
+	dev_b.init_after = NULL;
+	dev_c.init_after = NULL;
+	return 0;
+}
+
+static void test_init_tree_order(void **state)
+{
+	/* Without waits or declared ordering, the order is the same as without threads. */
+	dev_initialize();
+	assert_string_equal("abdc", order);
+}
+
+static void test_init_after_cousin(void **state)
+{
+	static struct device *const after_c[] = { &dev_c, NULL };
+
+	/* b and c are on different buses, so b only waits for c because it is declared. */
+	dev_b.init_after = after_c;
+	dev_initialize();
+	assert_string_equal("adcb", order);
+}
+
+static void test_init_after_without_init(void **state)
+{
+	static struct device *const after_domain[] = { &domain, NULL };
+
+	/* A device without an init() method doesn't hold anything up. */
+	dev_b.init_after = after_domain;
+	dev_initialize();
+	assert_string_equal("abdc", order);
+}
+
+static void test_init_after_cycle(void **state)
+{
+	static struct device *const after_b[] = { &dev_b, NULL };
+	static struct device *const after_c[] = { &dev_c, NULL };
+
+	/* A cycle is broken instead of leaving the devices uninitialized. */
+	dev_b.init_after = after_c;
+	dev_c.init_after = after_b;
+	dev_initialize();
+	assert_string_equal("adbc", order);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test_setup(test_init_tree_order, setup_tree),
+		cmocka_unit_test_setup(test_init_after_cousin, setup_tree),
+		cmocka_unit_test_setup(test_init_after_without_init, setup_tree),
+		cmocka_unit_test_setup(test_init_after_cycle, setup_tree),
+	};
+
+	return cb_run_group_tests(tests, NULL, NULL);
+}
@@ -11,3 +11,40 @@ efivars-test-cflags += -I src/vendorcode/intel/edk2/UDK2017/MdePkg/Include/
 efivars-test-cflags += -I src/vendorcode/intel/edk2/UDK2017/MdePkg/Include/Ia32/
 efivars-test-cflags += -I src/vendorcode/intel/edk2/UDK2017/MdePkg/Include/Pi/
 efivars-test-cflags += -I src/vendorcode/intel/edk2/UDK2017/MdeModulePkg/Include/
+
+tests-y += spi_flash_cache-test
+
+spi_flash_cache-test-srcs += tests/drivers/spi_flash_cache-test.c
+spi_flash_cache-test-srcs += src/drivers/spi/spi_flash_cache.c
+spi_flash_cache-test-srcs += tests/stubs/console.c
+spi_flash_cache-test-config += CONFIG_SPI_FLASH_READ_CACHE=1 \
+			       CONFIG_BOOT_DEVICE_SPI_FLASH_BUS=0 \
+			       CONFIG_SPI_FLASH_READ_CACHE_LINES=8 \
+			       CONFIG_SPI_FLASH_READ_CACHE_READAHEAD=2
+
+tests-y += spi_flash-test
+
+spi_flash-test-srcs += tests/drivers/spi_flash-test.c
+spi_flash-test-srcs += tests/stubs/spi_flash_emu.c
+spi_flash-test-srcs += tests/stubs/console.c
+spi_flash-test-srcs += src/drivers/spi/spi_flash.c
+spi_flash-test-srcs += src/drivers/spi/spi-generic.c
+spi_flash-test-srcs += src/drivers/spi/winbond.c
+spi_flash-test-srcs += src/drivers/spi/macronix.c
+spi_flash-test-srcs += src/commonlib/region.c
+spi_flash-test-config += CONFIG_SPI_FLASH=1 \
+			 CONFIG_SPI_FLASH_QUAD_IO=1 \
+			 CONFIG_SPI_FLASH_WINBOND=1 \
+			 CONFIG_SPI_FLASH_MACRONIX=1 \
+			 CONFIG_BOOT_DEVICE_SPI_FLASH_BUS=0
+
+tests-y += smmstore-test
+
+smmstore-test-srcs += tests/drivers/smmstore-test.c
+smmstore-test-srcs += tests/stubs/console.c
+smmstore-test-srcs += src/commonlib/region.c
+smmstore-test-cflags += -I tests/include/tests/lib/fmap
+smmstore-test-config += CONFIG_SMMSTORE=1 \
+			CONFIG_SMMSTORE_INDEX=1 \
+			CONFIG_SMMSTORE_INDEX_ENTRIES=64 \
+			CONFIG_SMMSTORE_COMPACT_THRESHOLD=75
@@ -0,0 +1,303 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include "../drivers/smmstore/store.c"
+
+#include <boot_device.h>
+#include <commonlib/region.h>
+#include <string.h>
+#include <tests/test.h>
+
+#define STORE_SIZE	FMAP_SECTION_SMMSTORE_SIZE
+#define LOG_SIZE	(STORE_SIZE - SMM_BLOCK_SIZE)
+
+static uint8_t flash[STORE_SIZE];
+static size_t erased_bytes;
+static bool fail_log_erase;
+
+static ssize_t flash_readat(const struct region_device *rd, void *b, size_t offset,
+			    size_t size)
+{
+	memcpy(b, &flash[offset], size);
+	return size;
+}
+
+/* Like NOR flash, programming can only clear bits. */
+static ssize_t flash_writeat(const struct region_device *rd, const void *b, size_t offset,
+			     size_t size)
+{
+	const uint8_t *data = b;
+
+	for (size_t i = 0; i < size; i++)
+		flash[offset + i] &= data[i];
+	return size;
+}
+
+static ssize_t flash_eraseat(const struct region_device *rd, size_t offset, size_t size)
+{
+	if (fail_log_erase && offset < LOG_SIZE)
+		return -1;
+
+	memset(&flash[offset], 0xff, size);
+	erased_bytes += size;
+	return size;
+}
+
+static const struct region_device_ops flash_ops = {
+	.readat = flash_readat,
+	.writeat = flash_writeat,
+	.eraseat = flash_eraseat,
+};
+
+static const struct region_device flash_rdev = REGION_DEV_INIT(&flash_ops, 0, STORE_SIZE);
+
+int fmap_locate_area(const char *name, struct region *r)
+{
+	r->offset = 0;
+	r->size = STORE_SIZE;
+	return 0;
+}
+
+int boot_device_ro_subregion(const struct region *sub, struct region_device *subrd)
+{
+	return rdev_chain(subrd, &flash_rdev, region_offset(sub), region_sz(sub));
+}
+
+int boot_device_rw_subregion(const struct region *sub, struct region_device *subrd)
+{
+	return rdev_chain(subrd, &flash_rdev, region_offset(sub), region_sz(sub));
+}
+
+static int setup_store(void **state)
+{
+	memset(flash, 0xff, sizeof(flash));
+	memset(&idx, 0, sizeof(idx));
+	erased_bytes = 0;
+	fail_log_erase = false;
+
+	return 0;
+}
+
+static void append(const char *key, const void *value, uint32_t value_sz)
+{
+	assert_int_equal(0, smmstore_append_data((void *)key, strlen(key), (void *)value,
+						 value_sz));
+}
+
+static void assert_value(const char *key, const void *value, size_t value_sz)
+{
+	uint8_t buf[2 * KiB];
+	size_t size = sizeof(buf);
+
+	assert_int_equal(0, smmstore_lookup_data((void *)key, strlen(key), buf, &size));
+	assert_int_equal(value_sz, size);
+	assert_memory_equal(value, buf, value_sz);
+}
+
+/* What a reset does to the in-SMRAM state. */
+static void reboot(void)
+{
+	memset(&idx, 0xa5, sizeof(idx));
+	idx.valid = false;
+}
+
+static void test_append_lookup(void **state)
+{
+	uint8_t buf[4];
+	size_t size = sizeof(buf);
+
+	append("BootOrder", "\x01\x00", 2);
+	append("Lang", "eng", 3);
+	append("BootOrder", "\x02\x00\x01\x00\x03\x00", 6);
+
+	assert_value("BootOrder", "\x02\x00\x01\x00\x03\x00", 6);
+	assert_value("Lang", "eng", 3);
+	assert_int_equal(2, idx.keys);
+
+	/* Keys are compared in full, not just by prefix or hash. */
+	assert_int_equal(-1, smmstore_lookup_data("Boot", 4, buf, &size));
+	assert_int_equal(-1, smmstore_lookup_data("Langs", 5, buf, &size));
+
+	/* A short buffer gets the size of the value. */
+	size = 4;
+	assert_int_equal(-1, smmstore_lookup_data("BootOrder", 9, buf, &size));
+	assert_int_equal(6, size);
+
+	/* The log format stays readable for consumers that walk it themselves. */
+	struct region_device store;
+	assert_int_equal(0, lookup_store(&store));
+	assert_int_equal(CB_SUCCESS, scan_end(&store));
+	assert_int_equal(idx.end, region_device_offset(&store));
+}
+
+static void test_rebuild(void **state)
+{
+	char key[16];
+
+	for (int i = 0; i < 40; i++) {
+		snprintf(key, sizeof(key), "Var%d", i % 10);
+		append(key, &i, sizeof(i));
+	}
+
+	/* A record whose termination byte never got written is skipped. */
+	flash[idx.end] = 4;
+	memset(&flash[idx.end + 1], 0, 7);
+	flash[idx.end + 8] = 'V';
+
+	reboot();
+	for (int i = 30; i < 40; i++) {
+		snprintf(key, sizeof(key), "Var%d", i % 10);
+		assert_value(key, &i, sizeof(i));
+	}
+	assert_int_equal(10, idx.keys);
+	assert_int_equal(40 * record_size(4, 4) + record_size(4, 0), idx.end);
+}
+
+static void test_compaction(void **state)
+{
+	uint8_t value[1000];
+	char key[16];
+	int i;
+
+	/* Many more updates than the log can hold, with only a few live keys. */
+	for (i = 0; i < 1000; i++) {
+		memset(value, i, sizeof(value));
+		snprintf(key, sizeof(key), "Var%d", i % 4);
+		append(key, value, sizeof(value));
+		assert_true(idx.end <= LOG_SIZE * CONFIG_SMMSTORE_COMPACT_THRESHOLD / 100);
+	}
+
+	assert_true(erased_bytes > 0);
+	for (i = 996; i < 1000; i++) {
+		memset(value, i, sizeof(value));
+		snprintf(key, sizeof(key), "Var%d", i % 4);
+		assert_value(key, value, sizeof(value));
+	}
+
+	/* The spare block is left erased. */
+	for (i = LOG_SIZE; i < STORE_SIZE; i++)
+		assert_int_equal(0xff, flash[i]);
+
+	reboot();
+	assert_value("Var3", value, sizeof(value));
+	assert_int_equal(4, idx.keys);
+}
+
+static void test_interrupted_compaction(void **state)
+{
+	uint8_t value[1000];
+	int i;
+
+	memset(value, 0x5a, sizeof(value));
+	for (i = 0; smmstore_append_data("Old", 3, value, sizeof(value)) == 0; i++) {
+		if (i == 10) {
+			append("Kept", "yes", 3);
+			/* Lose power while the log is being erased. */
+			fail_log_erase = true;
+		}
+	}
+	assert_false(idx.valid);
+	assert_true(i > 10);
+
+	fail_log_erase = false;
+	reboot();
+	assert_value("Kept", "yes", 3);
+	assert_value("Old", value, sizeof(value));
+	assert_int_equal(2, idx.keys);
+	assert_int_equal(idx.live, idx.end);
+	for (i = LOG_SIZE; i < STORE_SIZE; i++)
+		assert_int_equal(0xff, flash[i]);
+
+	append("New", "1", 1);
+	assert_value("New", "1", 1);
+}
+
+static void test_torn_header(void **state)
+{
+	append("A", "1", 1);
+	append("B", "2", 2);
+
+	/* Only the key size of the next record made it to flash. */
+	memset(&flash[idx.end], 0, 4);
+
+	reboot();
+	assert_value("A", "1", 1);
+	assert_value("B", "2", 2);
+
+	/* The log got compacted so appends can continue behind the live records. */
+	assert_int_equal(idx.live, idx.end);
+	append("C", "3", 1);
+	assert_value("C", "3", 1);
+}
+
+static void test_index_full(void **state)
+{
+	char key[16];
+
+	for (int i = 0; i < CONFIG_SMMSTORE_INDEX_ENTRIES; i++) {
+		snprintf(key, sizeof(key), "Var%d", i);
+		append(key, &i, sizeof(i));
+	}
+
+	assert_int_equal(-1, smmstore_append_data("Another", 7, "x", 1));
+	/* Existing keys can still be updated. */
+	append("Var0", "y", 1);
+	assert_value("Var0", "y", 1);
+}
+
+static void test_unindexed_store(void **state)
+{
+	uint8_t value[1000], buf[4];
+	size_t size = sizeof(buf);
+	uint32_t offset;
+
+	/* A log written without the index that reaches into the last block. */
+	memset(value, 0x5a, sizeof(value));
+	for (offset = 0; offset <= LOG_SIZE; offset += record_size(3, sizeof(value))) {
+		struct region_device record;
+
+		assert_int_equal(0, rdev_chain(&record, &flash_rdev, offset,
+					       record_size(3, sizeof(value))));
+		assert_int_equal(0, write_record(&record, "Old", 3, value, sizeof(value)));
+	}
+
+	/* Its records are kept, and appends go behind them. */
+	reboot();
+	assert_int_equal(-1, smmstore_lookup_data("Old", 3, buf, &size));
+	append("New", "1", 1);
+	assert_int_equal(0, erased_bytes);
+	assert_int_equal(3, flash[offset]);
+	assert_memory_equal("New", &flash[offset + RECORD_HDR_SZ], 3);
+
+	assert_int_equal(0, smmstore_clear_region());
+	append("New", "2", 1);
+	assert_value("New", "2", 1);
+}
+
+static void test_clear(void **state)
+{
+	uint8_t buf[4];
+	size_t size = sizeof(buf);
+
+	append("A", "1", 1);
+	assert_int_equal(0, smmstore_clear_region());
+	assert_int_equal(-1, smmstore_lookup_data("A", 1, buf, &size));
+	assert_int_equal(0, idx.keys);
+	append("A", "2", 1);
+	assert_value("A", "2", 1);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test_setup(test_append_lookup, setup_store),
+		cmocka_unit_test_setup(test_rebuild, setup_store),
+		cmocka_unit_test_setup(test_compaction, setup_store),
+		cmocka_unit_test_setup(test_interrupted_compaction, setup_store),
+		cmocka_unit_test_setup(test_torn_header, setup_store),
+		cmocka_unit_test_setup(test_index_full, setup_store),
+		cmocka_unit_test_setup(test_unindexed_store, setup_store),
+		cmocka_unit_test_setup(test_clear, setup_store),
+	};
+
+	return cb_run_group_tests(tests, NULL, NULL);
+}
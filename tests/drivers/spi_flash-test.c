@@ -0,0 +1,183 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <spi_flash.h>
+#include <string.h>
+#include <stubs/spi_flash_emu.h>
+#include <tests/test.h>
+#include <timer.h>
+#include <types.h>
+
+#define W25Q80_SIZE		(1 * MiB)
+#define MX25L1635E_SIZE		(2 * MiB)
+
+static uint8_t flash_data[MX25L1635E_SIZE];
+static uint8_t buf[64 * KiB];
+
+static struct spi_flash_emu emu;
+
+/* Stubs for the parts of spi_flash.c and winbond.c the tests don't exercise. */
+const struct spi_flash *boot_device_spi_flash(void)
+{
+	return NULL;
+}
+
+struct lb_record *lb_new_record(struct lb_header *header)
+{
+	return NULL;
+}
+
+/* A clock that advances by 10us each time it's read, so status polling can time out. */
+static uint64_t now_us;
+
+void timer_monotonic_get(struct mono_time *mt)
+{
+	mono_time_set_usecs(mt, now_us);
+	now_us += 10;
+}
+
+void udelay(unsigned int usecs)
+{
+	now_us += usecs;
+}
+
+static void setup_emu(const uint8_t idcode[3], size_t size, enum spi_flash_emu_qe qe)
+{
+	memset(&emu, 0, sizeof(emu));
+	memcpy(emu.idcode, idcode, 3);
+	emu.data = flash_data;
+	emu.size = size;
+	emu.qe = qe;
+
+	for (size_t i = 0; i < size; i++)
+		flash_data[i] = (i * 7) ^ (i >> 9);
+
+	spi_flash_emu_attach(&emu);
+}
+
+static int setup_winbond(void **state)
+{
+	const uint8_t w25q80[] = { 0xef, 0x40, 0x14 };
+
+	setup_emu(w25q80, W25Q80_SIZE, SPI_FLASH_EMU_QE_SR2_BIT1);
+	return 0;
+}
+
+static int setup_macronix(void **state)
+{
+	const uint8_t mx25l1635e[] = { 0xc2, 0x25, 0x15 };
+
+	setup_emu(mx25l1635e, MX25L1635E_SIZE, SPI_FLASH_EMU_QE_SR1_BIT6);
+	return 0;
+}
+
+static uint64_t read_clocks(unsigned int bus, u32 offset, size_t len)
+{
+	struct spi_flash flash;
+	uint64_t start;
+
+	assert_int_equal(0, spi_flash_probe(bus, 0, &flash));
+
+	start = emu.clocks;
+	assert_int_equal(0, spi_flash_read(&flash, offset, len, buf));
+	assert_memory_equal(buf, &flash_data[offset], len);
+	assert_int_equal(0, emu.protocol_errors);
+
+	return emu.clocks - start;
+}
+
+static void test_probe_modes(void **state)
+{
+	struct spi_flash flash;
+
+	assert_int_equal(0, spi_flash_probe(SPI_FLASH_EMU_BUS_SINGLE, 0, &flash));
+	assert_int_equal(W25Q80_SIZE, flash.size);
+	assert_false(spi_flash_emu_quad_enabled(&emu));
+
+	assert_int_equal(0, spi_flash_probe(SPI_FLASH_EMU_BUS_QUAD, 0, &flash));
+	assert_true(flash.flags.quad_io);
+	assert_true(flash.flags.quad_output);
+	assert_true(spi_flash_emu_quad_enabled(&emu));
+	/* Winbond parts get the volatile Quad Enable bit, which doesn't wear the flash. */
+	assert_int_equal(0, emu.status_writes);
+}
+
+static void test_read_modes(void **state)
+{
+	const uint64_t single = read_clocks(SPI_FLASH_EMU_BUS_SINGLE, 0x1234, sizeof(buf));
+	const uint64_t dual = read_clocks(SPI_FLASH_EMU_BUS_DUAL, 0x1234, sizeof(buf));
+	const uint64_t quad = read_clocks(SPI_FLASH_EMU_BUS_QUAD, 0x1234, sizeof(buf));
+
+	/* The data phase dominates, so each doubling of lanes nearly halves the clocks. */
+	assert_true(dual * 2 < single + 64);
+	assert_true(quad * 2 < dual + 64);
+
+	print_message("64 KiB read: %llu clocks single, %llu dual I/O, %llu quad I/O\n",
+		      (unsigned long long)single, (unsigned long long)dual,
+		      (unsigned long long)quad);
+}
+
+static void test_quad_enable_non_volatile(void **state)
+{
+	struct spi_flash flash;
+
+	assert_int_equal(0, spi_flash_probe(SPI_FLASH_EMU_BUS_QUAD, 0, &flash));
+	assert_true(flash.flags.quad_io);
+	assert_true(spi_flash_emu_quad_enabled(&emu));
+	assert_int_equal(1, emu.status_writes);
+
+	/* The bit is only written when it isn't set yet. */
+	assert_int_equal(0, spi_flash_probe(SPI_FLASH_EMU_BUS_QUAD, 0, &flash));
+	assert_int_equal(1, emu.status_writes);
+
+	read_clocks(SPI_FLASH_EMU_BUS_QUAD, MX25L1635E_SIZE - sizeof(buf), sizeof(buf));
+}
+
+static void test_quad_enable_locked(void **state)
+{
+	struct spi_flash flash;
+
+	emu.status_locked = true;
+
+	assert_int_equal(0, spi_flash_probe(SPI_FLASH_EMU_BUS_QUAD, 0, &flash));
+	assert_false(flash.flags.quad_io);
+	assert_false(flash.flags.quad_output);
+	assert_false(spi_flash_emu_quad_enabled(&emu));
+
+	/* Falls back to dual I/O, which needs no status register setup. */
+	read_clocks(SPI_FLASH_EMU_BUS_QUAD, 0x10000, 0x1000);
+}
+
+static void test_erase_program(void **state)
+{
+	struct spi_flash flash;
+	uint8_t data[600];
+
+	for (size_t i = 0; i < sizeof(data); i++)
+		data[i] = i * 3;
+
+	assert_int_equal(0, spi_flash_probe(SPI_FLASH_EMU_BUS_QUAD, 0, &flash));
+	assert_int_equal(0, spi_flash_erase(&flash, 0x3000, 0x1000));
+	for (size_t i = 0x3000; i < 0x4000; i++)
+		assert_int_equal(0xff, flash_data[i]);
+
+	/* Crosses page boundaries on both ends. */
+	assert_int_equal(0, spi_flash_write(&flash, 0x3080, sizeof(data), data));
+	assert_int_equal(0, spi_flash_read(&flash, 0x3080, sizeof(data), buf));
+	assert_memory_equal(buf, data, sizeof(data));
+	assert_int_equal(0xff, flash_data[0x307f]);
+	assert_int_equal(0xff, flash_data[0x3080 + sizeof(data)]);
+	assert_int_equal(0, emu.protocol_errors);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test_setup(test_probe_modes, setup_winbond),
+		cmocka_unit_test_setup(test_read_modes, setup_winbond),
+		cmocka_unit_test_setup(test_quad_enable_non_volatile, setup_macronix),
+		cmocka_unit_test_setup(test_quad_enable_locked, setup_winbond),
+		cmocka_unit_test_setup(test_erase_program, setup_winbond),
+	};
+
+	return cb_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,143 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <commonlib/helpers.h>
+#include <spi_flash.h>
+#include <string.h>
+#include <tests/test.h>
+#include <types.h>
+
+#define FLASH_SIZE (64 * KiB)
+#define LINE_SIZE (4 * KiB)
+
+static uint8_t flash_data[FLASH_SIZE];
+static int flash_reads;
+
+static struct spi_flash flash = {
+	.spi = { .bus = CONFIG_BOOT_DEVICE_SPI_FLASH_BUS, .cs = 0 },
+	.size = FLASH_SIZE,
+};
+
+int spi_flash_read(const struct spi_flash *f, u32 offset, size_t len, void *buf)
+{
+	if (offset + len > f->size)
+		return -1;
+
+	flash_reads++;
+	memcpy(buf, &flash_data[offset], len);
+	return 0;
+}
+
+static int setup_flash(void **state)
+{
+	uint8_t byte;
+
+	for (size_t i = 0; i < sizeof(flash_data); i++)
+		flash_data[i] = i ^ (i >> 8);
+
+	/* Start every test with a cold cache and no sequential stream in progress. */
+	spi_flash_cached_read(&flash, FLASH_SIZE - LINE_SIZE, 1, &byte);
+	spi_flash_cache_invalidate(0, FLASH_SIZE);
+	flash_reads = 0;
+
+	return 0;
+}
+
+static void cached_read(u32 offset, size_t len)
+{
+	uint8_t buf[4 * KiB];
+
+	assert_true(len <= sizeof(buf));
+	assert_int_equal(0, spi_flash_cached_read(&flash, offset, len, buf));
+	assert_memory_equal(buf, &flash_data[offset], len);
+}
+
+static void test_small_reads_hit_cache(void **state)
+{
+	cached_read(0x2010, 0x20);
+	assert_int_equal(1, flash_reads);
+
+	cached_read(0x2040, 0x100);
+	cached_read(0x2ff0, 0x10);
+	assert_int_equal(1, flash_reads);
+}
+
+static void test_read_across_lines(void **state)
+{
+	int reads;
+
+	/* Both lines miss, the second one sequentially, so it may read ahead too. */
+	cached_read(0x8ff0, 0x20);
+	reads = flash_reads;
+	assert_in_range(reads, 2, 2 + MIN(CONFIG_SPI_FLASH_READ_CACHE_READAHEAD, 1));
+
+	cached_read(0x8ff8, 0x10);
+	assert_int_equal(reads, flash_reads);
+}
+
+static void test_sequential_readahead(void **state)
+{
+	/* The second consecutive miss opens the readahead window. */
+	cached_read(0x4000, 0x40);
+	cached_read(0x5000, 0x40);
+	assert_int_equal(3, flash_reads);
+
+	/* 0x6000 was read ahead, 0x7000 misses again and reads further ahead. */
+	cached_read(0x6000, 0x40);
+	assert_int_equal(3, flash_reads);
+	cached_read(0x7000, 0x40);
+	assert_int_equal(3 + 1 + MIN(CONFIG_SPI_FLASH_READ_CACHE_READAHEAD, 2), flash_reads);
+}
+
+static void test_large_reads_bypass_cache(void **state)
+{
+	cached_read(0x1000, 4 * KiB);
+	cached_read(0x1000, 4 * KiB);
+	assert_int_equal(2, flash_reads);
+}
+
+static void test_invalidate(void **state)
+{
+	cached_read(0xa000, 0x10);
+	spi_flash_cache_invalidate(0xa800, 1);
+	flash_data[0xa000] ^= 0xff;
+	cached_read(0xa000, 0x10);
+	assert_int_equal(2, flash_reads);
+
+	/* Invalidating a neighbouring line must not drop this one. */
+	spi_flash_cache_invalidate(0xb000, 0x1000);
+	cached_read(0xa000, 0x10);
+	assert_int_equal(2, flash_reads);
+}
+
+static void test_other_flash_not_cached(void **state)
+{
+	struct spi_flash other = flash;
+	uint8_t buf[0x10];
+
+	other.spi.cs = 1;
+	assert_int_equal(0, spi_flash_cached_read(&other, 0x3000, sizeof(buf), buf));
+	assert_int_equal(0, spi_flash_cached_read(&other, 0x3000, sizeof(buf), buf));
+	assert_int_equal(2, flash_reads);
+}
+
+static void test_read_past_end(void **state)
+{
+	uint8_t buf[0x10];
+
+	assert_int_equal(-1, spi_flash_cached_read(&flash, FLASH_SIZE - 8, sizeof(buf), buf));
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test_setup(test_small_reads_hit_cache, setup_flash),
+		cmocka_unit_test_setup(test_read_across_lines, setup_flash),
+		cmocka_unit_test_setup(test_sequential_readahead, setup_flash),
+		cmocka_unit_test_setup(test_large_reads_bypass_cache, setup_flash),
+		cmocka_unit_test_setup(test_invalidate, setup_flash),
+		cmocka_unit_test_setup(test_other_flash_not_cached, setup_flash),
+		cmocka_unit_test_setup(test_read_past_end, setup_flash),
+	};
+
+	return cb_run_group_tests(tests, NULL, NULL);
+}
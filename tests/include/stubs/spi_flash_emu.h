@@ -0,0 +1,52 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#ifndef TESTS_STUBS_SPI_FLASH_EMU_H
+#define TESTS_STUBS_SPI_FLASH_EMU_H
+
+#include <types.h>
+
+/*
+ * Software model of a SPI NOR flash with 3-byte addressing. It decodes the
+ * commands coreboot's generic SPI flash driver sends and stores the array in
+ * a caller-provided buffer (e.g. the contents of a ROM image).
+ *
+ * The model is wired up as the controller for three buses, which differ in
+ * the transfer modes they offer:
+ */
+#define SPI_FLASH_EMU_BUS_QUAD		0	/* .xfer, .xfer_dual and .xfer_quad */
+#define SPI_FLASH_EMU_BUS_DUAL		1	/* .xfer and .xfer_dual */
+#define SPI_FLASH_EMU_BUS_SINGLE	2	/* .xfer only */
+
+enum spi_flash_emu_qe {
+	SPI_FLASH_EMU_QE_SR2_BIT1,	/* Winbond, GigaDevice */
+	SPI_FLASH_EMU_QE_SR1_BIT6,	/* Macronix, ISSI */
+};
+
+struct spi_flash_emu {
+	/* Configuration, set up by the test. */
+	uint8_t idcode[5];
+	uint8_t *data;
+	size_t size;
+	enum spi_flash_emu_qe qe;
+	bool status_locked;		/* Status register writes are ignored. */
+
+	/* Device state. */
+	uint8_t sr1;
+	uint8_t sr2;
+	bool wel;
+	bool volatile_wel;
+
+	/* Statistics. */
+	uint64_t clocks;		/* SPI clock cycles spent on the bus */
+	uint32_t commands;
+	uint32_t status_writes;		/* Non-volatile status register writes */
+	uint32_t protocol_errors;
+};
+
+/* Make emu the device behind all emulated buses and reset its state. */
+void spi_flash_emu_attach(struct spi_flash_emu *emu);
+
+/* Whether the Quad Enable bit is currently set. */
+bool spi_flash_emu_quad_enabled(const struct spi_flash_emu *emu);
+
+#endif /* TESTS_STUBS_SPI_FLASH_EMU_H */
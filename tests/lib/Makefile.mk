@@ -39,6 +39,9 @@ tests-y += cbfs-lookup-no-mcache-test
 tests-y += cbfs-lookup-has-mcache-test
 tests-y += lzma-test
 tests-y += ux_locales-test
+tests-y += rdev_async-test
+tests-y += rdev_update-test
+tests-y += async_task-test
 
 lib-test-srcs += tests/lib/lib-test.c
 
@@ -153,9 +156,11 @@ rtc-test-srcs += src/lib/rtc.c
 spd_cache-ddr3-test-srcs += tests/lib/spd_cache-test.c
 spd_cache-ddr3-test-srcs += tests/stubs/console.c
 spd_cache-ddr3-test-srcs += src/lib/spd_cache.c
+spd_cache-ddr3-test-srcs += src/lib/rdev_update.c
 spd_cache-ddr3-test-srcs += src/lib/crc_byte.c
 spd_cache-ddr3-test-srcs += src/commonlib/region.c
 spd_cache-ddr3-test-mocks += fmap_locate_area_as_rdev
+spd_cache-ddr3-test-mocks += fmap_locate_area_as_rdev_rw
 spd_cache-ddr3-test-config += CONFIG_SPD_CACHE_FMAP_NAME=\"RW_SPD_CACHE\" \
 				CONFIG_DIMM_MAX=4 CONFIG_DIMM_SPD_SIZE=256 \
 				CONFIG_BOOT_DEVICE_MEMORY_MAPPED=1
@@ -164,9 +169,11 @@ spd_cache-ddr3-test-cflags += -D__TEST_SPD_CACHE_DDR=3
 spd_cache-ddr4-test-srcs += tests/lib/spd_cache-test.c
 spd_cache-ddr4-test-srcs += tests/stubs/console.c
 spd_cache-ddr4-test-srcs += src/lib/spd_cache.c
+spd_cache-ddr4-test-srcs += src/lib/rdev_update.c
 spd_cache-ddr4-test-srcs += src/lib/crc_byte.c
 spd_cache-ddr4-test-srcs += src/commonlib/region.c
 spd_cache-ddr4-test-mocks += fmap_locate_area_as_rdev
+spd_cache-ddr4-test-mocks += fmap_locate_area_as_rdev_rw
 spd_cache-ddr4-test-config += CONFIG_SPD_CACHE_FMAP_NAME=\"RW_SPD_CACHE\" \
 				CONFIG_DIMM_MAX=4 CONFIG_DIMM_SPD_SIZE=512 \
 				CONFIG_BOOT_DEVICE_MEMORY_MAPPED=1
@@ -243,3 +250,22 @@ ux_locales-test-mocks += _cbfs_alloc \
 			vb2api_get_locale_id \
 			vboot_get_context
 ux_locales-test-config += CONFIG_VBOOT=1
+
+rdev_async-test-srcs += tests/lib/rdev_async-test.c
+rdev_async-test-srcs += tests/stubs/console.c
+rdev_async-test-srcs += tests/stubs/die.c
+rdev_async-test-srcs += src/lib/rdev_async.c
+rdev_async-test-srcs += src/commonlib/region.c
+
+rdev_update-test-srcs += tests/lib/rdev_update-test.c
+rdev_update-test-srcs += tests/stubs/console.c
+rdev_update-test-srcs += src/lib/rdev_update.c
+rdev_update-test-srcs += src/commonlib/region.c
+
+async_task-test-srcs += tests/lib/async_task-test.c
+async_task-test-srcs += tests/stubs/console.c
+async_task-test-srcs += tests/stubs/die.c
+async_task-test-srcs += src/lib/async_task.c
+async_task-test-srcs += src/lib/rdev_async.c
+async_task-test-srcs += src/commonlib/region.c
+async_task-test-config += CONFIG_ASYNC_TASKS=1
@@ -0,0 +1,198 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <async_task.h>
+#include <commonlib/region.h>
+#include <rdev_async.h>
+#include <string.h>
+#include <tests/test.h>
+#include <timer.h>
+
+/* A clock that advances by 10us each time it's read. */
+static uint64_t now_us;
+
+void timer_monotonic_get(struct mono_time *mt)
+{
+	mono_time_set_usecs(mt, now_us);
+	now_us += 10;
+}
+
+/* A polled "controller" which completes the oldest queued read per async_poll() call. */
+static uint8_t backing[0x100];
+static struct rdev_async_read *poll_queue;
+static int polls;
+
+static ssize_t polled_readat(const struct region_device *rd, void *b, size_t offset,
+			     size_t size)
+{
+	memcpy(b, &backing[offset], size);
+	return size;
+}
+
+static int polled_readat_async(const struct region_device *rd, struct rdev_async_read *req)
+{
+	struct rdev_async_read **link = &poll_queue;
+
+	while (*link)
+		link = &(*link)->next;
+	*link = req;
+
+	return 0;
+}
+
+static void polled_async_poll(const struct region_device *rd)
+{
+	struct rdev_async_read *req = poll_queue;
+
+	polls++;
+	if (!req)
+		return;
+
+	poll_queue = req->next;
+	memcpy(req->buffer, &backing[req->offset], req->size);
+	rdev_async_complete(req, req->size);
+}
+
+static const struct region_device_ops polled_ops = {
+	.readat = polled_readat,
+	.readat_async = polled_readat_async,
+	.async_poll = polled_async_poll,
+};
+
+static const struct region_device polled_rdev = REGION_DEV_INIT(&polled_ops, 0,
+								 sizeof(backing));
+
+static int setup_tasks(void **state)
+{
+	for (size_t i = 0; i < sizeof(backing); i++)
+		backing[i] = i ^ 0x5a;
+	poll_queue = NULL;
+	polls = 0;
+	now_us = 0;
+
+	return 0;
+}
+
+struct sleep_op {
+	struct async_task task;
+	int count;
+	uint64_t woken_us[3];
+};
+
+static enum async_status sleep_step(struct async_task *task)
+{
+	struct sleep_op *op = container_of(task, struct sleep_op, task);
+
+	ASYNC_BEGIN(task);
+	for (op->count = 0; op->count < 3; op->count++) {
+		ASYNC_SLEEP_US(task, 1000);
+		op->woken_us[op->count] = now_us;
+	}
+	ASYNC_END(task);
+}
+
+static void test_async_task_sleep(void **state)
+{
+	struct sleep_op op;
+
+	async_task_start(&op.task, sleep_step);
+	assert_false(op.task.done);
+
+	async_task_wait(&op.task);
+	assert_true(op.task.done);
+	assert_int_equal(3, op.count);
+	assert_true(op.woken_us[0] >= 1000);
+	assert_true(op.woken_us[1] >= op.woken_us[0] + 1000);
+	assert_true(op.woken_us[2] >= op.woken_us[1] + 1000);
+	assert_false(async_tasks_run());
+}
+
+struct read_op {
+	struct async_task task;
+	struct rdev_async_read req;
+	size_t offset;
+	uint8_t buf[16];
+	ssize_t result;
+};
+
+static enum async_status read_step(struct async_task *task)
+{
+	struct read_op *op = container_of(task, struct read_op, task);
+
+	ASYNC_BEGIN(task);
+	if (rdev_readat_async(&polled_rdev, &op->req, op->buf, op->offset, sizeof(op->buf),
+			      NULL, NULL) < 0) {
+		op->result = -1;
+		return ASYNC_DONE;
+	}
+	ASYNC_WAIT_READ(task, &op->req);
+	op->result = op->req.result;
+	ASYNC_END(task);
+}
+
+/* Hundreds of reads in flight, each costing only its frame. */
+static void test_async_task_reads(void **state)
+{
+	static struct read_op ops[200];
+	size_t i;
+
+	for (i = 0; i < ARRAY_SIZE(ops); i++) {
+		ops[i].offset = i % (sizeof(backing) - sizeof(ops[i].buf));
+		async_task_start(&ops[i].task, read_step);
+	}
+
+	/* The first run queues all reads, nothing can complete before the controller polls. */
+	assert_true(async_tasks_run());
+	assert_int_equal(0, polls);
+	for (i = 0; i < ARRAY_SIZE(ops); i++)
+		assert_false(ops[i].task.done);
+
+	async_tasks_wait_all();
+	for (i = 0; i < ARRAY_SIZE(ops); i++) {
+		assert_true(ops[i].task.done);
+		assert_int_equal(sizeof(ops[i].buf), ops[i].result);
+		assert_memory_equal(&backing[ops[i].offset], ops[i].buf, sizeof(ops[i].buf));
+	}
+}
+
+static int yields;
+
+static enum async_status yield_step(struct async_task *task)
+{
+	ASYNC_BEGIN(task);
+	yields++;
+	ASYNC_YIELD(task);
+	yields++;
+	/* Returning pending without a wait is the same as a yield. */
+	task->resume = 0;
+	return yields < 4 ? ASYNC_PENDING : ASYNC_DONE;
+	ASYNC_END(task);
+}
+
+static void test_async_task_yield(void **state)
+{
+	struct async_task task;
+
+	yields = 0;
+	async_task_start(&task, yield_step);
+
+	/* Each run only calls a step function once. */
+	assert_true(async_tasks_run());
+	assert_int_equal(1, yields);
+	assert_true(async_tasks_run());
+	assert_int_equal(2, yields);
+
+	async_task_wait(&task);
+	assert_int_equal(4, yields);
+	assert_false(async_tasks_run());
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test_setup(test_async_task_sleep, setup_tasks),
+		cmocka_unit_test_setup(test_async_task_reads, setup_tasks),
+		cmocka_unit_test_setup(test_async_task_yield, setup_tasks),
+	};
+
+	return cb_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,172 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <commonlib/region.h>
+#include <rdev_async.h>
+#include <string.h>
+#include <tests/test.h>
+#include <types.h>
+
+#define BACKING_SIZE	0x1000
+#define POLL_CHUNK	0x40
+
+static uint8_t backing[BACKING_SIZE];
+static uint8_t buf[2][BACKING_SIZE];
+
+static int done_calls;
+
+static void count_done(struct rdev_async_read *req)
+{
+	done_calls++;
+	assert_ptr_equal(&done_calls, req->arg);
+}
+
+static int setup_backing(void **state)
+{
+	for (size_t i = 0; i < sizeof(backing); i++)
+		backing[i] = i * 13 + (i >> 8);
+	memset(buf, 0, sizeof(buf));
+	done_calls = 0;
+
+	return 0;
+}
+
+/*
+ * A polled "controller" which moves POLL_CHUNK bytes of the oldest queued read per
+ * async_poll() call, to check that requests complete in order and only through polling.
+ */
+static struct rdev_async_read *poll_queue;
+static int refuse_async;
+static int sync_reads;
+
+static ssize_t polled_readat(const struct region_device *rd, void *b, size_t offset,
+			     size_t size)
+{
+	sync_reads++;
+	memcpy(b, &backing[offset], size);
+	return size;
+}
+
+static int polled_readat_async(const struct region_device *rd, struct rdev_async_read *req)
+{
+	struct rdev_async_read **link = &poll_queue;
+
+	if (refuse_async)
+		return -1;
+
+	while (*link)
+		link = &(*link)->next;
+	*link = req;
+	req->priv = (void *)0;
+
+	return 0;
+}
+
+static void polled_async_poll(const struct region_device *rd)
+{
+	struct rdev_async_read *req = poll_queue;
+	size_t done, chunk;
+
+	if (!req)
+		return;
+
+	done = (uintptr_t)req->priv;
+	chunk = MIN(POLL_CHUNK, req->size - done);
+	memcpy((uint8_t *)req->buffer + done, &backing[req->offset + done], chunk);
+	done += chunk;
+	req->priv = (void *)done;
+
+	if (done == req->size) {
+		poll_queue = req->next;
+		rdev_async_complete(req, req->size);
+	}
+}
+
+static const struct region_device_ops polled_ops = {
+	.readat = polled_readat,
+	.readat_async = polled_readat_async,
+	.async_poll = polled_async_poll,
+};
+
+static const struct region_device polled_rdev = REGION_DEV_INIT(&polled_ops, 0, BACKING_SIZE);
+
+static void test_fallback_mem(void **state)
+{
+	const struct mem_region_device mdev = MEM_REGION_DEV_RO_INIT(backing, sizeof(backing));
+	struct region_device child;
+	struct rdev_async_read req;
+
+	assert_int_equal(0, rdev_chain(&child, &mdev.rdev, 0x100, 0x800));
+	assert_int_equal(0, rdev_readat_async(&child, &req, buf[0], 0x10, 0x200, count_done,
+					      &done_calls));
+
+	/* Without threads, the fallback reads synchronously. */
+	assert_true(rdev_async_poll(&req));
+	assert_int_equal(1, done_calls);
+	assert_int_equal(0x200, rdev_async_wait(&req));
+	assert_memory_equal(buf[0], &backing[0x110], 0x200);
+}
+
+static void test_out_of_range(void **state)
+{
+	const struct mem_region_device mdev = MEM_REGION_DEV_RO_INIT(backing, sizeof(backing));
+	struct region_device child;
+	struct rdev_async_read req;
+
+	assert_int_equal(0, rdev_chain(&child, &mdev.rdev, 0x100, 0x800));
+	assert_int_not_equal(0, rdev_readat_async(&child, &req, buf[0], 0x700, 0x200,
+						  count_done, &done_calls));
+	assert_int_not_equal(0, rdev_readat_async(&child, &req, buf[0], SIZE_MAX, 2,
+						  count_done, &done_calls));
+	assert_int_equal(0, done_calls);
+}
+
+static void test_native_polled(void **state)
+{
+	struct rdev_async_read req[2];
+
+	refuse_async = 0;
+	sync_reads = 0;
+
+	assert_int_equal(0, rdev_readat_async(&polled_rdev, &req[0], buf[0], 0, 0x100,
+					      count_done, &done_calls));
+	assert_int_equal(0, rdev_readat_async(&polled_rdev, &req[1], buf[1], 0x300, 0x180,
+					      count_done, &done_calls));
+	assert_false(req[0].complete);
+	assert_false(req[1].complete);
+
+	/* Waiting on the second read drives the first one to completion too. */
+	assert_int_equal(0x180, rdev_async_wait(&req[1]));
+	assert_true(req[0].complete);
+	assert_int_equal(2, done_calls);
+	assert_int_equal(0x100, rdev_async_wait(&req[0]));
+	assert_memory_equal(buf[0], &backing[0], 0x100);
+	assert_memory_equal(buf[1], &backing[0x300], 0x180);
+	assert_int_equal(0, sync_reads);
+}
+
+static void test_native_refused(void **state)
+{
+	struct rdev_async_read req;
+
+	refuse_async = 1;
+	sync_reads = 0;
+
+	assert_int_equal(0, rdev_readat_async(&polled_rdev, &req, buf[0], 0x20, 0x40,
+					      count_done, &done_calls));
+	assert_int_equal(0x40, rdev_async_wait(&req));
+	assert_int_equal(1, sync_reads);
+	assert_int_equal(1, done_calls);
+	assert_memory_equal(buf[0], &backing[0x20], 0x40);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test_setup(test_fallback_mem, setup_backing),
+		cmocka_unit_test_setup(test_out_of_range, setup_backing),
+		cmocka_unit_test_setup(test_native_polled, setup_backing),
+		cmocka_unit_test_setup(test_native_refused, setup_backing),
+	};
+
+	return cb_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,160 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <commonlib/region.h>
+#include <rdev_update.h>
+#include <string.h>
+#include <tests/test.h>
+
+#define SECTOR		RDEV_UPDATE_SECTOR_SIZE
+#define PAGE		RDEV_UPDATE_PAGE_SIZE
+#define FLASH_SIZE	(3 * SECTOR)
+
+static uint8_t flash[FLASH_SIZE];
+static uint8_t data[FLASH_SIZE];
+static int erase_calls;
+static int write_calls;
+static size_t programmed;
+
+static ssize_t flash_readat(const struct region_device *rd, void *b, size_t offset,
+			    size_t size)
+{
+	memcpy(b, &flash[offset], size);
+	return size;
+}
+
+/* Like NOR flash, programming can only clear bits. */
+static ssize_t flash_writeat(const struct region_device *rd, const void *b, size_t offset,
+			     size_t size)
+{
+	const uint8_t *p = b;
+
+	for (size_t i = 0; i < size; i++)
+		flash[offset + i] &= p[i];
+	write_calls++;
+	programmed += size;
+	return size;
+}
+
+static ssize_t flash_eraseat(const struct region_device *rd, size_t offset, size_t size)
+{
+	assert_int_equal(0, offset % SECTOR);
+	memset(&flash[offset], 0xff, size);
+	erase_calls++;
+	return size;
+}
+
+static const struct region_device_ops flash_ops = {
+	.readat = flash_readat,
+	.writeat = flash_writeat,
+	.eraseat = flash_eraseat,
+};
+
+static const struct region_device flash_rdev = REGION_DEV_INIT(&flash_ops, 0, FLASH_SIZE);
+
+static void reset_counts(void)
+{
+	erase_calls = 0;
+	write_calls = 0;
+	programmed = 0;
+}
+
+static int setup_flash(void **state)
+{
+	memset(flash, 0xff, sizeof(flash));
+	for (size_t i = 0; i < sizeof(data); i++)
+		data[i] = i * 7 + (i >> 9);
+	reset_counts();
+
+	return 0;
+}
+
+static void assert_flash(size_t size)
+{
+	assert_memory_equal(data, flash, size);
+	for (size_t i = size; i < FLASH_SIZE; i++)
+		assert_int_equal(0xff, flash[i]);
+}
+
+static void test_erased(void **state)
+{
+	/* Nothing to erase, all data is programmed in one write per sector. */
+	assert_int_equal(CB_SUCCESS, rdev_update(&flash_rdev, data, 2 * SECTOR + 100));
+	assert_flash(2 * SECTOR + 100);
+	assert_int_equal(0, erase_calls);
+	assert_int_equal(3, write_calls);
+	assert_int_equal(2 * SECTOR + 100, programmed);
+}
+
+static void test_identical(void **state)
+{
+	assert_int_equal(CB_SUCCESS, rdev_update(&flash_rdev, data, FLASH_SIZE));
+	reset_counts();
+
+	assert_int_equal(CB_SUCCESS, rdev_update(&flash_rdev, data, FLASH_SIZE));
+	assert_flash(FLASH_SIZE);
+	assert_int_equal(0, erase_calls);
+	assert_int_equal(0, write_calls);
+}
+
+static void test_clear_bits(void **state)
+{
+	assert_int_equal(CB_SUCCESS, rdev_update(&flash_rdev, data, FLASH_SIZE));
+	reset_counts();
+
+	/* Only 1->0 changes in two adjacent pages and one other page: no erase. */
+	data[SECTOR + 2 * PAGE + 3] &= 0x0f;
+	data[SECTOR + 3 * PAGE + 9] = 0;
+	data[SECTOR + 7 * PAGE] = 0;
+	assert_int_equal(CB_SUCCESS, rdev_update(&flash_rdev, data, FLASH_SIZE));
+	assert_flash(FLASH_SIZE);
+	assert_int_equal(0, erase_calls);
+	assert_int_equal(2, write_calls);
+	assert_int_equal(3 * PAGE, programmed);
+}
+
+static void test_set_bits(void **state)
+{
+	assert_int_equal(CB_SUCCESS, rdev_update(&flash_rdev, data, FLASH_SIZE));
+	reset_counts();
+
+	/* A 0->1 change needs an erase, but only of its own sector. */
+	data[SECTOR + 5] = ~data[SECTOR + 5];
+	assert_int_equal(CB_SUCCESS, rdev_update(&flash_rdev, data, FLASH_SIZE));
+	assert_flash(FLASH_SIZE);
+	assert_int_equal(1, erase_calls);
+	assert_int_equal(1, write_calls);
+	assert_int_equal(SECTOR, programmed);
+}
+
+static void test_shrink(void **state)
+{
+	assert_int_equal(CB_SUCCESS, rdev_update(&flash_rdev, data, FLASH_SIZE));
+	reset_counts();
+
+	/* Bytes past the new data end up erased, untouched sectors stay as they are. */
+	assert_int_equal(CB_SUCCESS, rdev_update(&flash_rdev, data, SECTOR + PAGE + 1));
+	assert_flash(SECTOR + PAGE + 1);
+	assert_int_equal(2, erase_calls);
+	assert_int_equal(1, write_calls);
+	assert_int_equal(PAGE + 1, programmed);
+}
+
+static void test_too_large(void **state)
+{
+	assert_int_equal(CB_ERR, rdev_update(&flash_rdev, data, FLASH_SIZE + 1));
+	assert_int_equal(0, write_calls);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test_setup(test_erased, setup_flash),
+		cmocka_unit_test_setup(test_identical, setup_flash),
+		cmocka_unit_test_setup(test_clear_bits, setup_flash),
+		cmocka_unit_test_setup(test_set_bits, setup_flash),
+		cmocka_unit_test_setup(test_shrink, setup_flash),
+		cmocka_unit_test_setup(test_too_large, setup_flash),
+	};
+
+	return cb_run_group_tests(tests, NULL, NULL);
+}
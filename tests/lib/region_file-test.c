@@ -8,9 +8,38 @@
 #include <commonlib/region.h>
 #include <tests/lib/region_file_data.h>
 
+/* A single CBMEM entry is all region_file.c asks for. */
+static uint8_t cbmem_buffer[sizeof(local_hints)];
+static bool cbmem_entry_added;
+
+void *cbmem_find(u32 id)
+{
+	assert_int_equal(CBMEM_ID_REGF_HINTS, id);
+	return cbmem_entry_added ? cbmem_buffer : NULL;
+}
+
+void *cbmem_add(u32 id, u64 size)
+{
+	assert_int_equal(CBMEM_ID_REGF_HINTS, id);
+	assert_int_equal(sizeof(cbmem_buffer), size);
+	memset(cbmem_buffer, 0xa5, sizeof(cbmem_buffer));
+	cbmem_entry_added = true;
+	return cbmem_buffer;
+}
+
+/* Start a new boot with no hints. */
+static void reset_hints(void)
+{
+	for (size_t i = 0; i < REGF_MAX_HINTS; i++)
+		local_hints[i].slot = -1;
+	regf_hints = local_hints;
+	cbmem_entry_added = false;
+}
+
 static void clear_region_file(struct region_device *rdev)
 {
 	memset(rdev_mmap_full(rdev), 0xff, REGION_FILE_BUFFER_SIZE);
+	reset_hints();
 }
 
 static int setup_region_file_test_group(void **state)
@@ -289,6 +318,153 @@ static void test_region_file_update_data_arr(void **state)
 	assert_memory_equal(&dummy_data[data3_offset], &output_buffer[data2_size], data3_size);
 }
 
+/* Region device counting the reads, to compare the cost of finding the latest update. */
+#define COUNTED_BUFFER_SIZE (64 * KiB)
+
+static uint8_t counted_buffer[COUNTED_BUFFER_SIZE];
+static size_t counted_reads;
+
+static ssize_t counted_readat(const struct region_device *rd, void *b, size_t offset,
+			      size_t size)
+{
+	counted_reads++;
+	memcpy(b, &counted_buffer[offset], size);
+	return size;
+}
+
+static ssize_t counted_writeat(const struct region_device *rd, const void *b, size_t offset,
+			       size_t size)
+{
+	memcpy(&counted_buffer[offset], b, size);
+	return size;
+}
+
+static ssize_t counted_eraseat(const struct region_device *rd, size_t offset, size_t size)
+{
+	memset(&counted_buffer[offset], 0xff, size);
+	return size;
+}
+
+static const struct region_device_ops counted_ops = {
+	.readat = counted_readat,
+	.writeat = counted_writeat,
+	.eraseat = counted_eraseat,
+};
+
+static const struct region_device counted_rdev =
+	REGION_DEV_INIT(&counted_ops, 0, COUNTED_BUFFER_SIZE);
+
+/* Fill the counted region with updates of 16 bytes each and return the last slot. */
+static int fill_counted_region(size_t updates)
+{
+	struct region_file regf;
+	uint8_t data[16];
+
+	memset(counted_buffer, 0xff, sizeof(counted_buffer));
+	reset_hints();
+	assert_int_equal(0, region_file_init(&regf, &counted_rdev));
+	for (size_t i = 0; i < updates; i++) {
+		memset(data, i, sizeof(data));
+		assert_int_equal(0, region_file_update_data(&regf, data, sizeof(data)));
+	}
+
+	return regf.slot;
+}
+
+static size_t count_init_reads(struct region_file *regf)
+{
+	counted_reads = 0;
+	assert_int_equal(0, region_file_init(regf, &counted_rdev));
+	return counted_reads;
+}
+
+static void test_region_file_init_hint(void **state)
+{
+	const size_t updates[] = { 1, 7, 100, 1000, 3000 };
+	struct region_file searched, hinted;
+	size_t search_reads, hint_reads;
+
+	for (size_t i = 0; i < ARRAY_SIZE(updates); i++) {
+		const int slot = fill_counted_region(updates[i]);
+
+		reset_hints();
+		search_reads = count_init_reads(&searched);
+		hint_reads = count_init_reads(&hinted);
+
+		print_message("%5zu updates: %2zu reads searching, %zu with hint\n",
+			      updates[i], search_reads, hint_reads);
+
+		assert_int_equal(slot, searched.slot);
+		assert_int_equal(slot, hinted.slot);
+		assert_memory_equal(searched.data_blocks, hinted.data_blocks,
+				    sizeof(hinted.data_blocks));
+
+		/* First metadata block, the hinted slot and the data boundaries. */
+		assert_int_equal(3, hint_reads);
+		assert_true(hint_reads <= search_reads);
+	}
+}
+
+static void test_region_file_init_stale_hint(void **state)
+{
+	struct region_file regf;
+	uint8_t data[16] = { 0 };
+	int slot;
+
+	slot = fill_counted_region(50);
+
+	assert_int_equal(slot, local_hints[0].slot);
+
+	/* Updates made behind the hint's back, e.g. by the OS. */
+	for (int i = 0; i < 3; i++) {
+		struct region_file other;
+
+		assert_int_equal(0, region_file_init(&other, &counted_rdev));
+		assert_int_equal(0, region_file_update_data(&other, data, sizeof(data)));
+		local_hints[0].slot = slot;
+	}
+
+	assert_int_equal(0, region_file_init(&regf, &counted_rdev));
+	assert_int_equal(slot + 3, regf.slot);
+	assert_int_equal(slot + 3, local_hints[0].slot);
+
+	/* A hint beyond the metadata is ignored as well. */
+	local_hints[0].slot = 0x7fff;
+	assert_int_equal(0, region_file_init(&regf, &counted_rdev));
+	assert_int_equal(slot + 3, regf.slot);
+
+	/* After emptying the region, the region file restarts at the first slot. */
+	counted_eraseat(&counted_rdev, 0, COUNTED_BUFFER_SIZE);
+	assert_int_equal(0, region_file_init(&regf, &counted_rdev));
+	assert_int_equal(RF_EMPTY, regf.slot);
+	assert_int_equal(0, region_file_update_data(&regf, data, sizeof(data)));
+	assert_int_equal(1, regf.slot);
+	assert_int_equal(0, region_file_init(&regf, &counted_rdev));
+	assert_int_equal(1, regf.slot);
+}
+
+static void test_region_file_hint_cbmem(void **state)
+{
+	struct region_file regf;
+	int slot;
+
+	/* An early stage finds the latest update before CBMEM is up. */
+	slot = fill_counted_region(20);
+	reset_hints();
+	assert_int_equal(0, region_file_init(&regf, &counted_rdev));
+	regf_hints_cbmem_init(0);
+	assert_ptr_equal(cbmem_buffer, regf_hints);
+
+	/* The next stage picks the hint up from CBMEM. */
+	for (size_t i = 0; i < REGF_MAX_HINTS; i++)
+		local_hints[i].slot = -1;
+	regf_hints = local_hints;
+	regf_hints_cbmem_init(0);
+	assert_ptr_equal(cbmem_buffer, regf_hints);
+	assert_int_equal(3, count_init_reads(&regf));
+	assert_int_equal(slot, regf.slot);
+}
+
 int main(void)
 {
 	const struct CMUnitTest tests[] = {
@@ -322,6 +498,9 @@ int main(void)
 		cmocka_unit_test_setup_teardown(test_region_file_update_data_arr,
 						setup_teardown_region_file_test,
 						setup_teardown_region_file_test),
+		cmocka_unit_test(test_region_file_init_hint),
+		cmocka_unit_test(test_region_file_init_stale_hint),
+		cmocka_unit_test(test_region_file_hint_cbmem),
 	};
 
 	return cb_run_group_tests(tests, setup_region_file_test_group,
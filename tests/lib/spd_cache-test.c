@@ -11,10 +11,12 @@
 struct region_device flash_rdev_rw;
 static char *flash_buffer = NULL;
 static size_t flash_buffer_size = 0;
+static int erase_calls;
+static int write_calls;
 
 static int setup_spd_cache(void **state)
 {
-	flash_buffer_size = SC_SPD_TOTAL_LEN + SC_CRC_LEN;
+	flash_buffer_size = SC_CACHE_LEN;
 	flash_buffer = malloc(flash_buffer_size);
 
 	if (flash_buffer == NULL) {
@@ -29,6 +31,8 @@ static int setup_spd_cache(void **state)
 static int setup_spd_cache_test(void **state)
 {
 	memset(flash_buffer, 0xff, flash_buffer_size);
+	erase_calls = 0;
+	write_calls = 0;
 	return 0;
 }
 
@@ -47,6 +51,44 @@ int fmap_locate_area_as_rdev(const char *name, struct region_device *area)
 	return rdev_chain(area, &flash_rdev_rw, 0, flash_buffer_size);
 }
 
+static ssize_t flash_readat(const struct region_device *rd, void *b, size_t offset,
+			    size_t size)
+{
+	memcpy(b, &flash_buffer[offset], size);
+	return size;
+}
+
+/* Like SPI flash, programming can only clear bits. */
+static ssize_t flash_writeat(const struct region_device *rd, const void *b, size_t offset,
+			     size_t size)
+{
+	const uint8_t *data = b;
+
+	for (size_t i = 0; i < size; i++)
+		flash_buffer[offset + i] &= data[i];
+	write_calls++;
+	return size;
+}
+
+static ssize_t flash_eraseat(const struct region_device *rd, size_t offset, size_t size)
+{
+	memset(&flash_buffer[offset], 0xff, size);
+	erase_calls++;
+	return size;
+}
+
+static const struct region_device_ops flash_ops = {
+	.readat = flash_readat,
+	.writeat = flash_writeat,
+	.eraseat = flash_eraseat,
+};
+
+int fmap_locate_area_as_rdev_rw(const char *name, struct region_device *area)
+{
+	*area = (struct region_device)REGION_DEV_INIT(&flash_ops, 0, flash_buffer_size);
+	return 0;
+}
+
 /* This test verifies if load_spd_cache() correctly loads spd_cache pointer and size
    from provided region_device. Memory region device is returned by our
    fmap_locate_area_as_rdev() override. */
@@ -57,12 +99,23 @@ static void test_load_spd_cache(void **state)
 
 	assert_int_equal(CB_SUCCESS, load_spd_cache(&spd_cache, &spd_cache_sz));
 	assert_ptr_equal(flash_buffer, spd_cache);
-	assert_int_equal(SC_SPD_TOTAL_LEN + SC_CRC_LEN, spd_cache_sz);
+	assert_int_equal(SC_CACHE_LEN, spd_cache_sz);
 }
 
 static void calc_spd_cache_crc(uint8_t *spd_cache)
 {
-	*(uint16_t *)(spd_cache + SC_CRC_OFFSET) = CRC(spd_cache, SC_SPD_TOTAL_LEN, crc16_byte);
+	for (int i = 0; i < SC_SPD_NUMS; i++) {
+		uint8_t *slot = spd_cache + SC_SPD_OFFSET(i);
+		uint16_t crc = 0xffff;
+
+		for (int j = 0; j < SC_SPD_LEN; j++) {
+			if (slot[j] != 0xff) {
+				crc = CRC(slot, SC_SPD_LEN, crc16_byte);
+				break;
+			}
+		}
+		*(uint16_t *)(spd_cache + SC_CRC_OFFSET(i)) = crc;
+	}
 }
 
 __attribute__((unused)) static void fill_spd_cache_ddr3(uint8_t *spd_cache, size_t spd_cache_sz)
@@ -120,6 +173,113 @@ static void test_spd_cache_is_valid(void **state)
 	fill_spd_cache_ddr4(spd_cache, spd_cache_sz);
 #endif
 	assert_true(spd_cache_is_valid(spd_cache, spd_cache_sz));
+
+	/* A corrupted slot makes the whole cache invalid. */
+	spd_cache[SC_SPD_OFFSET(0) + 0x20] ^= 0x01;
+	assert_false(spd_cache_is_valid(spd_cache, spd_cache_sz));
+	spd_cache[SC_SPD_OFFSET(0) + 0x20] ^= 0x01;
+
+	/* So does a slot whose data was written but not its CRC. */
+	*(uint16_t *)(spd_cache + SC_CRC_OFFSET(SC_SPD_NUMS - 1)) = 0xffff;
+	assert_false(spd_cache_is_valid(spd_cache, spd_cache_sz));
+}
+
+/* Used by get_spd_smbus() to return SPD data for the DIMMs it's asked to read. */
+static uint8_t *smbus_spd[SC_SPD_NUMS];
+static uint8_t smbus_addr_map[SC_SPD_NUMS];
+
+void get_spd_smbus(struct spd_block *blk)
+{
+	for (int i = 0; i < SC_SPD_NUMS; i++) {
+		smbus_addr_map[i] = blk->addr_map[i];
+		blk->spd_array[i] = blk->addr_map[i] ? smbus_spd[i] : NULL;
+	}
+	blk->len = SC_SPD_LEN;
+}
+
+static void set_blk_spd(struct spd_block *blk, uint8_t *spd0, uint8_t *spd1)
+{
+	memset(blk, 0, sizeof(*blk));
+	blk->len = SC_SPD_LEN;
+	blk->spd_array[0] = spd0;
+	blk->spd_array[1] = spd1;
+}
+
+#if __TEST_SPD_CACHE_DDR == 3
+#define TEST_SPD_1	spd_data_ddr3_1
+#define TEST_SPD_2	spd_data_ddr3_1
+#elif __TEST_SPD_CACHE_DDR == 4
+#define TEST_SPD_1	spd_data_ddr4_1
+#define TEST_SPD_2	spd_data_ddr4_2
+#endif
+
+static void test_update_spd_cache(void **state)
+{
+	struct spd_block blk;
+	uint8_t *spd_cache;
+	size_t spd_cache_sz;
+
+	assert_int_equal(CB_SUCCESS, load_spd_cache(&spd_cache, &spd_cache_sz));
+
+	/* An erased region doesn't need to be erased again. */
+	set_blk_spd(&blk, TEST_SPD_1, NULL);
+	assert_int_equal(CB_SUCCESS, update_spd_cache(&blk));
+	assert_int_equal(0, erase_calls);
+	assert_int_equal(2, write_calls);
+	assert_true(spd_cache_is_valid(spd_cache, spd_cache_sz));
+	assert_memory_equal(TEST_SPD_1, spd_cache + SC_SPD_OFFSET(0), SC_SPD_LEN);
+
+	/* Nothing is written when nothing changed. */
+	write_calls = 0;
+	assert_int_equal(CB_SUCCESS, update_spd_cache(&blk));
+	assert_int_equal(0, erase_calls);
+	assert_int_equal(0, write_calls);
+
+	/* A DIMM added to an empty slot is programmed without an erase. */
+	set_blk_spd(&blk, TEST_SPD_1, TEST_SPD_2);
+	assert_int_equal(CB_SUCCESS, update_spd_cache(&blk));
+	assert_int_equal(0, erase_calls);
+	assert_int_equal(2, write_calls);
+	assert_true(spd_cache_is_valid(spd_cache, spd_cache_sz));
+	assert_memory_equal(TEST_SPD_2, spd_cache + SC_SPD_OFFSET(1), SC_SPD_LEN);
+
+	/* Replacing a DIMM needs the region erased and all present slots rewritten. */
+	write_calls = 0;
+	set_blk_spd(&blk, NULL, TEST_SPD_2);
+	assert_int_equal(CB_SUCCESS, update_spd_cache(&blk));
+	assert_int_equal(1, erase_calls);
+	assert_int_equal(2, write_calls);
+	assert_true(spd_cache_is_valid(spd_cache, spd_cache_sz));
+	assert_int_equal(0xffff, *(uint16_t *)(spd_cache + SC_SPD_OFFSET(0)));
+	assert_memory_equal(TEST_SPD_2, spd_cache + SC_SPD_OFFSET(1), SC_SPD_LEN);
+}
+
+static void test_spd_fill_changed_from_smbus(void **state)
+{
+	struct spd_block blk = {.addr_map = {0x50, 0x51, 0x52, 0x53}};
+	uint8_t new_spd[SC_SPD_LEN];
+	uint8_t *spd_cache;
+	size_t spd_cache_sz;
+
+	assert_int_equal(CB_SUCCESS, load_spd_cache(&spd_cache, &spd_cache_sz));
+	memcpy(spd_cache + SC_SPD_OFFSET(0), TEST_SPD_1, SC_SPD_LEN);
+	memcpy(spd_cache + SC_SPD_OFFSET(1), TEST_SPD_2, SC_SPD_LEN);
+	calc_spd_cache_crc(spd_cache);
+
+	memcpy(new_spd, TEST_SPD_2, SC_SPD_LEN);
+	smbus_spd[1] = new_spd;
+
+	/* Only the changed DIMM is read over SMBus, the others come from the cache. */
+	spd_fill_changed_from_smbus(spd_cache, &blk, 1 << 1);
+	assert_int_equal(0, smbus_addr_map[0]);
+	assert_int_equal(0x51, smbus_addr_map[1]);
+	assert_int_equal(0, smbus_addr_map[2]);
+	assert_int_equal(0, smbus_addr_map[3]);
+	assert_ptr_equal(spd_cache + SC_SPD_OFFSET(0), blk.spd_array[0]);
+	assert_ptr_equal(new_spd, blk.spd_array[1]);
+	assert_null(blk.spd_array[2]);
+	assert_null(blk.spd_array[3]);
+	assert_int_equal(SC_SPD_LEN, blk.len);
 }
 
 
@@ -142,6 +302,25 @@ static void get_sn_from_spd_cache(uint8_t *spd_cache, u32 arr[])
 }
 
 /* check_if_dimm_changed() has is used only with DDR4, so there tests are not used for DDR3 */
+__attribute__((unused)) static void test_spd_cache_changed_dimms(void **state)
+{
+	uint8_t *spd_cache;
+	size_t spd_cache_sz;
+	struct spd_block blk = {.addr_map = {0x50, 0x51, 0x52, 0x53},
+				.spd_array = {0}, .len = 0};
+
+	assert_int_equal(CB_SUCCESS, load_spd_cache(&spd_cache, &spd_cache_sz));
+	fill_spd_cache_ddr4(spd_cache, spd_cache_sz);
+	get_sn_from_spd_cache(spd_cache, get_spd_sn_ret_sn);
+
+	/* DIMM1 replaced, DIMM3 removed: all DIMMs are checked, not just up to DIMM1. */
+	get_spd_sn_ret_sn[1] = 0x43211234;
+	get_spd_sn_ret_sn[3] = 0xffffffff;
+	get_spd_sn_ret_sn_idx = 0;
+	will_return_count(get_spd_sn, CB_SUCCESS, SC_SPD_NUMS);
+	assert_int_equal((1 << 1) | (1 << 3), spd_cache_changed_dimms(spd_cache, &blk));
+}
+
 __attribute__((unused)) static void test_check_if_dimm_changed_not_changed(void **state)
 {
 	uint8_t *spd_cache;
@@ -255,6 +434,8 @@ int main(void)
 		cmocka_unit_test_setup(test_load_spd_cache, setup_spd_cache_test),
 		cmocka_unit_test_setup(test_spd_fill_from_cache, setup_spd_cache_test),
 		cmocka_unit_test_setup(test_spd_cache_is_valid, setup_spd_cache_test),
+		cmocka_unit_test_setup(test_update_spd_cache, setup_spd_cache_test),
+		cmocka_unit_test_setup(test_spd_fill_changed_from_smbus, setup_spd_cache_test),
 #if __TEST_SPD_CACHE_DDR == 4
 		cmocka_unit_test_setup(test_check_if_dimm_changed_not_changed,
 				       setup_spd_cache_test),
@@ -268,6 +449,7 @@ int main(void)
 				       setup_spd_cache_test),
 		cmocka_unit_test_setup(test_check_if_dimm_changed_with_nonexistent,
 				       setup_spd_cache_test),
+		cmocka_unit_test_setup(test_spd_cache_changed_dimms, setup_spd_cache_test),
 #endif
 	};
 
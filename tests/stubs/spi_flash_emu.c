@@ -0,0 +1,321 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <commonlib/helpers.h>
+#include <spi-generic.h>
+#include <string.h>
+
+#include "stubs/spi_flash_emu.h"
+
+#define EMU_PAGE_SIZE	256
+#define EMU_ADDR_LEN	3
+
+#define SR1_WIP		(1 << 0)
+#define SR1_WEL		(1 << 1)
+#define SR1_QE		(1 << 6)
+#define SR2_QE		(1 << 1)
+
+static struct spi_flash_emu *emu;
+
+/* State of the transaction between claim_bus() (CS# low) and release_bus() (CS# high). */
+static struct {
+	bool active;
+	uint8_t cmd[1 + EMU_ADDR_LEN + 3 + EMU_PAGE_SIZE];
+	size_t cmd_len;
+	unsigned int addr_lanes;
+	bool data_phase;
+	uint32_t addr;
+} txn;
+
+struct read_cmd {
+	uint8_t opcode;
+	uint8_t dummy_bytes;	/* Mode and dummy bytes, sent on addr_lanes */
+	uint8_t addr_lanes;
+	uint8_t data_lanes;
+	bool needs_qe;
+};
+
+static const struct read_cmd read_cmds[] = {
+	{ 0x03, 0, 1, 1, false },	/* Read */
+	{ 0x0b, 1, 1, 1, false },	/* Fast Read */
+	{ 0x3b, 1, 1, 2, false },	/* Dual Output Fast Read */
+	{ 0xbb, 1, 2, 2, false },	/* Dual I/O Fast Read */
+	{ 0x6b, 1, 1, 4, true },	/* Quad Output Fast Read */
+	{ 0xeb, 3, 4, 4, true },	/* Quad I/O Fast Read */
+};
+
+static int protocol_error(void)
+{
+	emu->protocol_errors++;
+	return -1;
+}
+
+static uint32_t cmd_addr(void)
+{
+	return (txn.cmd[1] << 16 | txn.cmd[2] << 8 | txn.cmd[3]) % emu->size;
+}
+
+bool spi_flash_emu_quad_enabled(const struct spi_flash_emu *e)
+{
+	if (e->qe == SPI_FLASH_EMU_QE_SR1_BIT6)
+		return e->sr1 & SR1_QE;
+	return e->sr2 & SR2_QE;
+}
+
+static int read_array(uint8_t *din, size_t bytesin, unsigned int lanes)
+{
+	const struct read_cmd *rc = NULL;
+
+	for (size_t i = 0; i < ARRAY_SIZE(read_cmds); i++) {
+		if (read_cmds[i].opcode == txn.cmd[0])
+			rc = &read_cmds[i];
+	}
+
+	if (!rc || lanes != rc->data_lanes)
+		return protocol_error();
+
+	if (!txn.data_phase) {
+		if (txn.cmd_len != 1 + EMU_ADDR_LEN + rc->dummy_bytes)
+			return protocol_error();
+		if (rc->addr_lanes != txn.addr_lanes)
+			return protocol_error();
+		if (rc->needs_qe && !spi_flash_emu_quad_enabled(emu))
+			return protocol_error();
+		txn.addr = cmd_addr();
+		txn.data_phase = true;
+	}
+
+	/* Like real parts, reads wrap around at the end of the array. */
+	while (bytesin--) {
+		*din++ = emu->data[txn.addr];
+		txn.addr = (txn.addr + 1) % emu->size;
+	}
+
+	return 0;
+}
+
+static int respond(uint8_t *din, size_t bytesin, unsigned int lanes)
+{
+	switch (txn.cmd[0]) {
+	case 0x9f:
+		if (lanes != 1)
+			return protocol_error();
+		memset(din, 0, bytesin);
+		memcpy(din, emu->idcode, MIN(bytesin, sizeof(emu->idcode)));
+		return 0;
+	case 0x05:
+	case 0x35:
+		if (lanes != 1)
+			return protocol_error();
+		memset(din, txn.cmd[0] == 0x05 ? emu->sr1 | (emu->wel ? SR1_WEL : 0) : emu->sr2,
+		       bytesin);
+		return 0;
+	default:
+		return read_array(din, bytesin, lanes);
+	}
+}
+
+static int emu_xfer_lanes(const struct spi_slave *slave, const void *dout, size_t bytesout,
+			  void *din, size_t bytesin, unsigned int lanes)
+{
+	const uint8_t *out = dout;
+
+	if (!txn.active || (bytesout && txn.data_phase))
+		return protocol_error();
+
+	emu->clocks += (bytesout + bytesin) * 8 / lanes;
+
+	if (bytesout) {
+		if (txn.cmd_len + bytesout > sizeof(txn.cmd))
+			return protocol_error();
+		/* The opcode always goes out on a single lane. */
+		if (!txn.cmd_len && lanes != 1)
+			return protocol_error();
+		if (txn.cmd_len + bytesout > 1) {
+			const unsigned int addr_lanes = txn.cmd_len ? lanes : 1;
+
+			if (txn.addr_lanes && txn.addr_lanes != addr_lanes)
+				return protocol_error();
+			txn.addr_lanes = addr_lanes;
+		}
+		memcpy(&txn.cmd[txn.cmd_len], out, bytesout);
+		txn.cmd_len += bytesout;
+	}
+
+	if (bytesin)
+		return respond(din, bytesin, lanes);
+
+	return 0;
+}
+
+static int emu_xfer(const struct spi_slave *slave, const void *dout, size_t bytesout,
+		    void *din, size_t bytesin)
+{
+	return emu_xfer_lanes(slave, dout, bytesout, din, bytesin, 1);
+}
+
+static int emu_xfer_dual(const struct spi_slave *slave, const void *dout, size_t bytesout,
+			 void *din, size_t bytesin)
+{
+	return emu_xfer_lanes(slave, dout, bytesout, din, bytesin, 2);
+}
+
+static int emu_xfer_quad(const struct spi_slave *slave, const void *dout, size_t bytesout,
+			 void *din, size_t bytesin)
+{
+	return emu_xfer_lanes(slave, dout, bytesout, din, bytesin, 4);
+}
+
+static int emu_claim_bus(const struct spi_slave *slave)
+{
+	if (txn.active)
+		return protocol_error();
+
+	memset(&txn, 0, sizeof(txn));
+	txn.active = true;
+
+	return 0;
+}
+
+static void write_status(void)
+{
+	const bool non_volatile = emu->wel;
+
+	if (!emu->wel && !emu->volatile_wel)
+		return;
+	if (emu->status_locked)
+		return;
+
+	if (txn.cmd[0] == 0x31) {
+		emu->sr2 = txn.cmd[1];
+	} else {
+		emu->sr1 = txn.cmd[1] & ~(SR1_WIP | SR1_WEL);
+		if (txn.cmd_len > 2)
+			emu->sr2 = txn.cmd[2];
+	}
+
+	if (non_volatile)
+		emu->status_writes++;
+}
+
+static void page_program(void)
+{
+	const uint32_t addr = cmd_addr();
+	const uint32_t page = ALIGN_DOWN(addr, EMU_PAGE_SIZE);
+
+	/* Programming can only clear bits and wraps around within the page. */
+	for (size_t i = 1 + EMU_ADDR_LEN; i < txn.cmd_len; i++) {
+		const uint32_t offset = page + (addr + i - 1 - EMU_ADDR_LEN) % EMU_PAGE_SIZE;
+
+		emu->data[offset] &= txn.cmd[i];
+	}
+}
+
+static void erase(size_t size)
+{
+	const uint32_t start = ALIGN_DOWN(cmd_addr(), size);
+
+	memset(&emu->data[start], 0xff, size);
+}
+
+static void emu_release_bus(const struct spi_slave *slave)
+{
+	const bool wel = emu->wel;
+
+	if (!txn.active) {
+		protocol_error();
+		return;
+	}
+
+	txn.active = false;
+	if (!txn.cmd_len)
+		return;
+
+	emu->commands++;
+
+	switch (txn.cmd[0]) {
+	case 0x06:
+		emu->wel = true;
+		return;
+	case 0x50:
+		emu->volatile_wel = true;
+		return;
+	case 0x04:
+		break;
+	case 0x01:
+	case 0x31:
+		write_status();
+		break;
+	case 0x02:
+		if (wel && txn.cmd_len > 1 + EMU_ADDR_LEN)
+			page_program();
+		break;
+	case 0x20:
+		if (wel && txn.cmd_len == 1 + EMU_ADDR_LEN)
+			erase(4 * KiB);
+		break;
+	case 0xd8:
+		if (wel && txn.cmd_len == 1 + EMU_ADDR_LEN)
+			erase(64 * KiB);
+		break;
+	case 0x60:
+	case 0xc7:
+		if (wel)
+			erase(emu->size);
+		break;
+	default:
+		/* Reads and register reads have no side effects. */
+		return;
+	}
+
+	emu->wel = false;
+	emu->volatile_wel = false;
+}
+
+static const struct spi_ctrlr emu_ctrlr_quad = {
+	.claim_bus = emu_claim_bus,
+	.release_bus = emu_release_bus,
+	.xfer = emu_xfer,
+	.xfer_dual = emu_xfer_dual,
+	.xfer_quad = emu_xfer_quad,
+	.max_xfer_size = SPI_CTRLR_DEFAULT_MAX_XFER_SIZE,
+};
+
+static const struct spi_ctrlr emu_ctrlr_dual = {
+	.claim_bus = emu_claim_bus,
+	.release_bus = emu_release_bus,
+	.xfer = emu_xfer,
+	.xfer_dual = emu_xfer_dual,
+	.max_xfer_size = SPI_CTRLR_DEFAULT_MAX_XFER_SIZE,
+};
+
+static const struct spi_ctrlr emu_ctrlr_single = {
+	.claim_bus = emu_claim_bus,
+	.release_bus = emu_release_bus,
+	.xfer = emu_xfer,
+	.max_xfer_size = SPI_CTRLR_DEFAULT_MAX_XFER_SIZE,
+};
+
+const struct spi_ctrlr_buses spi_ctrlr_bus_map[] = {
+	{ .ctrlr = &emu_ctrlr_quad, .bus_start = SPI_FLASH_EMU_BUS_QUAD,
+	  .bus_end = SPI_FLASH_EMU_BUS_QUAD },
+	{ .ctrlr = &emu_ctrlr_dual, .bus_start = SPI_FLASH_EMU_BUS_DUAL,
+	  .bus_end = SPI_FLASH_EMU_BUS_DUAL },
+	{ .ctrlr = &emu_ctrlr_single, .bus_start = SPI_FLASH_EMU_BUS_SINGLE,
+	  .bus_end = SPI_FLASH_EMU_BUS_SINGLE },
+};
+
+const size_t spi_ctrlr_bus_map_count = ARRAY_SIZE(spi_ctrlr_bus_map);
+
+void spi_flash_emu_attach(struct spi_flash_emu *e)
+{
+	emu = e;
+	emu->sr1 = 0;
+	emu->sr2 = 0;
+	emu->wel = false;
+	emu->volatile_wel = false;
+	emu->clocks = 0;
+	emu->commands = 0;
+	emu->status_writes = 0;
+	emu->protocol_errors = 0;
+	memset(&txn, 0, sizeof(txn));
+}
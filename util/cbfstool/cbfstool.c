@@ -8,10 +8,12 @@
 #include <ctype.h>
 #include <unistd.h>
 #include <getopt.h>
+#include <pthread.h>
 #include "common.h"
 #include "cbfs.h"
 #include "cbfs_image.h"
 #include "cbfs_sections.h"
+#include "compress_auto.h"
 #include "elfparsing.h"
 #include "partitioned_file.h"
 #include "lz4/lib/xxhash.h"
@@ -89,8 +91,18 @@ static struct param {
 	bool machine_parseable;
 	bool unprocessed;
 	bool ibb;
+	bool lz4_blocks;
+	/* Number of blocks in the LZ4 block index, known after compression. */
+	uint32_t lz4_num_blocks;
 	enum cbfs_compression compression;
 	int precompression;
+	/* -c auto: pick the compression per file with the cost profile. */
+	bool compress_auto;
+	struct compress_profile cost_profile;
+	/* File contents already read (and possibly compressed) by the batch workers. */
+	struct buffer *input_buffer;
+	/* Number of batch worker threads, 0 for one per CPU. */
+	unsigned int jobs;
 	enum vb2_hash_algorithm hash;
 	/* For linux payloads */
 	char *initrd;
@@ -597,6 +609,9 @@ static int do_cbfs_locate(uint32_t *cbfs_addr, size_t data_size)
 		metadata_size += sizeof(struct cbfs_file_attr_compression);
 	if (param.type == CBFS_TYPE_STAGE)
 		metadata_size += sizeof(struct cbfs_file_attr_stageheader);
+	if (param.lz4_num_blocks)
+		metadata_size += sizeof(struct cbfs_file_attr_lz4_blocks) +
+				 param.lz4_num_blocks * sizeof(uint32_t);
 
 	/* Take care of the hash attribute if it is used */
 	if (param.hash != VB2_HASH_INVALID)
@@ -852,6 +867,9 @@ static int add_topswap_bootblock(struct buffer *buffer, uint32_t *offset)
 	return convert_region_offset(buffer_size(buffer), offset);
 }
 
+static int cbfstool_convert_raw(struct buffer *buffer, uint32_t *offset,
+				struct cbfs_file *header);
+
 static int cbfs_add_component(const char *filename,
 			      const char *name,
 			      uint32_t headeroffset,
@@ -887,6 +905,16 @@ static int cbfs_add_component(const char *filename,
 		return 1;
 	}
 
+	if (param.lz4_blocks && param.compression != CBFS_COMPRESS_LZ4) {
+		ERROR("--lz4-blocks requires -c lz4.\n");
+		return 1;
+	}
+
+	if (param.compress_auto && convert != cbfstool_convert_raw) {
+		ERROR("-c auto is only supported when adding raw files.\n");
+		return 1;
+	}
+
 	if (!filename) {
 		ERROR("You need to specify -f/--filename.\n");
 		return 1;
@@ -912,7 +940,11 @@ static int cbfs_add_component(const char *filename,
 	}
 
 	struct buffer buffer;
-	if (buffer_from_file(&buffer, filename) != 0) {
+	if (param.input_buffer) {
+		/* Take over ownership of the buffer. */
+		buffer = *param.input_buffer;
+		memset(param.input_buffer, 0, sizeof(*param.input_buffer));
+	} else if (buffer_from_file(&buffer, filename) != 0) {
 		ERROR("Could not load file '%s'.\n", filename);
 		return 1;
 	}
@@ -1033,6 +1065,101 @@ error:
 	return 1;
 }
 
+static int cbfstool_convert_lz4_blocks(struct buffer *buffer, char *compressed,
+				       struct cbfs_file *header)
+{
+	uint32_t offsets[CBFS_LZ4_BLOCKS_MAX];
+	uint32_t block_size, num_blocks, i;
+	int compressed_size;
+
+	if (lz4_compress_indexed(buffer->data, buffer->size, compressed,
+				 &compressed_size, &block_size, offsets, &num_blocks)) {
+		WARN("Compression failed - disabled\n");
+		free(compressed);
+		header->len = htobe32(buffer->size);
+		return 0;
+	}
+
+	struct cbfs_file_attr_compression *cattr =
+		(struct cbfs_file_attr_compression *)
+		cbfs_add_file_attr(header,
+			CBFS_FILE_ATTR_TAG_COMPRESSION,
+			sizeof(struct cbfs_file_attr_compression));
+	struct cbfs_file_attr_lz4_blocks *battr =
+		(struct cbfs_file_attr_lz4_blocks *)
+		cbfs_add_file_attr(header,
+			CBFS_FILE_ATTR_TAG_LZ4_BLOCKS,
+			sizeof(struct cbfs_file_attr_lz4_blocks) +
+			num_blocks * sizeof(uint32_t));
+	if (cattr == NULL || battr == NULL) {
+		free(compressed);
+		return -1;
+	}
+	cattr->compression = htobe32(CBFS_COMPRESS_LZ4);
+	cattr->decompressed_size = htobe32(buffer->size);
+	battr->block_size = htobe32(block_size);
+	battr->num_blocks = htobe32(num_blocks);
+	for (i = 0; i < num_blocks; i++)
+		battr->offsets[i] = htobe32(offsets[i]);
+	param.lz4_num_blocks = num_blocks;
+
+	INFO("LZ4 block index: %u blocks of %u bytes\n", num_blocks, block_size);
+
+	free(buffer->data);
+	buffer->data = compressed;
+	buffer->size = compressed_size;
+	header->len = htobe32(buffer->size);
+	return 0;
+}
+
+/* Returns the size of the largest free space in |image|, without any metadata. */
+static size_t cbfs_largest_free_space(struct cbfs_image *image)
+{
+	struct cbfs_file *entry;
+	size_t largest = 0;
+
+	for (entry = cbfs_find_first_entry(image);
+	     entry && cbfs_is_valid_entry(image, entry);
+	     entry = cbfs_find_next_entry(image, entry)) {
+		uint32_t addr = cbfs_get_entry_addr(image, entry);
+		uint32_t addr_next = cbfs_get_entry_addr(image,
+					cbfs_find_next_entry(image, entry));
+
+		if (be32toh(entry->type) == CBFS_TYPE_NULL)
+			largest = MAX(largest, addr_next - addr);
+	}
+
+	return largest;
+}
+
+/*
+ * Picks the compression with the shortest predicted load time for the file. Sets
+ * param.compression to the result and, if it isn't CBFS_COMPRESS_NONE, returns the
+ * compressed data in |*compressed|.
+ */
+static int cbfstool_compress_auto(struct buffer *buffer, struct cbfs_file *header,
+				  char **compressed, int *compressed_size)
+{
+	const size_t metadata_size = be32toh(header->offset) +
+				     sizeof(struct cbfs_file_attr_compression);
+	struct cbfs_image image;
+	enum cbfs_compression algo;
+	size_t space;
+
+	if (cbfs_image_from_buffer(&image, param.image_region, param.headeroffset))
+		return -1;
+
+	space = cbfs_largest_free_space(&image);
+	space = space > metadata_size ? space - metadata_size : 0;
+
+	if (compress_auto(&param.cost_profile, header->filename, buffer->data,
+			  buffer->size, space, &algo, compressed, compressed_size))
+		return -1;
+
+	param.compression = algo;
+	return 0;
+}
+
 static int cbfstool_convert_raw(struct buffer *buffer,
 	unused uint32_t *offset, struct cbfs_file *header)
 {
@@ -1049,6 +1176,11 @@ static int cbfstool_convert_raw(struct buffer *buffer,
 		if (!compressed)
 			return -1;
 		memcpy(compressed, buffer->data + 8, compressed_size);
+	} else if (param.compress_auto) {
+		if (cbfstool_compress_auto(buffer, header, &compressed, &compressed_size))
+			return -1;
+		if (param.compression == CBFS_COMPRESS_NONE)
+			goto out;
 	} else {
 		if (param.compression == CBFS_COMPRESS_NONE)
 			goto out;
@@ -1060,6 +1192,9 @@ static int cbfstool_convert_raw(struct buffer *buffer,
 		if (!compressed)
 			return -1;
 
+		if (param.lz4_blocks)
+			return cbfstool_convert_lz4_blocks(buffer, compressed, header);
+
 		if (compress(buffer->data, buffer->size,
 			     compressed, &compressed_size)) {
 			WARN("Compression failed - disabled\n");
@@ -1752,6 +1887,205 @@ static int cbfs_compact(void)
 	return cbfs_compact_instance(&image);
 }
 
+struct reorder_file {
+	struct cbfs_file *header;	/* Copy of the header and attributes */
+	struct buffer data;
+};
+
+/* Files that firmware or hardware finds by their address must stay where they are. */
+static bool reorder_can_move(struct cbfs_file *entry)
+{
+	struct cbfs_file_attribute *attr;
+
+	switch (be32toh(entry->type)) {
+	case CBFS_TYPE_BOOTBLOCK:
+	case CBFS_TYPE_CBFSHEADER:
+	case CBFS_TYPE_INTEL_FIT:
+	case CBFS_TYPE_MICROCODE:
+	case CBFS_TYPE_FSP:
+		return false;
+	}
+
+	for (attr = cbfs_file_first_attr(entry); attr;
+	     attr = cbfs_file_next_attr(entry, attr)) {
+		const struct cbfs_file_attr_stageheader *sattr;
+
+		switch (be32toh(attr->tag)) {
+		case CBFS_FILE_ATTR_TAG_POSITION:
+		case CBFS_FILE_ATTR_TAG_ALIGNMENT:
+			return false;
+		case CBFS_FILE_ATTR_TAG_STAGEHEADER:
+			/* XIP stages are linked to run from their place in flash. */
+			sattr = (const void *)attr;
+			if (IS_HOST_SPACE_ADDRESS(be64toh(sattr->loadaddr)))
+				return false;
+			break;
+		}
+	}
+
+	return true;
+}
+
+/*
+ * Returns the file name of a trace line: the second tab-separated field of a
+ * `cbmem --cbfs-trace` line, or the whole line for a plain list of names.
+ */
+static char *reorder_trace_name(char *line)
+{
+	char *tab;
+
+	line[strcspn(line, "\r\n")] = '\0';
+	if (line[0] == '\0' || line[0] == '#')
+		return NULL;
+
+	tab = strchr(line, '\t');
+	if (tab) {
+		line = tab + 1;
+		line[strcspn(line, "\t")] = '\0';
+	}
+
+	return line[0] ? line : NULL;
+}
+
+static int cbfs_reorder(void)
+{
+	struct reorder_file *files = NULL;
+	size_t num_files = 0, max_files = 0, i;
+	struct cbfs_image image;
+	struct cbfs_file *entry;
+	uint32_t align, total = 0, cursor = 0;
+	bool contiguous = false;
+	char *line = NULL;
+	size_t line_size = 0;
+	FILE *trace;
+	int ret = 1;
+
+	if (!param.filename) {
+		ERROR("You need to specify -f/--file.\n");
+		return 1;
+	}
+
+	if (cbfs_image_from_buffer(&image, param.image_region,
+							param.headeroffset))
+		return 1;
+	align = image.has_header ? image.header.align : CBFS_ALIGNMENT;
+
+	trace = fopen(param.filename, "r");
+	if (!trace) {
+		ERROR("Could not open trace '%s'\n", param.filename);
+		return 1;
+	}
+
+	/* Collect the movable files in the order they were first accessed. */
+	while (getline(&line, &line_size, trace) >= 0) {
+		const char *name = reorder_trace_name(line);
+		struct reorder_file *file;
+		size_t header_size;
+
+		if (!name)
+			continue;
+
+		entry = cbfs_get_entry(&image, name);
+		if (!entry) {
+			DEBUG("'%s' is not in region '%s'\n", name,
+			      param.region_name);
+			continue;
+		}
+
+		for (i = 0; i < num_files; i++)
+			if (!strcmp(files[i].header->filename, entry->filename))
+				break;
+		if (i < num_files)
+			continue;
+
+		if (!reorder_can_move(entry)) {
+			INFO("'%s' has a fixed location, leaving it in place\n", name);
+			continue;
+		}
+
+		if (num_files == max_files) {
+			max_files = max_files ? 2 * max_files : 32;
+			file = realloc(files, max_files * sizeof(*files));
+			if (!file)
+				goto out;
+			files = file;
+		}
+
+		file = &files[num_files];
+		header_size = be32toh(entry->offset);
+		file->header = malloc(header_size);
+		if (!file->header)
+			goto out;
+		memcpy(file->header, entry, header_size);
+		if (buffer_create(&file->data, be32toh(entry->len), entry->filename)) {
+			free(file->header);
+			goto out;
+		}
+		memcpy(file->data.data, CBFS_SUBHEADER(entry), be32toh(entry->len));
+		num_files++;
+
+		total += ALIGN_UP(header_size + be32toh(entry->len), align);
+	}
+
+	if (!num_files) {
+		WARN("No file from the trace can be moved in region '%s'\n",
+		     param.region_name);
+		ret = 0;
+		goto out;
+	}
+
+	for (i = 0; i < num_files; i++)
+		if (cbfs_remove_entry(&image, files[i].header->filename))
+			goto out;
+
+	/* Look for one free run that takes all of them back to back. */
+	for (entry = cbfs_find_first_entry(&image);
+	     entry && cbfs_is_valid_entry(&image, entry);
+	     entry = cbfs_find_next_entry(&image, entry)) {
+		uint32_t addr = cbfs_get_entry_addr(&image, entry);
+		uint32_t addr_next = cbfs_get_entry_addr(&image,
+					cbfs_find_next_entry(&image, entry));
+
+		if (be32toh(entry->type) == CBFS_TYPE_NULL &&
+		    addr_next - addr >= total) {
+			cursor = addr;
+			contiguous = true;
+			break;
+		}
+	}
+
+	if (!contiguous)
+		WARN("No contiguous space for %u bytes, files will be placed "
+		     "first-fit in access order\n", total);
+
+	for (i = 0; i < num_files; i++) {
+		uint32_t header_size = be32toh(files[i].header->offset);
+		uint32_t content_offset = contiguous ? cursor + header_size : 0;
+
+		if (cbfs_add_entry(&image, &files[i].data, content_offset,
+				   files[i].header, 0)) {
+			ERROR("Could not place '%s'\n", files[i].header->filename);
+			goto out;
+		}
+
+		if (contiguous)
+			cursor = ALIGN_UP(content_offset + files[i].data.size, align);
+	}
+
+	INFO("Placed %zu files in access order\n", num_files);
+	ret = maybe_update_metadata_hash(&image);
+
+out:
+	for (i = 0; i < num_files; i++) {
+		free(files[i].header);
+		buffer_delete(&files[i].data);
+	}
+	free(files);
+	free(line);
+	fclose(trace);
+	return ret;
+}
+
 static int cbfs_expand(void)
 {
 	struct buffer src_buf;
@@ -1784,6 +2118,8 @@ static int cbfs_truncate(void)
 	return result;
 }
 
+static int cbfs_batch(void);
+
 static const struct command commands[] = {
 	{"add", "H:r:f:n:t:c:b:a:p:yvA:j:gh?", cbfs_add, true, true},
 	{"add-flat-binary", "H:r:f:n:l:e:c:b:p:vA:gh?", cbfs_add_flat_binary,
@@ -1793,6 +2129,7 @@ static const struct command commands[] = {
 	{"add-stage", "a:H:r:f:n:t:c:b:P:QS:p:yvA:gh?", cbfs_add_stage,
 				true, true},
 	{"add-int", "H:r:i:n:b:vgh?", cbfs_add_integer, true, true},
+	{"batch", "H:r:f:c:J:vh?", cbfs_batch, true, true},
 	{"add-master-header", "H:r:vh?j:", cbfs_add_master_header, true, true},
 	{"compact", "r:h?", cbfs_compact, true, true},
 	{"copy", "r:R:h?", cbfs_copy, true, true},
@@ -1802,6 +2139,7 @@ static const struct command commands[] = {
 	{"print", "H:r:vkh?", cbfs_print, true, false},
 	{"read", "r:f:vh?", cbfs_read, true, false},
 	{"remove", "H:r:n:vh?", cbfs_remove, true, true},
+	{"reorder", "H:r:f:vh?", cbfs_reorder, true, true},
 	{"write", "r:f:i:Fudvh?", cbfs_write, true, true},
 	{"expand", "r:h?", cbfs_expand, true, true},
 	{"truncate", "r:h?", cbfs_truncate, true, true},
@@ -1812,6 +2150,8 @@ enum {
 	LONGOPT_START = 256,
 	LONGOPT_IBB = LONGOPT_START,
 	LONGOPT_MMAP,
+	LONGOPT_LZ4_BLOCKS,
+	LONGOPT_COST_PROFILE,
 	LONGOPT_END,
 };
 
@@ -1837,6 +2177,7 @@ static struct option long_options[] = {
 	{"ignore-sec",    required_argument, 0, 'S' },
 	{"initrd",        required_argument, 0, 'I' },
 	{"int",           required_argument, 0, 'i' },
+	{"jobs",          required_argument, 0, 'J' },
 	{"load-address",  required_argument, 0, 'l' },
 	{"machine",       required_argument, 0, 'm' },
 	{"name",          required_argument, 0, 'n' },
@@ -1854,6 +2195,8 @@ static struct option long_options[] = {
 	{"unprocessed",   no_argument,       0, 'U' },
 	{"ibb",           no_argument,       0, LONGOPT_IBB },
 	{"mmap",          required_argument, 0, LONGOPT_MMAP },
+	{"lz4-blocks",    no_argument,       0, LONGOPT_LZ4_BLOCKS },
+	{"cost-profile",  required_argument, 0, LONGOPT_COST_PROFILE },
 	{NULL,            0,                 0,  0  }
 };
 
@@ -1953,9 +2296,16 @@ static void usage(char *name)
 	     "  -d               Accept short data; fill downward/from top\n"
 	     "  -F               Force action\n"
 	     "  -g               Generate position and alignment arguments\n"
+	     "  -J               Number of batch worker threads (default: one per CPU)\n"
 	     "  -U               Unprocessed; don't decompress or make ELF\n"
 	     "  -v               Provide verbose output (-v=INFO -vv=DEBUG output)\n"
 	     "  -h               Display this help message\n\n"
+	     "  --lz4-blocks     Store an index of independently decompressible\n"
+	     "                   LZ4 blocks for parallel loading\n"
+	     "  --cost-profile   Boot media and decompression speeds in MB/s\n"
+	     "                   for -c auto, e.g. media=20,lz4=400,lzma=40\n"
+	     "                   (0 disables an algorithm), and min_free=BYTES\n"
+	     "                   of CBFS space to keep when trading size for speed\n"
 	     "  --ext-win-base   Base of extended decode window in host address\n"
 	     "                   space(x86 only)\n"
 	     "  --ext-win-size   Size of extended decode window in host address\n"
@@ -1965,6 +2315,8 @@ static void usage(char *name)
 	     "        [-c compression] [-b base-address | -a alignment] \\\n"
 	     "        [-p padding size] [-y|--xip if TYPE is FSP]       \\\n"
 	     "        [-j topswap-size] (Intel CPUs only) [--ibb]       \\\n"
+	     "        [--lz4-blocks] (with -c lz4)                      \\\n"
+	     "        [--cost-profile profile] (with -c auto)           \\\n"
 	     "        [--ext-win-base win-base --ext-win-size win-size]     "
 			"Add a component\n"
 	     "                                                         "
@@ -1991,6 +2343,15 @@ static void usage(char *name)
 			"Add a legacy CBFS master header\n"
 	     " remove [-r image,regions] -n NAME                           "
 			"Remove a component\n"
+	     " batch [-r image,regions] [-c compression] [-J jobs] \\\n"
+	     "        -f MANIFEST                                          "
+			"Run add/add-int/remove commands from a\n"
+	     "                                                             "
+			"manifest, writing the image once\n"
+	     " reorder [-r image,regions] -f TRACE                         "
+			"Place files in the order they are listed\n"
+	     "                                                             "
+			"in TRACE (`cbmem --cbfs-trace` output)\n"
 	     " compact -r image,regions                                    "
 			"Defragment CBFS image.\n"
 	     " copy -r image,regions -R source-region                      "
@@ -2019,6 +2380,9 @@ static void usage(char *name)
 	     "  in two possible formats: if their value is greater than\n"
 	     "  0x80000000, they are interpreted as a top-aligned x86 memory\n"
 	     "  address; otherwise, they are treated as an offset into flash.\n"
+	     "COMPRESSION:\n"
+	     "  none, LZMA, LZ4, or auto to add raw files with whichever\n"
+	     "  gives the shortest predicted load time (see --cost-profile)\n"
 	     "ARCHes:\n", name, name
 	    );
 	print_supported_architectures();
@@ -2062,251 +2426,588 @@ static bool valid_opt(size_t i, int c)
 	return false;
 }
 
-int main(int argc, char **argv)
+static int parse_options(size_t i, int argc, char **argv)
 {
-	size_t i;
 	int c;
 
-	if (argc < 3) {
-		usage(argv[0]);
-		return 1;
-	}
-
-	char *image_name = argv[1];
-	char *cmd = argv[2];
-	optind += 2;
-
-	for (i = 0; i < ARRAY_SIZE(commands); i++) {
-		if (strcmp(cmd, commands[i].name) != 0)
-			continue;
-
-		while (1) {
-			char *suffix = NULL;
-			int option_index = 0;
+	while (1) {
+		char *suffix = NULL;
+		int option_index = 0;
 
-			c = getopt_long(argc, argv, commands[i].optstring,
-						long_options, &option_index);
-			if (c == -1) {
-				if (optind < argc) {
-					ERROR("%s: excessive argument -- '%s'"
-						"\n", argv[0], argv[optind]);
-					return 1;
-				}
-				break;
+		c = getopt_long(argc, argv, commands[i].optstring,
+					long_options, &option_index);
+		if (c == -1) {
+			if (optind < argc) {
+				ERROR("%s: excessive argument -- '%s'"
+					"\n", argv[0], argv[optind]);
+				return 1;
 			}
+			break;
+		}
 
-			/* Filter out illegal long options */
-			if (!valid_opt(i, c)) {
-				ERROR("%s: invalid option -- '%d'\n",
-				      argv[0], c);
-				c = '?';
-			}
+		/* Filter out illegal long options */
+		if (!valid_opt(i, c)) {
+			ERROR("%s: invalid option -- '%d'\n",
+			      argv[0], c);
+			c = '?';
+		}
 
-			switch(c) {
-			case 'n':
-				param.name = optarg;
-				break;
-			case 't':
-				if (intfiletype(optarg) != ((uint64_t) - 1))
-					param.type = intfiletype(optarg);
-				else
-					param.type = strtoul(optarg, NULL, 0);
-				if (param.type == 0)
-					WARN("Unknown type '%s' ignored\n",
-							optarg);
-				break;
-			case 'c': {
-				if (strcmp(optarg, "precompression") == 0) {
-					param.precompression = 1;
-					break;
-				}
-				int algo = cbfs_parse_comp_algo(optarg);
-				if (algo >= 0)
-					param.compression = algo;
-				else
-					WARN("Unknown compression '%s' ignored.\n",
-									optarg);
-				break;
-			}
-			case 'A': {
-				if (!vb2_lookup_hash_alg(optarg, &param.hash)) {
-					ERROR("Unknown hash algorithm '%s'.\n",
+		switch(c) {
+		case 'n':
+			param.name = optarg;
+			break;
+		case 't':
+			if (intfiletype(optarg) != ((uint64_t) - 1))
+				param.type = intfiletype(optarg);
+			else
+				param.type = strtoul(optarg, NULL, 0);
+			if (param.type == 0)
+				WARN("Unknown type '%s' ignored\n",
 						optarg);
-					return 1;
-				}
+			break;
+		case 'c': {
+			if (strcmp(optarg, "precompression") == 0) {
+				param.precompression = 1;
 				break;
 			}
-			case 'M':
-				param.fmap = optarg;
-				break;
-			case 'r':
-				param.region_name = optarg;
-				break;
-			case 'R':
-				param.source_region = optarg;
-				break;
-			case 'b':
-				param.baseaddress_input = strtoll(optarg, &suffix, 0);
-				if (!*optarg || (suffix && *suffix)) {
-					ERROR("Invalid base address '%s'.\n",
-						optarg);
-					return 1;
-				}
-				// baseaddress may be zero on non-x86, so we
-				// need an explicit "baseaddress_assigned".
-				param.baseaddress_assigned = 1;
-				break;
-			case 'l':
-				param.loadaddress = strtoull(optarg, &suffix, 0);
-				if (!*optarg || (suffix && *suffix)) {
-					ERROR("Invalid load address '%s'.\n",
-						optarg);
-					return 1;
-				}
-				break;
-			case 'e':
-				param.entrypoint = strtoull(optarg, &suffix, 0);
-				if (!*optarg || (suffix && *suffix)) {
-					ERROR("Invalid entry point '%s'.\n",
-						optarg);
-					return 1;
-				}
-				break;
-			case 's':
-				param.size = strtoul(optarg, &suffix, 0);
-				if (!*optarg) {
-					ERROR("Empty size specified.\n");
-					return 1;
-				}
-				switch (tolower((int)suffix[0])) {
-				case 'k':
-					param.size *= 1024;
-					break;
-				case 'm':
-					param.size *= 1024 * 1024;
-					break;
-				case '\0':
-					break;
-				default:
-					ERROR("Invalid suffix for size '%s'.\n",
-						optarg);
-					return 1;
-				}
-				break;
-			case 'B':
-				param.bootblock = optarg;
-				break;
-			case 'H':
-				param.headeroffset_input = strtoll(optarg, &suffix, 0);
-				if (!*optarg || (suffix && *suffix)) {
-					ERROR("Invalid header offset '%s'.\n",
-						optarg);
-					return 1;
-				}
-				param.headeroffset_assigned = 1;
-				break;
-			case 'a':
-				param.alignment = strtoul(optarg, &suffix, 0);
-				if (!*optarg || (suffix && *suffix)) {
-					ERROR("Invalid alignment '%s'.\n",
-						optarg);
-					return 1;
-				}
-				break;
-			case 'p':
-				param.padding = strtoul(optarg, &suffix, 0);
-				if (!*optarg || (suffix && *suffix)) {
-					ERROR("Invalid pad size '%s'.\n",
-						optarg);
-					return 1;
-				}
-				break;
-			case 'Q':
-				param.force_pow2_pagesize = 1;
-				break;
-			case 'o':
-				param.cbfsoffset_input = strtoll(optarg, &suffix, 0);
-				if (!*optarg || (suffix && *suffix)) {
-					ERROR("Invalid cbfs offset '%s'.\n",
-						optarg);
-					return 1;
-				}
-				param.cbfsoffset_assigned = 1;
-				break;
-			case 'f':
-				param.filename = optarg;
-				break;
-			case 'F':
-				param.force = 1;
-				break;
-			case 'i':
-				param.u64val = strtoull(optarg, &suffix, 0);
-				param.u64val_assigned = 1;
-				if (!*optarg || (suffix && *suffix)) {
-					ERROR("Invalid int parameter '%s'.\n",
-						optarg);
-					return 1;
-				}
-				break;
-			case 'u':
-				param.fill_partial_upward = true;
-				break;
-			case 'd':
-				param.fill_partial_downward = true;
-				break;
-			case 'w':
-				param.show_immutable = true;
-				break;
-			case 'j':
-				param.topswap_size = strtol(optarg, NULL, 0);
-				if (!is_valid_topswap())
-					return 1;
-				break;
-			case 'q':
-				param.ucode_region = optarg;
-				break;
-			case 'v':
-				verbose++;
-				break;
-			case 'm':
-				param.arch = string_to_arch(optarg);
-				break;
-			case 'I':
-				param.initrd = optarg;
-				break;
-			case 'C':
-				param.cmdline = optarg;
-				break;
-			case 'S':
-				param.ignore_sections = optarg;
-				break;
-			case 'y':
-				param.stage_xip = true;
-				break;
-			case 'g':
-				param.autogen_attr = true;
+			if (strcmp(optarg, "auto") == 0) {
+				param.compress_auto = true;
+				param.compression = CBFS_COMPRESS_NONE;
 				break;
+			}
+			int algo = cbfs_parse_comp_algo(optarg);
+			if (algo >= 0) {
+				param.compression = algo;
+				param.compress_auto = false;
+			} else
+				WARN("Unknown compression '%s' ignored.\n",
+								optarg);
+			break;
+		}
+		case 'A': {
+			if (!vb2_lookup_hash_alg(optarg, &param.hash)) {
+				ERROR("Unknown hash algorithm '%s'.\n",
+					optarg);
+				return 1;
+			}
+			break;
+		}
+		case 'M':
+			param.fmap = optarg;
+			break;
+		case 'r':
+			param.region_name = optarg;
+			break;
+		case 'R':
+			param.source_region = optarg;
+			break;
+		case 'b':
+			param.baseaddress_input = strtoll(optarg, &suffix, 0);
+			if (!*optarg || (suffix && *suffix)) {
+				ERROR("Invalid base address '%s'.\n",
+					optarg);
+				return 1;
+			}
+			// baseaddress may be zero on non-x86, so we
+			// need an explicit "baseaddress_assigned".
+			param.baseaddress_assigned = 1;
+			break;
+		case 'l':
+			param.loadaddress = strtoull(optarg, &suffix, 0);
+			if (!*optarg || (suffix && *suffix)) {
+				ERROR("Invalid load address '%s'.\n",
+					optarg);
+				return 1;
+			}
+			break;
+		case 'e':
+			param.entrypoint = strtoull(optarg, &suffix, 0);
+			if (!*optarg || (suffix && *suffix)) {
+				ERROR("Invalid entry point '%s'.\n",
+					optarg);
+				return 1;
+			}
+			break;
+		case 's':
+			param.size = strtoul(optarg, &suffix, 0);
+			if (!*optarg) {
+				ERROR("Empty size specified.\n");
+				return 1;
+			}
+			switch (tolower((int)suffix[0])) {
 			case 'k':
-				param.machine_parseable = true;
+				param.size *= 1024;
 				break;
-			case 'U':
-				param.unprocessed = true;
-				break;
-			case LONGOPT_IBB:
-				param.ibb = true;
+			case 'm':
+				param.size *= 1024 * 1024;
 				break;
-			case LONGOPT_MMAP:
-				if (decode_mmap_arg(optarg))
-					return 1;
+			case '\0':
 				break;
-			case 'h':
-			case '?':
-				usage(argv[0]);
-				return 1;
 			default:
-				break;
+				ERROR("Invalid suffix for size '%s'.\n",
+					optarg);
+				return 1;
+			}
+			break;
+		case 'B':
+			param.bootblock = optarg;
+			break;
+		case 'H':
+			param.headeroffset_input = strtoll(optarg, &suffix, 0);
+			if (!*optarg || (suffix && *suffix)) {
+				ERROR("Invalid header offset '%s'.\n",
+					optarg);
+				return 1;
+			}
+			param.headeroffset_assigned = 1;
+			break;
+		case 'a':
+			param.alignment = strtoul(optarg, &suffix, 0);
+			if (!*optarg || (suffix && *suffix)) {
+				ERROR("Invalid alignment '%s'.\n",
+					optarg);
+				return 1;
+			}
+			break;
+		case 'p':
+			param.padding = strtoul(optarg, &suffix, 0);
+			if (!*optarg || (suffix && *suffix)) {
+				ERROR("Invalid pad size '%s'.\n",
+					optarg);
+				return 1;
+			}
+			break;
+		case 'Q':
+			param.force_pow2_pagesize = 1;
+			break;
+		case 'o':
+			param.cbfsoffset_input = strtoll(optarg, &suffix, 0);
+			if (!*optarg || (suffix && *suffix)) {
+				ERROR("Invalid cbfs offset '%s'.\n",
+					optarg);
+				return 1;
+			}
+			param.cbfsoffset_assigned = 1;
+			break;
+		case 'f':
+			param.filename = optarg;
+			break;
+		case 'F':
+			param.force = 1;
+			break;
+		case 'i':
+			param.u64val = strtoull(optarg, &suffix, 0);
+			param.u64val_assigned = 1;
+			if (!*optarg || (suffix && *suffix)) {
+				ERROR("Invalid int parameter '%s'.\n",
+					optarg);
+				return 1;
+			}
+			break;
+		case 'u':
+			param.fill_partial_upward = true;
+			break;
+		case 'd':
+			param.fill_partial_downward = true;
+			break;
+		case 'w':
+			param.show_immutable = true;
+			break;
+		case 'j':
+			param.topswap_size = strtol(optarg, NULL, 0);
+			if (!is_valid_topswap())
+				return 1;
+			break;
+		case 'q':
+			param.ucode_region = optarg;
+			break;
+		case 'J':
+			param.jobs = strtoul(optarg, &suffix, 0);
+			if (!*optarg || (suffix && *suffix) || !param.jobs) {
+				ERROR("Invalid job count '%s'.\n", optarg);
+				return 1;
 			}
+			break;
+		case 'v':
+			verbose++;
+			break;
+		case 'm':
+			param.arch = string_to_arch(optarg);
+			break;
+		case 'I':
+			param.initrd = optarg;
+			break;
+		case 'C':
+			param.cmdline = optarg;
+			break;
+		case 'S':
+			param.ignore_sections = optarg;
+			break;
+		case 'y':
+			param.stage_xip = true;
+			break;
+		case 'g':
+			param.autogen_attr = true;
+			break;
+		case 'k':
+			param.machine_parseable = true;
+			break;
+		case 'U':
+			param.unprocessed = true;
+			break;
+		case LONGOPT_IBB:
+			param.ibb = true;
+			break;
+		case LONGOPT_MMAP:
+			if (decode_mmap_arg(optarg))
+				return 1;
+			break;
+		case LONGOPT_LZ4_BLOCKS:
+			param.lz4_blocks = true;
+			break;
+		case LONGOPT_COST_PROFILE:
+			if (compress_profile_parse(&param.cost_profile, optarg))
+				return 1;
+			break;
+		case 'h':
+		case '?':
+			usage(argv[0]);
+			return 1;
+		default:
+			break;
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * The batch command runs a manifest of add, add-int and remove commands (one per line, with
+ * the same options as on the command line, '#' starts a comment) against the image region
+ * that was read once by dispatch_command(). The region is only written back if all of them
+ * succeed. Options given to the batch command itself (e.g. -c) are the defaults for all
+ * entries, while -v on an entry only applies to that entry. File reading and compression for
+ * 'add' commands is done up front by a pool of -J worker threads, the results are then handed
+ * to cbfs_add_component() as (precompressed) input so that layout stays sequential and in
+ * manifest order.
+ */
+#define BATCH_MAX_ARGS 32
+
+struct batch_op {
+	size_t command;
+	unsigned int line;
+	struct param param;
+	int verbose;
+	struct buffer input;
+	bool prepared;
+	bool precompressed;
+};
+
+static struct {
+	pthread_mutex_t lock;
+	struct batch_op *ops;
+	size_t num_ops;
+	size_t next_op;
+} batch = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+};
+
+/* The LZMA encoder glue keeps its stream state in static variables. */
+static pthread_mutex_t batch_lzma_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static bool batch_op_can_prepare(const struct batch_op *op)
+{
+	return commands[op->command].function == cbfs_add && !op->param.precompression;
+}
+
+static bool batch_op_can_precompress(const struct batch_op *op)
+{
+	return op->param.compression != CBFS_COMPRESS_NONE && !op->param.compress_auto &&
+	       !op->param.lz4_blocks && op->param.type != CBFS_TYPE_FSP;
+}
+
+/* Read the input of op and compress it if that doesn't depend on the image. */
+static void batch_prepare(struct batch_op *op)
+{
+	struct buffer in;
+	comp_func_ptr compress;
+	int compressed_size;
+	int ret;
+
+	/* Failures are left to the sequential pass, which reports them in order. */
+	if (buffer_from_file(&in, op->param.filename))
+		return;
+
+	if (!batch_op_can_precompress(op)) {
+		op->input = in;
+		op->prepared = true;
+		return;
+	}
+
+	compress = compression_function(op->param.compression);
+	if (!compress || buffer_create(&op->input, in.size + 2 * sizeof(uint32_t),
+				       op->param.filename)) {
+		buffer_delete(&in);
+		return;
+	}
+
+	if (op->param.compression == CBFS_COMPRESS_LZMA)
+		pthread_mutex_lock(&batch_lzma_lock);
+	ret = compress(in.data, in.size, op->input.data + 2 * sizeof(uint32_t),
+		       &compressed_size);
+	if (op->param.compression == CBFS_COMPRESS_LZMA)
+		pthread_mutex_unlock(&batch_lzma_lock);
+
+	if (ret) {
+		buffer_delete(&op->input);
+	} else {
+		write_le32(op->input.data, op->param.compression);
+		write_le32(op->input.data + sizeof(uint32_t), in.size);
+		op->input.size = compressed_size + 2 * sizeof(uint32_t);
+		op->prepared = true;
+		op->precompressed = true;
+	}
+
+	buffer_delete(&in);
+}
+
+static void *batch_worker(unused void *arg)
+{
+	while (1) {
+		struct batch_op *op = NULL;
+
+		pthread_mutex_lock(&batch.lock);
+		while (batch.next_op < batch.num_ops && !op) {
+			if (batch_op_can_prepare(&batch.ops[batch.next_op]))
+				op = &batch.ops[batch.next_op];
+			batch.next_op++;
+		}
+		pthread_mutex_unlock(&batch.lock);
+
+		if (!op)
+			return NULL;
+
+		batch_prepare(op);
+	}
+}
+
+static void batch_run_workers(unsigned int jobs)
+{
+	long num_threads = jobs ? (long)jobs : sysconf(_SC_NPROCESSORS_ONLN);
+	pthread_t threads[64];
+	long i, started = 0;
+
+	/* The calling thread is one of the workers. */
+	num_threads--;
+	if (num_threads < 0)
+		num_threads = 0;
+	if (num_threads > (long)ARRAY_SIZE(threads))
+		num_threads = ARRAY_SIZE(threads);
+
+	batch.next_op = 0;
+	for (i = 0; i < num_threads; i++) {
+		if (pthread_create(&threads[i], NULL, batch_worker, NULL))
+			break;
+		started++;
+	}
+
+	/* Also works through the whole list if no thread could be started. */
+	batch_worker(NULL);
+
+	for (i = 0; i < started; i++)
+		pthread_join(threads[i], NULL);
+}
+
+static int batch_tokenize(char *line, char **argv)
+{
+	int argc = 0;
+
+	while (*line) {
+		while (*line == ' ' || *line == '\t' || *line == '\r')
+			line++;
+		if (!*line || *line == '#')
+			break;
+		if (argc == BATCH_MAX_ARGS)
+			return -1;
+
+		if (*line == '"') {
+			argv[argc++] = ++line;
+			while (*line && *line != '"')
+				line++;
+			if (!*line)
+				return -1;
+		} else {
+			argv[argc++] = line;
+			while (*line && *line != ' ' && *line != '\t' && *line != '\r')
+				line++;
+		}
+		if (*line)
+			*line++ = '\0';
+	}
+
+	argv[argc] = NULL;
+	return argc;
+}
+
+static int batch_parse_op(struct batch_op *op, char *line)
+{
+	char *argv[BATCH_MAX_ARGS + 1];
+	const struct param saved = param;
+	const int saved_verbose = verbose;
+	size_t i;
+	int argc, ret;
+
+	argc = batch_tokenize(line, argv);
+	if (argc < 0) {
+		ERROR("manifest line %u: malformed arguments\n", op->line);
+		return -1;
+	}
+	if (argc == 0)
+		return 0;
+
+	for (i = 0; i < ARRAY_SIZE(commands); i++) {
+		if (strcmp(argv[0], commands[i].name) == 0)
+			break;
+	}
+	if (i == ARRAY_SIZE(commands) || (commands[i].function != cbfs_add &&
+					  commands[i].function != cbfs_add_integer &&
+					  commands[i].function != cbfs_remove)) {
+		ERROR("manifest line %u: '%s' is not supported in a batch\n", op->line,
+		      argv[0]);
+		return -1;
+	}
+	op->command = i;
+
+	/* The -f of the batch command itself must not leak into its entries. */
+	param.filename = NULL;
+
+	/*
+	 * Reinitialize getopt and parse into a fresh copy of the batch-wide parameters.
+	 * optind = 0 is a glibc extension, the BSDs and macOS use optreset instead.
+	 */
+#if defined(__APPLE__) || defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__)
+	optreset = 1;
+	optind = 1;
+#else
+	optind = 0;
+#endif
+	ret = parse_options(i, argc, argv);
+	op->param = param;
+	op->verbose = verbose;
+	param = saved;
+	verbose = saved_verbose;
+
+	if (ret)
+		return -1;
+	if (op->param.region_name != saved.region_name) {
+		ERROR("manifest line %u: -r is not supported in a batch\n", op->line);
+		return -1;
+	}
+
+	return 1;
+}
+
+static int cbfs_batch(void)
+{
+	const struct param saved = param;
+	const int saved_verbose = verbose;
+	struct buffer manifest;
+	char *text, *line, *next;
+	unsigned int line_num = 0;
+	size_t i, max_ops = 1;
+	int ret = 1;
+
+	if (!param.filename) {
+		ERROR("You need to specify -f/--file.\n");
+		return 1;
+	}
+
+	if (buffer_from_file(&manifest, param.filename))
+		return 1;
+	/* Operations keep pointers into the text, so it stays around until the end. */
+	text = strndup(manifest.data, manifest.size);
+	buffer_delete(&manifest);
+	if (!text)
+		return 1;
+
+	for (line = text; *line; line++)
+		if (*line == '\n')
+			max_ops++;
+	batch.ops = calloc(max_ops, sizeof(*batch.ops));
+	batch.num_ops = 0;
+	if (!batch.ops)
+		goto out;
+
+	for (line = text; line; line = next) {
+		struct batch_op *op = &batch.ops[batch.num_ops];
+		int parsed;
+
+		next = strchr(line, '\n');
+		if (next)
+			*next++ = '\0';
+
+		op->line = ++line_num;
+		parsed = batch_parse_op(op, line);
+		if (parsed < 0)
+			goto out;
+		if (parsed > 0)
+			batch.num_ops++;
+	}
+
+	batch_run_workers(saved.jobs);
+
+	for (i = 0; i < batch.num_ops; i++) {
+		struct batch_op *op = &batch.ops[i];
+
+		param = op->param;
+		verbose = op->verbose;
+		if (op->prepared)
+			param.input_buffer = &op->input;
+		if (op->precompressed)
+			param.precompression = 1;
+		if (commands[op->command].function()) {
+			ERROR("manifest line %u: '%s' failed\n", op->line,
+			      commands[op->command].name);
+			goto out;
 		}
+	}
+
+	verbose = saved_verbose;
+	INFO("Processed %zu manifest entries\n", batch.num_ops);
+	ret = 0;
+
+out:
+	param = saved;
+	verbose = saved_verbose;
+	for (i = 0; batch.ops && i < batch.num_ops; i++)
+		buffer_delete(&batch.ops[i].input);
+	free(batch.ops);
+	batch.ops = NULL;
+	free(text);
+	return ret;
+}
+
+int main(int argc, char **argv)
+{
+	size_t i;
+
+	if (argc < 3) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	compress_profile_default(&param.cost_profile);
+
+	char *image_name = argv[1];
+	char *cmd = argv[2];
+	optind += 2;
+
+	for (i = 0; i < ARRAY_SIZE(commands); i++) {
+		if (strcmp(cmd, commands[i].name) != 0)
+			continue;
+
+		if (parse_options(i, argc, argv))
+			return 1;
 
 		if (commands[i].function == cbfs_create) {
 			if (param.fmap) {
@@ -164,6 +164,14 @@ typedef int (*decomp_func_ptr) (char *in, int in_len, char *out, int out_len,
 comp_func_ptr compression_function(enum cbfs_compression algo);
 decomp_func_ptr decompression_function(enum cbfs_compression algo);
 
+/* Compress with LZ4 into a frame of independent blocks small enough that there are at most
+ * CBFS_LZ4_BLOCKS_MAX of them, and return the block size and the offset of each block
+ * header for use in a cbfs_file_attr_lz4_blocks attribute.
+ * Returns 0 on success, non-zero otherwise.
+ */
+int lz4_compress_indexed(char *in, int in_len, char *out, int *out_len,
+			 uint32_t *block_size, uint32_t *offsets, uint32_t *num_blocks);
+
 uint64_t intfiletype(const char *name);
 
 /* cbfs-mkpayload.c */
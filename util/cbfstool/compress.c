@@ -5,15 +5,17 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include "common.h"
+#include <commonlib/endian.h>
 #include "lz4/lib/lz4frame.h"
 #include <commonlib/bsd/compression.h>
 
-static int lz4_compress(char *in, int in_len, char *out, int *out_len)
+static int do_lz4_compress(char *in, int in_len, char *out, int *out_len,
+			   LZ4F_blockSizeID_t block_size_id)
 {
 	LZ4F_preferences_t prefs = {
 		.compressionLevel = 20,
 		.frameInfo = {
-			.blockSizeID = max4MB,
+			.blockSizeID = block_size_id,
 			.blockMode = blockIndependent,
 			.contentChecksumFlag = noContentChecksum,
 		},
@@ -32,6 +34,69 @@ static int lz4_compress(char *in, int in_len, char *out, int *out_len)
 	return 0;
 }
 
+static int lz4_compress(char *in, int in_len, char *out, int *out_len)
+{
+	return do_lz4_compress(in, in_len, out, out_len, max4MB);
+}
+
+/* Walks the blocks of an LZ4F frame and records the offset of each block header. */
+static int lz4_frame_block_offsets(const uint8_t *frame, size_t size,
+				   uint32_t *offsets, uint32_t max_blocks)
+{
+	size_t offset = 4 + 1 + 1 + 1;	/* magic, FLG, BD, HC */
+	uint32_t num_blocks = 0;
+
+	if (size < offset)
+		return -1;
+	if (frame[4] & 0x08)		/* content size present */
+		offset += sizeof(uint64_t);
+	if (frame[4] & 0x10) {		/* block checksums not supported */
+		ERROR("LZ4 block checksums cannot be indexed\n");
+		return -1;
+	}
+
+	while (offset + sizeof(uint32_t) <= size) {
+		uint32_t bh = read_le32(frame + offset);
+		if (!bh)
+			return num_blocks;	/* EndMark */
+		if (num_blocks == max_blocks)
+			return -1;
+		offsets[num_blocks++] = offset;
+		offset += sizeof(uint32_t) + (bh & 0x7fffffff);
+	}
+
+	return -1;
+}
+
+int lz4_compress_indexed(char *in, int in_len, char *out, int *out_len,
+			 uint32_t *block_size, uint32_t *offsets, uint32_t *num_blocks)
+{
+	LZ4F_blockSizeID_t id;
+
+	/* Pick the smallest LZ4F block size whose index still fits the attribute. */
+	for (id = max64KB; id <= max4MB; id++) {
+		*block_size = 1U << (2 * id + 8);
+		if (DIV_ROUND_UP((size_t)in_len, *block_size) <= CBFS_LZ4_BLOCKS_MAX)
+			break;
+	}
+	if (id > max4MB) {
+		ERROR("File too large for an LZ4 block index (%d bytes)\n", in_len);
+		return -1;
+	}
+
+	if (do_lz4_compress(in, in_len, out, out_len, id))
+		return -1;
+
+	int ret = lz4_frame_block_offsets((uint8_t *)out, *out_len, offsets,
+					  CBFS_LZ4_BLOCKS_MAX);
+	if (ret < 0) {
+		ERROR("Failed to index LZ4 frame\n");
+		return -1;
+	}
+	*num_blocks = ret;
+	return 0;
+}
+
 static int lz4_decompress(char *in, int in_len, char *out, int out_len,
 			  size_t *actual_size)
 {
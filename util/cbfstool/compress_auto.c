@@ -0,0 +1,196 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "common.h"
+#include "cbfs_image.h"
+#include "compress_auto.h"
+
+struct candidate {
+	enum cbfs_compression algo;
+	char *in;
+	int in_len;
+	char *out;
+	int out_len;
+	int ret;
+	double read_us;
+	double decode_us;
+	pthread_t thread;
+	bool threaded;
+};
+
+static const char *algo_name(enum cbfs_compression algo)
+{
+	const struct typedesc_t *desc;
+
+	for (desc = types_cbfs_compression; desc->name; desc++)
+		if (desc->type == algo)
+			return desc->name;
+	return "?";
+}
+
+void compress_profile_default(struct compress_profile *profile)
+{
+	memset(profile, 0, sizeof(*profile));
+	profile->media_bw = 20;
+	profile->decode_bw[CBFS_COMPRESS_LZMA] = 40;
+	profile->decode_bw[CBFS_COMPRESS_LZ4] = 400;
+}
+
+int compress_profile_parse(struct compress_profile *profile, const char *spec)
+{
+	char *copy = strdup(spec);
+	char *saveptr = NULL;
+	char *item;
+	int ret = 0;
+
+	if (!copy)
+		return -1;
+
+	for (item = strtok_r(copy, ",", &saveptr); item;
+	     item = strtok_r(NULL, ",", &saveptr)) {
+		char *value = strchr(item, '=');
+		char *end;
+		double number;
+		int algo;
+
+		if (!value) {
+			ERROR("Cost profile entry '%s' is not key=value\n", item);
+			ret = -1;
+			break;
+		}
+		*value++ = '\0';
+
+		number = strtod(value, &end);
+		if (end == value || *end != '\0' || number < 0) {
+			ERROR("Invalid value '%s' for cost profile key '%s'\n", value, item);
+			ret = -1;
+			break;
+		}
+
+		if (!strcmp(item, "media")) {
+			if (number == 0) {
+				ERROR("Media bandwidth must not be 0\n");
+				ret = -1;
+				break;
+			}
+			profile->media_bw = number;
+		} else if (!strcmp(item, "min_free")) {
+			profile->min_free = number;
+		} else if ((algo = cbfs_parse_comp_algo(item)) > CBFS_COMPRESS_NONE &&
+			   algo < COMPRESS_AUTO_ALGOS) {
+			profile->decode_bw[algo] = number;
+		} else {
+			ERROR("Unknown cost profile key '%s'\n", item);
+			ret = -1;
+			break;
+		}
+	}
+
+	free(copy);
+	return ret;
+}
+
+static void *compress_candidate(void *arg)
+{
+	struct candidate *c = arg;
+	comp_func_ptr compress = compression_function(c->algo);
+
+	c->ret = -1;
+	c->out = malloc(c->in_len);
+	if (compress && c->out)
+		c->ret = compress(c->in, c->in_len, c->out, &c->out_len);
+
+	return NULL;
+}
+
+int compress_auto(const struct compress_profile *profile, const char *name,
+		  char *in, int in_len, size_t space,
+		  enum cbfs_compression *algo, char **out, int *out_len)
+{
+	struct candidate candidates[COMPRESS_AUTO_ALGOS];
+	struct candidate *best = NULL, *smallest = NULL;
+	size_t i;
+
+	memset(candidates, 0, sizeof(candidates));
+
+	/* Uncompressed is always an option; it only costs the read. */
+	candidates[CBFS_COMPRESS_NONE].algo = CBFS_COMPRESS_NONE;
+	candidates[CBFS_COMPRESS_NONE].out_len = in_len;
+
+	for (i = CBFS_COMPRESS_NONE + 1; i < ARRAY_SIZE(candidates); i++) {
+		struct candidate *c = &candidates[i];
+
+		c->algo = i;
+		c->in = in;
+		c->in_len = in_len;
+		c->ret = -1;
+		if (!profile->decode_bw[i])
+			continue;
+
+		if (pthread_create(&c->thread, NULL, compress_candidate, c) == 0)
+			c->threaded = true;
+		else
+			compress_candidate(c);
+	}
+
+	for (i = 0; i < ARRAY_SIZE(candidates); i++)
+		if (candidates[i].threaded)
+			pthread_join(candidates[i].thread, NULL);
+
+	printf("Compression for '%s' (%d bytes, media %g MB/s):\n", name, in_len,
+	       profile->media_bw);
+
+	for (i = 0; i < ARRAY_SIZE(candidates); i++) {
+		struct candidate *c = &candidates[i];
+
+		if (i != CBFS_COMPRESS_NONE && c->ret)
+			continue;
+
+		c->read_us = c->out_len / profile->media_bw;
+		if (i != CBFS_COMPRESS_NONE)
+			c->decode_us = in_len / profile->decode_bw[i];
+
+		if ((size_t)c->out_len > space)
+			continue;
+
+		if (!smallest || c->out_len < smallest->out_len)
+			smallest = c;
+		if (space - c->out_len < profile->min_free)
+			continue;
+		if (!best || c->read_us + c->decode_us < best->read_us + best->decode_us)
+			best = c;
+	}
+
+	if (!best)
+		best = smallest;
+
+	for (i = 0; i < ARRAY_SIZE(candidates); i++) {
+		const struct candidate *c = &candidates[i];
+
+		if (i != CBFS_COMPRESS_NONE && c->ret)
+			continue;
+
+		printf("  %-5s %10d bytes %10.0f us read + %8.0f us decode = %10.0f us%s\n",
+		       algo_name(c->algo),
+		       c->out_len, c->read_us, c->decode_us, c->read_us + c->decode_us,
+		       c == best ? "  <- selected" : "");
+	}
+
+	for (i = 0; i < ARRAY_SIZE(candidates); i++)
+		if (&candidates[i] != best)
+			free(candidates[i].out);
+
+	if (!best) {
+		ERROR("No compression of '%s' fits into %zu bytes\n", name, space);
+		return -1;
+	}
+
+	*algo = best->algo;
+	*out = best->out;
+	*out_len = best->out_len;
+
+	return 0;
+}
@@ -0,0 +1,48 @@
+/* cost-model-driven compression selection for cbfstool */
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#ifndef COMPRESS_AUTO_H_
+#define COMPRESS_AUTO_H_
+
+#include <stddef.h>
+#include <commonlib/bsd/compression.h>
+#include <commonlib/bsd/cbfs_serialized.h>
+
+#define COMPRESS_AUTO_ALGOS (CBFS_COMPRESS_LZ4 + 1)
+
+/*
+ * Describes how fast a board can get a file off its boot medium and decompress it. All
+ * bandwidths are in MB/s (= bytes per microsecond). A decode bandwidth of 0 means that the
+ * firmware loading the file can't decompress that algorithm, so it is never picked.
+ */
+struct compress_profile {
+	double media_bw;
+	double decode_bw[COMPRESS_AUTO_ALGOS];
+	/* Only pick a larger but faster result if this much CBFS space stays free. */
+	size_t min_free;
+};
+
+/* Fills in the default profile: memory-mapped SPI flash and a fast x86 core. */
+void compress_profile_default(struct compress_profile *profile);
+
+/*
+ * Updates |profile| from a comma-separated list of key=value pairs, e.g.
+ * "media=25,lz4=500,lzma=0,min_free=65536". Returns 0 on success.
+ */
+int compress_profile_parse(struct compress_profile *profile, const char *spec);
+
+/*
+ * Compresses |in| with every algorithm enabled in |profile|, in parallel threads, and picks
+ * the result with the lowest predicted load time (stored size / media bandwidth + decoded
+ * size / decode bandwidth) that leaves at least profile->min_free of the |space| bytes that
+ * are available for the file. If none does, the smallest result that fits is used. Prints
+ * the predicted load time of every candidate.
+ *
+ * On success, returns 0 and the winner in |*algo|. For anything but CBFS_COMPRESS_NONE,
+ * |*out| is a malloc()ed buffer of |*out_len| bytes that the caller must free.
+ */
+int compress_auto(const struct compress_profile *profile, const char *name,
+		  char *in, int in_len, size_t space,
+		  enum cbfs_compression *algo, char **out, int *out_len);
+
+#endif
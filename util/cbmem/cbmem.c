@@ -21,7 +21,11 @@
 #include <commonlib/bsd/cbmem_id.h>
 #include <commonlib/bsd/ipchksum.h>
 #include <commonlib/bsd/tpm_log_defs.h>
+#include <commonlib/boot_profile_serialized.h>
+#include <commonlib/cbfs_cache_stats_serialized.h>
+#include <commonlib/cbfs_trace_serialized.h>
 #include <commonlib/loglevel.h>
+#include <commonlib/printk_token_serialized.h>
 #include <commonlib/timestamp_serialized.h>
 #include <commonlib/tpm_log_serialized.h>
 #include <commonlib/coreboot_tables.h>
@@ -1095,6 +1099,304 @@ static void dump_tpm_log(void)
 		dump_tpm_cb_log();
 }
 
+/*
+ * Dump the CBFS access trace as tab-separated lines in access order, so that it can be fed
+ * to `cbfstool reorder` or any spreadsheet/awk script.
+ */
+static void dump_cbfs_trace(void)
+{
+	const struct cbfs_trace_table *table;
+	struct mapping trace_mapping;
+	uint64_t start;
+	size_t size;
+	uint32_t num_entries;
+
+	if (find_cbmem_entry(CBMEM_ID_CBFS_TRACE, &start, &size)) {
+		fprintf(stderr, "No CBFS trace found in CBMEM.\n");
+		return;
+	}
+
+	table = map_memory(&trace_mapping, start, size);
+	if (!table)
+		die("Unable to map CBFS trace\n");
+
+	num_entries = table->num_entries;
+	if (sizeof(*table) + (uint64_t)num_entries * sizeof(table->entries[0]) > size) {
+		fprintf(stderr, "CBFS trace is truncated.\n");
+		num_entries = (size - sizeof(*table)) / sizeof(table->entries[0]);
+	}
+
+	printf("# stage\tname\toffset\tsize\tdecompressed\tcompression\t"
+	       "read_us\tdecompress_us\tflags\n");
+
+	for (uint32_t i = 0; i < num_entries; i++) {
+		const struct cbfs_trace_entry *e = &table->entries[i];
+
+		printf("%.*s\t%.*s\t0x%x\t%u\t%u\t%u\t%u\t%u\t%s%s%s%s%s\n",
+		       (int)sizeof(e->stage), e->stage, (int)sizeof(e->name), e->name,
+		       e->offset, e->size, e->decompressed_size, e->compression,
+		       e->read_us, e->decompress_us,
+		       e->flags ? "" : "-",
+		       e->flags & CBFS_TRACE_FLAG_PRELOADED ? "P" : "",
+		       e->flags & CBFS_TRACE_FLAG_STAGE ? "S" : "",
+		       e->flags & CBFS_TRACE_FLAG_MAPPED ? "M" : "",
+		       e->flags & CBFS_TRACE_FLAG_FAILED ? "F" : "");
+	}
+
+	if (table->num_entries == table->max_entries)
+		fprintf(stderr, "CBFS trace is full, later accesses were not recorded.\n");
+
+	unmap_memory(&trace_mapping);
+}
+
+static void dump_cbfs_cache_stats(void)
+{
+	const struct cbfs_cache_stats_table *table;
+	struct mapping stats_mapping;
+	uint64_t start;
+	size_t size;
+
+	if (find_cbmem_entry(CBMEM_ID_CBFS_CACHE_STATS, &start, &size))
+		return;
+
+	if (size < sizeof(*table)) {
+		fprintf(stderr, "CBFS cache statistics are truncated.\n");
+		return;
+	}
+
+	table = map_memory(&stats_mapping, start, size);
+	if (!table)
+		die("Unable to map CBFS cache statistics\n");
+
+	printf("# stage\tsize\thigh_water\tpeak_allocs\tfailed\tfragmented\t"
+	       "used\tlargest_free\n");
+
+	for (uint32_t i = 0; i < MIN(table->num_entries, ARRAY_SIZE(table->entries)); i++) {
+		const struct cbfs_cache_stats_entry *e = &table->entries[i];
+
+		printf("# %.*s\t%u\t%u\t%u\t%u\t%u\t%u\t%u\n",
+		       (int)sizeof(e->stage), e->stage, e->size, e->high_water,
+		       e->peak_allocs, e->failed_allocs, e->fragmented_failures,
+		       e->used, e->largest_free);
+	}
+
+	unmap_memory(&stats_mapping);
+}
+
+enum boot_profile_print_type {
+	BOOT_PROFILE_PRINT_NONE = 0,
+	BOOT_PROFILE_PRINT_FOLDED,
+	BOOT_PROFILE_PRINT_SUMMARY,
+};
+
+struct boot_profile {
+	const struct boot_profile_entry *entries;
+	uint32_t num_entries;
+	int64_t *self_us;	/* Duration minus the children that ran on the same thread */
+};
+
+static const char *boot_profile_suffix(const struct boot_profile_entry *e)
+{
+	switch (e->type) {
+	case BOOT_PROFILE_DEV_INIT:
+		return " init";
+	case BOOT_PROFILE_DEV_ENABLE:
+		return " enable";
+	case BOOT_PROFILE_DEV_FINAL:
+		return " final";
+	default:
+		return "";
+	}
+}
+
+/* An entry's parent, or BOOT_PROFILE_NO_PARENT. Parents always come first. */
+static uint32_t boot_profile_parent(const struct boot_profile *prof, uint32_t i)
+{
+	const uint32_t parent = prof->entries[i].parent;
+
+	return parent < i ? parent : BOOT_PROFILE_NO_PARENT;
+}
+
+static void print_boot_profile_frame(const struct boot_profile_entry *e)
+{
+	if (e->name[0])
+		printf("%.*s%s", (int)sizeof(e->name), e->name, boot_profile_suffix(e));
+	else
+		printf("0x%" PRIx64 "%s", e->addr, boot_profile_suffix(e));
+}
+
+static void print_boot_profile_stack(const struct boot_profile *prof, uint32_t i)
+{
+	const struct boot_profile_entry *e = &prof->entries[i];
+	const uint32_t parent = boot_profile_parent(prof, i);
+
+	if (parent == BOOT_PROFILE_NO_PARENT) {
+		printf("ramstage;");
+	} else {
+		print_boot_profile_stack(prof, parent);
+		printf(";");
+	}
+
+	if (e->thread && (parent == BOOT_PROFILE_NO_PARENT ||
+			  prof->entries[parent].thread != e->thread))
+		printf("thread %u;", e->thread);
+
+	print_boot_profile_frame(e);
+}
+
+/*
+ * Print one line per entry with the entry's self time in microseconds, prefixed by the
+ * names of all enclosing entries, as expected by flame graph tools. Entries of other
+ * cooperative threads get an extra "thread N" frame, their time overlaps the main thread.
+ */
+static void dump_boot_profile_folded(const struct boot_profile *prof)
+{
+	for (uint32_t i = 0; i < prof->num_entries; i++) {
+		if (prof->self_us[i] <= 0)
+			continue;
+		print_boot_profile_stack(prof, i);
+		printf(" %" PRId64 "\n", prof->self_us[i]);
+	}
+}
+
+/* The longest child of an entry, on any thread, or BOOT_PROFILE_NO_PARENT. */
+static uint32_t boot_profile_longest_child(const struct boot_profile *prof, uint32_t i)
+{
+	uint32_t longest = BOOT_PROFILE_NO_PARENT;
+
+	for (uint32_t j = i + 1; j < prof->num_entries; j++) {
+		if (boot_profile_parent(prof, j) != i)
+			continue;
+		if (longest == BOOT_PROFILE_NO_PARENT ||
+		    prof->entries[j].duration_us > prof->entries[longest].duration_us)
+			longest = j;
+	}
+
+	return longest;
+}
+
+/* qsort() has no argument for the comparison function. */
+static const int64_t *sort_self_us;
+
+static int compare_self_us(const void *a, const void *b)
+{
+	const int64_t sa = sort_self_us[*(const uint32_t *)a];
+	const int64_t sb = sort_self_us[*(const uint32_t *)b];
+
+	return sa < sb ? 1 : sa > sb ? -1 : 0;
+}
+
+/*
+ * Print the time spent in each boot state and the chain of longest nested entries in
+ * it. Boot states run one after the other, so together these chains are the critical
+ * path of ramstage, down to the callback or device that dominates each state. Then list
+ * the entries with the most self time and the time threads spent blocked.
+ */
+static void dump_boot_profile_summary(const struct boot_profile *prof)
+{
+	const size_t top = MIN(prof->num_entries, 20);
+	uint64_t total_us = 0, blocked_us = 0;
+	uint32_t *order;
+
+	for (uint32_t i = 0; i < prof->num_entries; i++) {
+		const struct boot_profile_entry *e = &prof->entries[i];
+
+		if (e->type == BOOT_PROFILE_STATE)
+			total_us += e->duration_us;
+		else if (e->type == BOOT_PROFILE_BLOCKED)
+			blocked_us += e->duration_us;
+	}
+
+	printf("Critical path (%" PRIu64 " us in boot states):\n", total_us);
+	for (uint32_t i = 0; i < prof->num_entries; i++) {
+		const struct boot_profile_entry *e = &prof->entries[i];
+
+		if (e->type != BOOT_PROFILE_STATE)
+			continue;
+
+		printf("  %-20.*s %10u us %5.1f%%%s", (int)sizeof(e->name), e->name,
+		       e->duration_us, total_us ? 100.0 * e->duration_us / total_us : 0.0,
+		       e->flags & BOOT_PROFILE_FLAG_OPEN ? " (not finished)" : "");
+
+		for (uint32_t j = boot_profile_longest_child(prof, i);
+		     j != BOOT_PROFILE_NO_PARENT; j = boot_profile_longest_child(prof, j)) {
+			printf(" > ");
+			print_boot_profile_frame(&prof->entries[j]);
+			printf(" (%u us)", prof->entries[j].duration_us);
+		}
+		printf("\n");
+	}
+
+	order = malloc(prof->num_entries * sizeof(*order));
+	if (!order)
+		die("Unable to allocate memory\n");
+	for (uint32_t i = 0; i < prof->num_entries; i++)
+		order[i] = i;
+	sort_self_us = prof->self_us;
+	qsort(order, prof->num_entries, sizeof(*order), compare_self_us);
+
+	printf("\nMost self time:\n");
+	for (size_t i = 0; i < top && prof->self_us[order[i]] > 0; i++) {
+		printf("  %10" PRId64 " us  ", prof->self_us[order[i]]);
+		print_boot_profile_stack(prof, order[i]);
+		printf("\n");
+	}
+
+	printf("\nThreads blocked in thread_join()/mutexes: %" PRIu64 " us\n", blocked_us);
+
+	free(order);
+}
+
+static void dump_boot_profile(enum boot_profile_print_type type)
+{
+	const struct boot_profile_table *table;
+	struct mapping profile_mapping;
+	struct boot_profile prof;
+	uint64_t start;
+	size_t size;
+
+	if (find_cbmem_entry(CBMEM_ID_BOOT_PROFILE, &start, &size)) {
+		fprintf(stderr, "No boot profile found in CBMEM.\n");
+		return;
+	}
+
+	table = map_memory(&profile_mapping, start, size);
+	if (!table)
+		die("Unable to map boot profile\n");
+
+	prof.entries = table->entries;
+	prof.num_entries = table->num_entries;
+	if (sizeof(*table) + (uint64_t)prof.num_entries * sizeof(table->entries[0]) > size) {
+		fprintf(stderr, "Boot profile is truncated.\n");
+		prof.num_entries = (size - sizeof(*table)) / sizeof(table->entries[0]);
+	}
+
+	prof.self_us = calloc(prof.num_entries + 1, sizeof(*prof.self_us));
+	if (!prof.self_us)
+		die("Unable to allocate memory\n");
+
+	for (uint32_t i = 0; i < prof.num_entries; i++) {
+		const uint32_t parent = boot_profile_parent(&prof, i);
+
+		prof.self_us[i] += prof.entries[i].duration_us;
+		if (parent != BOOT_PROFILE_NO_PARENT &&
+		    prof.entries[parent].thread == prof.entries[i].thread)
+			prof.self_us[parent] -= prof.entries[i].duration_us;
+	}
+
+	if (type == BOOT_PROFILE_PRINT_FOLDED)
+		dump_boot_profile_folded(&prof);
+	else
+		dump_boot_profile_summary(&prof);
+
+	if (table->dropped)
+		fprintf(stderr, "Boot profile is full, %u entries were not recorded.\n",
+			table->dropped);
+
+	free(prof.self_us);
+	unmap_memory(&profile_mapping);
+}
+
 struct cbmem_console {
 	u32 size;
 	u32 cursor;
@@ -1133,6 +1435,408 @@ static int parse_loglevel(char *arg, int *print_unknown_logs)
 	return BIOS_NEVER;
 }
 
+struct printk_token {
+	uint32_t token;
+	const char *fmt;
+};
+
+static struct printk_token *printk_tokens;
+static size_t num_printk_tokens;
+
+static int printk_token_cmp(const void *a, const void *b)
+{
+	const struct printk_token *ta = a, *tb = b;
+
+	if (ta->token != tb->token)
+		return ta->token < tb->token ? -1 : 1;
+	/* Keep the order of the file for equal tokens, so the first one wins. */
+	return ta->fmt < tb->fmt ? -1 : ta->fmt > tb->fmt;
+}
+
+/* Read the NUL-separated format strings collected by the build into printk_tokens.db. */
+static void load_printk_tokens(const char *filename)
+{
+	struct stat st;
+	size_t i, n = 0;
+	char *db;
+	FILE *f;
+
+	f = fopen(filename, "rb");
+	if (!f || fstat(fileno(f), &st)) {
+		fprintf(stderr, "Failed to open %s: %s\n", filename, strerror(errno));
+		exit(1);
+	}
+
+	db = malloc(st.st_size + 1);
+	printk_tokens = malloc((st.st_size / 2 + 1) * sizeof(*printk_tokens));
+	if (!db || !printk_tokens)
+		die("Not enough memory for printk tokens.\n");
+	if (fread(db, 1, st.st_size, f) != (size_t)st.st_size)
+		die("Failed to read printk tokens.\n");
+	fclose(f);
+	db[st.st_size] = '\0';
+
+	for (i = 0; i < (size_t)st.st_size; i += strlen(&db[i]) + 1) {
+		if (!db[i])
+			continue;
+		printk_tokens[n].fmt = &db[i];
+		printk_tokens[n].token = printk_token_hash(&db[i], strlen(&db[i]));
+		n++;
+	}
+
+	qsort(printk_tokens, n, sizeof(*printk_tokens), printk_token_cmp);
+
+	/* Duplicates, from several stages or several calls with the same string. */
+	num_printk_tokens = MIN(n, (size_t)1);
+	for (i = 1; i < n; i++) {
+		const struct printk_token *last = &printk_tokens[num_printk_tokens - 1];
+
+		if (last->token == printk_tokens[i].token) {
+			if (strcmp(last->fmt, printk_tokens[i].fmt))
+				debug("printk token %08x collision: \"%s\"\n",
+				      printk_tokens[i].token, printk_tokens[i].fmt);
+			continue;
+		}
+		printk_tokens[num_printk_tokens++] = printk_tokens[i];
+	}
+}
+
+static const char *find_printk_token(uint32_t token)
+{
+	size_t lo = 0, hi = num_printk_tokens;
+
+	while (lo < hi) {
+		const size_t mid = (lo + hi) / 2;
+		const struct printk_token *t = &printk_tokens[mid];
+
+		if (t->token == token)
+			return t->fmt;
+		if (t->token < token)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return NULL;
+}
+
+struct printk_record {
+	const uint8_t *data;
+	size_t size;
+	size_t pos;
+	uint64_t types;
+};
+
+static bool record_varint(struct printk_record *rec, uint64_t *val)
+{
+	int shift = 0;
+
+	*val = 0;
+	while (rec->pos < rec->size && shift < 64) {
+		const uint8_t b = rec->data[rec->pos++];
+
+		*val |= (uint64_t)(b & 0x7f) << shift;
+		if (!(b & 0x80))
+			return true;
+		shift += 7;
+	}
+
+	return false;
+}
+
+/* The next argument and its PRINTK_ARG_* type, PRINTK_ARG_NONE if there's none left. */
+static unsigned int record_arg(struct printk_record *rec, uint64_t *val, const char **str)
+{
+	const unsigned int type = rec->types & ((1 << PRINTK_ARG_BITS) - 1);
+
+	rec->types >>= PRINTK_ARG_BITS;
+	if (type == PRINTK_ARG_NONE || !record_varint(rec, val))
+		return PRINTK_ARG_NONE;
+
+	if (type == PRINTK_ARG_STRING) {
+		if (*val > rec->size - rec->pos)
+			return PRINTK_ARG_NONE;
+		*str = (const char *)&rec->data[rec->pos];
+		rec->pos += *val;
+	}
+
+	return type;
+}
+
+static size_t decode_base64(const char *in, size_t len, uint8_t *out, size_t out_size)
+{
+	static const char digits[] =
+		"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+	size_t i, j, n = 0;
+	uint32_t v;
+
+	if (len % 4 || len / 4 * 3 > out_size)
+		return 0;
+
+	for (i = 0; i < len; i += 4) {
+		v = 0;
+		for (j = 0; j < 4; j++) {
+			const char *p = strchr(digits, in[i + j]);
+
+			if (in[i + j] == '=' && i + 4 == len && j >= 2)
+				p = digits;
+			else if (!p || !in[i + j])
+				return 0;
+			v = v << 6 | (p - digits);
+		}
+		out[n++] = v >> 16;
+		if (in[i + 2] != '=')
+			out[n++] = v >> 8;
+		if (in[i + 3] != '=')
+			out[n++] = v;
+	}
+
+	return n;
+}
+
+/*
+ * Print one argument like vtxprintf() in coreboot does. spec holds the '%', flags, width
+ * and precision, the length modifier and conversion are added here.
+ */
+static void print_printk_arg(FILE *out, char *spec, char conv, int qualifier,
+			     struct printk_record *rec)
+{
+	const size_t spec_len = strlen(spec);
+	const char *str = NULL;
+	unsigned int type;
+	uint64_t val;
+	char *s;
+
+	type = record_arg(rec, &val, &str);
+	if (type == PRINTK_ARG_NONE) {
+		fputs("<missing>", out);
+		return;
+	}
+
+	if ((conv == 's') != (type == PRINTK_ARG_STRING)) {
+		fputs("<?>", out);
+		return;
+	}
+
+	switch (conv) {
+	case 's':
+		s = strndup(str, val);
+		if (!s)
+			die("Not enough memory for printk argument.\n");
+		strcpy(&spec[spec_len], "s");
+		fprintf(out, spec, s);
+		free(s);
+		break;
+	case 'c':
+		strcpy(&spec[spec_len], "c");
+		fprintf(out, spec, (unsigned char)val);
+		break;
+	case 'p':
+		/* Padded to 32 bits, unless there's a width or precision. */
+		fputs("0x", out);
+		strcpy(&spec[spec_len], spec_len == 1 ? ".8llx" : "llx");
+		fprintf(out, spec, (unsigned long long)val);
+		break;
+	case 'd':
+	case 'i':
+		if (type == PRINTK_ARG_32)
+			val = (int32_t)val;
+		if (qualifier == 'h')
+			val = (short)val;
+		else if (qualifier == 'H')
+			val = (signed char)val;
+		strcpy(&spec[spec_len], "lld");
+		fprintf(out, spec, (long long)val);
+		break;
+	default:
+		if (qualifier == 'h')
+			val = (unsigned short)val;
+		else if (qualifier == 'H')
+			val = (unsigned char)val;
+		snprintf(&spec[spec_len], 4, "ll%c", conv);
+		fprintf(out, spec, (unsigned long long)val);
+	}
+}
+
+/* The width or precision at fmt, '*' takes it from the next argument. */
+static const char *printk_spec_number(const char *fmt, char *spec, struct printk_record *rec)
+{
+	const char *unused;
+	uint64_t val;
+	size_t n;
+
+	if (*fmt == '*') {
+		if (record_arg(rec, &val, &unused) == PRINTK_ARG_32)
+			snprintf(&spec[strlen(spec)], 12, "%d", (int32_t)val);
+		return fmt + 1;
+	}
+
+	n = MIN(strspn(fmt, "0123456789"), (size_t)8);
+	strncat(spec, fmt, n);
+	return fmt + strspn(fmt, "0123456789");
+}
+
+/* Expand the record of a tokenized printk() with its format string. */
+static bool print_printk_record(FILE *out, const char *b64, size_t len)
+{
+	uint8_t data[PRINTK_TOKEN_MAX_RECORD];
+	struct printk_record rec = { .data = data };
+	const char *fmt, *unused;
+	char spec[40];
+	int qualifier;
+	uint64_t val;
+	size_t n;
+
+	rec.size = decode_base64(b64, len, data, sizeof(data));
+	if (rec.size < 4)
+		return false;
+
+	fmt = find_printk_token(data[0] | data[1] << 8 | data[2] << 16 |
+				(uint32_t)data[3] << 24);
+	rec.pos = 4;
+	if (!fmt || !record_varint(&rec, &rec.types))
+		return false;
+
+	for (; *fmt; fmt++) {
+		if (*fmt != '%') {
+			fputc(*fmt, out);
+			continue;
+		}
+
+		fmt++;
+		n = MIN(strspn(fmt, "-+ #0"), (size_t)5);
+		spec[0] = '%';
+		memcpy(&spec[1], fmt, n);
+		spec[n + 1] = '\0';
+		fmt += strspn(fmt, "-+ #0");
+
+		fmt = printk_spec_number(fmt, spec, &rec);
+		if (*fmt == '.') {
+			strcat(spec, ".");
+			fmt = printk_spec_number(fmt + 1, spec, &rec);
+		}
+
+		qualifier = -1;
+		if (*fmt && strchr("hlLzj", *fmt)) {
+			qualifier = *fmt++;
+			if (*fmt == 'l') {
+				qualifier = 'L';
+				fmt++;
+			}
+			if (*fmt == 'h') {
+				qualifier = 'H';
+				fmt++;
+			}
+		}
+
+		switch (*fmt) {
+		case '%':
+			fputc('%', out);
+			break;
+		case 'n':
+			record_arg(&rec, &val, &unused);
+			break;
+		case 'c':
+		case 's':
+		case 'p':
+		case 'd':
+		case 'i':
+		case 'u':
+		case 'x':
+		case 'X':
+		case 'o':
+			print_printk_arg(out, spec, *fmt, qualifier, &rec);
+			break;
+		default:
+			fputc('%', out);
+			if (!*fmt)
+				return true;
+			fputc(*fmt, out);
+		}
+	}
+
+	return true;
+}
+
+/* Write c, after the pending level marker if it starts the text of a line. */
+static void put_console_char(FILE *out, char c, char marker, bool *pending)
+{
+	if (c != '\n' && *pending) {
+		fputc(marker, out);
+		*pending = false;
+	}
+	fputc(c, out);
+}
+
+/*
+ * Replace the '$' lines of tokenized printk() calls in the console with their text. The
+ * level marker is repeated for each line of the text. The newline ending the record isn't
+ * part of the text, so markers of records which continue a line are dropped.
+ */
+static char *detokenize_console(const char *console_c, size_t *size)
+{
+	bool line_start = true, pending = false;
+	size_t i, j, end, text_size;
+	char marker = 0;
+	char *buf, *text;
+	FILE *out, *f;
+	bool ok;
+
+	out = open_memstream(&buf, size);
+	if (!out)
+		die("Not enough memory for console.\n");
+
+	for (i = 0; console_c[i]; i++) {
+		if (BIOS_LOG_IS_MARKER(console_c[i])) {
+			if (line_start) {
+				marker = console_c[i];
+				pending = true;
+			}
+			continue;
+		}
+
+		/* Records are only recognized at the start of a line, after its marker. */
+		if (console_c[i] == PRINTK_TOKEN_PREFIX && (i == 0 || console_c[i - 1] == '\n' ||
+							    BIOS_LOG_IS_MARKER(console_c[i - 1]))) {
+			end = i + 1 + strcspn(&console_c[i + 1], "\n");
+
+			f = open_memstream(&text, &text_size);
+			if (!f)
+				die("Not enough memory for console.\n");
+			ok = console_c[end] == '\n' &&
+			     print_printk_record(f, &console_c[i + 1], end - i - 1);
+			fclose(f);
+
+			if (ok) {
+				for (j = 0; j < text_size; j++) {
+					put_console_char(out, text[j], marker, &pending);
+					line_start = text[j] == '\n';
+					if (line_start)
+						pending = marker != 0;
+				}
+				if (line_start) {
+					pending = false;
+					marker = 0;
+				}
+				free(text);
+				i = end;
+				continue;
+			}
+			free(text);
+		}
+
+		put_console_char(out, console_c[i], marker, &pending);
+		line_start = console_c[i] == '\n';
+		if (line_start) {
+			pending = false;
+			marker = 0;
+		}
+	}
+
+	fclose(out);
+	return buf;
+}
+
 /* dump the cbmem console */
 static void dump_console(enum console_print_type type, int max_loglevel, int print_unknown_logs)
 {
@@ -1192,6 +1896,13 @@ static void dump_console(enum console_print_type type, int max_loglevel, int pri
 		    && !BIOS_LOG_IS_MARKER(console_c[cursor]))
 			console_c[cursor] = '?';
 
+	if (num_printk_tokens) {
+		char *text = detokenize_console(console_c, &size);
+
+		free(console_c);
+		console_c = text;
+	}
+
 	/* We detect the reboot cutoff by looking for a bootblock, romstage or
 	   ramstage banner, in that order (to account for platforms without
 	   CONFIG_BOOTBLOCK_CONSOLE and/or CONFIG_EARLY_CONSOLE). Once we find
@@ -1536,12 +2247,13 @@ static void print_version(void)
 
 static void print_usage(const char *name, int exit_code)
 {
-	printf("usage: %s [-cCltTLxVvh?]\n", name);
+	printf("usage: %s [-cCltTLFPpxVvh?] [-k tokens]\n", name);
 	printf("\n"
 	     "   -c | --console:                   print cbmem console\n"
 	     "   -1 | --oneboot:                   print cbmem console for last boot only\n"
 	     "   -2 | --2ndtolast:                 print cbmem console for the boot that came before the last one only\n"
 	     "   -B | --loglevel:                  maximum loglevel to print; prefix `+` (e.g. -B +INFO) to also print lines that have no level\n"
+	     "   -k | --tokens FILE:               decode tokenized printk() lines with the build's printk_tokens.db\n"
 	     "   -C | --coverage:                  dump coverage information\n"
 	     "   -l | --list:                      print cbmem table of contents\n"
 	     "   -x | --hexdump:                   print hexdump of cbmem area\n"
@@ -1551,6 +2263,10 @@ static void print_usage(const char *name, int exit_code)
 	     "   -S | --stacked-timestamps:        print stacked timestamps (e.g. for flame graph tools)\n"
 	     "   -a | --add-timestamp ID:          append timestamp with ID\n"
 	     "   -L | --tcpa-log                   print TPM log\n"
+	     "   -F | --cbfs-trace:                print CBFS cache statistics and access trace\n"
+	     "                                     (flags: P=preloaded, S=stage, M=mapped, F=failed)\n"
+	     "   -P | --boot-profile:              print boot profile as folded stacks (e.g. for flame graph tools)\n"
+	     "   -p | --boot-profile-summary:      print boot profile critical path and top entries\n"
 	     "   -V | --verbose:                   verbose (debugging) output\n"
 	     "   -v | --version:                   print the version\n"
 	     "   -h | --help:                      print this help\n"
@@ -1682,6 +2398,8 @@ int main(int argc, char** argv)
 	int print_hexdump = 0;
 	int print_rawdump = 0;
 	int print_tcpa_log = 0;
+	int print_cbfs_trace = 0;
+	enum boot_profile_print_type boot_profile_type = BOOT_PROFILE_PRINT_NONE;
 	enum timestamps_print_type timestamp_type = TIMESTAMPS_PRINT_NONE;
 	enum console_print_type console_type = CONSOLE_PRINT_FULL;
 	unsigned int rawdump_id = 0;
@@ -1695,9 +2413,13 @@ int main(int argc, char** argv)
 		{"oneboot", 0, 0, '1'},
 		{"2ndtolast", 0, 0, '2'},
 		{"loglevel", required_argument, 0, 'B'},
+		{"tokens", required_argument, 0, 'k'},
 		{"coverage", 0, 0, 'C'},
 		{"list", 0, 0, 'l'},
 		{"tcpa-log", 0, 0, 'L'},
+		{"cbfs-trace", 0, 0, 'F'},
+		{"boot-profile", 0, 0, 'P'},
+		{"boot-profile-summary", 0, 0, 'p'},
 		{"timestamps", 0, 0, 't'},
 		{"parseable-timestamps", 0, 0, 'T'},
 		{"stacked-timestamps", 0, 0, 'S'},
@@ -1709,7 +2431,7 @@ int main(int argc, char** argv)
 		{"help", 0, 0, 'h'},
 		{0, 0, 0, 0}
 	};
-	while ((opt = getopt_long(argc, argv, "c12B:CltTSa:LxVvh?r:",
+	while ((opt = getopt_long(argc, argv, "c12B:k:CltTSa:LFPpxVvh?r:",
 				  long_options, &option_index)) != EOF) {
 		switch (opt) {
 		case 'c':
@@ -1729,6 +2451,9 @@ int main(int argc, char** argv)
 		case 'B':
 			max_loglevel = parse_loglevel(optarg, &print_unknown_logs);
 			break;
+		case 'k':
+			load_printk_tokens(optarg);
+			break;
 		case 'C':
 			print_coverage = 1;
 			print_defaults = 0;
@@ -1741,6 +2466,18 @@ int main(int argc, char** argv)
 			print_tcpa_log = 1;
 			print_defaults = 0;
 			break;
+		case 'F':
+			print_cbfs_trace = 1;
+			print_defaults = 0;
+			break;
+		case 'P':
+			boot_profile_type = BOOT_PROFILE_PRINT_FOLDED;
+			print_defaults = 0;
+			break;
+		case 'p':
+			boot_profile_type = BOOT_PROFILE_PRINT_SUMMARY;
+			print_defaults = 0;
+			break;
 		case 'x':
 			print_hexdump = 1;
 			print_defaults = 0;
@@ -1890,6 +2627,14 @@ int main(int argc, char** argv)
 	if (print_tcpa_log)
 		dump_tpm_log();
 
+	if (print_cbfs_trace) {
+		dump_cbfs_cache_stats();
+		dump_cbfs_trace();
+	}
+
+	if (boot_profile_type != BOOT_PROFILE_PRINT_NONE)
+		dump_boot_profile(boot_profile_type);
+
 	unmap_memory(&lbtable_mapping);
 
 	close(mem_fd);
@@ -720,6 +720,11 @@ void add_device_ops(struct bus *bus, char *ops_id)
 	bus->dev->ops_id = ops_id;
 }
 
+void add_init_after(struct bus *bus, const char *alias)
+{
+	add_identifier(&bus->dev->init_after, alias);
+}
+
 /* Allocate a new bus for the provided device. */
 static void alloc_bus(struct device *dev)
 {
@@ -1197,6 +1202,29 @@ static struct chip_instance *get_chip_instance(const struct device *dev)
 	return chip_ins;
 }
 
+static void emit_init_after(FILE *fil, struct device *dev)
+{
+	struct identifier *id;
+
+	fprintf(fil, "#if !DEVTREE_EARLY\n");
+	fprintf(fil, "STORAGE struct device *const %s_init_after[] = {\n", dev->name);
+	for (id = dev->init_after; id; id = id->next) {
+		const struct device *const after = find_alias(&base_root_dev, id->id);
+		if (!after) {
+			printf("ERROR: Cannot find device alias '%s'.\n", id->id);
+			exit(1);
+		}
+		if (after == dev) {
+			printf("ERROR: Device '%s' cannot be initialized after itself.\n",
+			       id->id);
+			exit(1);
+		}
+		fprintf(fil, "\t&%s,\n", after->name);
+	}
+	fprintf(fil, "\tNULL\n};\n");
+	fprintf(fil, "#endif\n");
+}
+
 static void pass1(FILE *fil, FILE *head, struct device *ptr, struct device *next)
 {
 	struct chip_instance *chip_ins = get_chip_instance(ptr);
@@ -1210,6 +1238,9 @@ static void pass1(FILE *fil, FILE *head, struct device *ptr, struct device *next
 		exit(1);
 	}
 
+	if (ptr->init_after)
+		emit_init_after(fil, ptr);
+
 	if (ptr == &base_root_dev)
 		fprintf(fil, "DEVTREE_CONST struct device %s = {\n", ptr->name);
 	else
@@ -1228,6 +1259,8 @@ static void pass1(FILE *fil, FILE *head, struct device *ptr, struct device *next
 		fprintf(fil, "\t.ops = &default_dev_ops_root,\n");
 	else
 		fprintf(fil, "\t.ops = NULL,\n");
+	if (ptr->init_after)
+		fprintf(fil, "\t.init_after = %s_init_after,\n", ptr->name);
 	fprintf(fil, "#endif\n");
 	fprintf(fil, "\t.upstream = &%s_bus,\n", ptr->parent->dev->name);
 	fprintf(fil, "\t.path = {");
@@ -1776,6 +1809,11 @@ static void update_device(struct device *base_dev, struct device *override_dev)
 	 */
 	base_dev->probe = override_dev->probe;
 
+	/* Add init ordering of override device to the one of base device. */
+	struct identifier *id;
+	for (id = override_dev->init_after; id; id = id->next)
+		add_identifier(&base_dev->init_after, id->id);
+
 	/* Copy SMBIOS slot information from base device */
 	base_dev->smbios_slot_type = override_dev->smbios_slot_type;
 	base_dev->smbios_slot_length = override_dev->smbios_slot_length;
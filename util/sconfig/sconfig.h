@@ -176,6 +176,9 @@ struct device {
 
 	/* List of field+option to probe. */
 	struct fw_config_probe *probe;
+
+	/* Aliases of the devices to initialize before this one. */
+	struct identifier *init_after;
 };
 
 extern struct bus *root_parent;
@@ -227,3 +230,5 @@ void append_fw_config_bits(struct fw_config_field_bits **bits,
 			   unsigned int start_bit, unsigned int end_bit);
 
 void add_device_ops(struct bus *, char *ops_id);
+
+void add_init_after(struct bus *bus, const char *alias);